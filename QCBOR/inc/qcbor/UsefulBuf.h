@@ -632,6 +632,25 @@ int UsefulBuf_Compare(const UsefulBufC UB1, const UsefulBufC UB2);
 size_t UsefulBuf_IsValue(const UsefulBufC UB, uint8_t uValue);
 
 
+/**
+ * @brief Check that a buffer is valid UTF-8.
+ *
+ * @param[in] UB  The bytes to check.
+ *
+ * @return 1 if @c UB is valid UTF-8, 0 if not.
+ *
+ * Validity is per RFC 3629. Overlong forms, surrogates (U+D800 to
+ * U+DFFF), code points above U+10FFFF and truncated sequences are
+ * rejected. An empty or NULL buffer is valid.
+ *
+ * When compiled with SSSE3 enabled, 16 bytes are checked per step
+ * using the nibble lookup method of Keiser and Lemire. Otherwise a
+ * portable implementation is used that skips ASCII eight bytes at a
+ * time.
+ */
+int UsefulBuf_IsValidUTF8(UsefulBufC UB);
+
+
 /**
  * @brief Find one @ref UsefulBufC in another.
  *
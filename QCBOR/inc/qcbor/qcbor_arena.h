@@ -0,0 +1,204 @@
+/*==============================================================================
+ Copyright (c) 2016-2018, The Linux Foundation.
+ Copyright (c) 2018-2021, Laurence Lundblade.
+ Copyright (c) 2021, Arm Limited.
+ All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors, nor the name "Laurence Lundblade" may be used to
+      endorse or promote products derived from this software without
+      specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ =============================================================================*/
+
+
+#ifndef qcbor_arena_h
+#define qcbor_arena_h
+
+
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ @file qcbor_arena.h
+
+ @anchor Arena
+ # Arena String Allocator
+
+ The arena is a string allocator for indefinite-length strings, and
+ for all strings when @c bAllStrings is set, that is an alternative
+ to QCBORDecode_SetMemPool(). The MemPool must be sized for the
+ largest input that will be decoded. The arena can start with a
+ small buffer, or none, and grow.
+
+ Memory comes from regions. The first region is a buffer given to
+ QCBORArena_Init(). If QCBORArena_SetGrowth() has been called, more
+ regions are obtained from the caller's region allocator as needed,
+ each twice the size of the previous. With no growth set up, the
+ arena fails allocations that don't fit like the MemPool does.
+
+ Strings are allocated one after another in the current region. The
+ newest one grows in place while there is room, as happens for each
+ chunk of an indefinite-length string, and is moved to the next
+ region if not. The decoder only ever resizes or frees the newest
+ string, so nothing else is tracked.
+
+ QCBORArena_Reset() makes all the memory of the arena available again
+ in constant time. The regions it has grown are kept, so decoding
+ many messages in turn with a reset before each reaches a steady
+ state with no more calls to the region allocator. All the strings
+ from before the reset are no longer valid. QCBORArena_Release()
+ gives the grown regions back.
+
+ An arena is not safe to use from more than one thread at a time.
+ Give each thread its own. Nothing is shared between arenas.
+
+ @code
+     QCBORArena Arena;
+     uint8_t    Initial[256];
+
+     QCBORArena_Init(&Arena, UsefulBuf_FROM_BYTE_ARRAY(Initial));
+     QCBORArena_SetGrowth(&Arena, MyRegionAllocate, MyRegionFree, NULL);
+     for(each message) {
+        QCBORArena_Reset(&Arena);
+        QCBORDecode_Init(&DCtx, Message, QCBOR_DECODE_MODE_NORMAL);
+        QCBORDecode_SetArena(&DCtx, &Arena, false);
+        // Decode the message
+     }
+     QCBORArena_Release(&Arena);
+ @endcode
+
+ This is not available when @c QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+ is defined as there is no use for a string allocator then.
+ */
+
+
+/** A string allocator set up with QCBORArena_Init(). */
+typedef struct _QCBORArena QCBORArena;
+
+
+/**
+ @brief Get a region of memory for an arena.
+
+ @param[in] pRegionCtx  The context given to QCBORArena_SetGrowth().
+ @param[in] uSize       The size of region wanted.
+
+ @return The region of @c uSize bytes or more, or @ref NULLUsefulBuf
+         if there is none. It must be aligned for a pointer, as @c
+         malloc() does.
+ */
+typedef UsefulBuf (*QCBORArenaRegionAllocate)(void *pRegionCtx, size_t uSize);
+
+
+/**
+ @brief Give back a region obtained with @ref QCBORArenaRegionAllocate.
+
+ @param[in] pRegionCtx  The context given to QCBORArena_SetGrowth().
+ @param[in] Region      The region as it was returned.
+ */
+typedef void (*QCBORArenaRegionFree)(void *pRegionCtx, UsefulBuf Region);
+
+
+/**
+ The smallest region an arena grows by. Requests larger than the
+ doubled previous region get a region of their size.
+ */
+#define QCBOR_ARENA_MIN_GROWTH 1024
+
+
+/**
+ @brief Set up an arena.
+
+ @param[out] pArena   The arena.
+ @param[in] Initial   The first region, or @ref NULLUsefulBuf for none.
+
+ A small amount of @c Initial, a few pointers, is used to keep track
+ of it. If it is too small for that it is not used.
+ */
+void QCBORArena_Init(QCBORArena *pArena, UsefulBuf Initial);
+
+
+/**
+ @brief Let an arena grow.
+
+ @param[in] pArena      The arena.
+ @param[in] pfAllocate  Gets a new region.
+ @param[in] pfFree      Gives back a region. This may be @c NULL if
+                        QCBORArena_Release() is never called.
+ @param[in] pRegionCtx  Passed to @c pfAllocate and @c pfFree.
+ */
+void QCBORArena_SetGrowth(QCBORArena              *pArena,
+                          QCBORArenaRegionAllocate pfAllocate,
+                          QCBORArenaRegionFree     pfFree,
+                          void                    *pRegionCtx);
+
+
+/**
+ @brief Make all the memory of an arena available again.
+
+ @param[in] pArena  The arena.
+
+ This takes the same time no matter how much was allocated. Strings
+ allocated before this are no longer valid.
+ */
+void QCBORArena_Reset(QCBORArena *pArena);
+
+
+/**
+ @brief Give back the regions an arena has grown.
+
+ @param[in] pArena  The arena.
+
+ Each region from the region allocator is passed to the @c pfFree
+ given to QCBORArena_SetGrowth(). The arena is reset and can still be
+ used.
+ */
+void QCBORArena_Release(QCBORArena *pArena);
+
+
+/**
+ @brief Use an arena as the string allocator of a decoder.
+
+ @param[in] pCtx         The decode context.
+ @param[in] pArena       The arena.
+ @param[in] bAllStrings  See QCBORDecode_SetUpAllocator().
+
+ This calls QCBORDecode_SetUpAllocator() with the arena. The arena
+ must stay valid while the decode context and its strings are used.
+ */
+void QCBORDecode_SetArena(QCBORDecodeContext *pCtx, QCBORArena *pArena, bool bAllStrings);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_arena_h */
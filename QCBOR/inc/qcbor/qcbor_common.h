@@ -524,7 +524,52 @@ typedef enum {
 
    /** Floating point support is completely turned off, encoding/decoding
        floating point numbers is not possible. */
-   QCBOR_ERR_ALL_FLOAT_DISABLED = 46
+   QCBOR_ERR_ALL_FLOAT_DISABLED = 46,
+
+   /** A text string is not valid UTF-8. Only reported when UTF-8
+       validation is enabled with QCBORDecode_SetUTF8Validation(). */
+   QCBOR_ERR_BAD_UTF8 = 47,
+
+   /** An integer, length or tag number was not encoded in the
+       shortest possible head. Only reported in @ref
+       QCBOR_DECODE_MODE_DCBOR. The item after the head is not
+       consumed so this error makes no further decoding possible. */
+   QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD = 48,
+
+   /** An indefinite-length string, array or map was encountered. Only
+       reported in @ref QCBOR_DECODE_MODE_DCBOR. The item after the
+       head is not consumed so this error makes no further decoding
+       possible. */
+   QCBOR_ERR_DCBOR_INDEFINITE_LENGTH = 49,
+
+   /** A floating-point value has a shorter exact representation or
+       is a NaN other than 0x7e00. Only reported in @ref
+       QCBOR_DECODE_MODE_DCBOR. */
+   QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT = 50,
+
+   /** A map label is not greater than the previous label in bytewise
+       lexicographic order of their encoding. Only reported when the
+       check is enabled with QCBORDecode_SetMapLabelOrderCheck() or
+       in @ref QCBOR_DECODE_MODE_DCBOR. Equal labels are reported as
+       @ref QCBOR_ERR_DUPLICATE_LABEL. */
+   QCBOR_ERR_UNSORTED_LABEL = 51,
+
+   /** The buffer given to QCBORTape_Build() is too small for the
+       number of data items in the input. */
+   QCBOR_ERR_TAPE_TOO_SMALL = 52,
+
+   /** The input added so far with QCBORDecode_AddInput() ends before
+       the next data item does. Decoding can go on after more is
+       added. Until then QCBORDecode_IsUnrecoverableError() is @c true
+       for this so traversal stops. */
+   QCBOR_ERR_NEED_MORE_INPUT = 53,
+
+   /** QCBORParallel_Decode() could not start any worker thread. */
+   QCBOR_ERR_THREAD_START = 54,
+
+   /** A string given by QCBORDecode_GetNextCompact() was put together
+       or copied by the string allocator, so it is not in the input. */
+   QCBOR_ERR_ALLOCATED_STRING = 55
 
    /* This is stored in uint8_t; never add values > 255 */
 } QCBORError;
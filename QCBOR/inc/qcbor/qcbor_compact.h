@@ -0,0 +1,213 @@
+/*==============================================================================
+ Copyright (c) 2016-2018, The Linux Foundation.
+ Copyright (c) 2018-2021, Laurence Lundblade.
+ Copyright (c) 2021, Arm Limited.
+ All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors, nor the name "Laurence Lundblade" may be used to
+      endorse or promote products derived from this software without
+      specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ =============================================================================*/
+
+
+#ifndef qcbor_compact_h
+#define qcbor_compact_h
+
+
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ @file qcbor_compact.h
+
+ @anchor CompactItem
+ # Compact Items
+
+ A @ref QCBORItem is 56 bytes on 64-bit machines. Most of that is for
+ the decoded content of tags like dates and big floats, and for
+ pointers to strings. When many decoded items are kept, for example
+ records decoded into flat arrays, a @ref QCBORCompactItem holds the
+ same traversal in 24 bytes.
+
+ QCBORDecode_GetNextCompact() is the same traversal as
+ QCBORDecode_GetNext(). There are these differences:
+
+ - Strings and string labels are an offset and length in the input
+   given to QCBORDecode_Init(), not a pointer. QCBORCompact_String()
+   and QCBORCompact_LabelString() give them as a @ref UsefulBufC.
+ - Tag content is not decoded. A tagged item is given as its content,
+   for example a date as its integer or string, with
+   @ref QCBOR_COMPACT_TAGGED set in @c uFlags. The tag numbers are
+   then available from QCBORDecode_GetNthTagOfLast() until the next
+   item is decoded.
+ - Strings that come from the string allocator are not in the input.
+   They give @ref QCBOR_ERR_ALLOCATED_STRING. These are
+   indefinite-length strings, and all strings when the allocator is set
+   up with @c bAllStrings.
+
+ Items without tags go through the same fast path as
+ QCBORDecode_GetNextPlain().
+
+ @code
+     QCBORCompactItem Items[1000];
+     size_t           uCount = 0;
+
+     QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+     while(uCount < 1000 &&
+           QCBORDecode_GetNextCompact(&DCtx, &Items[uCount]) == QCBOR_SUCCESS) {
+        uCount++;
+     }
+     uErr = QCBORDecode_Finish(&DCtx);
+     Name = QCBORCompact_String(&Items[3], Encoded);
+ @endcode
+ */
+
+
+/** An offset and length in the input of a string in a @ref QCBORCompactItem. */
+typedef struct {
+   uint32_t uOffset;
+   uint32_t uLen;
+} QCBORCompactString;
+
+
+/** The item has one or more tag numbers. See QCBORDecode_GetNthTagOfLast(). */
+#define QCBOR_COMPACT_TAGGED 0x01
+
+
+/**
+ A decoded item filled in by QCBORDecode_GetNextCompact(). The fields
+ have the same meaning as the ones of the same name in @ref QCBORItem.
+ */
+typedef struct {
+   /** One of @ref QCBOR_TYPE_INT64 and such. Never a type that is only
+    *  from decoding tag content. */
+   uint8_t  uDataType;
+   /** @ref QCBOR_TYPE_NONE, @ref QCBOR_TYPE_INT64, @ref
+    *  QCBOR_TYPE_UINT64, @ref QCBOR_TYPE_TEXT_STRING or @ref
+    *  QCBOR_TYPE_BYTE_STRING. */
+   uint8_t  uLabelType;
+   uint8_t  uNestingLevel;
+   uint8_t  uNextNestLevel;
+   /** @ref QCBOR_COMPACT_TAGGED or 0. */
+   uint8_t  uFlags;
+
+   union {
+      int64_t            int64;
+      uint64_t           uint64;
+      /** For @ref QCBOR_TYPE_BYTE_STRING and @ref QCBOR_TYPE_TEXT_STRING. */
+      QCBORCompactString string;
+      uint16_t           uCount;
+      double             dfnum;
+      float              fnum;
+      uint8_t            uSimple;
+   } val;
+
+   union {
+      int64_t            int64;
+      uint64_t           uint64;
+      QCBORCompactString string;
+   } label;
+} QCBORCompactItem;
+
+
+/**
+ @brief Get the next item as a compact item.
+
+ @param[in] pCtx       The decoder context.
+ @param[out] pCompact  The decoded item.
+
+ @retval QCBOR_ERR_ALLOCATED_STRING  The string is not in the input.
+
+ Otherwise the errors are those of QCBORDecode_GetNext(), less those
+ from decoding tag content. Like QCBORDecode_GetNext() this doesn't
+ set the internal decoding error. On error @c uDataType and @c
+ uLabelType are @ref QCBOR_TYPE_NONE.
+ */
+QCBORError QCBORDecode_GetNextCompact(QCBORDecodeContext *pCtx, QCBORCompactItem *pCompact);
+
+
+/**
+ @brief Get the string value of a compact item.
+
+ @param[in] pCompact  The item. Its @c uDataType must be @ref
+                      QCBOR_TYPE_BYTE_STRING or @ref QCBOR_TYPE_TEXT_STRING.
+ @param[in] Encoded   The input given to QCBORDecode_Init().
+
+ @return The string, pointing into @c Encoded.
+ */
+static UsefulBufC QCBORCompact_String(const QCBORCompactItem *pCompact, UsefulBufC Encoded);
+
+
+/**
+ @brief Get the string label of a compact item.
+
+ @param[in] pCompact  The item. Its @c uLabelType must be @ref
+                      QCBOR_TYPE_BYTE_STRING or @ref QCBOR_TYPE_TEXT_STRING.
+ @param[in] Encoded   The input given to QCBORDecode_Init().
+
+ @return The label, pointing into @c Encoded.
+ */
+static UsefulBufC QCBORCompact_LabelString(const QCBORCompactItem *pCompact, UsefulBufC Encoded);
+
+
+
+
+/* ===========================================================================
+   BEGINNING OF PRIVATE INLINE IMPLEMENTATION
+   ========================================================================== */
+
+static inline UsefulBufC
+QCBORCompact_String(const QCBORCompactItem *pCompact, UsefulBufC Encoded)
+{
+   return UsefulBuf_Head(UsefulBuf_Tail(Encoded, pCompact->val.string.uOffset),
+                         pCompact->val.string.uLen);
+}
+
+
+static inline UsefulBufC
+QCBORCompact_LabelString(const QCBORCompactItem *pCompact, UsefulBufC Encoded)
+{
+   return UsefulBuf_Head(UsefulBuf_Tail(Encoded, pCompact->label.string.uOffset),
+                         pCompact->label.string.uLen);
+}
+
+/* ===========================================================================
+   END OF PRIVATE INLINE IMPLEMENTATION
+   ========================================================================== */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_compact_h */
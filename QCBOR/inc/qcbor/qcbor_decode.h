@@ -173,7 +173,9 @@ typedef enum {
    /** See QCBORDecode_Init() */
    QCBOR_DECODE_MODE_MAP_STRINGS_ONLY = 1,
    /** See QCBORDecode_Init() */
-   QCBOR_DECODE_MODE_MAP_AS_ARRAY = 2
+   QCBOR_DECODE_MODE_MAP_AS_ARRAY = 2,
+   /** See QCBORDecode_Init() */
+   QCBOR_DECODE_MODE_DCBOR = 3
    /* This is stored in uint8_t in places; never add values > 255 */
 } QCBORDecodeMode;
 
@@ -591,7 +593,10 @@ typedef UsefulBuf (* QCBORStringAllocate)(void *pAllocateCxt, void *pOldMem, siz
 
 /**
  * QCBORDecodeContext holds the context for decoding CBOR.  It is
- * about 300 bytes, so it can go on the stack.  The contents are
+ * about 300 bytes on 64-bit CPUs, so it can go on the stack.
+ * QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK makes it about 130 bytes larger,
+ * QCBOR_ENABLE_INCREMENTAL_INPUT about 40 bytes larger and
+ * QCBOR_ENABLE_MAP_INDEX about 20 bytes larger.  The contents are
  * opaque, and the caller should not access any internal items.  A
  * context may be re-used serially as long as it is re initialized.
  */
@@ -615,7 +620,7 @@ typedef struct _QCBORDecodeContext QCBORDecodeContext;
  * QCBORDecode_SetMemPool() or QCBORDecode_SetUpAllocator() must be
  * called to set up a string allocator.
  *
- * Three decoding modes are supported.  In normal mode, @ref
+ * Four decoding modes are supported.  In normal mode, @ref
  * QCBOR_DECODE_MODE_NORMAL, maps are decoded and strings and integers
  * are accepted as map labels. If a label is other than these, the
  * error @ref QCBOR_ERR_MAP_LABEL_TYPE is returned by
@@ -634,6 +639,24 @@ typedef struct _QCBORDecodeContext QCBORDecodeContext;
  * also counted. This mode is useful for decoding CBOR that has labels
  * that are not integers or text strings, but the caller must manage
  * much of the map decoding.
+ *
+ * In @ref QCBOR_DECODE_MODE_DCBOR maps are decoded as in normal mode
+ * and the input is also checked for deterministic encoding (D-CBOR)
+ * in the same pass, so it need not be re-encoded and compared.
+ * Arguments (integers, lengths and tag numbers) must use the
+ * shortest head, giving @ref QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD.
+ * Indefinite-length strings, arrays and maps give @ref
+ * QCBOR_ERR_DCBOR_INDEFINITE_LENGTH.  Floating-point values must be
+ * in the shortest form that represents them exactly, subnormals
+ * included, and the only NaN is the half-precision 0x7e00. Others
+ * give @ref QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT. The first two are
+ * unrecoverable, see QCBORDecode_IsUnrecoverableError(), while
+ * decoding can continue after the last. Text strings are
+ * also validated as UTF-8 as by QCBORDecode_SetUTF8Validation() and
+ * map labels are checked as by QCBORDecode_SetMapLabelOrderCheck().
+ * The float check is not performed when QCBOR_DISABLE_PREFERRED_FLOAT
+ * is defined, and the label order check only when
+ * QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK is.
  */
 void QCBORDecode_Init(QCBORDecodeContext *pCtx, UsefulBufC EncodedCBOR, QCBORDecodeMode nMode);
 
@@ -726,6 +749,53 @@ void QCBORDecode_SetUpAllocator(QCBORDecodeContext *pCtx,
                                 bool                bAllStrings);
 
 
+/**
+ * @brief Enable or disable UTF-8 validation of text strings.
+ *
+ * @param[in] pCtx       The decode context.
+ * @param[in] bValidate  If true, text strings are checked.
+ *
+ * CBOR requires text strings to be UTF-8, but by default the decoder
+ * returns their bytes unchecked. With validation enabled, a text
+ * string that is not valid UTF-8 per RFC 3629 results in @ref
+ * QCBOR_ERR_BAD_UTF8. The chunks of indefinite-length text strings
+ * are checked individually. The string has been consumed when the
+ * error is returned, so decoding can continue.
+ *
+ * See UsefulBuf_IsValidUTF8() for the implementation which is
+ * vectorized when SSSE3 is enabled at compile time.
+ */
+void QCBORDecode_SetUTF8Validation(QCBORDecodeContext *pCtx, bool bValidate);
+
+
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+/**
+ * @brief Enable or disable the map label order check.
+ *
+ * @param[in] pCtx    The decode context.
+ * @param[in] bCheck  If true, map labels are checked.
+ *
+ * Deterministic encoding requires the labels of a map to be sorted
+ * in bytewise lexicographic order of their encoded form, which also
+ * rules out duplicates.  With the check enabled, each label is
+ * compared with the previous label of the same map as it is decoded
+ * and @ref QCBOR_ERR_UNSORTED_LABEL or @ref QCBOR_ERR_DUPLICATE_LABEL
+ * is returned on the item with the offending label. The cost is
+ * linear in the size of the labels and no memory is allocated.
+ *
+ * The item is fully decoded when the error is returned, so decoding
+ * can continue. This check is always on in @ref
+ * QCBOR_DECODE_MODE_DCBOR. It is not performed in @ref
+ * QCBOR_DECODE_MODE_MAP_AS_ARRAY.
+ *
+ * The check and this function are only available when
+ * QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK is defined, which adds 8
+ * bytes per nesting level to @ref QCBORDecodeContext.
+ */
+void QCBORDecode_SetMapLabelOrderCheck(QCBORDecodeContext *pCtx, bool bCheck);
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+
+
 /**
  * @brief Get the next item (integer, byte string, array...) in the
  * preorder traversal of the CBOR tree.
@@ -887,6 +957,12 @@ void QCBORDecode_SetUpAllocator(QCBORDecodeContext *pCtx,
  * | @ref QCBOR_ERR_NO_MORE_ITEMS        | Need more input data items to decode |
  * | @ref QCBOR_ERR_BAD_EXP_AND_MANTISSA | The structure of a big float or big number is invalid |
  * | @ref QCBOR_ERR_BAD_TAG_CONTENT      | The content of a tag is of the wrong type |
+ * | @ref QCBOR_ERR_BAD_UTF8             | Text string is not valid UTF-8 (only with QCBORDecode_SetUTF8Validation()) |
+ * | @ref QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD   | Argument not in shortest form (only with @ref QCBOR_DECODE_MODE_DCBOR) |
+ * | @ref QCBOR_ERR_DCBOR_INDEFINITE_LENGTH  | Indefinite-length item (only with @ref QCBOR_DECODE_MODE_DCBOR) |
+ * | @ref QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT | Float not in shortest form (only with @ref QCBOR_DECODE_MODE_DCBOR) |
+ * | @ref QCBOR_ERR_UNSORTED_LABEL           | Map labels out of order (only with QCBORDecode_SetMapLabelOrderCheck()) |
+ * | @ref QCBOR_ERR_DUPLICATE_LABEL          | Duplicate map label (only with QCBORDecode_SetMapLabelOrderCheck()) |
  * | __Implementation Limits__  ||
  * | @ref QCBOR_ERR_INT_OVERFLOW                  | Input integer smaller than INT64_MIN |
  * | @ref QCBOR_ERR_ARRAY_DECODE_TOO_LONG         | Array or map has more elements than can be handled |
@@ -923,6 +999,28 @@ void QCBORDecode_VGetNext(QCBORDecodeContext *pCtx, QCBORItem *pDecodedItem);
 QCBORError QCBORDecode_GetNext(QCBORDecodeContext *pCtx, QCBORItem *pDecodedItem);
 
 
+/**
+ * @brief QCBORDecode_GetNext() with a fast path for items without tags.
+ *
+ * @param[in]  pCtx          The decoder context.
+ * @param[out] pDecodedItem  The decoded CBOR item.
+ *
+ * @return See error table of decoding errors set by QCBORDecode_VGetNext().
+ *
+ * This gives exactly the same items and errors as
+ * QCBORDecode_GetNext() and the two can be mixed. Items, and labels
+ * of map entries, that are not tags, breaks or indefinite-length
+ * strings are decoded in one step instead of going through each of
+ * the decoder's layers. This is the usual case for deterministic
+ * CBOR, such as that checked by @ref QCBOR_DECODE_MODE_DCBOR. Other
+ * items go through the layers as usual, as does everything in @ref
+ * QCBOR_DECODE_MODE_MAP_STRINGS_ONLY and @ref
+ * QCBOR_DECODE_MODE_MAP_AS_ARRAY modes, when all strings are allocated
+ * and when input is added with QCBORDecode_AddInput().
+ */
+QCBORError QCBORDecode_GetNextPlain(QCBORDecodeContext *pCtx, QCBORItem *pDecodedItem);
+
+
 /**
  * @brief Get the next item, fully consuming it if it is a map or array.
  *
@@ -1105,6 +1203,124 @@ QCBORError
 QCBORDecode_PartialFinish(QCBORDecodeContext *pCtx, size_t *puConsumed);
 
 
+#ifdef QCBOR_ENABLE_INCREMENTAL_INPUT
+/**
+ * @brief Initialize the decoder for input that arrives in chunks.
+ *
+ * @param[in] pCtx    The context to initialize.
+ * @param[in] Buffer  Memory the decoder keeps the input in.
+ * @param[in] nMode   See QCBORDecode_Init() and @ref QCBORDecodeMode.
+ *
+ * This is for CBOR that arrives a piece at a time, for example from a
+ * network connection, where waiting for all of it or buffering all of
+ * it is not practical. The chunks may split the input anywhere, in the
+ * middle of a head or a string. Input is given to the decoder with
+ * QCBORDecode_AddInput() and the end of it is marked with
+ * QCBORDecode_EndInput().
+ *
+ * When the next data item is not all in the input added so far,
+ * decoding reports @ref QCBOR_ERR_NEED_MORE_INPUT. The decoder is left
+ * exactly as it was before the call, so the call can be repeated after
+ * more input is added. Since data items are decoded whole, this only
+ * happens at data item boundaries. Arrays and maps are decoded a data
+ * item at a time, so they may be much larger than @c Buffer. Nesting
+ * is tracked between chunks as usual. For example:
+ *
+ * @code
+ *     QCBORDecode_InitIncremental(&DCtx, Buffer, QCBOR_DECODE_MODE_NORMAL);
+ *     while(1) {
+ *        uErr = QCBORDecode_GetNext(&DCtx, &Item);
+ *        if(uErr == QCBOR_ERR_NEED_MORE_INPUT) {
+ *           Chunk = ReadFromNetwork();
+ *           if(Chunk.len == 0) {
+ *              QCBORDecode_EndInput(&DCtx);
+ *           }
+ *           while(Chunk.len) {
+ *              Chunk = QCBORDecode_AddInput(&DCtx, Chunk);
+ *              // Anything left over is added after decoding more
+ *           }
+ *           continue;
+ *        }
+ *        if(uErr != QCBOR_SUCCESS) {
+ *           break;
+ *        }
+ *        // Process Item
+ *     }
+ * @endcode
+ *
+ * Spiffy decode works the same way. A call that sets @ref
+ * QCBOR_ERR_NEED_MORE_INPUT has no other effect and QCBORDecode_AddInput()
+ * clears the error so the call can be repeated.
+ *
+ * The input is kept in @c Buffer, not in the memory passed to
+ * QCBORDecode_AddInput(). Strings in decoded items point into @c
+ * Buffer and remain valid only until the next call to
+ * QCBORDecode_AddInput(), which may move the input still needed to the
+ * start of @c Buffer to make room. Consumed input is discarded then,
+ * except that maps and arrays entered with QCBORDecode_EnterMap() and
+ * such, and byte strings entered with QCBORDecode_EnterBstrWrapped(),
+ * are kept until they are exited so they can be searched and rewound.
+ * @c Buffer must therefore be at least as big as the largest data item
+ * with its label and tag numbers, plus one byte when it is in an
+ * indefinite-length array or map, plus what is kept for entered maps,
+ * arrays and byte strings. When the input still needed fills @c Buffer, decoding
+ * fails with @ref QCBOR_ERR_INPUT_TOO_LARGE.
+ *
+ * QCBORDecode_PartialFinish() counts the discarded input in the bytes
+ * consumed. QCBORDecode_Finish() gives @ref QCBOR_ERR_NEED_MORE_INPUT
+ * if that was the last error, otherwise it is as usual for the input
+ * added so far.
+ *
+ * This and the other incremental input functions are only available
+ * when QCBOR_ENABLE_INCREMENTAL_INPUT is defined, which makes @ref
+ * QCBORDecodeContext larger.
+ */
+void
+QCBORDecode_InitIncremental(QCBORDecodeContext *pCtx,
+                            UsefulBuf           Buffer,
+                            QCBORDecodeMode     nMode);
+
+
+/**
+ * @brief Add a chunk of input.
+ *
+ * @param[in] pCtx   The decode context set up with
+ *                   QCBORDecode_InitIncremental().
+ * @param[in] Input  The chunk of encoded CBOR to add.
+ *
+ * @return The part of @c Input that did not fit in the buffer. It is
+ *         empty when all of @c Input was added.
+ *
+ * The chunk is copied into the decoder's buffer after the input added
+ * before. The remainder should be added after more items have been
+ * decoded. Nothing is added after QCBORDecode_EndInput() or if the
+ * context was not set up with QCBORDecode_InitIncremental().
+ *
+ * This clears @ref QCBOR_ERR_NEED_MORE_INPUT from the error state.
+ * See QCBORDecode_InitIncremental() about strings in items decoded
+ * before this call.
+ */
+UsefulBufC
+QCBORDecode_AddInput(QCBORDecodeContext *pCtx, UsefulBufC Input);
+
+
+/**
+ * @brief Mark the end of the input.
+ *
+ * @param[in] pCtx  The decode context set up with
+ *                  QCBORDecode_InitIncremental().
+ *
+ * After this, decoding treats the input added so far as all of the
+ * input. Running out of it gives the usual errors like @ref
+ * QCBOR_ERR_NO_MORE_ITEMS and @ref QCBOR_ERR_HIT_END instead of @ref
+ * QCBOR_ERR_NEED_MORE_INPUT. This clears @ref QCBOR_ERR_NEED_MORE_INPUT
+ * from the error state.
+ */
+void
+QCBORDecode_EndInput(QCBORDecodeContext *pCtx);
+#endif /* QCBOR_ENABLE_INCREMENTAL_INPUT */
+
+
 /**
  * @brief Get the decoding error.
  *
@@ -1169,7 +1385,11 @@ static bool QCBORDecode_IsNotWellFormedError(QCBORError uErr);
  * limits such as the limit on array and map nesting are encountered.
  *
  * The unrecoverable errors are a range of the errors in
- * @ref QCBORError.
+ * @ref QCBORError. @ref QCBOR_ERR_NEED_MORE_INPUT is also
+ * unrecoverable until more input is added, as are @ref
+ * QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD and @ref
+ * QCBOR_ERR_DCBOR_INDEFINITE_LENGTH which are reported before the
+ * contents of the item are consumed.
  */
 static bool QCBORDecode_IsUnrecoverableError(QCBORError uErr);
 
@@ -1435,8 +1655,11 @@ static inline bool QCBORDecode_IsNotWellFormedError(QCBORError uErr)
 
 static inline bool QCBORDecode_IsUnrecoverableError(QCBORError uErr)
 {
-   if(uErr >= QCBOR_START_OF_UNRECOVERABLE_DECODE_ERRORS &&
-      uErr <= QCBOR_END_OF_UNRECOVERABLE_DECODE_ERRORS) {
+   if((uErr >= QCBOR_START_OF_UNRECOVERABLE_DECODE_ERRORS &&
+       uErr <= QCBOR_END_OF_UNRECOVERABLE_DECODE_ERRORS) ||
+      uErr == QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD ||
+      uErr == QCBOR_ERR_DCBOR_INDEFINITE_LENGTH ||
+      uErr == QCBOR_ERR_NEED_MORE_INPUT) {
       return true;
    } else {
       return false;
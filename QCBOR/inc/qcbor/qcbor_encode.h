@@ -696,6 +696,52 @@ void QCBOREncode_AddFloatNoPreferred(QCBOREncodeContext *pCtx, float fNum);
 static void QCBOREncode_AddFloatNoPreferredToMap(QCBOREncodeContext *pCtx, const char *szLabel, float fNum);
 
 static void QCBOREncode_AddFloatNoPreferredToMapN(QCBOREncodeContext *pCtx, int64_t nLabel, float fNum);
+
+
+/**
+ @brief Add an array of double-precision floating-point numbers.
+
+ @param[in] pCtx      The encoding context to add the array to.
+ @param[in] pdValues  The numbers.
+ @param[in] uCount    The number of them.
+
+ The output is the same as from QCBOREncode_OpenArray(),
+ QCBOREncode_AddDouble() for each number and
+ QCBOREncode_CloseArray(), including the preferred serialization of
+ each number. It is faster because the array head goes out first and
+ the numbers are classified for preferred serialization in blocks,
+ with SIMD instructions on CPUs that have them.
+
+ If @c uCount is more than @ref QCBOR_MAX_ITEMS_IN_ARRAY, @ref
+ QCBOR_ERR_ARRAY_TOO_LONG is set and nothing is output. Otherwise
+ error handling is the same as QCBOREncode_AddInt64().
+
+ See also QCBORDecode_GetDoubleArray().
+ */
+void QCBOREncode_AddDoubleArray(QCBOREncodeContext *pCtx, const double *pdValues, size_t uCount);
+
+static void QCBOREncode_AddDoubleArrayToMap(QCBOREncodeContext *pCtx, const char *szLabel, const double *pdValues, size_t uCount);
+
+static void QCBOREncode_AddDoubleArrayToMapN(QCBOREncodeContext *pCtx, int64_t nLabel, const double *pdValues, size_t uCount);
+
+
+/**
+ @brief Add an array of single-precision floating-point numbers.
+
+ @param[in] pCtx      The encoding context to add the array to.
+ @param[in] pfValues  The numbers.
+ @param[in] uCount    The number of them.
+
+ This is the same as QCBOREncode_AddDoubleArray() except the output
+ is as from QCBOREncode_AddFloat() for each number.
+
+ See also QCBORDecode_GetFloatArray().
+ */
+void QCBOREncode_AddFloatArray(QCBOREncodeContext *pCtx, const float *pfValues, size_t uCount);
+
+static void QCBOREncode_AddFloatArrayToMap(QCBOREncodeContext *pCtx, const char *szLabel, const float *pfValues, size_t uCount);
+
+static void QCBOREncode_AddFloatArrayToMapN(QCBOREncodeContext *pCtx, int64_t nLabel, const float *pfValues, size_t uCount);
 #endif /* USEFULBUF_DISABLE_ALL_FLOAT */
 
 
@@ -2278,6 +2324,34 @@ QCBOREncode_AddFloatNoPreferredToMapN(QCBOREncodeContext *pMe, int64_t nLabel, f
    QCBOREncode_AddInt64(pMe, nLabel);
    QCBOREncode_AddFloatNoPreferred(pMe, dNum);
 }
+
+static inline void
+QCBOREncode_AddDoubleArrayToMap(QCBOREncodeContext *pMe, const char *szLabel, const double *pdValues, size_t uCount)
+{
+   QCBOREncode_AddSZString(pMe, szLabel);
+   QCBOREncode_AddDoubleArray(pMe, pdValues, uCount);
+}
+
+static inline void
+QCBOREncode_AddDoubleArrayToMapN(QCBOREncodeContext *pMe, int64_t nLabel, const double *pdValues, size_t uCount)
+{
+   QCBOREncode_AddInt64(pMe, nLabel);
+   QCBOREncode_AddDoubleArray(pMe, pdValues, uCount);
+}
+
+static inline void
+QCBOREncode_AddFloatArrayToMap(QCBOREncodeContext *pMe, const char *szLabel, const float *pfValues, size_t uCount)
+{
+   QCBOREncode_AddSZString(pMe, szLabel);
+   QCBOREncode_AddFloatArray(pMe, pfValues, uCount);
+}
+
+static inline void
+QCBOREncode_AddFloatArrayToMapN(QCBOREncodeContext *pMe, int64_t nLabel, const float *pfValues, size_t uCount)
+{
+   QCBOREncode_AddInt64(pMe, nLabel);
+   QCBOREncode_AddFloatArray(pMe, pfValues, uCount);
+}
 #endif /* USEFULBUF_DISABLE_ALL_FLOAT */
 
 
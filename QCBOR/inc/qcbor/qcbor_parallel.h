@@ -0,0 +1,192 @@
+/*==============================================================================
+ Copyright (c) 2016-2018, The Linux Foundation.
+ Copyright (c) 2018-2021, Laurence Lundblade.
+ Copyright (c) 2021, Arm Limited.
+ All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors, nor the name "Laurence Lundblade" may be used to
+      endorse or promote products derived from this software without
+      specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ =============================================================================*/
+
+
+#ifndef qcbor_parallel_h
+#define qcbor_parallel_h
+
+
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ @file qcbor_parallel.h
+
+ @anchor ParallelDecode
+ # Parallel Decode
+
+ QCBORParallel_Decode() decodes the top-level items of a CBOR
+ sequence, typically independent records, on several worker threads.
+
+ The calling thread splits the sequence into chunks of whole items
+ with QCBORSequence_Next(), which reads only the item heads. Each
+ worker takes the next chunk and decodes each item in it with a
+ decode context of its own, set up the same as
+ QCBORSequence_NextDecoder() does, and with its own part of the
+ workspace as the MemPool. The decode callback fills in a
+ fixed-size result for each item. The results go to the deliver
+ callback, one at a time, either in the order of the sequence or a
+ chunk at a time as chunks are decoded.
+
+ Since each item is decoded by a decode context of its own the items
+ are the same as those QCBORDecode_GetNext() gives going through the
+ sequence in one decode context, as long as the sequence is not
+ larger than @ref QCBOR_MAX_DECODE_INPUT_SIZE.
+
+ The splitting is done by one thread, so it limits how many workers
+ are useful. It is usually several times faster than decoding.
+
+ No memory is allocated. The workspace given to
+ QCBORParallel_Decode() holds the state of the threads, the MemPools
+ and the results of the chunks being decoded. Its size comes from
+ QCBORParallel_WorkspaceSize().
+
+ This uses POSIX threads. It is left out of the library when
+ @c QCBOR_DISABLE_PARALLEL is defined.
+ */
+
+
+/**
+ @brief Decode one item of the sequence.
+
+ @param[in] pCallbackCtx  The context from @ref QCBORParallelConfig.
+ @param[in] pDCtx         Decode context set up on the item.
+ @param[out] pResult      Where to put the result for the item. It is
+                          @c uResultSize bytes aligned for any
+                          integer or pointer type.
+
+ @return The error for the item that is given to the deliver callback.
+
+ This is called on worker threads, so it must only use what is safe
+ to use from several threads at once. Usually this ends with
+ returning QCBORDecode_Finish(). Strings that come from the MemPool,
+ which are the indefinite-length ones, must be copied into the result
+ since the MemPool is reused for the next item. Other strings point
+ into the sequence.
+ */
+typedef QCBORError (*QCBORParallelDecodeCallback)(void               *pCallbackCtx,
+                                                  QCBORDecodeContext *pDCtx,
+                                                  void               *pResult);
+
+
+/**
+ @brief Take the result of one item.
+
+ @param[in] pCallbackCtx  The context from @ref QCBORParallelConfig.
+ @param[in] uIndex        The index of the item in the sequence.
+ @param[in] uError        What the decode callback returned.
+ @param[in] pResult       The result the decode callback filled in.
+
+ @return @ref QCBOR_SUCCESS to go on or an error to stop decoding.
+
+ Calls to this are never at the same time, but may be on different
+ worker threads.
+ */
+typedef QCBORError (*QCBORParallelDeliverCallback)(void       *pCallbackCtx,
+                                                   uint64_t    uIndex,
+                                                   QCBORError  uError,
+                                                   const void *pResult);
+
+
+/**
+ Configuration for QCBORParallel_Decode().
+ */
+typedef struct {
+   /** The number of worker threads. 0 is the same as 1. */
+   unsigned                     uThreads;
+   /** The items of a chunk stop after this many bytes. 0 for 64KB. */
+   size_t                       uChunkSize;
+   /** The most items in a chunk. 0 for 1024. */
+   uint32_t                     uChunkItems;
+   /** The size of the result for one item. */
+   size_t                       uResultSize;
+   /** The size of the MemPool of each worker. 0 for none. */
+   size_t                       uPoolSize;
+   /** If true, results are delivered in the order of the sequence. */
+   bool                         bOrdered;
+   /** See QCBORDecode_Init(). */
+   QCBORDecodeMode              nDecodeMode;
+   QCBORParallelDecodeCallback  pfDecode;
+   QCBORParallelDeliverCallback pfDeliver;
+   void                        *pCallbackCtx;
+} QCBORParallelConfig;
+
+
+/**
+ @brief The size of workspace needed.
+
+ @param[in] pConfig  The configuration.
+
+ @return The size of the workspace to give QCBORParallel_Decode().
+
+ This grows with the number of threads times the size of the results
+ of a chunk, plus the MemPools.
+ */
+size_t QCBORParallel_WorkspaceSize(const QCBORParallelConfig *pConfig);
+
+
+/**
+ @brief Decode the items of a sequence on several threads.
+
+ @param[in] pConfig    The threads, callbacks and sizes.
+ @param[in] Sequence   The CBOR sequence.
+ @param[in] Workspace  Memory for the state of the decoding of size
+                       QCBORParallel_WorkspaceSize().
+
+ @retval QCBOR_ERR_BUFFER_TOO_SMALL  @c Workspace is too small.
+ @retval QCBOR_ERR_THREAD_START      No worker thread could be started.
+
+ Returns when all items have been delivered, or delivering has
+ stopped because the deliver callback returned an error, which is
+ then returned here. If the sequence can't be split because an item
+ is not well-formed, all the items before it are delivered and the
+ error from QCBORSequence_Next() is returned.
+ */
+QCBORError QCBORParallel_Decode(const QCBORParallelConfig *pConfig,
+                                UsefulBufC                 Sequence,
+                                UsefulBuf                  Workspace);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_parallel_h */
@@ -186,6 +186,9 @@ struct _QCBOREncodeContext {
    208 TOTAL
 
  32-bit machine size is 200 bytes
+
+ The unions are 16 bytes, 336 bytes total (328 on 32-bit), with
+ QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK defined.
  */
 typedef struct __QCBORDecodeNesting  {
    // PRIVATE DATA STRUCTURE
@@ -233,6 +236,13 @@ typedef struct __QCBORDecodeNesting  {
             uint16_t uCountCursor;
 #define QCBOR_NON_BOUNDED_OFFSET UINT32_MAX
             uint32_t uStartOffset;
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+            /* Byte span of the most recent label in a map for the
+             * label order check. uLastLabelEnd is 0 if there is none
+             * since the map was entered or rewound. */
+            uint32_t uLastLabelStart;
+            uint32_t uLastLabelEnd;
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
          } ma; /* for maps and arrays */
          struct {
             /* The end of the input before the bstr was entered so that
@@ -263,6 +273,130 @@ typedef struct __QCBORDecodeNesting  {
 } QCBORDecodeNesting;
 
 
+/*
+ PRIVATE DATA STRUCTURE
+
+ One slot of the buffer set up with QCBORDecode_SetMapIndex(). Each
+ indexed map has a slot describing it followed by a slot for each of
+ its labels. The map slot has the offsets of the first item and the
+ end of the map, the number of labels and the slot of the enclosing
+ indexed map. String labels are kept as an offset and length in the
+ input. uItemOffset is the start of the encoded label, where decoding
+ of the labeled item starts, and uPosition is the number of items
+ before it in the map.
+
+ 64-bit machine size is 16 bytes
+ */
+typedef union __QCBORMapIndexEntry {
+   // PRIVATE DATA STRUCTURE
+   struct {
+      union {
+         int64_t  int64;
+         uint64_t uint64;
+         struct {
+            uint32_t uOffset;
+            uint32_t uLen;
+         } string;
+      } label;
+      uint32_t uItemOffset;
+      uint16_t uPosition;
+      uint8_t  uLabelType;
+   } item;
+   struct {
+      uint32_t uStart;
+      uint32_t uEnd;
+      uint32_t uCount;    // Labels or QCBOR_MAP_INDEX_UNUSABLE
+      uint32_t uPrevious; // Slot or QCBOR_MAP_INDEX_NONE
+   } map;
+} QCBORMapIndexEntry;
+
+
+/*
+ PRIVATE DATA STRUCTURE
+
+ One data item in a tape built with QCBORTape_Build(). uOffset is the
+ start of the item's head and uInitialByte is the first byte of
+ it. uArgument is the argument of the head, except for
+ indefinite-length strings, arrays and maps where it is the number of
+ chunks, items or pairs found. uNext is the index of the entry after
+ this item and everything in it and uEnd is the offset after them,
+ including any break.
+
+ 64-bit machine size is 24 bytes
+ */
+typedef struct __QCBORTapeEntry {
+   // PRIVATE DATA STRUCTURE
+   uint64_t uArgument;
+   uint32_t uOffset;
+   uint32_t uNext;
+   uint32_t uEnd;
+   uint8_t  uInitialByte;
+} QCBORTapeEntry;
+
+
+/*
+ PRIVATE DATA STRUCTURE
+
+ Holds the tape built with QCBORTape_Build().
+ */
+struct _QCBORTape {
+   // PRIVATE DATA STRUCTURE
+   UsefulBufC      Encoded;
+   QCBORTapeEntry *pEntries;
+   uint32_t        uCount;
+};
+
+
+/*
+ PRIVATE DATA STRUCTURE
+
+ Reader for the items of a sequence set up with
+ QCBORSequence_Init(). uOffset is where the next item starts and uErr
+ is the error that stopped reading there, if any.
+ */
+struct _QCBORSequenceReader {
+   // PRIVATE DATA STRUCTURE
+   UsefulBufC Sequence;
+   size_t     uOffset;
+   uint8_t    uErr;
+};
+
+
+/*
+ PRIVATE DATA STRUCTURE
+
+ The start of each region of a QCBORArena. Region is the memory as it
+ was given to the arena and this header is at its start, aligned.
+ */
+typedef struct __QCBORArenaRegion {
+   // PRIVATE DATA STRUCTURE
+   struct __QCBORArenaRegion *pNext;
+   UsefulBuf                  Region;
+} QCBORArenaRegion;
+
+
+/*
+ PRIVATE DATA STRUCTURE
+
+ The arena string allocator. Regions are in a list from pFirst, the
+ initial one first if there is one. Allocations come from pCurrent
+ starting at pFree. pNewest is the most recent allocation which can
+ be resized or freed. uGrowth is the size of the next region to grow.
+ */
+struct _QCBORArena {
+   // PRIVATE DATA STRUCTURE
+   QCBORArenaRegion *pFirst;
+   QCBORArenaRegion *pCurrent;
+   QCBORArenaRegion *pInitial;
+   uint8_t          *pFree;
+   uint8_t          *pNewest;
+   size_t            uGrowth;
+   UsefulBuf       (*pfRegionAllocate)(void *pRegionCtx, size_t uSize);
+   void            (*pfRegionFree)(void *pRegionCtx, UsefulBuf Region);
+   void             *pRegionCtx;
+};
+
+
 typedef struct  {
    // PRIVATE DATA STRUCTURE
    void *pAllocateCxt;
@@ -304,8 +438,34 @@ struct _QCBORDecodeContext {
 #define QCBOR_MAP_OFFSET_CACHE_INVALID UINT32_MAX
    uint32_t uMapEndOffsetCache;
 
+#ifdef QCBOR_ENABLE_MAP_INDEX
+   // Label indexes of the current bounded map and the maps it is
+   // in, see QCBORDecode_SetMapIndex(). uMapIndexTop is the slot
+   // describing the last map indexed or QCBOR_MAP_INDEX_NONE.
+#define QCBOR_MAP_INDEX_UNUSABLE UINT32_MAX
+#define QCBOR_MAP_INDEX_NONE     UINT32_MAX
+   QCBORMapIndexEntry *pMapIndex;
+   uint32_t uMapIndexSize;  // Number of slots
+   uint32_t uMapIndexTop;
+#endif /* QCBOR_ENABLE_MAP_INDEX */
+
+#ifdef QCBOR_ENABLE_INCREMENTAL_INPUT
+   // Input added in chunks, see QCBORDecode_InitIncremental().
+   // InputBuffer.len is 0 when not in use. uInputEnd is the end of
+   // the input added so far, uInputDiscarded the number of bytes
+   // before the start of the buffer that were moved out of it.
+   UsefulBuf InputBuffer;
+   size_t    uInputDiscarded;
+   uint32_t  uInputEnd;
+   uint8_t   bInputComplete;
+#endif /* QCBOR_ENABLE_INCREMENTAL_INPUT */
+
    uint8_t  uDecodeMode;
    uint8_t  bStringAllocateAll;
+   uint8_t  bValidateUTF8;
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+   uint8_t  bCheckLabelOrder;
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
    uint8_t  uLastError;  // QCBORError stuffed into a uint8_t
 
    /* See MapTagNumber() for description of how tags are mapped. */
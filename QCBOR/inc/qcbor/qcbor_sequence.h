@@ -0,0 +1,245 @@
+/*==============================================================================
+ Copyright (c) 2016-2018, The Linux Foundation.
+ Copyright (c) 2018-2021, Laurence Lundblade.
+ Copyright (c) 2021, Arm Limited.
+ All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors, nor the name "Laurence Lundblade" may be used to
+      endorse or promote products derived from this software without
+      specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ =============================================================================*/
+
+
+#ifndef qcbor_sequence_h
+#define qcbor_sequence_h
+
+
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ @file qcbor_sequence.h
+
+ @anchor SequenceReader
+ # Sequence Reader
+
+ A CBOR sequence (RFC 8742) is CBOR data items one after another with
+ nothing in between, as is used for logs and archives that are
+ appended to. Such files may be much larger than the @ref
+ QCBOR_MAX_DECODE_INPUT_SIZE that QCBORDecode_Init() accepts even
+ though each item in them is small.
+
+ The sequence reader splits a sequence into its top-level items. It
+ finds the end of each item by reading only its heads and jumping over
+ string content. Items are given as a pointer and length into the
+ sequence, nothing is copied, and each can be decoded with its own
+ decode context. QCBORSequence_NextDecoder() does both.
+
+ The sequence is typically a memory-mapped file. Since the reader
+ goes through it once from start to end, the mapping should be
+ advised as sequential so the operating system reads ahead and drops
+ pages behind. On POSIX systems:
+
+ @code
+     int fd = open(szFileName, O_RDONLY);
+     struct stat st;
+     fstat(fd, &st);
+     void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+     madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+     QCBORSequenceReader Reader;
+     QCBORDecodeContext  DCtx;
+     QCBORSequence_Init(&Reader, (UsefulBufC){p, (size_t)st.st_size});
+     while(QCBORSequence_NextDecoder(&Reader, &DCtx, QCBOR_DECODE_MODE_NORMAL) == QCBOR_SUCCESS) {
+        // Decode one item with DCtx
+        uErr = QCBORDecode_Finish(&DCtx);
+     }
+ @endcode
+
+ Offsets in the sequence are @ref QCBORSequenceOffset. It is 32 bits
+ unless @c QCBOR_SEQUENCE_64BIT_OFFSETS is defined when building and
+ using QCBOR, so sequences are limited to @ref QCBOR_MAX_SEQUENCE_SIZE.
+ Each item must still be no larger than @ref
+ QCBOR_MAX_DECODE_INPUT_SIZE to be decoded.
+
+ Items are checked to be well-formed and within the nesting limit of
+ the decoder, as far as is needed to find their end. Nothing else is
+ checked. An error leaves the reader at the start of the item that is
+ in error. There's no finding where the next item starts after an
+ item that is not well-formed, but QCBORSequence_Seek() can go to an
+ offset that is known to be the start of one, for example from an
+ index kept with the file.
+ */
+
+
+#ifdef QCBOR_SEQUENCE_64BIT_OFFSETS
+/** Byte offset of an item in a sequence. */
+typedef uint64_t QCBORSequenceOffset;
+/** The largest sequence that QCBORSequence_Init() accepts. */
+#define QCBOR_MAX_SEQUENCE_SIZE SIZE_MAX
+#else /* QCBOR_SEQUENCE_64BIT_OFFSETS */
+typedef uint32_t QCBORSequenceOffset;
+#define QCBOR_MAX_SEQUENCE_SIZE QCBOR_MAX_DECODE_INPUT_SIZE
+#endif /* QCBOR_SEQUENCE_64BIT_OFFSETS */
+
+
+/** A reader set up with QCBORSequence_Init(). */
+typedef struct _QCBORSequenceReader QCBORSequenceReader;
+
+
+/**
+ @brief Set up a reader for a CBOR sequence.
+
+ @param[out] pReader   The reader to set up.
+ @param[in] Sequence   The encoded CBOR sequence.
+
+ If @c Sequence is larger than @ref QCBOR_MAX_SEQUENCE_SIZE,
+ QCBORSequence_Next() gives @ref QCBOR_ERR_INPUT_TOO_LARGE.
+
+ @c Sequence is not copied and must remain valid while items from it
+ are used.
+ */
+void QCBORSequence_Init(QCBORSequenceReader *pReader, UsefulBufC Sequence);
+
+
+/**
+ @brief Get the next item in a sequence.
+
+ @param[in] pReader  The reader.
+ @param[out] pItem   The encoded item. It points into the sequence.
+
+ @retval QCBOR_ERR_NO_MORE_ITEMS  The end of the sequence.
+ @retval QCBOR_ERR_INPUT_TOO_LARGE
+ @retval QCBOR_ERR_HIT_END
+ @retval QCBOR_ERR_UNSUPPORTED
+ @retval QCBOR_ERR_BAD_INT
+ @retval QCBOR_ERR_BAD_BREAK
+ @retval QCBOR_ERR_INDEFINITE_STRING_CHUNK
+ @retval QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP
+ @retval QCBOR_ERR_INDEF_LEN_STRINGS_DISABLED
+ @retval QCBOR_ERR_INDEF_LEN_ARRAYS_DISABLED
+
+ On success the reader is advanced to the item after. On error it
+ stays at the start of the item, which QCBORSequence_Tell() gives, and
+ the same error is returned again until QCBORSequence_Seek() is called.
+ */
+QCBORError QCBORSequence_Next(QCBORSequenceReader *pReader, UsefulBufC *pItem);
+
+
+/**
+ @brief Get the next item in a sequence and set up to decode it.
+
+ @param[in] pReader  The reader.
+ @param[out] pDCtx   The decode context to initialize for the item.
+ @param[in] nMode    See QCBORDecode_Init().
+
+ @retval QCBOR_ERR_INPUT_TOO_LARGE  The item is larger than @ref
+                                    QCBOR_MAX_DECODE_INPUT_SIZE.
+
+ Otherwise the same as QCBORSequence_Next(). The decode context is
+ only initialized when this succeeds. It may be configured further,
+ for example with QCBORDecode_SetMemPool(), before decoding.
+ */
+static QCBORError
+QCBORSequence_NextDecoder(QCBORSequenceReader *pReader,
+                          QCBORDecodeContext  *pDCtx,
+                          QCBORDecodeMode      nMode);
+
+
+/**
+ @brief Get the offset of the next item.
+
+ @param[in] pReader  The reader.
+
+ @return The offset of the item the next QCBORSequence_Next() gives,
+         or the size of the sequence at the end.
+ */
+static QCBORSequenceOffset QCBORSequence_Tell(const QCBORSequenceReader *pReader);
+
+
+/**
+ @brief Continue reading at an offset.
+
+ @param[in] pReader  The reader.
+ @param[in] uOffset  The offset of an item, usually one from
+                     QCBORSequence_Tell().
+
+ This clears the error of the reader. If @c uOffset is past the end
+ of the sequence, QCBORSequence_Next() gives @ref QCBOR_ERR_HIT_END.
+ */
+void QCBORSequence_Seek(QCBORSequenceReader *pReader, QCBORSequenceOffset uOffset);
+
+
+
+
+/* ===========================================================================
+   BEGINNING OF PRIVATE INLINE IMPLEMENTATION
+   ========================================================================== */
+
+static inline QCBORError
+QCBORSequence_NextDecoder(QCBORSequenceReader *pReader,
+                          QCBORDecodeContext  *pDCtx,
+                          QCBORDecodeMode      nMode)
+{
+   UsefulBufC Item;
+   QCBORError uErr;
+
+   uErr = QCBORSequence_Next(pReader, &Item);
+   if(uErr != QCBOR_SUCCESS) {
+      return uErr;
+   }
+   if(Item.len > QCBOR_MAX_DECODE_INPUT_SIZE) {
+      return QCBOR_ERR_INPUT_TOO_LARGE;
+   }
+   QCBORDecode_Init(pDCtx, Item, nMode);
+
+   return QCBOR_SUCCESS;
+}
+
+
+static inline QCBORSequenceOffset
+QCBORSequence_Tell(const QCBORSequenceReader *pReader)
+{
+   return (QCBORSequenceOffset)pReader->uOffset;
+}
+
+/* ===========================================================================
+   END OF PRIVATE INLINE IMPLEMENTATION
+   ========================================================================== */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_sequence_h */
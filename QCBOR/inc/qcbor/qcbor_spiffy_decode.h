@@ -561,7 +561,11 @@ static void QCBORDecode_GetDoubleConvertInMapSZ(QCBORDecodeContext *pCtx,
  returned as plus or minus zero or infinity rather than setting an
  under or overflow error.
 
- There is often loss of precision in the conversion.
+ There is often loss of precision in the conversion. Big numbers are
+ rounded to the nearest double. So are decimal fractions with a
+ mantissa less than 2^53 in magnitude and an exponent from -22 to 22,
+ which covers most prices and measurements. Other decimal fractions
+ may be off in the last bit.
 
  See also QCBORDecode_GetDoubleConvert() and QCBORDecode_GetDoubleConvert().
 */
@@ -640,6 +644,141 @@ static void QCBORDecode_ExitArray(QCBORDecodeContext *pCtx);
 
 
 
+/**
+ @brief Decode an array of integers into a C array of int64_t.
+
+ @param[in] pCtx          The decode context.
+ @param[out] pnValues     Where to put the integers.
+ @param[in] uMaxValues    The number of entries in @c pnValues.
+ @param[out] puNumValues  The number of integers put in @c pnValues.
+
+ This is the same as QCBORDecode_EnterArray(), then
+ QCBORDecode_GetInt64() for each item in the array, then
+ QCBORDecode_ExitArray(), in one call. The results and errors are
+ the same, but it is much faster for large arrays. Items that are
+ plain integers are decoded straight from the input without making a
+ @ref QCBORItem for each.
+
+ If the array has more than @c uMaxValues items @ref
+ QCBOR_ERR_ARRAY_DECODE_TOO_LONG is set. On error @c *puNumValues is
+ the number of entries filled in before the error, and the array is
+ not exited.
+
+ Please see @ref Decode-Errors-Overview "Decode Errors Overview".
+ */
+void QCBORDecode_GetInt64Array(QCBORDecodeContext *pCtx,
+                               int64_t            *pnValues,
+                               size_t              uMaxValues,
+                               size_t             *puNumValues);
+
+void QCBORDecode_GetInt64ArrayInMapN(QCBORDecodeContext *pCtx,
+                                     int64_t             nLabel,
+                                     int64_t            *pnValues,
+                                     size_t              uMaxValues,
+                                     size_t             *puNumValues);
+
+void QCBORDecode_GetInt64ArrayInMapSZ(QCBORDecodeContext *pCtx,
+                                      const char         *szLabel,
+                                      int64_t            *pnValues,
+                                      size_t              uMaxValues,
+                                      size_t             *puNumValues);
+
+
+/**
+ @brief Decode an array of integers into a C array of uint64_t.
+
+ @param[in] pCtx          The decode context.
+ @param[out] puValues     Where to put the integers.
+ @param[in] uMaxValues    The number of entries in @c puValues.
+ @param[out] puNumValues  The number of integers put in @c puValues.
+
+ This is QCBORDecode_GetInt64Array() for QCBORDecode_GetUInt64().
+ */
+void QCBORDecode_GetUInt64Array(QCBORDecodeContext *pCtx,
+                                uint64_t           *puValues,
+                                size_t              uMaxValues,
+                                size_t             *puNumValues);
+
+void QCBORDecode_GetUInt64ArrayInMapN(QCBORDecodeContext *pCtx,
+                                      int64_t             nLabel,
+                                      uint64_t           *puValues,
+                                      size_t              uMaxValues,
+                                      size_t             *puNumValues);
+
+void QCBORDecode_GetUInt64ArrayInMapSZ(QCBORDecodeContext *pCtx,
+                                       const char         *szLabel,
+                                       uint64_t           *puValues,
+                                       size_t              uMaxValues,
+                                       size_t             *puNumValues);
+
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+/**
+ @brief Decode an array of floating-point values into a C array of double.
+
+ @param[in] pCtx          The decode context.
+ @param[out] pdValues     Where to put the values.
+ @param[in] uMaxValues    The number of entries in @c pdValues.
+ @param[out] puNumValues  The number of values put in @c pdValues.
+
+ This is QCBORDecode_GetInt64Array() for QCBORDecode_GetDouble().
+ Half-precision values are collected as they are decoded and widened
+ in blocks rather than one at a time.
+ */
+void QCBORDecode_GetDoubleArray(QCBORDecodeContext *pCtx,
+                                double             *pdValues,
+                                size_t              uMaxValues,
+                                size_t             *puNumValues);
+
+void QCBORDecode_GetDoubleArrayInMapN(QCBORDecodeContext *pCtx,
+                                      int64_t             nLabel,
+                                      double             *pdValues,
+                                      size_t              uMaxValues,
+                                      size_t             *puNumValues);
+
+void QCBORDecode_GetDoubleArrayInMapSZ(QCBORDecodeContext *pCtx,
+                                       const char         *szLabel,
+                                       double             *pdValues,
+                                       size_t              uMaxValues,
+                                       size_t             *puNumValues);
+
+
+/**
+ @brief Decode an array of floating-point values into a C array of float.
+
+ @param[in] pCtx          The decode context.
+ @param[out] pfValues     Where to put the values.
+ @param[in] uMaxValues    The number of entries in @c pfValues.
+ @param[out] puNumValues  The number of values put in @c pfValues.
+
+ This is the same as QCBORDecode_GetDoubleArray() except for the
+ type of the values. Half- and single-precision values always fit. A
+ double-precision value is accepted only if it converts to a float
+ without loss, otherwise @ref QCBOR_ERR_FLOAT_EXCEPTION is set. A
+ double-precision NaN is narrowed as by a cast. If floating-point HW
+ use is disabled, double-precision values set @ref
+ QCBOR_ERR_HW_FLOAT_DISABLED.
+ */
+void QCBORDecode_GetFloatArray(QCBORDecodeContext *pCtx,
+                               float              *pfValues,
+                               size_t              uMaxValues,
+                               size_t             *puNumValues);
+
+void QCBORDecode_GetFloatArrayInMapN(QCBORDecodeContext *pCtx,
+                                     int64_t             nLabel,
+                                     float              *pfValues,
+                                     size_t              uMaxValues,
+                                     size_t             *puNumValues);
+
+void QCBORDecode_GetFloatArrayInMapSZ(QCBORDecodeContext *pCtx,
+                                      const char         *szLabel,
+                                      float              *pfValues,
+                                      size_t              uMaxValues,
+                                      size_t             *puNumValues);
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+
+
 
 /**
  @brief Enter a map for decoding and searching.
@@ -695,6 +834,52 @@ void QCBORDecode_EnterMapFromMapN(QCBORDecodeContext *pCtx, int64_t nLabel);
 void QCBORDecode_EnterMapFromMapSZ(QCBORDecodeContext *pCtx, const char *szLabel);
 
 
+#ifdef QCBOR_ENABLE_MAP_INDEX
+/** The memory needed per map label for QCBORDecode_SetMapIndex(). */
+#define QCBOR_MAP_INDEX_BYTES_PER_LABEL sizeof(QCBORMapIndexEntry)
+
+/**
+ @brief Provide memory for indexing the labels of entered maps.
+
+ @param[in] pCtx         The decode context.
+ @param[in] IndexBuffer  Memory for the index. @ref
+                         QCBOR_MAP_INDEX_BYTES_PER_LABEL bytes per
+                         label and per map plus up to 7 bytes for
+                         alignment.
+
+ Without an index, every QCBORDecode_GetXxxxInMapX() call decodes
+ the whole entered map, so looking up all the labels of a map is
+ quadratic. With an index, the labels and their offsets are recorded
+ in one traversal when a map is entered with QCBORDecode_EnterMap(),
+ QCBORDecode_EnterMapFromMapN() or such. Lookups then binary search
+ the index and decode only the item found. The index is kept in the
+ sort order of deterministically encoded (D-CBOR) maps so these need
+ no sorting. Other maps are sorted in place. A small non-negative
+ integer label that equals its position in the index is found
+ directly.
+
+ The indexes of the maps the entered map is in are kept, so after
+ QCBORDecode_ExitMap() returns to an enclosing map its lookups use
+ the index already built. Entering and exiting each of N maps in a map
+ is thus linear, not quadratic. The buffer must hold the labels of all
+ the maps entered at once for this. When the labels of a nested map
+ don't fit after those of the maps it is in, it is indexed in their
+ place and an enclosing map is indexed again on its next lookup.
+
+ The results, including duplicate detection and errors, are the same
+ as without an index. Maps with more labels than fit in @c
+ IndexBuffer, maps with any item in error and string labels that
+ were allocated are searched without the index.
+
+ The memory must remain valid until decoding is finished. It is not
+ used in @ref QCBOR_DECODE_MODE_MAP_AS_ARRAY. The index and this
+ function are only available when QCBOR_ENABLE_MAP_INDEX is defined,
+ which makes @ref QCBORDecodeContext larger.
+ */
+void QCBORDecode_SetMapIndex(QCBORDecodeContext *pCtx, UsefulBuf IndexBuffer);
+#endif /* QCBOR_ENABLE_MAP_INDEX */
+
+
 /**
  @brief Exit a map that has been enetered.
 
@@ -838,6 +1023,47 @@ void QCBORDecode_GetItemInMapSZ(QCBORDecodeContext *pCtx,
 void QCBORDecode_GetItemsInMap(QCBORDecodeContext *pCtx, QCBORItem *pItemList);
 
 
+/**
+ @brief Get a group of labeled items all at once from a sorted map
+
+ @param[in] pCtx   The decode context.
+ @param[in,out] pItemList  On input the items to search for. On output the returned items.
+
+ This works like QCBORDecode_GetItemsInMap() for maps whose labels
+ are in the deterministic order of RFC 8949 section 4.2.1, as they are
+ in D-CBOR. Items may not be found in maps that are not sorted, so use
+ this only for maps that are known to be deterministically encoded.
+
+ The labels in @c pItemList are sorted the same way. They can be in
+ any order as the results are returned in the order given. The map is
+ then walked once, matching its labels against the sorted labels.
+ Duplicates of the labels searched for are detected and those of
+ other labels are not, as with QCBORDecode_GetItemsInMap().
+
+ These are the differences from QCBORDecode_GetItemsInMap():
+
+ - @ref QCBOR_ERR_UNSORTED_LABEL is set if labels out of order are
+   encountered.
+
+ - The walk stops at the first label in the map past the largest
+   label searched for. The items after it are not decoded, so their
+   errors are not reported and their labels are not checked for
+   order.
+
+ - The cursor is not changed. QCBORDecode_GetItemsInMap() leaves it
+   at the end of the map.
+
+ Integer, byte string and text string labels can be searched for.
+ @c pItemList can have at most 64 items. @ref
+ QCBOR_ERR_ARRAY_DECODE_TOO_LONG is set if there are more.
+
+ If an index has been set up with QCBORDecode_SetMapIndex(), it is
+ used instead of walking the map and the labels in the map need not
+ be in order.
+ */
+void QCBORDecode_GetItemsInSortedMap(QCBORDecodeContext *pCtx, QCBORItem *pItemList);
+
+
 /**
  @brief Per-item callback for map searching.
 
@@ -0,0 +1,330 @@
+/*==============================================================================
+ Copyright (c) 2016-2018, The Linux Foundation.
+ Copyright (c) 2018-2021, Laurence Lundblade.
+ Copyright (c) 2021, Arm Limited.
+ All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors, nor the name "Laurence Lundblade" may be used to
+      endorse or promote products derived from this software without
+      specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ =============================================================================*/
+
+
+#ifndef qcbor_tape_h
+#define qcbor_tape_h
+
+
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ @file qcbor_tape.h
+
+ @anchor Tape
+ # Tape
+
+ QCBORDecode_GetNext() and spiffy decode traverse the encoded CBOR
+ in order. Getting many items out of a large document by label
+ traverses the same maps over and over, even with
+ QCBORDecode_SetMapIndex(), which only indexes one map at a time.
+
+ A tape is built in one sequential pass over the input. It has one
+ entry per data item in document order. Map labels, tag numbers and
+ the chunks of indefinite-length strings each get an entry of their
+ own. Each entry records where the item is in the input, its major
+ type, its argument and where the entries for everything inside it
+ end. From any entry, the next sibling and the first child are found
+ without looking at the input. Values are decoded from the input only
+ when they are asked for with QCBORTape_GetItem().
+
+ Entries are identified by their index in the tape. The first item
+ in the input is at index 0. For an entry at index @c i:
+
+ - The first child of an array, map, tag or indefinite-length string
+   is at <tt>i + 1</tt>.
+ - QCBORTape_Next() gives the entry after @c i and everything in it,
+   the next sibling. The children of @c i are the entries from <tt>i
+   + 1</tt> up to QCBORTape_Next(). For other items this is <tt>i +
+   1</tt>.
+ - The children of a map alternate label and value.
+ - A tag has one child, the item it tags, which may be another tag.
+
+ The input may be a CBOR sequence (RFC 8742). The top-level items are
+ then siblings and the last QCBORTape_Next() is QCBORTape_Count().
+
+ For example, to get the value of label 7 in the map that is the
+ second item of the top-level array:
+
+ @code
+     QCBORTapeEntry Entries[100];
+     QCBORTape      Tape;
+     uint32_t       uIndex;
+     QCBORItem      Item;
+
+     uErr = QCBORTape_Build(&Tape, Encoded, UsefulBuf_FROM_BYTE_ARRAY(Entries));
+     uIndex = QCBORTape_Next(&Tape, 1);
+     uErr = QCBORTape_GetInMapN(&Tape, uIndex, 7, &uIndex);
+     uErr = QCBORTape_GetItem(&Tape, uIndex, &Item);
+ @endcode
+
+ Building checks that the input is well-formed and within the limits
+ of this implementation. Nothing else is checked. Tag content, UTF-8
+ and duplicate labels are not. The whole input must be well-formed;
+ there is no partial tape.
+
+ The tape refers to the input, which must remain valid while the tape
+ is used.
+ */
+
+
+/** A tape built with QCBORTape_Build(). */
+typedef struct _QCBORTape QCBORTape;
+
+
+/**
+ The memory needed per data item for QCBORTape_Build(). There are never
+ more items than bytes of input.
+ */
+#define QCBOR_TAPE_BYTES_PER_ITEM sizeof(QCBORTapeEntry)
+
+
+/**
+ The maximum nesting of arrays, maps, tags and indefinite-length
+ strings in QCBORTape_Build(). A tag and the item it tags count as two
+ levels. Deeper nesting is @ref QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP.
+ */
+#define QCBOR_TAPE_MAX_NESTING 32
+
+
+/**
+ @brief Build the tape for some encoded CBOR.
+
+ @param[out] pTape         The tape to build.
+ @param[in] Encoded        The CBOR to index.
+ @param[in] TapeBuffer     Memory for the tape entries, @ref
+                           QCBOR_TAPE_BYTES_PER_ITEM per data item plus
+                           up to 7 bytes for alignment.
+
+ @retval QCBOR_ERR_TAPE_TOO_SMALL  More items than fit in @c TapeBuffer.
+ @retval QCBOR_ERR_INPUT_TOO_LARGE
+ @retval QCBOR_ERR_UNSUPPORTED
+ @retval QCBOR_ERR_HIT_END
+ @retval QCBOR_ERR_BAD_INT
+ @retval QCBOR_ERR_BAD_BREAK
+ @retval QCBOR_ERR_BAD_TYPE_7
+ @retval QCBOR_ERR_INDEFINITE_STRING_CHUNK
+ @retval QCBOR_ERR_ARRAY_DECODE_TOO_LONG
+ @retval QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP
+ @retval QCBOR_ERR_INDEF_LEN_STRINGS_DISABLED
+ @retval QCBOR_ERR_INDEF_LEN_ARRAYS_DISABLED
+
+ This reads every head in the input once and jumps over string
+ content. @c Encoded may be empty, giving a tape with no entries. On
+ error the tape has no entries.
+
+ The memory needed can be bounded before any decoding by the length of
+ the input. Exactly what is needed is QCBORTape_Count() times @ref
+ QCBOR_TAPE_BYTES_PER_ITEM.
+ */
+QCBORError QCBORTape_Build(QCBORTape *pTape, UsefulBufC Encoded, UsefulBuf TapeBuffer);
+
+
+/**
+ @brief The number of entries in the tape.
+
+ @param[in] pTape  The tape.
+
+ @return The index one past the last entry.
+ */
+static uint32_t QCBORTape_Count(const QCBORTape *pTape);
+
+
+/**
+ @brief Get the entry after an item and everything in it.
+
+ @param[in] pTape   The tape.
+ @param[in] uIndex  The index of the item. Must be less than
+                    QCBORTape_Count().
+
+ @return The index of the next sibling or the end of the enclosing
+         item's children.
+ */
+static uint32_t QCBORTape_Next(const QCBORTape *pTape, uint32_t uIndex);
+
+
+/**
+ @brief Get the CBOR major type of an entry.
+
+ @param[in] pTape   The tape.
+ @param[in] uIndex  The index of the item. Must be less than
+                    QCBORTape_Count().
+
+ @return @c CBOR_MAJOR_TYPE_XXX, 0 to 7.
+ */
+static uint8_t QCBORTape_MajorType(const QCBORTape *pTape, uint32_t uIndex);
+
+
+/**
+ @brief Get the argument of an entry.
+
+ @param[in] pTape   The tape.
+ @param[in] uIndex  The index of the item. Must be less than
+                    QCBORTape_Count().
+
+ @return The integer value, the string length, the number of array
+         items or map pairs, or the tag number. For indefinite-length
+         strings, arrays and maps it is the number of chunks, items or
+         pairs that were found.
+ */
+static uint64_t QCBORTape_Argument(const QCBORTape *pTape, uint32_t uIndex);
+
+
+/**
+ @brief Get the encoded CBOR of an item and everything in it.
+
+ @param[in] pTape   The tape.
+ @param[in] uIndex  The index of the item. Must be less than
+                    QCBORTape_Count().
+
+ @return The encoded item, for example to hash or copy it.
+ */
+UsefulBufC QCBORTape_GetEncoded(const QCBORTape *pTape, uint32_t uIndex);
+
+
+/**
+ @brief Decode the value of an entry.
+
+ @param[in] pTape   The tape.
+ @param[in] uIndex  The index of the item.
+ @param[out] pItem  The decoded item.
+
+ @retval QCBOR_ERR_NO_MORE_ITEMS   @c uIndex is past the end of the tape.
+ @retval QCBOR_ERR_INT_OVERFLOW
+ @retval QCBOR_ERR_HALF_PRECISION_DISABLED
+ @retval QCBOR_ERR_ALL_FLOAT_DISABLED
+
+ Only the value is filled in, like QCBORDecode_GetNext() would for
+ the item without its label and tags. Strings point into the input.
+ For tags, the tagged item is decoded; the tag numbers are
+ QCBORTape_Argument() of the tag entries. For arrays and maps @c
+ val.uCount is the number of items or pairs, also when they are
+ indefinite-length if the count fits. For indefinite-length strings
+ the string is @ref QCBOR_STRING_LENGTH_INDEFINITE and the chunks are
+ the children of the entry.
+ */
+QCBORError QCBORTape_GetItem(const QCBORTape *pTape, uint32_t uIndex, QCBORItem *pItem);
+
+
+/**
+ @brief Find the value for an integer label in a map.
+
+ @param[in] pTape          The tape.
+ @param[in] uMapIndex      The index of the map.
+ @param[in] nLabel         The label to look for.
+ @param[out] puValueIndex  The index of the value.
+
+ @retval QCBOR_ERR_UNEXPECTED_TYPE  @c uMapIndex is not a map.
+ @retval QCBOR_ERR_LABEL_NOT_FOUND
+
+ The labels are compared from the tape without decoding anything and
+ values are stepped over in one step. If the label occurs more than
+ once, the first is found.
+ */
+QCBORError QCBORTape_GetInMapN(const QCBORTape *pTape,
+                               uint32_t         uMapIndex,
+                               int64_t          nLabel,
+                               uint32_t        *puValueIndex);
+
+
+/**
+ @brief Find the value for a text string label in a map.
+
+ @param[in] pTape          The tape.
+ @param[in] uMapIndex      The index of the map.
+ @param[in] szLabel        The label to look for.
+ @param[out] puValueIndex  The index of the value.
+
+ @retval QCBOR_ERR_UNEXPECTED_TYPE  @c uMapIndex is not a map.
+ @retval QCBOR_ERR_LABEL_NOT_FOUND
+
+ See QCBORTape_GetInMapN(). Indefinite-length labels are not matched.
+ */
+QCBORError QCBORTape_GetInMapSZ(const QCBORTape *pTape,
+                                uint32_t         uMapIndex,
+                                const char      *szLabel,
+                                uint32_t        *puValueIndex);
+
+
+
+
+/* ===========================================================================
+   BEGINNING OF PRIVATE INLINE IMPLEMENTATION
+   ========================================================================== */
+
+static inline uint32_t
+QCBORTape_Count(const QCBORTape *pTape)
+{
+   return pTape->uCount;
+}
+
+
+static inline uint32_t
+QCBORTape_Next(const QCBORTape *pTape, uint32_t uIndex)
+{
+   return pTape->pEntries[uIndex].uNext;
+}
+
+
+static inline uint8_t
+QCBORTape_MajorType(const QCBORTape *pTape, uint32_t uIndex)
+{
+   return (uint8_t)(pTape->pEntries[uIndex].uInitialByte >> 5);
+}
+
+
+static inline uint64_t
+QCBORTape_Argument(const QCBORTape *pTape, uint32_t uIndex)
+{
+   return pTape->pEntries[uIndex].uArgument;
+}
+
+/* ===========================================================================
+   END OF PRIVATE INLINE IMPLEMENTATION
+   ========================================================================== */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_tape_h */
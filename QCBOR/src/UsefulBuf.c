@@ -59,6 +59,11 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "UsefulBuf.h"
 
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define USEFULBUF_UTF8_SSSE3
+#endif
+
 // used to catch use of uninitialized or corrupted UsefulOutBuf
 #define USEFUL_OUT_BUF_MAGIC  (0x0B0F)
 
@@ -121,6 +126,192 @@ size_t UsefulBuf_IsValue(const UsefulBufC UB, uint8_t uValue)
 }
 
 
+#ifdef USEFULBUF_UTF8_SSSE3
+
+/* Error classes for a pair of consecutive bytes. A pair is invalid if
+ * the same class is present in all three lookup tables.
+ */
+#define UTF8_TOO_SHORT   0x01 /* 11______ 0_______ or 11______ 11______ */
+#define UTF8_TOO_LONG    0x02 /* 0_______ 10______ */
+#define UTF8_OVERLONG_3  0x04 /* 11100000 100_____ */
+#define UTF8_TOO_LARGE   0x08 /* 11110100 1001____ and above */
+#define UTF8_SURROGATE   0x10 /* 11101101 101_____ */
+#define UTF8_OVERLONG_2  0x20 /* 1100000_ 10______ */
+#define UTF8_OVERLONG_4  0x40 /* 11110000 1000____, also 11110101+ 1000____ */
+#define UTF8_TWO_CONTS   0x80 /* 10______ 10______ */
+
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+#define UTF8_4_BIG (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_OVERLONG_4)
+
+static inline __m128i
+UTF8HighNibbles(__m128i Bytes)
+{
+   return _mm_and_si128(_mm_srli_epi16(Bytes, 4), _mm_set1_epi8(0x0f));
+}
+
+
+/* Returns non-zero lanes for errors in Input given the previous 16 bytes. */
+static inline __m128i
+UTF8CheckBlock(__m128i Input, __m128i Previous)
+{
+   const __m128i Byte1High = _mm_setr_epi8(
+      UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+      UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+      (char)UTF8_TWO_CONTS, (char)UTF8_TWO_CONTS,
+      (char)UTF8_TWO_CONTS, (char)UTF8_TWO_CONTS,
+      UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+      UTF8_TOO_SHORT,
+      UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+      UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_OVERLONG_4);
+   const __m128i Byte1Low = _mm_setr_epi8(
+      (char)(UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4),
+      (char)(UTF8_CARRY | UTF8_OVERLONG_2),
+      (char)UTF8_CARRY,
+      (char)UTF8_CARRY,
+      (char)(UTF8_CARRY | UTF8_TOO_LARGE),
+      (char)UTF8_4_BIG, (char)UTF8_4_BIG, (char)UTF8_4_BIG,
+      (char)UTF8_4_BIG, (char)UTF8_4_BIG, (char)UTF8_4_BIG,
+      (char)UTF8_4_BIG, (char)UTF8_4_BIG,
+      (char)(UTF8_4_BIG | UTF8_SURROGATE),
+      (char)UTF8_4_BIG, (char)UTF8_4_BIG);
+   const __m128i Byte2High = _mm_setr_epi8(
+      UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+      UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+      (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_OVERLONG_4),
+      (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE),
+      (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+      (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+      UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT);
+
+   const __m128i Prev1 = _mm_alignr_epi8(Input, Previous, 15);
+   const __m128i Special =
+      _mm_and_si128(_mm_and_si128(_mm_shuffle_epi8(Byte1High, UTF8HighNibbles(Prev1)),
+                                  _mm_shuffle_epi8(Byte1Low, _mm_and_si128(Prev1, _mm_set1_epi8(0x0f)))),
+                    _mm_shuffle_epi8(Byte2High, UTF8HighNibbles(Input)));
+
+   /* The third and fourth bytes of a sequence are where two
+    * continuation bytes in a row are expected.
+    */
+   const __m128i Third  = _mm_subs_epu8(_mm_alignr_epi8(Input, Previous, 14),
+                                        _mm_set1_epi8((char)(0xe0 - 0x80)));
+   const __m128i Fourth = _mm_subs_epu8(_mm_alignr_epi8(Input, Previous, 13),
+                                        _mm_set1_epi8((char)(0xf0 - 0x80)));
+   const __m128i Expected = _mm_and_si128(_mm_or_si128(Third, Fourth), _mm_set1_epi8((char)0x80));
+
+   return _mm_xor_si128(Expected, Special);
+}
+
+
+/*
+ Public function -- see UsefulBuf.h
+ */
+int UsefulBuf_IsValidUTF8(UsefulBufC UB)
+{
+   /* Non-zero for lead bytes in the last three positions that need
+    * bytes from the next block. */
+   const __m128i IncompleteLimit = _mm_setr_epi8(
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      (char)(0xf0 - 1), (char)(0xe0 - 1), (char)(0xc0 - 1));
+   const uint8_t *pBytes = (const uint8_t *)UB.ptr;
+   __m128i Error      = _mm_setzero_si128();
+   __m128i Previous   = _mm_setzero_si128();
+   __m128i Incomplete = _mm_setzero_si128();
+   size_t  uOffset;
+
+   for(uOffset = 0; uOffset + 16 <= UB.len; uOffset += 16) {
+      const __m128i Input = _mm_loadu_si128((const __m128i *)(pBytes + uOffset));
+      if(_mm_movemask_epi8(Input) == 0) {
+         /* All ASCII. Only check that the previous block was complete. */
+         Error = _mm_or_si128(Error, Incomplete);
+      } else {
+         Error      = _mm_or_si128(Error, UTF8CheckBlock(Input, Previous));
+         Incomplete = _mm_subs_epu8(Input, IncompleteLimit);
+      }
+      Previous = Input;
+   }
+
+   if(uOffset < UB.len) {
+      /* Zero padding makes a truncated sequence at the end fail */
+      uint8_t uTail[16] = {0};
+      memcpy(uTail, pBytes + uOffset, UB.len - uOffset);
+      Error = _mm_or_si128(Error, UTF8CheckBlock(_mm_loadu_si128((const __m128i *)uTail), Previous));
+   } else {
+      Error = _mm_or_si128(Error, Incomplete);
+   }
+
+   return _mm_movemask_epi8(_mm_cmpeq_epi8(Error, _mm_setzero_si128())) == 0xffff;
+}
+
+#else /* USEFULBUF_UTF8_SSSE3 */
+
+/*
+ Public function -- see UsefulBuf.h
+ */
+int UsefulBuf_IsValidUTF8(UsefulBufC UB)
+{
+   const uint8_t *pBytes = (const uint8_t *)UB.ptr;
+   size_t         uOffset = 0;
+
+   while(uOffset < UB.len) {
+      if(pBytes[uOffset] < 0x80) {
+         /* Skip ASCII eight bytes at a time when possible */
+         uint64_t uWord;
+         while(uOffset + 8 <= UB.len) {
+            memcpy(&uWord, pBytes + uOffset, sizeof(uWord));
+            if(uWord & 0x8080808080808080ULL) {
+               break;
+            }
+            uOffset += 8;
+         }
+         while(uOffset < UB.len && pBytes[uOffset] < 0x80) {
+            uOffset++;
+         }
+         continue;
+      }
+
+      const uint8_t uLead  = pBytes[uOffset];
+      uint8_t       uLower = 0x80;
+      uint8_t       uUpper = 0xbf;
+      size_t        uTrailing;
+      if(uLead >= 0xc2 && uLead <= 0xdf) {
+         uTrailing = 1;
+      } else if(uLead >= 0xe0 && uLead <= 0xef) {
+         uTrailing = 2;
+         if(uLead == 0xe0) {
+            uLower = 0xa0; /* Overlong */
+         } else if(uLead == 0xed) {
+            uUpper = 0x9f; /* Surrogate */
+         }
+      } else if(uLead >= 0xf0 && uLead <= 0xf4) {
+         uTrailing = 3;
+         if(uLead == 0xf0) {
+            uLower = 0x90; /* Overlong */
+         } else if(uLead == 0xf4) {
+            uUpper = 0x8f; /* Above U+10FFFF */
+         }
+      } else {
+         return 0;
+      }
+
+      if(UB.len - uOffset <= uTrailing ||
+         pBytes[uOffset + 1] < uLower ||
+         pBytes[uOffset + 1] > uUpper) {
+         return 0;
+      }
+      for(size_t uIndex = 2; uIndex <= uTrailing; uIndex++) {
+         if((pBytes[uOffset + uIndex] & 0xc0) != 0x80) {
+            return 0;
+         }
+      }
+      uOffset += 1 + uTrailing;
+   }
+
+   return 1;
+}
+
+#endif /* USEFULBUF_UTF8_SSSE3 */
+
+
 /*
  Public function -- see UsefulBuf.h
  */
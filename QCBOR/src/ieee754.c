@@ -22,6 +22,18 @@
 #include "ieee754.h"
 #include <string.h> // For memcpy()
 
+/*
+ The SIMD kernels of the block conversions are each compiled for their
+ instruction set with a target attribute, so no compiler flags are
+ needed, and are only called after checking that the CPU has it.
+ */
+#if !defined(QCBOR_DISABLE_FLOAT_SIMD) && !defined(QCBOR_DISABLE_FLOAT_HW_USE) && \
+    defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IEEE754_X86_KERNELS
+#include <immintrin.h>
+#define IEEE754_TARGET(x) __attribute__((target(x)))
+#endif
+
 
 /*
  This code is written for clarity and verifiability, not for size, on
@@ -333,10 +345,70 @@ uint16_t IEEE754_DoubleToHalf(double d)
 }
 
 
-/*
-  EEE754_HalfToFloat() was created but is not needed. It can be retrieved from
-  github history if needed.
- */
+static inline float CopyUint32ToFloat(uint32_t u32)
+{
+    float f;
+    memcpy(&f, &u32, sizeof(uint32_t));
+    return f;
+}
+
+
+// Public function; see ieee754.h
+float IEEE754_HalfToFloat(uint16_t uHalfPrecision)
+{
+    // Pull out the three parts of the half-precision float
+    const uint32_t uHalfSignificand      = uHalfPrecision & HALF_SIGNIFICAND_MASK;
+    const int32_t  nHalfUnBiasedExponent = (int32_t)((uHalfPrecision & HALF_EXPONENT_MASK) >> HALF_EXPONENT_SHIFT) - HALF_EXPONENT_BIAS;
+    const uint32_t uHalfSign             = (uHalfPrecision & HALF_SIGN_MASK) >> HALF_SIGN_SHIFT;
+
+
+    // Make the three parts of the single-precision number
+    uint32_t uSingleSignificand, uSingleBiasedExponent;
+    if(nHalfUnBiasedExponent == HALF_EXPONENT_ZERO) {
+        // 0 or subnormal
+        uSingleBiasedExponent = SINGLE_EXPONENT_ZERO + SINGLE_EXPONENT_BIAS;
+        if(uHalfSignificand) {
+            // Subnormal case. Like for double, a half-precision
+            // subnormal is always a normal single-precision float.
+            uSingleBiasedExponent = -HALF_EXPONENT_BIAS + SINGLE_EXPONENT_BIAS +1;
+            uSingleSignificand = uHalfSignificand;
+            do {
+                uSingleSignificand <<= 1;
+                uSingleBiasedExponent--;
+            } while ((uSingleSignificand & 0x400) == 0);
+            uSingleSignificand &= HALF_SIGNIFICAND_MASK;
+            uSingleSignificand <<= (SINGLE_NUM_SIGNIFICAND_BITS - HALF_NUM_SIGNIFICAND_BITS);
+        } else {
+            // Just zero
+            uSingleSignificand = 0;
+        }
+    } else if(nHalfUnBiasedExponent == HALF_EXPONENT_INF_OR_NAN) {
+        // NaN or Inifinity
+        uSingleBiasedExponent = SINGLE_EXPONENT_INF_OR_NAN + SINGLE_EXPONENT_BIAS;
+        if(uHalfSignificand) {
+            // NaN. Payload is aligned on the LSB, qNaN bit copied
+            // explicitly, the same as IEEE754_HalfToDouble().
+            uSingleSignificand = uHalfSignificand & ~HALF_QUIET_NAN_BIT;
+            if(uHalfSignificand & HALF_QUIET_NAN_BIT) {
+                uSingleSignificand |= SINGLE_QUIET_NAN_BIT;
+            }
+        } else {
+            // Infinity
+            uSingleSignificand = 0;
+        }
+    } else {
+        // Normal number
+        uSingleBiasedExponent = (uint32_t)(nHalfUnBiasedExponent + SINGLE_EXPONENT_BIAS);
+        uSingleSignificand    = uHalfSignificand << (SINGLE_NUM_SIGNIFICAND_BITS - HALF_NUM_SIGNIFICAND_BITS);
+    }
+
+
+    // Shift the 3 parts into place as a single-precision
+    const uint32_t uSingle = uSingleSignificand |
+                            (uSingleBiasedExponent << SINGLE_EXPONENT_SHIFT) |
+                            (uHalfSign << SINGLE_SIGN_SHIFT);
+    return CopyUint32ToFloat(uSingle);
+}
 
 
 // Public function; see ieee754.h
@@ -408,6 +480,212 @@ double IEEE754_HalfToDouble(uint16_t uHalfPrecision)
 
 
 
+static int nKernelLimit = IEEE754_KERNEL_AVX2;
+
+// Public function; see ieee754.h
+void IEEE754_LimitKernel(int nKernel)
+{
+    nKernelLimit = nKernel;
+}
+
+
+// Public function; see ieee754.h
+int IEEE754_Kernel(void)
+{
+    int nKernel = IEEE754_KERNEL_PORTABLE;
+
+#ifdef IEEE754_X86_KERNELS
+    // These read what libgcc or compiler-rt found out at start up,
+    // including whether the OS saves the AVX registers.
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+        nKernel = IEEE754_KERNEL_AVX2;
+    } else if(__builtin_cpu_supports("sse2")) {
+        nKernel = IEEE754_KERNEL_SSE2;
+    }
+#endif
+
+    return nKernel < nKernelLimit ? nKernel : nKernelLimit;
+}
+
+
+// The most values a kernel does at once. Fewer than this go straight
+// to the one-at-a-time code.
+#define KERNEL_GROUP 8
+
+
+#ifdef IEEE754_X86_KERNELS
+
+// Whether any of 8 half-precision values is a NaN.
+IEEE754_TARGET("sse2")
+static inline int HalvesHaveNaN(__m128i Halves)
+{
+    const __m128i Magnitude = _mm_and_si128(Halves, _mm_set1_epi16(0x7fff));
+    // Signed compare is OK as the sign bit is masked off
+    return _mm_movemask_epi8(_mm_cmpgt_epi16(Magnitude, _mm_set1_epi16((short)HALF_EXPONENT_MASK)));
+}
+
+
+// Each of the kernels returns how many values it did. It stops at the
+// end or at a group of values with a NaN in it. The one-at-a-time code
+// does the group and the kernel is called again for the rest. Calling
+// the one-at-a-time code from within a kernel would run it with the
+// upper halves of the AVX registers in use, which is very slow on some
+// CPUs.
+
+IEEE754_TARGET("avx2,f16c")
+static size_t HalfToFloatAvx2(const uint16_t *puHalves, float *pfValues, size_t uCount)
+{
+    size_t i;
+    for(i = 0; i + 8 <= uCount; i += 8) {
+        const __m128i Halves = _mm_loadu_si128((const __m128i *)&puHalves[i]);
+        if(HalvesHaveNaN(Halves)) {
+            break;
+        }
+        _mm256_storeu_ps(&pfValues[i], _mm256_cvtph_ps(Halves));
+    }
+    return i;
+}
+
+
+IEEE754_TARGET("avx2,f16c")
+static size_t HalfToDoubleAvx2(const uint16_t *puHalves, double *pdValues, size_t uCount)
+{
+    size_t i;
+    for(i = 0; i + 8 <= uCount; i += 8) {
+        const __m128i Halves = _mm_loadu_si128((const __m128i *)&puHalves[i]);
+        if(HalvesHaveNaN(Halves)) {
+            break;
+        }
+        // Widening float to double is exact for all but NaN
+        const __m256 Floats = _mm256_cvtph_ps(Halves);
+        _mm256_storeu_pd(&pdValues[i],     _mm256_cvtps_pd(_mm256_castps256_ps128(Floats)));
+        _mm256_storeu_pd(&pdValues[i + 4], _mm256_cvtps_pd(_mm256_extractf128_ps(Floats, 1)));
+    }
+    return i;
+}
+
+
+// Converts 4 half-precision values, zero-extended to 32 bits, that
+// are not NaN to single-precision. The exponent is rebiased, again for
+// infinity, and subnormals are normalized by subtracting the value
+// their bits have with the exponent of the smallest normal.  The
+// subtraction is exact and its result normal, so it is not affected
+// by rounding or flush-to-zero modes.
+IEEE754_TARGET("sse2")
+static inline __m128 HalfToFloatSse2Lanes(__m128i Halves)
+{
+    const __m128i Rebias   = _mm_set1_epi32((SINGLE_EXPONENT_BIAS - HALF_EXPONENT_BIAS) << SINGLE_EXPONENT_SHIFT);
+    const __m128i InfOrNaN = _mm_set1_epi32((int)HALF_EXPONENT_MASK << (SINGLE_NUM_SIGNIFICAND_BITS - HALF_NUM_SIGNIFICAND_BITS));
+    const __m128i Sign     = _mm_slli_epi32(_mm_and_si128(Halves, _mm_set1_epi32(HALF_SIGN_MASK)), SINGLE_SIGN_SHIFT - HALF_SIGN_SHIFT);
+
+    __m128i Bits = _mm_slli_epi32(_mm_and_si128(Halves, _mm_set1_epi32(0x7fff)), SINGLE_NUM_SIGNIFICAND_BITS - HALF_NUM_SIGNIFICAND_BITS);
+    const __m128i Exponent = _mm_and_si128(Bits, InfOrNaN);
+    Bits = _mm_add_epi32(Bits, Rebias);
+    Bits = _mm_add_epi32(Bits, _mm_and_si128(_mm_cmpeq_epi32(Exponent, InfOrNaN), Rebias));
+
+    const __m128i IsSmall    = _mm_cmpeq_epi32(Exponent, _mm_setzero_si128());
+    const __m128i SmallestNormal = _mm_set1_epi32((HALF_EXPONENT_MIN + SINGLE_EXPONENT_BIAS) << SINGLE_EXPONENT_SHIFT);
+    const __m128  Normalized = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(Bits, _mm_set1_epi32(1 << SINGLE_EXPONENT_SHIFT))),
+                                          _mm_castsi128_ps(SmallestNormal));
+    Bits = _mm_or_si128(_mm_and_si128(IsSmall, _mm_castps_si128(Normalized)), _mm_andnot_si128(IsSmall, Bits));
+
+    return _mm_castsi128_ps(_mm_or_si128(Bits, Sign));
+}
+
+
+IEEE754_TARGET("sse2")
+static size_t HalfToFloatSse2(const uint16_t *puHalves, float *pfValues, size_t uCount)
+{
+    size_t i;
+    for(i = 0; i + 8 <= uCount; i += 8) {
+        const __m128i Halves = _mm_loadu_si128((const __m128i *)&puHalves[i]);
+        if(HalvesHaveNaN(Halves)) {
+            break;
+        }
+        _mm_storeu_ps(&pfValues[i],     HalfToFloatSse2Lanes(_mm_unpacklo_epi16(Halves, _mm_setzero_si128())));
+        _mm_storeu_ps(&pfValues[i + 4], HalfToFloatSse2Lanes(_mm_unpackhi_epi16(Halves, _mm_setzero_si128())));
+    }
+    return i;
+}
+
+
+IEEE754_TARGET("sse2")
+static size_t HalfToDoubleSse2(const uint16_t *puHalves, double *pdValues, size_t uCount)
+{
+    size_t i;
+    for(i = 0; i + 8 <= uCount; i += 8) {
+        const __m128i Halves = _mm_loadu_si128((const __m128i *)&puHalves[i]);
+        if(HalvesHaveNaN(Halves)) {
+            break;
+        }
+        const __m128 Low  = HalfToFloatSse2Lanes(_mm_unpacklo_epi16(Halves, _mm_setzero_si128()));
+        const __m128 High = HalfToFloatSse2Lanes(_mm_unpackhi_epi16(Halves, _mm_setzero_si128()));
+        _mm_storeu_pd(&pdValues[i],     _mm_cvtps_pd(Low));
+        _mm_storeu_pd(&pdValues[i + 2], _mm_cvtps_pd(_mm_movehl_ps(Low, Low)));
+        _mm_storeu_pd(&pdValues[i + 4], _mm_cvtps_pd(High));
+        _mm_storeu_pd(&pdValues[i + 6], _mm_cvtps_pd(_mm_movehl_ps(High, High)));
+    }
+    return i;
+}
+
+#endif /* IEEE754_X86_KERNELS */
+
+
+// Public function; see ieee754.h
+void IEEE754_HalfToDoubleBlock(const uint16_t *puHalves, double *pdValues, size_t uCount)
+{
+    const int nKernel = uCount >= KERNEL_GROUP ? IEEE754_Kernel() : IEEE754_KERNEL_PORTABLE;
+    size_t    i       = 0;
+
+    while(i < uCount) {
+        switch(nKernel) {
+#ifdef IEEE754_X86_KERNELS
+            case IEEE754_KERNEL_AVX2:
+                i += HalfToDoubleAvx2(&puHalves[i], &pdValues[i], uCount - i);
+                break;
+            case IEEE754_KERNEL_SSE2:
+                i += HalfToDoubleSse2(&puHalves[i], &pdValues[i], uCount - i);
+                break;
+#endif
+            default:
+                break;
+        }
+        const size_t uGroupEnd = uCount - i < KERNEL_GROUP ? uCount : i + KERNEL_GROUP;
+        for(; i < uGroupEnd; i++) {
+            pdValues[i] = IEEE754_HalfToDouble(puHalves[i]);
+        }
+    }
+}
+
+
+// Public function; see ieee754.h
+void IEEE754_HalfToFloatBlock(const uint16_t *puHalves, float *pfValues, size_t uCount)
+{
+    const int nKernel = uCount >= KERNEL_GROUP ? IEEE754_Kernel() : IEEE754_KERNEL_PORTABLE;
+    size_t    i       = 0;
+
+    while(i < uCount) {
+        switch(nKernel) {
+#ifdef IEEE754_X86_KERNELS
+            case IEEE754_KERNEL_AVX2:
+                i += HalfToFloatAvx2(&puHalves[i], &pfValues[i], uCount - i);
+                break;
+            case IEEE754_KERNEL_SSE2:
+                i += HalfToFloatSse2(&puHalves[i], &pfValues[i], uCount - i);
+                break;
+#endif
+            default:
+                break;
+        }
+        const size_t uGroupEnd = uCount - i < KERNEL_GROUP ? uCount : i + KERNEL_GROUP;
+        for(; i < uGroupEnd; i++) {
+            pfValues[i] = IEEE754_HalfToFloat(puHalves[i]);
+        }
+    }
+}
+
+
+
 /*
  IEEE754_FloatToDouble(uint32_t uFloat) was created but is not needed. It can be retrieved from
 github history if needed.
@@ -498,6 +776,411 @@ IEEE754_union IEEE754_DoubleToSmallestInternal(double d, int bAllowHalfPrecision
     return result;
 }
 
+
+// Biased double-precision exponents of the values that convert to
+// normal half and single-precision, and the rebiasing to them
+#define DOUBLE_HALF_EXPONENT_LOW     (HALF_EXPONENT_MIN + DOUBLE_EXPONENT_BIAS)
+#define DOUBLE_HALF_EXPONENT_HIGH    (HALF_EXPONENT_MAX + DOUBLE_EXPONENT_BIAS)
+#define DOUBLE_SINGLE_EXPONENT_LOW   (SINGLE_EXPONENT_MIN + DOUBLE_EXPONENT_BIAS)
+#define DOUBLE_SINGLE_EXPONENT_HIGH  (SINGLE_EXPONENT_MAX + DOUBLE_EXPONENT_BIAS)
+#define DOUBLE_TO_HALF_REBIAS        (DOUBLE_EXPONENT_BIAS - HALF_EXPONENT_BIAS)
+#define DOUBLE_TO_SINGLE_REBIAS      (DOUBLE_EXPONENT_BIAS - SINGLE_EXPONENT_BIAS)
+
+// The same for single-precision to half-precision
+#define SINGLE_HALF_EXPONENT_LOW     (HALF_EXPONENT_MIN + SINGLE_EXPONENT_BIAS)
+#define SINGLE_HALF_EXPONENT_HIGH    (HALF_EXPONENT_MAX + SINGLE_EXPONENT_BIAS)
+#define SINGLE_TO_HALF_REBIAS        (SINGLE_EXPONENT_BIAS - HALF_EXPONENT_BIAS)
+
+
+// The size of a lane from bit masks of the lanes that fit half and
+// single-precision. This is a lookup rather than branches as the
+// sizes in real data are often not predictable.
+static inline uint8_t LaneSize(int nHalfLanes, int nSingleLanes, int nLane)
+{
+    static const uint8_t auSizes[4] = {
+        IEEE754_UNION_IS_DOUBLE, IEEE754_UNION_IS_SINGLE, IEEE754_UNION_IS_HALF, IEEE754_UNION_IS_HALF
+    };
+    return auSizes[((nHalfLanes >> nLane) & 1) << 1 | ((nSingleLanes >> nLane) & 1)];
+}
+
+
+#ifdef IEEE754_X86_KERNELS
+
+/*
+ The kernels below make the same decisions as
+ IEEE754_DoubleToSmallestInternal() and IEEE754_FloatToSmallest() for
+ all lanes at once with integer operations on the bits: zero and
+ infinity go to half-precision, normal numbers whose exponent is in
+ range and whose dropped significand bits are zero go to half or
+ single-precision, and everything else is left as it is. Groups with
+ a NaN in them are done one at a time for the NaN payload handling of
+ IEEE754_DoubleToHalf() and IEEE754_FloatToHalf().
+ */
+
+// nLow <= x <= nHigh for each lane
+IEEE754_TARGET("avx2")
+static inline __m256i InRange64Avx2(__m256i x, int64_t nLow, int64_t nHigh)
+{
+    return _mm256_andnot_si256(_mm256_cmpgt_epi64(_mm256_set1_epi64x(nLow), x),
+                               _mm256_cmpgt_epi64(_mm256_set1_epi64x(nHigh + 1), x));
+}
+
+IEEE754_TARGET("avx2")
+static inline __m256i InRange32Avx2(__m256i x, int32_t nLow, int32_t nHigh)
+{
+    return _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(nLow), x),
+                               _mm256_cmpgt_epi32(_mm256_set1_epi32(nHigh + 1), x));
+}
+
+IEEE754_TARGET("sse2")
+static inline __m128i InRange32Sse2(__m128i x, int32_t nLow, int32_t nHigh)
+{
+    return _mm_andnot_si128(_mm_cmpgt_epi32(_mm_set1_epi32(nLow), x),
+                            _mm_cmpgt_epi32(_mm_set1_epi32(nHigh + 1), x));
+}
+
+
+IEEE754_TARGET("avx2")
+static size_t DoubleToSmallestAvx2(const double *pdValues, IEEE754_union *pResults, size_t uCount, int bAllowHalfPrecision)
+{
+    const __m256i AllowHalf = _mm256_set1_epi64x(bAllowHalfPrecision ? -1 : 0);
+    const __m256i Zero      = _mm256_setzero_si256();
+    const __m256i Infinity  = _mm256_set1_epi64x((int64_t)DOUBLE_EXPONENT_MASK);
+    uint64_t      auValues[4];
+    size_t        i;
+
+    for(i = 0; i + 4 <= uCount; i += 4) {
+        const __m256i Bits      = _mm256_loadu_si256((const __m256i *)&pdValues[i]);
+        const __m256i Magnitude = _mm256_andnot_si256(_mm256_set1_epi64x((int64_t)DOUBLE_SIGN_MASK), Bits);
+        // Signed compare is OK as the sign bit is masked off
+        if(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(Magnitude, Infinity)))) {
+            break;
+        }
+
+        const __m256i Exponent    = _mm256_srli_epi64(Magnitude, DOUBLE_EXPONENT_SHIFT);
+        const __m256i Significand = _mm256_and_si256(Bits, _mm256_set1_epi64x((int64_t)DOUBLE_SIGNIFICAND_MASK));
+        const __m256i IsInfinity  = _mm256_cmpeq_epi64(Magnitude, Infinity);
+        const __m256i IsZero      = _mm256_cmpeq_epi64(Magnitude, Zero);
+
+        const __m256i HalfFits =
+            _mm256_and_si256(_mm256_and_si256(InRange64Avx2(Exponent, DOUBLE_HALF_EXPONENT_LOW, DOUBLE_HALF_EXPONENT_HIGH), AllowHalf),
+                             _mm256_cmpeq_epi64(_mm256_and_si256(Significand, _mm256_set1_epi64x((int64_t)(DOUBLE_SIGNIFICAND_MASK >> HALF_NUM_SIGNIFICAND_BITS))), Zero));
+        const __m256i HalfNormal =
+            _mm256_or_si256(_mm256_slli_epi64(_mm256_sub_epi64(Exponent, _mm256_set1_epi64x(DOUBLE_TO_HALF_REBIAS)), HALF_EXPONENT_SHIFT),
+                            _mm256_srli_epi64(Significand, DOUBLE_NUM_SIGNIFICAND_BITS - HALF_NUM_SIGNIFICAND_BITS));
+        const __m256i Half =
+            _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi64(Bits, DOUBLE_SIGN_SHIFT - HALF_SIGN_SHIFT), _mm256_set1_epi64x(HALF_SIGN_MASK)),
+                            _mm256_or_si256(_mm256_and_si256(IsInfinity, _mm256_set1_epi64x(HALF_EXPONENT_MASK)),
+                                            _mm256_and_si256(HalfFits, HalfNormal)));
+        const __m256i IsHalf = _mm256_or_si256(_mm256_or_si256(IsZero, IsInfinity), HalfFits);
+
+        const __m256i SingleFits =
+            _mm256_and_si256(InRange64Avx2(Exponent, DOUBLE_SINGLE_EXPONENT_LOW, DOUBLE_SINGLE_EXPONENT_HIGH),
+                             _mm256_cmpeq_epi64(_mm256_and_si256(Significand, _mm256_set1_epi64x((int64_t)(DOUBLE_SIGNIFICAND_MASK >> SINGLE_NUM_SIGNIFICAND_BITS))), Zero));
+        const __m256i Single =
+            _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi64(Bits, DOUBLE_SIGN_SHIFT - SINGLE_SIGN_SHIFT), _mm256_set1_epi64x(SINGLE_SIGN_MASK)),
+                            _mm256_or_si256(_mm256_slli_epi64(_mm256_sub_epi64(Exponent, _mm256_set1_epi64x(DOUBLE_TO_SINGLE_REBIAS)), SINGLE_EXPONENT_SHIFT),
+                                            _mm256_srli_epi64(Significand, DOUBLE_NUM_SIGNIFICAND_BITS - SINGLE_NUM_SIGNIFICAND_BITS)));
+
+        _mm256_storeu_si256((__m256i *)auValues, _mm256_blendv_epi8(_mm256_blendv_epi8(Bits, Single, SingleFits), Half, IsHalf));
+        const int nHalfLanes   = _mm256_movemask_pd(_mm256_castsi256_pd(IsHalf));
+        const int nSingleLanes = _mm256_movemask_pd(_mm256_castsi256_pd(SingleFits));
+        for(int j = 0; j < 4; j++) {
+            pResults[i + (size_t)j].uSize  = LaneSize(nHalfLanes, nSingleLanes, j);
+            pResults[i + (size_t)j].uValue = auValues[j];
+        }
+    }
+    return i;
+}
+
+
+// SSE2 has no 64-bit compares so the doubles are split into their
+// high and low 32 bits. The sign, exponent and top 20 significand bits
+// are in the high 32.
+IEEE754_TARGET("sse2")
+static size_t DoubleToSmallestSse2(const double *pdValues, IEEE754_union *pResults, size_t uCount, int bAllowHalfPrecision)
+{
+    const __m128i AllowHalf = _mm_set1_epi32(bAllowHalfPrecision ? -1 : 0);
+    const __m128i Zero      = _mm_setzero_si128();
+    const __m128i Infinity  = _mm_set1_epi32((int32_t)(DOUBLE_EXPONENT_MASK >> 32));
+    uint32_t      auValues[4];
+    size_t        i;
+
+    for(i = 0; i + 4 <= uCount; i += 4) {
+        const __m128  Pair1 = _mm_castpd_ps(_mm_loadu_pd(&pdValues[i]));
+        const __m128  Pair2 = _mm_castpd_ps(_mm_loadu_pd(&pdValues[i + 2]));
+        const __m128i Low   = _mm_castps_si128(_mm_shuffle_ps(Pair1, Pair2, _MM_SHUFFLE(2, 0, 2, 0)));
+        const __m128i High  = _mm_castps_si128(_mm_shuffle_ps(Pair1, Pair2, _MM_SHUFFLE(3, 1, 3, 1)));
+
+        const __m128i Magnitude = _mm_and_si128(High, _mm_set1_epi32(0x7fffffff));
+        const __m128i LowIsZero = _mm_cmpeq_epi32(Low, Zero);
+        const __m128i IsNaN     = _mm_or_si128(_mm_cmpgt_epi32(Magnitude, Infinity),
+                                               _mm_andnot_si128(LowIsZero, _mm_cmpeq_epi32(Magnitude, Infinity)));
+        if(_mm_movemask_epi8(IsNaN)) {
+            break;
+        }
+
+        const __m128i Exponent   = _mm_srli_epi32(Magnitude, DOUBLE_EXPONENT_SHIFT - 32);
+        const __m128i IsInfinity = _mm_and_si128(LowIsZero, _mm_cmpeq_epi32(Magnitude, Infinity));
+        const __m128i IsZero     = _mm_and_si128(LowIsZero, _mm_cmpeq_epi32(Magnitude, Zero));
+
+        // The dropped bits are all of the low 32 and 10 of the high
+        const __m128i HalfFits =
+            _mm_and_si128(_mm_and_si128(InRange32Sse2(Exponent, DOUBLE_HALF_EXPONENT_LOW, DOUBLE_HALF_EXPONENT_HIGH), AllowHalf),
+                          _mm_and_si128(LowIsZero, _mm_cmpeq_epi32(_mm_and_si128(High, _mm_set1_epi32(0x3ff)), Zero)));
+        const __m128i HalfNormal =
+            _mm_or_si128(_mm_slli_epi32(_mm_sub_epi32(Exponent, _mm_set1_epi32(DOUBLE_TO_HALF_REBIAS)), HALF_EXPONENT_SHIFT),
+                         _mm_and_si128(_mm_srli_epi32(High, DOUBLE_NUM_SIGNIFICAND_BITS - HALF_NUM_SIGNIFICAND_BITS - 32), _mm_set1_epi32(HALF_SIGNIFICAND_MASK)));
+        const __m128i Half =
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi32(High, DOUBLE_SIGN_SHIFT - HALF_SIGN_SHIFT - 32), _mm_set1_epi32(HALF_SIGN_MASK)),
+                         _mm_or_si128(_mm_and_si128(IsInfinity, _mm_set1_epi32(HALF_EXPONENT_MASK)),
+                                      _mm_and_si128(HalfFits, HalfNormal)));
+        const __m128i IsHalf = _mm_or_si128(_mm_or_si128(IsZero, IsInfinity), HalfFits);
+
+        // The dropped bits are 29 of the low 32
+        const __m128i SingleFits =
+            _mm_and_si128(InRange32Sse2(Exponent, DOUBLE_SINGLE_EXPONENT_LOW, DOUBLE_SINGLE_EXPONENT_HIGH),
+                          _mm_cmpeq_epi32(_mm_and_si128(Low, _mm_set1_epi32(0x1fffffff)), Zero));
+        const __m128i Single =
+            _mm_or_si128(_mm_or_si128(_mm_and_si128(High, _mm_set1_epi32((int32_t)SINGLE_SIGN_MASK)),
+                                      _mm_slli_epi32(_mm_sub_epi32(Exponent, _mm_set1_epi32(DOUBLE_TO_SINGLE_REBIAS)), SINGLE_EXPONENT_SHIFT)),
+                         _mm_or_si128(_mm_slli_epi32(_mm_and_si128(High, _mm_set1_epi32(0xfffff)), SINGLE_NUM_SIGNIFICAND_BITS - 20),
+                                      _mm_srli_epi32(Low, 32 - (SINGLE_NUM_SIGNIFICAND_BITS - 20))));
+
+        _mm_storeu_si128((__m128i *)auValues, _mm_or_si128(_mm_and_si128(IsHalf, Half), _mm_andnot_si128(IsHalf, Single)));
+        const int nHalfLanes   = _mm_movemask_ps(_mm_castsi128_ps(IsHalf));
+        const int nSingleLanes = _mm_movemask_ps(_mm_castsi128_ps(SingleFits));
+        for(int j = 0; j < 4; j++) {
+            // The halves and singles are in auValues. Doubles are as they were.
+            const uint64_t uDoubleMask = 0 - (uint64_t)(((nHalfLanes | nSingleLanes) >> j & 1) ^ 1);
+            pResults[i + (size_t)j].uSize  = LaneSize(nHalfLanes, nSingleLanes, j);
+            pResults[i + (size_t)j].uValue = (CopyDoubleToUint64(pdValues[i + (size_t)j]) & uDoubleMask) | (auValues[j] & ~uDoubleMask);
+        }
+    }
+    return i;
+}
+
+
+IEEE754_TARGET("avx2")
+static size_t FloatToSmallestAvx2(const float *pfValues, IEEE754_union *pResults, size_t uCount)
+{
+    const __m256i Zero     = _mm256_setzero_si256();
+    const __m256i Infinity = _mm256_set1_epi32((int32_t)SINGLE_EXPONENT_MASK);
+    uint32_t      auValues[8];
+    size_t        i;
+
+    for(i = 0; i + 8 <= uCount; i += 8) {
+        const __m256i Bits      = _mm256_loadu_si256((const __m256i *)&pfValues[i]);
+        const __m256i Magnitude = _mm256_andnot_si256(_mm256_set1_epi32((int32_t)SINGLE_SIGN_MASK), Bits);
+        if(_mm256_movemask_epi8(_mm256_cmpgt_epi32(Magnitude, Infinity))) {
+            break;
+        }
+
+        const __m256i Exponent   = _mm256_srli_epi32(Magnitude, SINGLE_EXPONENT_SHIFT);
+        const __m256i IsInfinity = _mm256_cmpeq_epi32(Magnitude, Infinity);
+        // Only positive zero, like IEEE754_FloatToSmallest()
+        const __m256i IsZero     = _mm256_cmpeq_epi32(Bits, Zero);
+
+        const __m256i HalfFits =
+            _mm256_and_si256(InRange32Avx2(Exponent, SINGLE_HALF_EXPONENT_LOW, SINGLE_HALF_EXPONENT_HIGH),
+                             _mm256_cmpeq_epi32(_mm256_and_si256(Bits, _mm256_set1_epi32(SINGLE_SIGNIFICAND_MASK >> HALF_NUM_SIGNIFICAND_BITS)), Zero));
+        const __m256i HalfNormal =
+            _mm256_or_si256(_mm256_slli_epi32(_mm256_sub_epi32(Exponent, _mm256_set1_epi32(SINGLE_TO_HALF_REBIAS)), HALF_EXPONENT_SHIFT),
+                            _mm256_and_si256(_mm256_srli_epi32(Bits, SINGLE_NUM_SIGNIFICAND_BITS - HALF_NUM_SIGNIFICAND_BITS), _mm256_set1_epi32(HALF_SIGNIFICAND_MASK)));
+        const __m256i Half =
+            _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(Bits, SINGLE_SIGN_SHIFT - HALF_SIGN_SHIFT), _mm256_set1_epi32(HALF_SIGN_MASK)),
+                            _mm256_or_si256(_mm256_and_si256(IsInfinity, _mm256_set1_epi32(HALF_EXPONENT_MASK)),
+                                            _mm256_and_si256(HalfFits, HalfNormal)));
+        const __m256i IsHalf = _mm256_or_si256(_mm256_or_si256(IsZero, IsInfinity), HalfFits);
+
+        _mm256_storeu_si256((__m256i *)auValues, _mm256_blendv_epi8(Bits, Half, IsHalf));
+        const int nHalfLanes = _mm256_movemask_ps(_mm256_castsi256_ps(IsHalf));
+        for(int j = 0; j < 8; j++) {
+            pResults[i + (size_t)j].uSize  = LaneSize(nHalfLanes, 0xff, j);
+            pResults[i + (size_t)j].uValue = auValues[j];
+        }
+    }
+    return i;
+}
+
+
+IEEE754_TARGET("sse2")
+static size_t FloatToSmallestSse2(const float *pfValues, IEEE754_union *pResults, size_t uCount)
+{
+    const __m128i Zero     = _mm_setzero_si128();
+    const __m128i Infinity = _mm_set1_epi32((int32_t)SINGLE_EXPONENT_MASK);
+    uint32_t      auValues[4];
+    size_t        i;
+
+    for(i = 0; i + 4 <= uCount; i += 4) {
+        const __m128i Bits      = _mm_castps_si128(_mm_loadu_ps(&pfValues[i]));
+        const __m128i Magnitude = _mm_andnot_si128(_mm_set1_epi32((int32_t)SINGLE_SIGN_MASK), Bits);
+        if(_mm_movemask_epi8(_mm_cmpgt_epi32(Magnitude, Infinity))) {
+            break;
+        }
+
+        const __m128i Exponent   = _mm_srli_epi32(Magnitude, SINGLE_EXPONENT_SHIFT);
+        const __m128i IsInfinity = _mm_cmpeq_epi32(Magnitude, Infinity);
+        const __m128i IsZero     = _mm_cmpeq_epi32(Bits, Zero);
+
+        const __m128i HalfFits =
+            _mm_and_si128(InRange32Sse2(Exponent, SINGLE_HALF_EXPONENT_LOW, SINGLE_HALF_EXPONENT_HIGH),
+                          _mm_cmpeq_epi32(_mm_and_si128(Bits, _mm_set1_epi32(SINGLE_SIGNIFICAND_MASK >> HALF_NUM_SIGNIFICAND_BITS)), Zero));
+        const __m128i HalfNormal =
+            _mm_or_si128(_mm_slli_epi32(_mm_sub_epi32(Exponent, _mm_set1_epi32(SINGLE_TO_HALF_REBIAS)), HALF_EXPONENT_SHIFT),
+                         _mm_and_si128(_mm_srli_epi32(Bits, SINGLE_NUM_SIGNIFICAND_BITS - HALF_NUM_SIGNIFICAND_BITS), _mm_set1_epi32(HALF_SIGNIFICAND_MASK)));
+        const __m128i Half =
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi32(Bits, SINGLE_SIGN_SHIFT - HALF_SIGN_SHIFT), _mm_set1_epi32(HALF_SIGN_MASK)),
+                         _mm_or_si128(_mm_and_si128(IsInfinity, _mm_set1_epi32(HALF_EXPONENT_MASK)),
+                                      _mm_and_si128(HalfFits, HalfNormal)));
+        const __m128i IsHalf = _mm_or_si128(_mm_or_si128(IsZero, IsInfinity), HalfFits);
+
+        _mm_storeu_si128((__m128i *)auValues, _mm_or_si128(_mm_and_si128(IsHalf, Half), _mm_andnot_si128(IsHalf, Bits)));
+        const int nHalfLanes = _mm_movemask_ps(_mm_castsi128_ps(IsHalf));
+        for(int j = 0; j < 4; j++) {
+            pResults[i + (size_t)j].uSize  = LaneSize(nHalfLanes, 0xf, j);
+            pResults[i + (size_t)j].uValue = auValues[j];
+        }
+    }
+    return i;
+}
+
+#endif /* IEEE754_X86_KERNELS */
+
+
+// Public function; see ieee754.h
+void IEEE754_DoubleToSmallestBlock(const double *pdValues, IEEE754_union *pResults, size_t uCount, int bAllowHalfPrecision)
+{
+    const int nKernel = uCount >= KERNEL_GROUP ? IEEE754_Kernel() : IEEE754_KERNEL_PORTABLE;
+    size_t    i       = 0;
+
+    while(i < uCount) {
+        switch(nKernel) {
+#ifdef IEEE754_X86_KERNELS
+            case IEEE754_KERNEL_AVX2:
+                i += DoubleToSmallestAvx2(&pdValues[i], &pResults[i], uCount - i, bAllowHalfPrecision);
+                break;
+            case IEEE754_KERNEL_SSE2:
+                i += DoubleToSmallestSse2(&pdValues[i], &pResults[i], uCount - i, bAllowHalfPrecision);
+                break;
+#endif
+            default:
+                break;
+        }
+        const size_t uGroupEnd = uCount - i < KERNEL_GROUP ? uCount : i + KERNEL_GROUP;
+        for(; i < uGroupEnd; i++) {
+            pResults[i] = IEEE754_DoubleToSmallestInternal(pdValues[i], bAllowHalfPrecision);
+        }
+    }
+}
+
+
+// Public function; see ieee754.h
+void IEEE754_FloatToSmallestBlock(const float *pfValues, IEEE754_union *pResults, size_t uCount)
+{
+    const int nKernel = uCount >= KERNEL_GROUP ? IEEE754_Kernel() : IEEE754_KERNEL_PORTABLE;
+    size_t    i       = 0;
+
+    while(i < uCount) {
+        switch(nKernel) {
+#ifdef IEEE754_X86_KERNELS
+            case IEEE754_KERNEL_AVX2:
+                i += FloatToSmallestAvx2(&pfValues[i], &pResults[i], uCount - i);
+                break;
+            case IEEE754_KERNEL_SSE2:
+                i += FloatToSmallestSse2(&pfValues[i], &pResults[i], uCount - i);
+                break;
+#endif
+            default:
+                break;
+        }
+        const size_t uGroupEnd = uCount - i < KERNEL_GROUP ? uCount : i + KERNEL_GROUP;
+        for(; i < uGroupEnd; i++) {
+            pResults[i] = IEEE754_FloatToSmallest(pfValues[i]);
+        }
+    }
+}
+
+/*
+ Whether a finite, non-zero value fits a smaller format without loss.
+ The value is uSignificand * 2^nLsbExponent.  nMaxExponent and
+ nMinExponent are the unbiased normal exponent range of the smaller
+ format and nSignificandBits its number of significand bits.
+ */
+static int
+IEEE754_FitsExactly(uint64_t uSignificand, int64_t nLsbExponent, int64_t nMaxExponent, int64_t nMinExponent, int64_t nSignificandBits)
+{
+    // Trailing zeros don't need to be represented
+    while(!(uSignificand & 1)) {
+        uSignificand >>= 1;
+        nLsbExponent++;
+    }
+    int64_t nTopExponent = nLsbExponent;
+    for(uint64_t u = uSignificand >> 1; u; u >>= 1) {
+        nTopExponent++;
+    }
+    if(nTopExponent > nMaxExponent) {
+        return 0;
+    }
+
+    // The lowest bit that can be held is that of the smallest
+    // subnormal or, for normal numbers, nSignificandBits below the top
+    int64_t nMinLsbExponent = nMinExponent - nSignificandBits;
+    if(nTopExponent - nSignificandBits > nMinLsbExponent) {
+        nMinLsbExponent = nTopExponent - nSignificandBits;
+    }
+    return nLsbExponent >= nMinLsbExponent;
+}
+
+
+/*
+ Public function; see ieee754.h
+ */
+int IEEE754_IsNotShortest(uint64_t uValue, uint8_t uSize)
+{
+    uint64_t uSignificand;
+    int64_t  nBiasedExponent;
+
+    switch(uSize) {
+        case IEEE754_UNION_IS_HALF:
+            // Every half is shortest, but only one NaN is allowed
+            if((uValue & HALF_EXPONENT_MASK) == HALF_EXPONENT_MASK && (uValue & HALF_SIGNIFICAND_MASK)) {
+                return uValue != 0x7e00;
+            }
+            return 0;
+
+        case IEEE754_UNION_IS_SINGLE:
+            nBiasedExponent = (int64_t)((uValue & SINGLE_EXPONENT_MASK) >> SINGLE_EXPONENT_SHIFT);
+            uSignificand    = uValue & SINGLE_SIGNIFICAND_MASK;
+            if(nBiasedExponent == SINGLE_EXPONENT_INF_OR_NAN + SINGLE_EXPONENT_BIAS || (nBiasedExponent == 0 && uSignificand == 0)) {
+                // Infinity, NaN and zero
+                return 1;
+            }
+            if(nBiasedExponent == 0) {
+                // Subnormal
+                nBiasedExponent = 1;
+            } else {
+                uSignificand |= 1ULL << SINGLE_NUM_SIGNIFICAND_BITS;
+            }
+            return IEEE754_FitsExactly(uSignificand, nBiasedExponent - SINGLE_EXPONENT_BIAS - SINGLE_NUM_SIGNIFICAND_BITS, HALF_EXPONENT_MAX, HALF_EXPONENT_MIN, HALF_NUM_SIGNIFICAND_BITS);
+
+        default:
+            nBiasedExponent = (int64_t)((uValue & DOUBLE_EXPONENT_MASK) >> DOUBLE_EXPONENT_SHIFT);
+            uSignificand    = uValue & DOUBLE_SIGNIFICAND_MASK;
+            if(nBiasedExponent == DOUBLE_EXPONENT_INF_OR_NAN + DOUBLE_EXPONENT_BIAS || (nBiasedExponent == 0 && uSignificand == 0)) {
+                // Infinity, NaN and zero
+                return 1;
+            }
+            if(nBiasedExponent == 0) {
+                // Subnormal
+                nBiasedExponent = 1;
+            } else {
+                uSignificand |= 1ULL << DOUBLE_NUM_SIGNIFICAND_BITS;
+            }
+            return IEEE754_FitsExactly(uSignificand, nBiasedExponent - DOUBLE_EXPONENT_BIAS - DOUBLE_NUM_SIGNIFICAND_BITS, SINGLE_EXPONENT_MAX, SINGLE_EXPONENT_MIN, SINGLE_NUM_SIGNIFICAND_BITS);
+    }
+}
+
 #else
 
 int x;
@@ -16,6 +16,7 @@
 #define ieee754_h
 
 #include <stdint.h>
+#include <stddef.h>
 
 
 
@@ -91,6 +92,59 @@ uint16_t IEEE754_DoubleToHalf(double d);
 double IEEE754_HalfToDouble(uint16_t uHalfPrecision);
 
 
+/*
+ Convert half-precision float to single-precision float. This is a
+ loss-less conversion and needs no floating-point hardware.
+ */
+float IEEE754_HalfToFloat(uint16_t uHalfPrecision);
+
+
+/*
+ The block conversions below use SIMD instructions when the CPU has
+ them. This is checked at run time, so the same object code works on
+ all CPUs of an architecture. The results are always bit-for-bit the
+ same as the one-at-a-time conversions, including NaN payloads and
+ subnormals. Blocks with a NaN in them are done one at a time because
+ the SIMD conversions align NaN payloads on the MSB.
+
+ The kernels, best last. Only x86 has SIMD kernels so far. They are
+ not built when QCBOR_DISABLE_FLOAT_SIMD or QCBOR_DISABLE_FLOAT_HW_USE
+ is defined.
+ */
+#define IEEE754_KERNEL_PORTABLE 0
+#define IEEE754_KERNEL_SSE2     1
+#define IEEE754_KERNEL_AVX2     2 // AVX2 and F16C
+
+
+/*
+ Returns the kernel the block conversions use, one of
+ IEEE754_KERNEL_xxxx.
+ */
+int IEEE754_Kernel(void);
+
+
+/*
+ Limits the block conversions to kernels up to nKernel so each can be
+ tested and timed. This is a global setting. It must not be changed
+ while conversions are running on other threads.
+ */
+void IEEE754_LimitKernel(int nKernel);
+
+
+/*
+ Convert a block of half-precision floats to double-precision. The
+ results are the same as IEEE754_HalfToDouble() on each.
+ */
+void IEEE754_HalfToDoubleBlock(const uint16_t *puHalves, double *pdValues, size_t uCount);
+
+
+/*
+ Convert a block of half-precision floats to single-precision. The
+ results are the same as IEEE754_HalfToFloat() on each.
+ */
+void IEEE754_HalfToFloatBlock(const uint16_t *puHalves, float *pfValues, size_t uCount);
+
+
 // Both tags the value and gives the size
 #define IEEE754_UNION_IS_HALF   2
 #define IEEE754_UNION_IS_SINGLE 4
@@ -137,6 +191,30 @@ static inline IEEE754_union IEEE754_DoubleToSmallest(double d)
 IEEE754_union IEEE754_FloatToSmallest(float f);
 
 
+/*
+ Converts a block of doubles. The results are the same as
+ IEEE754_DoubleToSmallestInternal() on each.
+ */
+void IEEE754_DoubleToSmallestBlock(const double *pdValues, IEEE754_union *pResults, size_t uCount, int bAllowHalfPrecision);
+
+
+/*
+ Converts a block of floats. The results are the same as
+ IEEE754_FloatToSmallest() on each.
+ */
+void IEEE754_FloatToSmallestBlock(const float *pfValues, IEEE754_union *pResults, size_t uCount);
+
+
+/*
+ Returns true if a half, single or double-precision value, given as
+ its bits and its size (one of IEEE754_UNION_IS_xxxx), has a shorter
+ exact representation, subnormals included. This is the rule for
+ deterministic encoding (D-CBOR). Zero, infinity and NaN are shortest
+ as half-precision and the only NaN allowed is the quiet NaN 0x7e00.
+ */
+int IEEE754_IsNotShortest(uint64_t uValue, uint8_t uSize);
+
+
 #endif /* ieee754_h */
 
 
@@ -0,0 +1,274 @@
+/*==============================================================================
+ Copyright (c) 2016-2018, The Linux Foundation.
+ Copyright (c) 2018-2021, Laurence Lundblade.
+ Copyright (c) 2021, Arm Limited.
+ All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors, nor the name "Laurence Lundblade" may be used to
+      endorse or promote products derived from this software without
+      specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_arena.h"
+
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+
+/* ===========================================================================
+   Arena -- GROWABLE STRING ALLOCATOR
+
+   Allocations are made one after another in the current region like
+   the MemPool. When one doesn't fit the next region in the list that
+   is large enough becomes current, or a new region twice the size of
+   the last is added. Only the newest allocation can be resized or
+   freed, which is all the decoder needs. The regions stay in the list
+   after a reset so they are reused.
+
+   Code Reviewers: THIS DOES POINTER MATH
+   ========================================================================== */
+
+
+static inline uint8_t *
+Arena_RegionStart(QCBORArenaRegion *pRegion)
+{
+   return (uint8_t *)pRegion + sizeof(QCBORArenaRegion);
+}
+
+static inline uint8_t *
+Arena_RegionEnd(const QCBORArenaRegion *pRegion)
+{
+   return (uint8_t *)pRegion->Region.ptr + pRegion->Region.len;
+}
+
+
+/* Puts the region header at the start of Region, aligned. Returns
+ * NULL if the region is too small for the header. */
+static QCBORArenaRegion *
+Arena_MakeRegion(UsefulBuf Region)
+{
+   const uintptr_t uAlignMask = sizeof(void *) - 1;
+   const size_t    uSkip      = (size_t)((sizeof(void *) - ((uintptr_t)Region.ptr & uAlignMask)) & uAlignMask);
+
+   if(Region.ptr == NULL || Region.len < uSkip + sizeof(QCBORArenaRegion)) {
+      return NULL;
+   }
+   QCBORArenaRegion *pRegion = (QCBORArenaRegion *)(void *)((uint8_t *)Region.ptr + uSkip);
+   pRegion->pNext  = NULL;
+   pRegion->Region = Region;
+
+   return pRegion;
+}
+
+
+/* Makes pRegion current with all its memory free */
+static inline void
+Arena_SetCurrent(QCBORArena *pMe, QCBORArenaRegion *pRegion)
+{
+   pMe->pCurrent = pRegion;
+   pMe->pFree    = pRegion ? Arena_RegionStart(pRegion) : NULL;
+   pMe->pNewest  = NULL;
+}
+
+
+static UsefulBuf
+Arena_Allocate(QCBORArena *pMe, size_t uSize)
+{
+   QCBORArenaRegion *pRegion;
+   QCBORArenaRegion *pLastRegion = NULL;
+
+   if(pMe->pCurrent == NULL || uSize > (size_t)(Arena_RegionEnd(pMe->pCurrent) - pMe->pFree)) {
+      /* Regions after the current one are free */
+      pRegion = pMe->pCurrent ? pMe->pCurrent->pNext : pMe->pFirst;
+      pLastRegion = pMe->pCurrent;
+      while(pRegion != NULL &&
+            uSize > (size_t)(Arena_RegionEnd(pRegion) - Arena_RegionStart(pRegion))) {
+         pLastRegion = pRegion;
+         pRegion     = pRegion->pNext;
+      }
+
+      if(pRegion == NULL) {
+         if(pMe->pfRegionAllocate == NULL ||
+            uSize > SIZE_MAX - sizeof(QCBORArenaRegion) - sizeof(void *)) {
+            return NULLUsefulBuf;
+         }
+         size_t uRegionSize = uSize + sizeof(QCBORArenaRegion) + sizeof(void *);
+         if(uRegionSize < pMe->uGrowth) {
+            uRegionSize = pMe->uGrowth;
+         }
+         pRegion = Arena_MakeRegion((*pMe->pfRegionAllocate)(pMe->pRegionCtx, uRegionSize));
+         if(pRegion == NULL) {
+            return NULLUsefulBuf;
+         }
+         if(uSize > (size_t)(Arena_RegionEnd(pRegion) - Arena_RegionStart(pRegion))) {
+            /* The region allocator returned less than asked for */
+            if(pMe->pfRegionFree) {
+               (*pMe->pfRegionFree)(pMe->pRegionCtx, pRegion->Region);
+            }
+            return NULLUsefulBuf;
+         }
+         pMe->uGrowth = pRegion->Region.len <= SIZE_MAX / 2 ? pRegion->Region.len * 2 : SIZE_MAX;
+
+         /* Add it at the end of the list */
+         while(pLastRegion != NULL && pLastRegion->pNext != NULL) {
+            pLastRegion = pLastRegion->pNext;
+         }
+         if(pLastRegion == NULL) {
+            pMe->pFirst = pRegion;
+         } else {
+            pLastRegion->pNext = pRegion;
+         }
+      }
+      Arena_SetCurrent(pMe, pRegion);
+   }
+
+   pMe->pNewest = pMe->pFree;
+   pMe->pFree  += uSize;
+
+   return (UsefulBuf){pMe->pNewest, uSize};
+}
+
+
+/*
+ Implements QCBORStringAllocate for the arena.
+ */
+static UsefulBuf
+Arena_Function(void *pArena, void *pMem, size_t uNewSize)
+{
+   QCBORArena *pMe = (QCBORArena *)pArena;
+
+   if(pMem == NULL) {
+      if(uNewSize == 0) {
+         /* DESTRUCT MODE. The strings are good until a reset. */
+         return NULLUsefulBuf;
+      }
+      /* ALLOCATION MODE */
+      return Arena_Allocate(pMe, uNewSize);
+   }
+
+   if(pMem != pMe->pNewest) {
+      /* Only the newest allocation can be resized or freed */
+      return NULLUsefulBuf;
+   }
+   const size_t uOldSize = (size_t)(pMe->pFree - pMe->pNewest);
+
+   if(uNewSize == 0) {
+      /* FREE MODE */
+      pMe->pFree   = pMe->pNewest;
+      pMe->pNewest = NULL;
+      return NULLUsefulBuf;
+   }
+
+   /* REALLOCATION MODE */
+   if(uNewSize <= (size_t)(Arena_RegionEnd(pMe->pCurrent) - pMe->pNewest)) {
+      pMe->pFree = pMe->pNewest + uNewSize;
+      return (UsefulBuf){pMe->pNewest, uNewSize};
+   }
+
+   /* Move it to another region. It doesn't fit in this one so the old
+    * contents are not overwritten by the new allocation. */
+   QCBORArenaRegion *pOldRegion = pMe->pCurrent;
+   pMe->pFree = pMe->pNewest;
+   UsefulBuf NewMem = Arena_Allocate(pMe, uNewSize);
+   if(UsefulBuf_IsNULL(NewMem)) {
+      /* Leave it as it was */
+      pMe->pCurrent = pOldRegion;
+      pMe->pNewest  = pMem;
+      pMe->pFree    = (uint8_t *)pMem + uOldSize;
+      return NULLUsefulBuf;
+   }
+   memcpy(NewMem.ptr, pMem, uOldSize);
+
+   return NewMem;
+}
+
+
+/*
+ Public function, see header qcbor/qcbor_arena.h file
+ */
+void QCBORArena_Init(QCBORArena *pMe, UsefulBuf Initial)
+{
+   memset(pMe, 0, sizeof(QCBORArena));
+   pMe->pInitial = Arena_MakeRegion(Initial);
+   pMe->pFirst   = pMe->pInitial;
+   pMe->uGrowth  = Initial.len < QCBOR_ARENA_MIN_GROWTH / 2 ? QCBOR_ARENA_MIN_GROWTH : Initial.len * 2;
+   Arena_SetCurrent(pMe, pMe->pFirst);
+}
+
+
+/*
+ Public function, see header qcbor/qcbor_arena.h file
+ */
+void QCBORArena_SetGrowth(QCBORArena              *pMe,
+                          QCBORArenaRegionAllocate pfAllocate,
+                          QCBORArenaRegionFree     pfFree,
+                          void                    *pRegionCtx)
+{
+   pMe->pfRegionAllocate = pfAllocate;
+   pMe->pfRegionFree     = pfFree;
+   pMe->pRegionCtx       = pRegionCtx;
+}
+
+
+/*
+ Public function, see header qcbor/qcbor_arena.h file
+ */
+void QCBORArena_Reset(QCBORArena *pMe)
+{
+   Arena_SetCurrent(pMe, pMe->pFirst);
+}
+
+
+/*
+ Public function, see header qcbor/qcbor_arena.h file
+ */
+void QCBORArena_Release(QCBORArena *pMe)
+{
+   QCBORArenaRegion *pRegion = pMe->pFirst;
+
+   while(pRegion != NULL) {
+      QCBORArenaRegion *pNext = pRegion->pNext;
+      if(pRegion != pMe->pInitial && pMe->pfRegionFree != NULL) {
+         (*pMe->pfRegionFree)(pMe->pRegionCtx, pRegion->Region);
+      }
+      pRegion = pNext;
+   }
+   if(pMe->pInitial != NULL) {
+      pMe->pInitial->pNext = NULL;
+   }
+   pMe->pFirst = pMe->pInitial;
+   Arena_SetCurrent(pMe, pMe->pFirst);
+}
+
+
+/*
+ Public function, see header qcbor/qcbor_arena.h file
+ */
+void QCBORDecode_SetArena(QCBORDecodeContext *pMe, QCBORArena *pArena, bool bAllStrings)
+{
+   QCBORDecode_SetUpAllocator(pMe, Arena_Function, pArena, bAllStrings);
+}
+
+#endif /* ! QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
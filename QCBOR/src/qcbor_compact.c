@@ -0,0 +1,118 @@
+/*==============================================================================
+ Copyright (c) 2016-2018, The Linux Foundation.
+ Copyright (c) 2018-2021, Laurence Lundblade.
+ Copyright (c) 2021, Arm Limited.
+ All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors, nor the name "Laurence Lundblade" may be used to
+      endorse or promote products derived from this software without
+      specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_compact.h"
+#include "qcbor_decode_private.h"
+
+
+/* Offset of a string in the whole input, which includes input
+ * discarded by QCBORDecode_AddInput(). Strings that were not
+ * allocated are always in the input, but this is checked so the
+ * casts are safe.
+ */
+static inline QCBORError
+CompactString(const QCBORDecodeContext *pMe, UsefulBufC String, QCBORCompactString *pCompact)
+{
+   const ptrdiff_t nOffset = (const uint8_t *)String.ptr - (const uint8_t *)pMe->InBuf.UB.ptr;
+   if(nOffset < 0 || String.len > pMe->InBuf.UB.len - (size_t)nOffset) {
+      return QCBOR_ERR_ALLOCATED_STRING;
+   }
+   size_t uOffset = (size_t)nOffset;
+#ifdef QCBOR_ENABLE_INCREMENTAL_INPUT
+   uOffset += pMe->uInputDiscarded;
+#endif /* QCBOR_ENABLE_INCREMENTAL_INPUT */
+   if(uOffset + String.len > QCBOR_MAX_DECODE_INPUT_SIZE) {
+      return QCBOR_ERR_INPUT_TOO_LARGE;
+   }
+
+   pCompact->uOffset = (uint32_t)uOffset;
+   pCompact->uLen    = (uint32_t)String.len;
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_compact.h file
+ */
+QCBORError
+QCBORDecode_GetNextCompact(QCBORDecodeContext *pMe, QCBORCompactItem *pCompact)
+{
+   QCBORItem  Item;
+   QCBORError uErr;
+
+   uErr = QCBORDecode_Private_GetNextNoTagContent(pMe, &Item);
+   if(uErr != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   if(Item.uDataAlloc || Item.uLabelAlloc) {
+      uErr = QCBOR_ERR_ALLOCATED_STRING;
+      goto Done;
+   }
+
+   /* For QCBORDecode_GetNthTagOfLast() */
+   memcpy(pMe->uLastTags, Item.uTags, sizeof(Item.uTags));
+
+   pCompact->uDataType      = Item.uDataType;
+   pCompact->uLabelType     = Item.uLabelType;
+   pCompact->uNestingLevel  = Item.uNestingLevel;
+   pCompact->uNextNestLevel = Item.uNextNestLevel;
+   pCompact->uFlags         = Item.uTags[0] != CBOR_TAG_INVALID16 ? QCBOR_COMPACT_TAGGED : 0;
+
+   if(Item.uDataType == QCBOR_TYPE_BYTE_STRING || Item.uDataType == QCBOR_TYPE_TEXT_STRING) {
+      uErr = CompactString(pMe, Item.val.string, &(pCompact->val.string));
+      if(uErr != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   } else {
+      /* All the other types there can be without tag content decoding
+       * are in the first 8 bytes of the union.
+       */
+      pCompact->val.uint64 = Item.val.uint64;
+   }
+
+   if(Item.uLabelType == QCBOR_TYPE_BYTE_STRING || Item.uLabelType == QCBOR_TYPE_TEXT_STRING) {
+      uErr = CompactString(pMe, Item.label.string, &(pCompact->label.string));
+   } else {
+      pCompact->label.uint64 = Item.label.uint64;
+   }
+
+Done:
+   if(uErr != QCBOR_SUCCESS) {
+      pCompact->uDataType  = QCBOR_TYPE_NONE;
+      pCompact->uLabelType = QCBOR_TYPE_NONE;
+   }
+   return uErr;
+}
@@ -34,12 +34,13 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "qcbor/qcbor_decode.h"
 #include "qcbor/qcbor_spiffy_decode.h"
+#include "qcbor_decode_private.h"
 #include "ieee754.h" /* Does not use math.h */
 
 #ifndef QCBOR_DISABLE_FLOAT_HW_USE
 
 #include <math.h> /* For isnan(), llround(), llroudf(), round(), roundf(),
-                   * pow(), exp2()
+                   * pow(), ldexp()
                    */
 #include <fenv.h> /* feclearexcept(), fetestexcept() */
 
@@ -52,15 +53,6 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
 
-static inline bool
-QCBORItem_IsMapOrArray(const QCBORItem *pMe)
-{
-   const uint8_t uDataType = pMe->uDataType;
-   return uDataType == QCBOR_TYPE_MAP ||
-          uDataType == QCBOR_TYPE_ARRAY ||
-          uDataType == QCBOR_TYPE_MAP_AS_ARRAY;
-}
-
 static inline bool
 QCBORItem_IsEmptyDefiniteLengthMapOrArray(const QCBORItem *pMe)
 {
@@ -306,6 +298,18 @@ DecodeNesting_Ascend(QCBORDecodeNesting *pNesting)
 }
 
 
+static inline void
+DecodeNesting_ClearLastLabel(struct nesting_decode_level *pLevel)
+{
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+   /* No previous label for the map label order check */
+   pLevel->u.ma.uLastLabelEnd = 0;
+#else /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+   (void)pLevel;
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+}
+
+
 static QCBORError
 DecodeNesting_Descend(QCBORDecodeNesting *pNesting, uint8_t uType)
 {
@@ -381,6 +385,7 @@ DecodeNesting_DescendMapOrArray(QCBORDecodeNesting *pNesting,
    /* Fill in the new map/array level. Check above makes casts OK. */
    pNesting->pCurrent->u.ma.uCountCursor  = (uint16_t)uCount;
    pNesting->pCurrent->u.ma.uCountTotal   = (uint16_t)uCount;
+   DecodeNesting_ClearLastLabel(pNesting->pCurrent);
 
    DecodeNesting_ClearBoundedMode(pNesting);
 
@@ -452,9 +457,47 @@ DecodeNesting_ResetMapOrArrayCount(QCBORDecodeNesting *pNesting)
    if(pNesting->pCurrent->u.ma.uCountCursor != QCBOR_COUNT_INDICATES_ZERO_LENGTH) {
       pNesting->pCurrentBounded->u.ma.uCountCursor = pNesting->pCurrentBounded->u.ma.uCountTotal;
    }
+   /* Traversal starts over so there is no previous label */
+   DecodeNesting_ClearLastLabel(pNesting->pCurrentBounded);
+}
+
+
+static inline void
+DecodeNesting_SetMapOrArrayPosition(QCBORDecodeNesting *pNesting, uint16_t uItemsBefore)
+{
+   /* Sets the bounded level up as if uItemsBefore items had been
+    * traversed. Only call on a bounded map or array that isn't empty.
+    */
+   if(pNesting->pCurrentBounded->u.ma.uCountTotal != QCBOR_COUNT_INDICATES_INDEFINITE_LENGTH) {
+      pNesting->pCurrentBounded->u.ma.uCountCursor =
+         (uint16_t)(pNesting->pCurrentBounded->u.ma.uCountTotal - uItemsBefore);
+   }
+   DecodeNesting_ClearLastLabel(pNesting->pCurrentBounded);
 }
 
 
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+static inline void
+DecodeNesting_GetLastLabel(const QCBORDecodeNesting *pNesting,
+                           uint32_t                 *puStart,
+                           uint32_t                 *puEnd)
+{
+   *puStart = pNesting->pCurrent->u.ma.uLastLabelStart;
+   *puEnd   = pNesting->pCurrent->u.ma.uLastLabelEnd;
+}
+
+
+static inline void
+DecodeNesting_SetLastLabel(QCBORDecodeNesting *pNesting,
+                           uint32_t            uStart,
+                           uint32_t            uEnd)
+{
+   pNesting->pCurrent->u.ma.uLastLabelStart = uStart;
+   pNesting->pCurrent->u.ma.uLastLabelEnd   = uEnd;
+}
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+
+
 static inline void
 DecodeNesting_Init(QCBORDecodeNesting *pNesting)
 {
@@ -574,6 +617,286 @@ void QCBORDecode_Init(QCBORDecodeContext *pMe,
 }
 
 
+#ifdef QCBOR_ENABLE_INCREMENTAL_INPUT
+
+/*
+ * Public function, see header file
+ */
+void QCBORDecode_InitIncremental(QCBORDecodeContext *pMe,
+                                 UsefulBuf           Buffer,
+                                 QCBORDecodeMode     nDecodeMode)
+{
+   const UsefulBufC NoInput = {Buffer.ptr, 0};
+
+   QCBORDecode_Init(pMe, NoInput, nDecodeMode);
+   if(Buffer.len > QCBOR_MAX_DECODE_INPUT_SIZE) {
+      Buffer.len = QCBOR_MAX_DECODE_INPUT_SIZE;
+   }
+   pMe->InputBuffer = Buffer;
+}
+
+
+static inline bool
+Incremental_IsEnabled(const QCBORDecodeContext *pMe)
+{
+   return pMe->InputBuffer.len != 0;
+}
+
+
+/* The number of bytes of input before the start of the buffer */
+static inline size_t
+Incremental_Discarded(const QCBORDecodeContext *pMe)
+{
+   return pMe->uInputDiscarded;
+}
+
+
+/* The outermost bstr-wrapped level entered or NULL. Its saved end is
+ * the end of the input. */
+static struct nesting_decode_level *
+Incremental_OutermostBstr(QCBORDecodeContext *pMe)
+{
+   struct nesting_decode_level *pLevel;
+
+   for(pLevel = &(pMe->nesting.pLevels[1]); pLevel <= pMe->nesting.pCurrent; pLevel++) {
+      if(pLevel->uLevelType == QCBOR_TYPE_BYTE_STRING) {
+         return pLevel;
+      }
+   }
+   return NULL;
+}
+
+
+/* Whether running out of bytes now might only be because more input
+ * is yet to be added. Not so inside bstr-wrapped CBOR, which is always
+ * all there. */
+static bool
+Incremental_IsAtEnd(QCBORDecodeContext *pMe)
+{
+   return Incremental_IsEnabled(pMe) &&
+          !pMe->bInputComplete &&
+          Incremental_OutermostBstr(pMe) == NULL;
+}
+
+
+/* Offset of the first byte of input that is still needed; the
+ * cursor, the start of entered maps, arrays and byte strings and the
+ * last label for the map label order check. */
+static size_t
+Incremental_KeepFrom(QCBORDecodeContext *pMe)
+{
+   const struct nesting_decode_level *pLevel;
+   size_t uKeep;
+
+   uKeep = UsefulInputBuf_Tell(&(pMe->InBuf));
+   for(pLevel = &(pMe->nesting.pLevels[1]); pLevel <= pMe->nesting.pCurrent; pLevel++) {
+      if(pLevel->uLevelType == QCBOR_TYPE_BYTE_STRING) {
+         if(pLevel->u.bs.uBstrStartOffset < uKeep) {
+            uKeep = pLevel->u.bs.uBstrStartOffset;
+         }
+      } else {
+         if(pLevel->u.ma.uStartOffset < uKeep) {
+            /* Also excludes QCBOR_NON_BOUNDED_OFFSET */
+            uKeep = pLevel->u.ma.uStartOffset;
+         }
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+         if(pLevel->u.ma.uLastLabelEnd != 0 && pLevel->u.ma.uLastLabelStart < uKeep) {
+            uKeep = pLevel->u.ma.uLastLabelStart;
+         }
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+      }
+   }
+   return uKeep;
+}
+
+
+/* Adjust all offsets into the input for the first uDelta bytes of
+ * the buffer having been discarded. */
+static void
+Incremental_Rebase(QCBORDecodeContext *pMe, uint32_t uDelta)
+{
+   struct nesting_decode_level *pLevel;
+
+   pMe->InBuf.cursor -= uDelta;
+   if(Incremental_OutermostBstr(pMe) != NULL) {
+      UsefulInputBuf_SetBufferLength(&(pMe->InBuf),
+                                     UsefulInputBuf_GetBufferLength(&(pMe->InBuf)) - uDelta);
+   }
+
+   for(pLevel = &(pMe->nesting.pLevels[1]); pLevel <= pMe->nesting.pCurrent; pLevel++) {
+      if(pLevel->uLevelType == QCBOR_TYPE_BYTE_STRING) {
+         pLevel->u.bs.uSavedEndOffset  -= uDelta;
+         pLevel->u.bs.uBstrStartOffset -= uDelta;
+      } else {
+         if(pLevel->u.ma.uStartOffset != QCBOR_NON_BOUNDED_OFFSET) {
+            pLevel->u.ma.uStartOffset -= uDelta;
+         }
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+         if(pLevel->u.ma.uLastLabelEnd != 0) {
+            pLevel->u.ma.uLastLabelStart -= uDelta;
+            pLevel->u.ma.uLastLabelEnd   -= uDelta;
+         }
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+      }
+   }
+
+   if(pMe->uMapEndOffsetCache != QCBOR_MAP_OFFSET_CACHE_INVALID) {
+      pMe->uMapEndOffsetCache -= uDelta;
+   }
+
+   pMe->uInputEnd       -= uDelta;
+   pMe->uInputDiscarded += uDelta;
+}
+
+
+/* After decoding was rolled back for more input, whether there can be
+ * room for it. */
+static QCBORError
+Incremental_CheckRoom(QCBORDecodeContext *pMe)
+{
+   if(Incremental_KeepFrom(pMe) == 0 && pMe->uInputEnd == pMe->InputBuffer.len) {
+      /* The input still needed fills the buffer */
+      return QCBOR_ERR_INPUT_TOO_LARGE;
+   }
+   return QCBOR_ERR_NEED_MORE_INPUT;
+}
+
+
+/* Called with the error from decoding that started with the saved
+ * cursor and nesting. Running out of input that is not complete
+ * becomes QCBOR_ERR_NEED_MORE_INPUT and the decoder is put back to
+ * as it was so the decoding can be repeated. */
+static QCBORError
+Incremental_Rollback(QCBORDecodeContext       *pMe,
+                     QCBORError                uErr,
+                     const UsefulInputBuf     *pSavedInBuf,
+                     const QCBORDecodeNesting *pSavedNesting)
+{
+   if(uErr == QCBOR_ERR_NO_MORE_ITEMS && DecodeNesting_IsAtEndOfBoundedLevel(&(pMe->nesting))) {
+      return uErr;
+   }
+   if((uErr == QCBOR_ERR_HIT_END || uErr == QCBOR_ERR_NO_MORE_ITEMS) && Incremental_IsAtEnd(pMe)) {
+      uErr = QCBOR_ERR_NEED_MORE_INPUT;
+   }
+   if(uErr == QCBOR_ERR_NEED_MORE_INPUT) {
+      pMe->InBuf   = *pSavedInBuf;
+      pMe->nesting = *pSavedNesting;
+      uErr = Incremental_CheckRoom(pMe);
+   }
+   return uErr;
+}
+
+
+/*
+ * Public function, see header file
+ */
+UsefulBufC QCBORDecode_AddInput(QCBORDecodeContext *pMe, UsefulBufC Input)
+{
+   struct nesting_decode_level *pBstr;
+   size_t                       uKeep;
+   size_t                       uCopy;
+
+   if(!Incremental_IsEnabled(pMe) || pMe->bInputComplete) {
+      return Input;
+   }
+
+   if(Input.len > pMe->InputBuffer.len - pMe->uInputEnd) {
+      /* Make room by moving out input no longer needed */
+      uKeep = Incremental_KeepFrom(pMe);
+      if(uKeep != 0) {
+         memmove(pMe->InputBuffer.ptr,
+                 (uint8_t *)pMe->InputBuffer.ptr + uKeep,
+                 pMe->uInputEnd - uKeep);
+         Incremental_Rebase(pMe, (uint32_t)uKeep);
+      }
+   }
+
+   uCopy = pMe->InputBuffer.len - pMe->uInputEnd;
+   if(Input.len < uCopy) {
+      uCopy = Input.len;
+   }
+   memcpy((uint8_t *)pMe->InputBuffer.ptr + pMe->uInputEnd, Input.ptr, uCopy);
+   pMe->uInputEnd += (uint32_t)uCopy;
+
+   pBstr = Incremental_OutermostBstr(pMe);
+   if(pBstr != NULL) {
+      pBstr->u.bs.uSavedEndOffset = pMe->uInputEnd;
+   } else {
+      UsefulInputBuf_SetBufferLength(&(pMe->InBuf), pMe->uInputEnd);
+   }
+
+#ifdef QCBOR_ENABLE_MAP_INDEX
+   /* Labels in the index may have moved and a map that was too short
+    * to index may be all there now. */
+   pMe->uMapIndexTop = QCBOR_MAP_INDEX_NONE;
+#endif /* QCBOR_ENABLE_MAP_INDEX */
+   /* Reading past the end of the input added before is not an error */
+   pMe->InBuf.err = 0;
+   if(pMe->uLastError == QCBOR_ERR_NEED_MORE_INPUT) {
+      pMe->uLastError = QCBOR_SUCCESS;
+   }
+
+   return UsefulBuf_Tail(Input, uCopy);
+}
+
+
+/*
+ * Public function, see header file
+ */
+void QCBORDecode_EndInput(QCBORDecodeContext *pMe)
+{
+   pMe->bInputComplete = true;
+   pMe->InBuf.err      = 0;
+   if(pMe->uLastError == QCBOR_ERR_NEED_MORE_INPUT) {
+      pMe->uLastError = QCBOR_SUCCESS;
+   }
+}
+
+#else /* QCBOR_ENABLE_INCREMENTAL_INPUT */
+
+static inline bool
+Incremental_IsEnabled(const QCBORDecodeContext *pMe)
+{
+   (void)pMe;
+   return false;
+}
+
+static inline size_t
+Incremental_Discarded(const QCBORDecodeContext *pMe)
+{
+   (void)pMe;
+   return 0;
+}
+
+static inline bool
+Incremental_IsAtEnd(QCBORDecodeContext *pMe)
+{
+   (void)pMe;
+   return false;
+}
+
+static inline QCBORError
+Incremental_CheckRoom(QCBORDecodeContext *pMe)
+{
+   (void)pMe;
+   return QCBOR_ERR_NEED_MORE_INPUT;
+}
+
+static inline QCBORError
+Incremental_Rollback(QCBORDecodeContext       *pMe,
+                     QCBORError                uErr,
+                     const UsefulInputBuf     *pSavedInBuf,
+                     const QCBORDecodeNesting *pSavedNesting)
+{
+   (void)pMe;
+   (void)pSavedInBuf;
+   (void)pSavedNesting;
+   return uErr;
+}
+
+#endif /* QCBOR_ENABLE_INCREMENTAL_INPUT */
+
+
 #ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
 
 /*
@@ -593,6 +916,26 @@ void QCBORDecode_SetUpAllocator(QCBORDecodeContext *pMe,
 
 
 
+/*
+ * Public function, see header file
+ */
+void QCBORDecode_SetUTF8Validation(QCBORDecodeContext *pMe, bool bValidate)
+{
+   pMe->bValidateUTF8 = bValidate;
+}
+
+
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+/*
+ * Public function, see header file
+ */
+void QCBORDecode_SetMapLabelOrderCheck(QCBORDecodeContext *pMe, bool bCheck)
+{
+   pMe->bCheckLabelOrder = bCheck;
+}
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+
+
 /*
  * Deprecated public function, see header file
  */
@@ -666,83 +1009,13 @@ void QCBORDecode_SetCallerConfiguredTagList(QCBORDecodeContext   *pMe,
  */
 
 
-/**
- * @brief Decode the CBOR head, the type and argument.
- *
- * @param[in] pUInBuf            The input buffer to read from.
- * @param[out] pnMajorType       The decoded major type.
- * @param[out] puArgument        The decoded argument.
- * @param[out] pnAdditionalInfo  The decoded Lower 5 bits of initial byte.
- *
- * @retval QCBOR_ERR_UNSUPPORTED
- * @retval QCBOR_ERR_HIT_END
- *
- * This decodes the CBOR "head" that every CBOR data item has. See
- * longer explaination of the head in documentation for
- * QCBOREncode_EncodeHead().
- *
- * This does the network->host byte order conversion. The conversion
- * here also results in the conversion for floats in addition to that
- * for lengths, tags and integer values.
- *
- * The int type is preferred to uint8_t for some variables as this
- * avoids integer promotions, can reduce code size and makes static
- * analyzers happier.
- */
-static inline QCBORError
-DecodeHead(UsefulInputBuf *pUInBuf,
-           int            *pnMajorType,
-           uint64_t       *puArgument,
-           int            *pnAdditionalInfo)
-{
-   QCBORError uReturn;
-
-   /* Get the initial byte that every CBOR data item has and break it
-    * down. */
-   const int nInitialByte    = (int)UsefulInputBuf_GetByte(pUInBuf);
-   const int nTmpMajorType   = nInitialByte >> 5;
-   const int nAdditionalInfo = nInitialByte & 0x1f;
-
-   /* Where the argument accumulates */
-   uint64_t uArgument;
-
-   if(nAdditionalInfo >= LEN_IS_ONE_BYTE && nAdditionalInfo <= LEN_IS_EIGHT_BYTES) {
-      /* Need to get 1,2,4 or 8 additional argument bytes. Map
-       * LEN_IS_ONE_BYTE..LEN_IS_EIGHT_BYTES to actual length.
-       */
-      static const uint8_t aIterate[] = {1,2,4,8};
-
-      /* Loop getting all the bytes in the argument */
-      uArgument = 0;
-      for(int i = aIterate[nAdditionalInfo - LEN_IS_ONE_BYTE]; i; i--) {
-         /* This shift and add gives the endian conversion. */
-         uArgument = (uArgument << 8) + UsefulInputBuf_GetByte(pUInBuf);
-      }
-   } else if(nAdditionalInfo >= ADDINFO_RESERVED1 && nAdditionalInfo <= ADDINFO_RESERVED3) {
-      /* The reserved and thus-far unused additional info values */
-      uReturn = QCBOR_ERR_UNSUPPORTED;
-      goto Done;
-   } else {
-      /* Less than 24, additional info is argument or 31, an
-       * indefinite-length.  No more bytes to get.
-       */
-      uArgument = (uint64_t)nAdditionalInfo;
-   }
-
-   if(UsefulInputBuf_GetError(pUInBuf)) {
-      uReturn = QCBOR_ERR_HIT_END;
-      goto Done;
-   }
+/* Optional checks on atomic data items, see DecodeAtomicDataItem() */
+#define QCBOR_CHECK_UTF8  0x01 /* Text strings must be valid UTF-8 */
+#define QCBOR_CHECK_DCBOR 0x02 /* Deterministic encoding, see QCBOR_DECODE_MODE_DCBOR */
 
-   /* All successful if arrived here. */
-   uReturn           = QCBOR_SUCCESS;
-   *pnMajorType      = nTmpMajorType;
-   *puArgument       = uArgument;
-   *pnAdditionalInfo = nAdditionalInfo;
 
-Done:
-   return uReturn;
-}
+/* DecodeHead() is in qcbor_decode_private.h for the other source
+ * files that scan heads. */
 
 
 /**
@@ -837,18 +1110,34 @@ DecodeInteger(int nMajorType, uint64_t uArgument, QCBORItem *pDecodedItem)
  *
  * @param[in] nAdditionalInfo   The lower five bits from the initial byte.
  * @param[in] uArgument         The argument from the head.
+ * @param[in] bDCBOR            Reject floats not in shortest form.
  * @param[out] pDecodedItem     The filled in decoded item.
  *
  * @retval QCBOR_ERR_HALF_PRECISION_DISABLED
  * @retval QCBOR_ERR_ALL_FLOAT_DISABLED
  * @retval QCBOR_ERR_BAD_TYPE_7
+ * @retval QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT
  */
 
 static inline QCBORError
-DecodeType7(int nAdditionalInfo, uint64_t uArgument, QCBORItem *pDecodedItem)
+DecodeType7(int nAdditionalInfo, uint64_t uArgument, bool bDCBOR, QCBORItem *pDecodedItem)
 {
    QCBORError uReturn = QCBOR_SUCCESS;
 
+#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
+   if(bDCBOR && nAdditionalInfo >= HALF_PREC_FLOAT && nAdditionalInfo <= DOUBLE_PREC_FLOAT) {
+      /* HALF_PREC_FLOAT..DOUBLE_PREC_FLOAT line up with
+       * IEEE754_UNION_IS_HALF..IEEE754_UNION_IS_DOUBLE as 2, 4 and 8.
+       */
+      if(IEEE754_IsNotShortest(uArgument, (uint8_t)(2 << (nAdditionalInfo - HALF_PREC_FLOAT)))) {
+         uReturn = QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT;
+         goto Done;
+      }
+   }
+#else /* QCBOR_DISABLE_PREFERRED_FLOAT */
+   (void)bDCBOR;
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+
    /* uAdditionalInfo is 5 bits from the initial byte. Compile time
     * checks above make sure uAdditionalInfo values line up with
     * uDataType values.  DecodeHead() never returns an AdditionalInfo
@@ -951,12 +1240,14 @@ Done:
  *
  * @param[in] pAllocator     The string allocator or NULL.
  * @param[in] uStrLen        The length of the string.
+ * @param[in] bValidateUTF8  If true, check that the bytes are UTF-8.
  * @param[in] pUInBuf        The surce from which to read the string's bytes.
  * @param[out] pDecodedItem  The filled in decoded item.
  *
  * @retval QCBOR_ERR_HIT_END
  * @retval QCBOR_ERR_STRING_ALLOCATE
  * @retval QCBOR_ERR_STRING_TOO_LONG
+ * @retval QCBOR_ERR_BAD_UTF8
  *
  * The reads @c uStrlen bytes from @c pUInBuf and fills in @c
  * pDecodedItem. If @c pAllocator is not NULL then memory for the
@@ -965,6 +1256,7 @@ Done:
 static inline QCBORError
 DecodeBytes(const QCBORInternalAllocator *pAllocator,
             uint64_t                      uStrLen,
+            bool                          bValidateUTF8,
             UsefulInputBuf               *pUInBuf,
             QCBORItem                    *pDecodedItem)
 {
@@ -989,6 +1281,12 @@ DecodeBytes(const QCBORInternalAllocator *pAllocator,
       goto Done;
    }
 
+   if(bValidateUTF8 && !UsefulBuf_IsValidUTF8(Bytes)) {
+      /* The string is consumed so decoding can continue */
+      uReturn = QCBOR_ERR_BAD_UTF8;
+      goto Done;
+   }
+
 #ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
    /* Note that this is not where allocation to coalesce
     * indefinite-length strings is done. This is for when the caller
@@ -1068,6 +1366,7 @@ static inline uint8_t ConvertArrayOrMapType(int nCBORMajorType)
  * @param[in] pUInBuf       Input buffer to read data item from.
  * @param[out] pDecodedItem  The filled-in decoded item.
  * @param[in] pAllocator    The allocator to use for strings or NULL.
+ * @param[in] uChecks       QCBOR_CHECK_UTF8 and/or QCBOR_CHECK_DCBOR.
  *
  * @retval QCBOR_ERR_UNSUPPORTED
  * @retval QCBOR_ERR_HIT_END
@@ -1078,6 +1377,10 @@ static inline uint8_t ConvertArrayOrMapType(int nCBORMajorType)
  * @retval QCBOR_ERR_ALL_FLOAT_DISABLED
  * @retval QCBOR_ERR_BAD_TYPE_7
  * @retval QCBOR_ERR_INDEF_LEN_ARRAYS_DISABLED
+ * @retval QCBOR_ERR_BAD_UTF8
+ * @retval QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD
+ * @retval QCBOR_ERR_DCBOR_INDEFINITE_LENGTH
+ * @retval QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT
  *
  * This decodes the most primitive / atomic data item. It does
  * no combing of data items.
@@ -1085,7 +1388,8 @@ static inline uint8_t ConvertArrayOrMapType(int nCBORMajorType)
 static QCBORError
 DecodeAtomicDataItem(UsefulInputBuf               *pUInBuf,
                      QCBORItem                    *pDecodedItem,
-                     const QCBORInternalAllocator *pAllocator)
+                     const QCBORInternalAllocator *pAllocator,
+                     uint8_t                       uChecks)
 {
    QCBORError uReturn;
 
@@ -1100,7 +1404,11 @@ DecodeAtomicDataItem(UsefulInputBuf               *pUInBuf,
 
    memset(pDecodedItem, 0, sizeof(QCBORItem));
 
-   uReturn = DecodeHead(pUInBuf, &nMajorType, &uArgument, &nAdditionalInfo);
+   uReturn = DecodeHead(pUInBuf,
+                        &nMajorType,
+                        &uArgument,
+                        &nAdditionalInfo,
+                        uChecks & QCBOR_CHECK_DCBOR);
    if(uReturn) {
       goto Done;
    }
@@ -1124,7 +1432,11 @@ DecodeAtomicDataItem(UsefulInputBuf               *pUInBuf,
          if(nAdditionalInfo == LEN_IS_INDEFINITE) {
             pDecodedItem->val.string = (UsefulBufC){NULL, QCBOR_STRING_LENGTH_INDEFINITE};
          } else {
-            uReturn = DecodeBytes(pAllocator, uArgument, pUInBuf, pDecodedItem);
+            uReturn = DecodeBytes(pAllocator,
+                                  uArgument,
+                                  (uChecks & QCBOR_CHECK_UTF8) && nMajorType == CBOR_MAJOR_TYPE_TEXT_STRING,
+                                  pUInBuf,
+                                  pDecodedItem);
          }
          break;
 
@@ -1161,7 +1473,10 @@ DecodeAtomicDataItem(UsefulInputBuf               *pUInBuf,
 
       case CBOR_MAJOR_TYPE_SIMPLE:
          /* Major type 7: float, double, true, false, null... */
-         uReturn = DecodeType7(nAdditionalInfo, uArgument, pDecodedItem);
+         uReturn = DecodeType7(nAdditionalInfo,
+                               uArgument,
+                               uChecks & QCBOR_CHECK_DCBOR,
+                               pDecodedItem);
          break;
 
       default:
@@ -1175,6 +1490,17 @@ Done:
 }
 
 
+/*
+ * Semi-private function, see qcbor_decode_private.h
+ */
+QCBORError
+QCBORDecode_Private_DecodeAtomicDataItem(UsefulInputBuf *pUInBuf,
+                                         QCBORItem      *pDecodedItem)
+{
+   return DecodeAtomicDataItem(pUInBuf, pDecodedItem, NULL, 0);
+}
+
+
 /**
  * @brief Process indefinite-length strings (decode layer 5).
  *
@@ -1244,8 +1570,18 @@ QCBORDecode_GetNextFullString(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
    }
 #endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
 
+   uint8_t uChecks = 0;
+   if(pMe->uDecodeMode == QCBOR_DECODE_MODE_DCBOR) {
+      uChecks = QCBOR_CHECK_UTF8 | QCBOR_CHECK_DCBOR;
+   } else if(pMe->bValidateUTF8) {
+      uChecks = QCBOR_CHECK_UTF8;
+   }
+
    QCBORError uReturn;
-   uReturn = DecodeAtomicDataItem(&(pMe->InBuf), pDecodedItem, pAllocatorForGetNext);
+   uReturn = DecodeAtomicDataItem(&(pMe->InBuf),
+                                  pDecodedItem,
+                                  pAllocatorForGetNext,
+                                  uChecks);
    if(uReturn != QCBOR_SUCCESS) {
       goto Done;
    }
@@ -1279,7 +1615,10 @@ QCBORDecode_GetNextFullString(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
        * be allocated. They are always copied in the the contiguous
        * buffer allocated here.
        */
-      uReturn = DecodeAtomicDataItem(&(pMe->InBuf), &StringChunkItem, NULL);
+      uReturn = DecodeAtomicDataItem(&(pMe->InBuf),
+                                     &StringChunkItem,
+                                     NULL,
+                                     uChecks);
       if(uReturn) {
          break;
       }
@@ -1492,6 +1831,82 @@ Done:
 }
 
 
+/* Whether map labels are checked with CheckMapLabelOrder() */
+static inline bool
+MapLabelOrder_IsChecked(const QCBORDecodeContext *pMe)
+{
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+   return pMe->bCheckLabelOrder || pMe->uDecodeMode == QCBOR_DECODE_MODE_DCBOR;
+#else /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+   (void)pMe;
+   return false;
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+}
+
+
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+/**
+ * @brief Check a map label against the previous one in the same map.
+ *
+ * @param[in] pMe          Decoder context.
+ * @param[in] uLabelStart  Offset of the encoded label in the input.
+ * @param[in] uLabelEnd    Offset just past the encoded label.
+ *
+ * @retval QCBOR_ERR_UNSORTED_LABEL
+ * @retval QCBOR_ERR_DUPLICATE_LABEL
+ *
+ * The encoded bytes of the labels are compared in bytewise
+ * lexicographic order, the order of deterministically encoded maps
+ * in RFC 8949 section 4.2.1. A shorter label that is a prefix of the
+ * longer sorts first. The label is then remembered in the current
+ * nesting level, so the map is checked in one pass over its labels.
+ */
+static QCBORError
+CheckMapLabelOrder(QCBORDecodeContext *pMe, size_t uLabelStart, size_t uLabelEnd)
+{
+   QCBORError uReturn = QCBOR_SUCCESS;
+   uint32_t   uLastStart;
+   uint32_t   uLastEnd;
+
+   DecodeNesting_GetLastLabel(&(pMe->nesting), &uLastStart, &uLastEnd);
+
+   if(uLastEnd != 0) {
+      const uint8_t *pInput     = pMe->InBuf.UB.ptr;
+      const size_t   uLastLen   = uLastEnd - uLastStart;
+      const size_t   uLabelLen  = uLabelEnd - uLabelStart;
+      const size_t   uCommonLen = uLastLen < uLabelLen ? uLastLen : uLabelLen;
+
+      int nCompare = memcmp(pInput + uLastStart, pInput + uLabelStart, uCommonLen);
+      if(nCompare == 0) {
+         if(uLastLen == uLabelLen) {
+            uReturn = QCBOR_ERR_DUPLICATE_LABEL;
+         } else if(uLastLen > uLabelLen) {
+            uReturn = QCBOR_ERR_UNSORTED_LABEL;
+         }
+      } else if(nCompare > 0) {
+         uReturn = QCBOR_ERR_UNSORTED_LABEL;
+      }
+   }
+
+   /* Casts are safe because the input size is limited to
+    * QCBOR_MAX_DECODE_INPUT_SIZE in QCBORDecode_Init().
+    */
+   DecodeNesting_SetLastLabel(&(pMe->nesting), (uint32_t)uLabelStart, (uint32_t)uLabelEnd);
+
+   return uReturn;
+}
+#else /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+static inline QCBORError
+CheckMapLabelOrder(QCBORDecodeContext *pMe, size_t uLabelStart, size_t uLabelEnd)
+{
+   (void)pMe;
+   (void)uLabelStart;
+   (void)uLabelEnd;
+   return QCBOR_SUCCESS;
+}
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+
+
 /**
  * @brief Combine a map entry label and value into one item (decode layer 3).
  *
@@ -1513,6 +1928,8 @@ Done:
  * @retval QCBOR_ERR_TOO_MANY_TAGS
  * @retval QCBOR_ERR_ARRAY_DECODE_TOO_LONG
  * @retval QCBOR_ERR_MAP_LABEL_TYPE
+ * @retval QCBOR_ERR_UNSORTED_LABEL
+ * @retval QCBOR_ERR_DUPLICATE_LABEL
  *
  * If a the current nesting level is a map, then this
  * combines pairs of items into one data item with a label
@@ -1528,6 +1945,8 @@ Done:
 static inline QCBORError
 QCBORDecode_GetNextMapEntry(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
 {
+   const size_t uLabelStart = UsefulInputBuf_Tell(&(pMe->InBuf));
+
    QCBORError uReturn = QCBORDecode_GetNextTagNumber(pMe, pDecodedItem);
    if(uReturn != QCBOR_SUCCESS) {
       goto Done;
@@ -1546,11 +1965,23 @@ QCBORDecode_GetNextMapEntry(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
           * be the real data item.
           */
          QCBORItem LabelItem = *pDecodedItem;
+         const size_t uLabelEnd = UsefulInputBuf_Tell(&(pMe->InBuf));
          uReturn = QCBORDecode_GetNextTagNumber(pMe, pDecodedItem);
          if(QCBORDecode_IsUnrecoverableError(uReturn)) {
             goto Done;
          }
 
+         if(MapLabelOrder_IsChecked(pMe)) {
+            /* Checked after the value is consumed so that traversal
+             * can continue after an error, as for other recoverable
+             * errors on the value.
+             */
+            const QCBORError uOrderErr = CheckMapLabelOrder(pMe, uLabelStart, uLabelEnd);
+            if(uReturn == QCBOR_SUCCESS) {
+               uReturn = uOrderErr;
+            }
+         }
+
          pDecodedItem->uLabelAlloc = LabelItem.uDataAlloc;
 
          if(LabelItem.uDataType == QCBOR_TYPE_TEXT_STRING) {
@@ -1607,7 +2038,7 @@ Done:
 /**
  * @brief Peek and see if next data item is a break;
  *
- * @param[in]  pUIB            UsefulInputBuf to read from.
+ * @param[in]  pMe             Decode context to read from.
  * @param[out] pbNextIsBreak   Indicate if next was a break or not.
  *
  * @return  Any decoding error.
@@ -1616,13 +2047,22 @@ Done:
  * if not it is not consumed.
 */
 static inline QCBORError
-NextIsBreak(UsefulInputBuf *pUIB, bool *pbNextIsBreak)
+NextIsBreak(QCBORDecodeContext *pMe, bool *pbNextIsBreak)
 {
+   UsefulInputBuf *pUIB = &(pMe->InBuf);
+
    *pbNextIsBreak = false;
+   if(UsefulInputBuf_BytesUnconsumed(pUIB) == 0 && Incremental_IsAtEnd(pMe)) {
+      /* The break may be in the input not yet added */
+      return QCBOR_ERR_NEED_MORE_INPUT;
+   }
    if(UsefulInputBuf_BytesUnconsumed(pUIB) != 0) {
       QCBORItem Peek;
       size_t uPeek = UsefulInputBuf_Tell(pUIB);
-      QCBORError uReturn = DecodeAtomicDataItem(pUIB, &Peek, NULL);
+      QCBORError uReturn = DecodeAtomicDataItem(pUIB, &Peek, NULL, 0);
+      if(uReturn == QCBOR_ERR_HIT_END && Incremental_IsAtEnd(pMe)) {
+         uReturn = QCBOR_ERR_NEED_MORE_INPUT;
+      }
       if(uReturn != QCBOR_SUCCESS) {
          return uReturn;
       }
@@ -1684,7 +2124,7 @@ QCBORDecode_NestLevelAscender(QCBORDecodeContext *pMe, bool bMarkEnd)
 
          /* Check for a break which is what ends indefinite-length arrays/maps */
          bool bIsBreak = false;
-         uReturn = NextIsBreak(&(pMe->InBuf), &bIsBreak);
+         uReturn = NextIsBreak(pMe, &bIsBreak);
          if(uReturn != QCBOR_SUCCESS) {
             goto Done;
          }
@@ -2286,7 +2726,14 @@ ProcessTaggedString(uint16_t uTag, QCBORItem *pDecodedItem)
 static QCBORError
 QCBORDecode_GetNextTagContent(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
 {
-   QCBORError uReturn;
+   QCBORError         uReturn;
+   UsefulInputBuf     SaveInBuf;
+   QCBORDecodeNesting SaveNesting;
+
+   if(Incremental_IsEnabled(pMe)) {
+      SaveInBuf   = pMe->InBuf;
+      SaveNesting = pMe->nesting;
+   }
 
    uReturn = QCBORDecode_GetNextMapOrArray(pMe, pDecodedItem);
    if(uReturn != QCBOR_SUCCESS) {
@@ -2355,6 +2802,9 @@ QCBORDecode_GetNextTagContent(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
    }
 
 Done:
+   if(uReturn != QCBOR_SUCCESS && Incremental_IsEnabled(pMe)) {
+      uReturn = Incremental_Rollback(pMe, uReturn, &SaveInBuf, &SaveNesting);
+   }
    return uReturn;
 }
 
@@ -2375,6 +2825,234 @@ QCBORDecode_GetNext(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
 }
 
 
+/**
+ * @brief Decode one item that has no tags with layers 1 to 6 in one.
+ *
+ * @param[in] pMe            Decoder context.
+ * @param[out] pDecodedItem  The decoded item.
+ * @param[out] puErr         The error for the item when it was decoded.
+ *
+ * @return @c false if nothing was consumed and the item needs the
+ *         full pipeline.
+ *
+ * This does what the decode layers do for an item, and for a map
+ * entry its label, that is not a tag, a break or an
+ * indefinite-length string, without going through them. Whenever it
+ * sees one of those, or anything that errors, it puts the input back
+ * where it was so QCBORDecode_GetNextTagContent() decodes the item
+ * from the start and gives exactly the same result and error. Nothing
+ * before the nesting is updated can be seen, since no strings are
+ * allocated.
+ */
+static bool
+QCBORDecode_Private_GetNextPlain(QCBORDecodeContext *pMe,
+                                 QCBORItem          *pDecodedItem,
+                                 QCBORError         *puErr)
+{
+   const UsefulInputBuf SaveInBuf = pMe->InBuf;
+
+   if(UsefulInputBuf_BytesUnconsumed(&(pMe->InBuf)) == 0 ||
+      DecodeNesting_IsAtEndOfBoundedLevel(&(pMe->nesting))) {
+      goto Fallback;
+   }
+
+   uint8_t uChecks = 0;
+   if(pMe->uDecodeMode == QCBOR_DECODE_MODE_DCBOR) {
+      uChecks = QCBOR_CHECK_UTF8 | QCBOR_CHECK_DCBOR;
+   } else if(pMe->bValidateUTF8) {
+      uChecks = QCBOR_CHECK_UTF8;
+   }
+
+   const size_t uLabelStart = UsefulInputBuf_Tell(&(pMe->InBuf));
+   size_t       uLabelEnd   = 0;
+   uint8_t      uLabelType  = QCBOR_TYPE_NONE;
+   UsefulBufC   LabelString = NULLUsefulBufC;
+   int64_t      nLabel      = 0;
+
+   const bool bIsMap = DecodeNesting_IsCurrentTypeMap(&(pMe->nesting));
+   if(bIsMap) {
+      if(DecodeAtomicDataItem(&(pMe->InBuf), pDecodedItem, NULL, uChecks) != QCBOR_SUCCESS) {
+         goto Fallback;
+      }
+      uLabelType = pDecodedItem->uDataType;
+      switch(uLabelType) {
+         case QCBOR_TYPE_TEXT_STRING:
+         case QCBOR_TYPE_BYTE_STRING:
+            if(pDecodedItem->val.string.len == QCBOR_STRING_LENGTH_INDEFINITE) {
+               goto Fallback;
+            }
+            LabelString = pDecodedItem->val.string;
+            break;
+
+         case QCBOR_TYPE_INT64:
+         case QCBOR_TYPE_UINT64:
+            /* Copied as 64 bits either way */
+            nLabel = pDecodedItem->val.int64;
+            break;
+
+         default:
+            /* Tags, breaks and label types that are errors */
+            goto Fallback;
+      }
+      uLabelEnd = UsefulInputBuf_Tell(&(pMe->InBuf));
+   }
+
+   if(DecodeAtomicDataItem(&(pMe->InBuf), pDecodedItem, NULL, uChecks) != QCBOR_SUCCESS) {
+      goto Fallback;
+   }
+   if(pDecodedItem->uDataType == QCBOR_TYPE_TAG || pDecodedItem->uDataType == QCBOR_TYPE_BREAK) {
+      goto Fallback;
+   }
+   if((pDecodedItem->uDataType == QCBOR_TYPE_TEXT_STRING ||
+       pDecodedItem->uDataType == QCBOR_TYPE_BYTE_STRING) &&
+      pDecodedItem->val.string.len == QCBOR_STRING_LENGTH_INDEFINITE) {
+      goto Fallback;
+   }
+
+   /* ==== Past here it is the same as the layers and not undone ==== */
+   memset(pDecodedItem->uTags, 0xff, sizeof(pDecodedItem->uTags));
+   *puErr = QCBOR_SUCCESS;
+
+   if(bIsMap) {
+      if(MapLabelOrder_IsChecked(pMe)) {
+         *puErr = CheckMapLabelOrder(pMe, uLabelStart, uLabelEnd);
+      }
+      pDecodedItem->uLabelType = uLabelType;
+      if(uLabelType == QCBOR_TYPE_TEXT_STRING || uLabelType == QCBOR_TYPE_BYTE_STRING) {
+         pDecodedItem->label.string = LabelString;
+      } else {
+         pDecodedItem->label.int64 = nLabel;
+      }
+   }
+
+   pDecodedItem->uNestingLevel = DecodeNesting_GetCurrentLevel(&(pMe->nesting));
+
+   if(QCBORItem_IsMapOrArray(pDecodedItem)) {
+      const QCBORError uDescendErr = DecodeNesting_DescendMapOrArray(&(pMe->nesting),
+                                                                     pDecodedItem->uDataType,
+                                                                     pDecodedItem->val.uCount);
+      if(uDescendErr != QCBOR_SUCCESS) {
+         *puErr = uDescendErr;
+         return true;
+      }
+   }
+
+   if(!QCBORItem_IsMapOrArray(pDecodedItem) ||
+       QCBORItem_IsEmptyDefiniteLengthMapOrArray(pDecodedItem) ||
+       QCBORItem_IsIndefiniteLengthMapOrArray(pDecodedItem)) {
+      const QCBORError uAscendErr = QCBORDecode_NestLevelAscender(pMe, true);
+      if(uAscendErr != QCBOR_SUCCESS) {
+         *puErr = uAscendErr;
+         return true;
+      }
+   }
+
+   if(DecodeNesting_IsAtEndOfBoundedLevel(&(pMe->nesting))) {
+      pDecodedItem->uNextNestLevel = 0;
+   } else {
+      pDecodedItem->uNextNestLevel = DecodeNesting_GetCurrentLevel(&(pMe->nesting));
+   }
+
+   return true;
+
+Fallback:
+   pMe->InBuf = SaveInBuf;
+   return false;
+}
+
+
+/* The modes that change labels, allocating all strings and input
+ * added in chunks always take the full pipeline.
+ */
+static inline bool
+QCBORDecode_Private_PlainAllowed(const QCBORDecodeContext *pMe)
+{
+   return (pMe->uDecodeMode == QCBOR_DECODE_MODE_NORMAL ||
+           pMe->uDecodeMode == QCBOR_DECODE_MODE_DCBOR) &&
+          !pMe->bStringAllocateAll &&
+          !Incremental_IsEnabled(pMe);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_decode.h file
+ */
+QCBORError
+QCBORDecode_GetNextPlain(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
+{
+   QCBORError uErr;
+
+   if(QCBORDecode_Private_PlainAllowed(pMe) &&
+      QCBORDecode_Private_GetNextPlain(pMe, pDecodedItem, &uErr)) {
+      goto Done;
+   }
+
+   uErr = QCBORDecode_GetNextTagContent(pMe, pDecodedItem);
+
+Done:
+   if(uErr != QCBOR_SUCCESS) {
+      pDecodedItem->uDataType  = QCBOR_TYPE_NONE;
+      pDecodedItem->uLabelType = QCBOR_TYPE_NONE;
+   }
+   return uErr;
+}
+
+
+/*
+ * Semi-private function, see qcbor_decode_private.h
+ */
+QCBORError
+QCBORDecode_Private_GetNextNoTagContent(QCBORDecodeContext *pMe,
+                                        QCBORItem          *pDecodedItem)
+{
+   QCBORError         uErr;
+   UsefulInputBuf     SaveInBuf;
+   QCBORDecodeNesting SaveNesting;
+
+   if(QCBORDecode_Private_PlainAllowed(pMe) &&
+      QCBORDecode_Private_GetNextPlain(pMe, pDecodedItem, &uErr)) {
+      return uErr;
+   }
+
+   /* Layers 2 to 6. Tag content is not decoded. */
+   if(Incremental_IsEnabled(pMe)) {
+      SaveInBuf   = pMe->InBuf;
+      SaveNesting = pMe->nesting;
+   }
+   uErr = QCBORDecode_GetNextMapOrArray(pMe, pDecodedItem);
+   if(uErr != QCBOR_SUCCESS && Incremental_IsEnabled(pMe)) {
+      uErr = Incremental_Rollback(pMe, uErr, &SaveInBuf, &SaveNesting);
+   }
+   return uErr;
+}
+
+
+/*
+ * Semi-private function, see qcbor_decode_private.h
+ */
+uint16_t
+QCBORDecode_Private_PlainArrayCount(const QCBORDecodeContext *pMe)
+{
+   if(!QCBORDecode_Private_PlainAllowed(pMe) ||
+      pMe->nesting.pCurrent != pMe->nesting.pCurrentBounded ||
+      !DecodeNesting_IsCurrentDefiniteLength(&(pMe->nesting)) ||
+      DecodeNesting_IsAtEndOfBoundedLevel(&(pMe->nesting))) {
+      return 0;
+   }
+   return pMe->nesting.pCurrent->u.ma.uCountCursor;
+}
+
+
+/*
+ * Semi-private function, see qcbor_decode_private.h
+ */
+bool
+QCBORDecode_Private_IsAtEndOfBounded(const QCBORDecodeContext *pMe)
+{
+   return DecodeNesting_IsAtEndOfBoundedLevel(&(pMe->nesting));
+}
+
+
 /*
  * Public function, see header qcbor/qcbor_decode.h file
  */
@@ -2480,7 +3158,7 @@ bool QCBORDecode_IsTagged(QCBORDecodeContext *pMe,
 QCBORError QCBORDecode_PartialFinish(QCBORDecodeContext *pMe, size_t *puConsumed)
 {
    if(puConsumed != NULL) {
-      *puConsumed = pMe->InBuf.cursor;
+      *puConsumed = pMe->InBuf.cursor + Incremental_Discarded(pMe);
    }
 
    QCBORError uReturn = pMe->uLastError;
@@ -2748,6 +3426,238 @@ static inline void CopyTags(QCBORDecodeContext *pMe, const QCBORItem *pItem)
 }
 
 
+/* Item count for SkipByHeads() that means up to a break */
+#define QCBOR_SKIP_TO_BREAK UINT32_MAX
+
+
+/* Returns true if skipping by heads gives the same result as
+ * decoding every item. The checks these options make can give
+ * recoverable errors before the value of a map entry is read, which
+ * changes the traversal. */
+static inline bool
+SkipByHeadsAllowed(const QCBORDecodeContext *pMe)
+{
+   return pMe->uDecodeMode != QCBOR_DECODE_MODE_DCBOR &&
+          !pMe->bValidateUTF8 &&
+          !pMe->bStringAllocateAll;
+}
+
+
+/**
+ * @brief Skip the contents of a map or array using only the heads.
+ *
+ * @param[in] pMe      The decode context.
+ * @param[in] uLevel   Nesting level of the map or array.
+ * @param[in] uItems   Number of items to skip or @ref QCBOR_SKIP_TO_BREAK.
+ * @param[in] bIsMap   If the items alternate between labels and values.
+ *
+ * @return true if skipped, false if full decoding is needed.
+ *
+ * This finds the end of the contents of a map or array whose head
+ * has been read by walking over the heads and skipping string
+ * contents. No QCBORItem is filled in and nothing is allocated. An
+ * explicit stack of item counts replaces the nesting tracking.
+ *
+ * This only handles the CBOR that decodes without error or with
+ * recoverable errors in values that don't change the traversal. On
+ * anything else, including CBOR that is not well-formed, exceeds
+ * implementation limits or needs tag content processing that reads
+ * further items, the cursor is put back and false is returned. Full
+ * decoding then finds and reports the error.
+ *
+ * On success the cursor is after the last item and after the break
+ * when skipping to a break. The nesting is not changed.
+ */
+static bool
+SkipByHeads(QCBORDecodeContext *pMe, uint8_t uLevel, uint32_t uItems, bool bIsMap)
+{
+   struct {
+      uint32_t uRemaining; /* Items left or QCBOR_SKIP_TO_BREAK */
+      bool     bIsMap;
+      bool     bLabelNext;
+   } aStack[QCBOR_MAX_ARRAY_NESTING + 1];
+
+   UsefulInputBuf *pUIB       = &(pMe->InBuf);
+   const size_t    uStart     = UsefulInputBuf_Tell(pUIB);
+   const bool      bMapLabels = pMe->uDecodeMode != QCBOR_DECODE_MODE_MAP_AS_ARRAY;
+   int             nDepth     = 0;
+   int             nTags      = 0;
+
+   if(UsefulInputBuf_GetError(pUIB)) {
+      /* Reads would return zeros without advancing */
+      return false;
+   }
+
+   aStack[0].uRemaining = uItems;
+   aStack[0].bIsMap     = bIsMap;
+   aStack[0].bLabelNext = bIsMap;
+
+   for(;;) {
+      /* Pop definite-length levels that are done */
+      while(aStack[nDepth].uRemaining == 0) {
+         if(nDepth == 0) {
+            return true;
+         }
+         nDepth--;
+      }
+
+      if(!UsefulInputBuf_BytesAvailable(pUIB, 1)) {
+         goto Fail;
+      }
+      const uint8_t uInitialByte    = UsefulInputBuf_GetByte(pUIB);
+      const int     nMajorType      = uInitialByte >> 5;
+      const int     nAdditionalInfo = uInitialByte & 0x1f;
+      uint64_t      uArgument;
+
+      if(nAdditionalInfo < LEN_IS_ONE_BYTE) {
+         uArgument = (uint64_t)nAdditionalInfo;
+      } else if(nAdditionalInfo <= LEN_IS_EIGHT_BYTES) {
+         const size_t uSize = (size_t)1 << (nAdditionalInfo - LEN_IS_ONE_BYTE);
+         if(!UsefulInputBuf_BytesAvailable(pUIB, uSize)) {
+            goto Fail;
+         }
+         switch(nAdditionalInfo) {
+            case LEN_IS_ONE_BYTE:   uArgument = UsefulInputBuf_GetByte(pUIB);   break;
+            case LEN_IS_TWO_BYTES:  uArgument = UsefulInputBuf_GetUint16(pUIB); break;
+            case LEN_IS_FOUR_BYTES: uArgument = UsefulInputBuf_GetUint32(pUIB); break;
+            default:                uArgument = UsefulInputBuf_GetUint64(pUIB); break;
+         }
+      } else if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+         uArgument = 0;
+      } else {
+         /* Reserved additional info */
+         goto Fail;
+      }
+
+      const bool bIsLabel = bMapLabels && aStack[nDepth].bIsMap && aStack[nDepth].bLabelNext;
+
+      if(nMajorType == CBOR_MAJOR_TYPE_TAG) {
+         /* Tags on labels are decoded differently. Tags 4 and 5 are
+          * decoded by reading the array they enclose. */
+         if(bIsLabel || nAdditionalInfo == LEN_IS_INDEFINITE ||
+            uArgument > QCBOR_LAST_UNMAPPED_TAG ||
+            uArgument == CBOR_TAG_DECIMAL_FRACTION || uArgument == CBOR_TAG_BIGFLOAT ||
+            ++nTags > QCBOR_MAX_TAGS_PER_ITEM) {
+            goto Fail;
+         }
+         continue;
+      }
+
+      if(nMajorType == CBOR_MAJOR_TYPE_SIMPLE && nAdditionalInfo == LEN_IS_INDEFINITE) {
+         /* A break, good only where an indefinite-length level ends */
+         if(nTags != 0 ||
+            aStack[nDepth].uRemaining != QCBOR_SKIP_TO_BREAK ||
+            (aStack[nDepth].bIsMap && !aStack[nDepth].bLabelNext)) {
+            goto Fail;
+         }
+         if(nDepth == 0) {
+            return true;
+         }
+         nDepth--;
+         continue;
+      }
+
+      /* Labels that decode with an error stop the value from being
+       * read, so only integers and definite-length strings here. */
+      if(bIsLabel &&
+         (nMajorType > CBOR_MAJOR_TYPE_TEXT_STRING ||
+          nAdditionalInfo == LEN_IS_INDEFINITE ||
+          (nMajorType == CBOR_MAJOR_TYPE_NEGATIVE_INT && uArgument > INT64_MAX))) {
+         goto Fail;
+      }
+
+      /* This is a data item in the current level */
+      nTags = 0;
+      if(aStack[nDepth].uRemaining != QCBOR_SKIP_TO_BREAK) {
+         aStack[nDepth].uRemaining--;
+      }
+      aStack[nDepth].bLabelNext = !aStack[nDepth].bLabelNext;
+
+      /* Items that decode with an error are not skipped even though
+       * the error is recoverable. The error would come from the peek
+       * for a break after a nested map or array in the full decode,
+       * which changes the traversal. */
+      switch(nMajorType) {
+         case CBOR_MAJOR_TYPE_POSITIVE_INT:
+            if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+               goto Fail;
+            }
+            break;
+
+         case CBOR_MAJOR_TYPE_NEGATIVE_INT:
+            if(nAdditionalInfo == LEN_IS_INDEFINITE || uArgument > INT64_MAX) {
+               goto Fail;
+            }
+            break;
+
+         case CBOR_MAJOR_TYPE_BYTE_STRING:
+         case CBOR_MAJOR_TYPE_TEXT_STRING:
+            /* Indefinite-length strings need a string allocator */
+            if(nAdditionalInfo == LEN_IS_INDEFINITE ||
+               uArgument > UsefulInputBuf_BytesUnconsumed(pUIB)) {
+               goto Fail;
+            }
+            UsefulInputBuf_Seek(pUIB, UsefulInputBuf_Tell(pUIB) + (size_t)uArgument);
+            break;
+
+         case CBOR_MAJOR_TYPE_ARRAY:
+         case CBOR_MAJOR_TYPE_MAP: {
+            const bool bNewIsMap = nMajorType == CBOR_MAJOR_TYPE_MAP;
+            uint32_t   uNewItems;
+            if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+               if(bNewIsMap && !bMapLabels) {
+                  /* Maps-as-arrays mode only takes definite-length maps */
+                  goto Fail;
+               }
+               uNewItems = QCBOR_SKIP_TO_BREAK;
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+               goto Fail;
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+            } else if(uArgument == 0) {
+               /* Empty definite-length doesn't descend */
+               break;
+            } else if(uArgument > (bNewIsMap && !bMapLabels ? QCBOR_MAX_ITEMS_IN_ARRAY/2 : QCBOR_MAX_ITEMS_IN_ARRAY)) {
+               goto Fail;
+            } else {
+               uNewItems = (uint32_t)(bNewIsMap ? uArgument * 2 : uArgument);
+            }
+            if(uLevel + nDepth >= QCBOR_MAX_ARRAY_NESTING) {
+               goto Fail;
+            }
+            nDepth++;
+            aStack[nDepth].uRemaining = uNewItems;
+            aStack[nDepth].bIsMap     = bNewIsMap;
+            aStack[nDepth].bLabelNext = bNewIsMap;
+            break;
+         }
+
+         default:
+            /* Simple values and floats */
+            if(nAdditionalInfo == LEN_IS_ONE_BYTE && uArgument <= CBOR_SIMPLE_BREAK) {
+               /* Two-byte encoding of simple values under 32 */
+               goto Fail;
+            }
+#ifdef QCBOR_DISABLE_PREFERRED_FLOAT
+            if(nAdditionalInfo == HALF_PREC_FLOAT) {
+               goto Fail;
+            }
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+#ifdef USEFULBUF_DISABLE_ALL_FLOAT
+            if(nAdditionalInfo >= HALF_PREC_FLOAT && nAdditionalInfo <= DOUBLE_PREC_FLOAT) {
+               goto Fail;
+            }
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+            break;
+      }
+   }
+
+Fail:
+   UsefulInputBuf_Seek(pUIB, uStart);
+   return false;
+}
+
+
 /*
  Consume an entire map or array (and do next to
  nothing for non-aggregate types).
@@ -2766,12 +3676,47 @@ ConsumeItem(QCBORDecodeContext *pMe,
    if(QCBORItem_IsMapOrArray(pItemToConsume) && !bIsEmpty) {
       /* There is only real work to do for non-empty maps and arrays */
 
+      if(SkipByHeadsAllowed(pMe)) {
+         const bool bIsMap = pItemToConsume->uDataType == QCBOR_TYPE_MAP;
+         uint32_t   uItems = pItemToConsume->val.uCount;
+         if(uItems == QCBOR_COUNT_INDICATES_INDEFINITE_LENGTH) {
+            uItems = QCBOR_SKIP_TO_BREAK;
+         } else if(bIsMap) {
+            uItems *= 2;
+         }
+         const size_t             uStart      = UsefulInputBuf_Tell(&(pMe->InBuf));
+         const QCBORDecodeNesting SaveNesting = pMe->nesting;
+         if(SkipByHeads(pMe, pItemToConsume->uNextNestLevel, uItems, bIsMap)) {
+            /* Out of the skipped map or array, then as if its last
+             * item had just been decoded. */
+            DecodeNesting_Ascend(&(pMe->nesting));
+            uReturn = QCBORDecode_NestLevelAscender(pMe, true);
+            if(uReturn == QCBOR_SUCCESS) {
+               if(DecodeNesting_IsAtEndOfBoundedLevel(&(pMe->nesting))) {
+                  *puNextNestLevel = 0;
+               } else {
+                  *puNextNestLevel = DecodeNesting_GetCurrentLevel(&(pMe->nesting));
+               }
+               goto Done;
+            }
+            if(QCBORDecode_IsUnrecoverableError(uReturn)) {
+               /* Same as the full decode of the last item gives */
+               goto Done;
+            }
+            /* The item after is in error. Let the full decode deal with it. */
+            pMe->nesting = SaveNesting;
+            UsefulInputBuf_Seek(&(pMe->InBuf), uStart);
+         }
+      }
+
       /* This works for definite- and indefinite- length
        * maps and arrays by using the nesting level
        */
       do {
          uReturn = QCBORDecode_GetNext(pMe, &Item);
-         if(QCBORDecode_IsUnrecoverableError(uReturn)) {
+         if(QCBORDecode_IsUnrecoverableError(uReturn) ||
+            uReturn == QCBOR_ERR_NO_MORE_ITEMS) {
+            /* No more items means the map or array is truncated */
             goto Done;
          }
       } while(Item.uNextNestLevel >= pItemToConsume->uNextNestLevel);
@@ -2795,11 +3740,24 @@ Done:
 
 void QCBORDecode_VGetNextConsume(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
 {
+   QCBORError         uErr;
+   UsefulInputBuf     SaveInBuf;
+   QCBORDecodeNesting SaveNesting;
+
+   if(Incremental_IsEnabled(pMe)) {
+      SaveInBuf   = pMe->InBuf;
+      SaveNesting = pMe->nesting;
+   }
+
    QCBORDecode_VGetNext(pMe, pDecodedItem);
 
    if(pMe->uLastError == QCBOR_SUCCESS) {
-      pMe->uLastError = (uint8_t)ConsumeItem(pMe, pDecodedItem,
-         &pDecodedItem->uNextNestLevel);
+      uErr = ConsumeItem(pMe, pDecodedItem, &pDecodedItem->uNextNestLevel);
+      if(uErr != QCBOR_SUCCESS && Incremental_IsEnabled(pMe)) {
+         /* The end of the item is not all there yet */
+         uErr = Incremental_Rollback(pMe, uErr, &SaveInBuf, &SaveNesting);
+      }
+      pMe->uLastError = (uint8_t)uErr;
    }
 }
 
@@ -2885,21 +3843,538 @@ MatchLabel(QCBORItem Item1, QCBORItem Item2)
 }
 
 
-/*
- Returns true if Item1 and Item2 are the same type
- or if either are of QCBOR_TYPE_ANY.
+/*
+ Returns true if Item1 and Item2 are the same type
+ or if either are of QCBOR_TYPE_ANY.
+ */
+static inline bool
+MatchType(QCBORItem Item1, QCBORItem Item2)
+{
+   if(Item1.uDataType == Item2.uDataType) {
+      return true;
+   } else if(Item1.uDataType == QCBOR_TYPE_ANY) {
+      return true;
+   } else if(Item2.uDataType == QCBOR_TYPE_ANY) {
+      return true;
+   }
+   return false;
+}
+
+
+/*
+ A map label normalized for ordering. nRank and uValue order integers
+ as their encoded heads do: non-negative integers ascending, then
+ negative integers descending. Byte strings then text strings follow
+ in order of length and then content. This is the order of the labels
+ in a deterministically encoded map.
+ */
+typedef struct {
+   int        nRank;
+   uint64_t   uValue;
+   UsefulBufC String;
+} MapIndexKey;
+
+
+static inline bool
+MapIndex_ItemKey(const QCBORItem *pItem, MapIndexKey *pKey)
+{
+   /* Only some of these are used, but -O2 can't always tell */
+   pKey->nRank  = 0;
+   pKey->uValue = 0;
+   pKey->String = NULLUsefulBufC;
+
+   switch(pItem->uLabelType) {
+      case QCBOR_TYPE_INT64:
+         if(pItem->label.int64 < 0) {
+            pKey->nRank  = 1;
+            pKey->uValue = (uint64_t)(-(pItem->label.int64 + 1));
+         } else {
+            pKey->nRank  = 0;
+            pKey->uValue = (uint64_t)pItem->label.int64;
+         }
+         return true;
+
+      case QCBOR_TYPE_UINT64:
+         pKey->nRank  = 0;
+         pKey->uValue = pItem->label.uint64;
+         return true;
+
+      case QCBOR_TYPE_BYTE_STRING:
+      case QCBOR_TYPE_TEXT_STRING:
+         pKey->nRank  = pItem->uLabelType == QCBOR_TYPE_BYTE_STRING ? 2 : 3;
+         pKey->String = pItem->label.string;
+         return true;
+
+      default:
+         /* Other label types are never matched */
+         return false;
+   }
+}
+
+
+static int
+MapIndex_CompareKeys(const MapIndexKey *pKey1, const MapIndexKey *pKey2)
+{
+   if(pKey1->nRank != pKey2->nRank) {
+      return pKey1->nRank < pKey2->nRank ? -1 : 1;
+   }
+   if(pKey1->nRank < 2) {
+      if(pKey1->uValue == pKey2->uValue) {
+         return 0;
+      }
+      return pKey1->uValue < pKey2->uValue ? -1 : 1;
+   }
+   if(pKey1->String.len != pKey2->String.len) {
+      return pKey1->String.len < pKey2->String.len ? -1 : 1;
+   }
+   if(pKey1->String.len == 0) {
+      return 0;
+   }
+   return memcmp(pKey1->String.ptr, pKey2->String.ptr, pKey1->String.len);
+}
+
+
+#ifdef QCBOR_ENABLE_MAP_INDEX
+
+/*
+ Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_SetMapIndex(QCBORDecodeContext *pMe, UsefulBuf IndexBuffer)
+{
+   /* Align the entries for their 64-bit labels */
+   const size_t uAlignMask = sizeof(uint64_t) - 1;
+   const size_t uSkip = (sizeof(uint64_t) - ((uintptr_t)IndexBuffer.ptr & uAlignMask)) & uAlignMask;
+
+   pMe->uMapIndexSize = 0;
+   pMe->uMapIndexTop  = QCBOR_MAP_INDEX_NONE;
+   if(IndexBuffer.ptr == NULL || IndexBuffer.len < uSkip) {
+      return;
+   }
+
+   pMe->pMapIndex = (QCBORMapIndexEntry *)(void *)((uint8_t *)IndexBuffer.ptr + uSkip);
+   const size_t uSize = (IndexBuffer.len - uSkip) / sizeof(QCBORMapIndexEntry);
+   /* Slot numbers must not reach QCBOR_MAP_INDEX_NONE */
+   pMe->uMapIndexSize = uSize >= UINT32_MAX ? UINT32_MAX - 1 : (uint32_t)uSize;
+}
+
+
+static inline void
+MapIndex_EntryKey(const QCBORDecodeContext *pMe,
+                  const QCBORMapIndexEntry *pEntry,
+                  MapIndexKey              *pKey)
+{
+   /* Only one of these is used, but -O2 can't always tell */
+   pKey->uValue = 0;
+   pKey->String = NULLUsefulBufC;
+
+   switch(pEntry->item.uLabelType) {
+      case QCBOR_TYPE_INT64:
+         if(pEntry->item.label.int64 < 0) {
+            pKey->nRank  = 1;
+            pKey->uValue = (uint64_t)(-(pEntry->item.label.int64 + 1));
+         } else {
+            pKey->nRank  = 0;
+            pKey->uValue = (uint64_t)pEntry->item.label.int64;
+         }
+         break;
+
+      case QCBOR_TYPE_UINT64:
+         pKey->nRank  = 0;
+         pKey->uValue = pEntry->item.label.uint64;
+         break;
+
+      default:
+         pKey->nRank      = pEntry->item.uLabelType == QCBOR_TYPE_BYTE_STRING ? 2 : 3;
+         pKey->String.ptr = (const uint8_t *)pMe->InBuf.UB.ptr + pEntry->item.label.string.uOffset;
+         pKey->String.len = pEntry->item.label.string.uLen;
+         break;
+   }
+}
+
+
+/* The slot describing the last map indexed */
+static inline QCBORMapIndexEntry *
+MapIndex_Map(const QCBORDecodeContext *pMe)
+{
+   return &(pMe->pMapIndex[pMe->uMapIndexTop]);
+}
+
+
+/* The labels of the last map indexed */
+static inline QCBORMapIndexEntry *
+MapIndex_Entries(const QCBORDecodeContext *pMe)
+{
+   return MapIndex_Map(pMe) + 1;
+}
+
+
+static int
+MapIndex_CompareEntries(const QCBORDecodeContext *pMe, uint32_t uIndex1, uint32_t uIndex2)
+{
+   const QCBORMapIndexEntry *pEntries = MapIndex_Entries(pMe);
+   MapIndexKey               Key1;
+   MapIndexKey               Key2;
+
+   MapIndex_EntryKey(pMe, &pEntries[uIndex1], &Key1);
+   MapIndex_EntryKey(pMe, &pEntries[uIndex2], &Key2);
+
+   return MapIndex_CompareKeys(&Key1, &Key2);
+}
+
+
+/*
+ Heapsort of the index so maps that are not deterministically
+ encoded can be indexed too. No recursion or memory allocation.
+ */
+static void
+MapIndex_Sort(QCBORDecodeContext *pMe, uint32_t uCount)
+{
+   QCBORMapIndexEntry *pEntries = MapIndex_Entries(pMe);
+
+   for(uint32_t uEnd = uCount, uStart = uCount / 2; uEnd > 1; ) {
+      if(uStart > 0) {
+         /* Building the heap */
+         uStart--;
+      } else {
+         /* Move the largest to the end */
+         uEnd--;
+         const QCBORMapIndexEntry Tmp = pEntries[0];
+         pEntries[0]    = pEntries[uEnd];
+         pEntries[uEnd] = Tmp;
+      }
+
+      /* Sift down */
+      uint32_t uRoot = uStart;
+      for(;;) {
+         uint32_t uChild = 2 * uRoot + 1;
+         if(uChild >= uEnd) {
+            break;
+         }
+         if(uChild + 1 < uEnd && MapIndex_CompareEntries(pMe, uChild, uChild + 1) < 0) {
+            uChild++;
+         }
+         if(MapIndex_CompareEntries(pMe, uRoot, uChild) >= 0) {
+            break;
+         }
+         const QCBORMapIndexEntry Tmp = pEntries[uRoot];
+         pEntries[uRoot]  = pEntries[uChild];
+         pEntries[uChild] = Tmp;
+         uRoot = uChild;
+      }
+   }
+}
+
+
+/**
+ @brief Index the labels of the current bounded map.
+
+ @param[in] pMe    The decode context.
+ @param[in] uSlot  Where in the index buffer to put it.
+
+ @return true if the map has more labels than fit.
+
+ This traverses the map once like MapSearch() and records the label
+ and offset of every item in the slots after @c uSlot. @c uSlot
+ describes the map and becomes the last map indexed. The index is
+ marked unusable if the map has an error of any sort, has too many
+ items or has allocated string labels. MapSearch() then does the work
+ without the index and reports any errors. The cursor and nesting are
+ not changed.
+ */
+static bool
+MapIndex_Build(QCBORDecodeContext *pMe, uint32_t uSlot)
+{
+   const UsefulInputBuf SaveInBuf = pMe->InBuf;
+   uint32_t             uCount    = 0;
+   bool                 bNoRoom   = false;
+
+   QCBORMapIndexEntry *pMap = &(pMe->pMapIndex[uSlot]);
+   pMap->map.uStart    = DecodeNesting_GetMapOrArrayStart(&(pMe->nesting));
+   /* Until it is indexed it encloses no other map */
+   pMap->map.uEnd      = pMap->map.uStart;
+   pMap->map.uCount    = QCBOR_MAP_INDEX_UNUSABLE;
+   pMap->map.uPrevious = uSlot == 0 ? QCBOR_MAP_INDEX_NONE : pMe->uMapIndexTop;
+   pMe->uMapIndexTop   = uSlot;
+
+   QCBORMapIndexEntry *pEntries = pMap + 1;
+   const uint32_t      uRoom    = pMe->uMapIndexSize - uSlot - 1;
+
+   QCBORDecodeNesting SaveNesting;
+   DecodeNesting_PrepareForMapSearch(&(pMe->nesting), &SaveNesting);
+
+   RewindMapOrArray(pMe);
+
+   const uint8_t *pInput        = pMe->InBuf.UB.ptr;
+   const uint8_t  uMapNestLevel = DecodeNesting_GetBoundedModeLevel(&(pMe->nesting));
+   uint8_t        uNextNestLevel;
+   do {
+      const size_t uOffset = UsefulInputBuf_Tell(&(pMe->InBuf));
+
+      QCBORItem Item;
+      if(QCBORDecode_GetNextTagContent(pMe, &Item) != QCBOR_SUCCESS) {
+         goto Done;
+      }
+      if(uCount == uRoom) {
+         bNoRoom = true;
+         goto Done;
+      }
+
+      QCBORMapIndexEntry *pEntry = &pEntries[uCount];
+      switch(Item.uLabelType) {
+         case QCBOR_TYPE_INT64:
+            pEntry->item.label.int64 = Item.label.int64;
+            break;
+
+         case QCBOR_TYPE_UINT64:
+            pEntry->item.label.uint64 = Item.label.uint64;
+            break;
+
+         case QCBOR_TYPE_BYTE_STRING:
+         case QCBOR_TYPE_TEXT_STRING:
+            if(Item.uLabelAlloc) {
+               goto Done;
+            }
+            /* Not allocated so it is in the input. Casts are OK
+             * because the input is less than QCBOR_MAX_DECODE_INPUT_SIZE */
+            pEntry->item.label.string.uOffset = (uint32_t)((const uint8_t *)Item.label.string.ptr - pInput);
+            pEntry->item.label.string.uLen    = (uint32_t)Item.label.string.len;
+            break;
+
+         default:
+            goto Done;
+      }
+      pEntry->item.uLabelType  = Item.uLabelType;
+      pEntry->item.uItemOffset = (uint32_t)uOffset;
+      /* Cast is OK because GetNext() limits the items in a map */
+      pEntry->item.uPosition   = (uint16_t)uCount;
+      uCount++;
+
+      if(ConsumeItem(pMe, &Item, &uNextNestLevel) != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   } while(uNextNestLevel >= uMapNestLevel);
+
+   const size_t uEndOffset = UsefulInputBuf_Tell(&(pMe->InBuf));
+   if((uint32_t)uEndOffset >= QCBOR_MAX_DECODE_INPUT_SIZE) {
+      goto Done;
+   }
+
+   /* D-CBOR maps are already in order */
+   for(uint32_t i = 1; i < uCount; i++) {
+      if(MapIndex_CompareEntries(pMe, i - 1, i) > 0) {
+         MapIndex_Sort(pMe, uCount);
+         break;
+      }
+   }
+
+   pMap->map.uCount        = uCount;
+   pMap->map.uEnd          = (uint32_t)uEndOffset;
+   pMe->uMapEndOffsetCache = (uint32_t)uEndOffset;
+
+Done:
+   DecodeNesting_RestoreFromMapSearch(&(pMe->nesting), &SaveNesting);
+   /* Also clears a read error from a map that is not all there */
+   pMe->InBuf = SaveInBuf;
+
+   return bNoRoom;
+}
+
+
+static inline bool
+MapIndex_IsEnabled(const QCBORDecodeContext *pMe)
+{
+   return pMe->uMapIndexSize != 0 && pMe->uDecodeMode != QCBOR_DECODE_MODE_MAP_AS_ARRAY;
+}
+
+
+/* Returns true if the current bounded map has a usable index,
+ * building it if needed.
+ *
+ * The indexes of the maps it is in are kept before it in the buffer
+ * so exiting back to one of them doesn't index it again. Those of
+ * maps that were exited are dropped. */
+static bool
+MapIndex_IsUsable(QCBORDecodeContext *pMe)
+{
+   if(!MapIndex_IsEnabled(pMe) || !DecodeNesting_IsBoundedType(&(pMe->nesting), QCBOR_TYPE_MAP)) {
+      return false;
+   }
+
+   const uint32_t uStart = DecodeNesting_GetMapOrArrayStart(&(pMe->nesting));
+   uint32_t       uSlot  = 0;
+   while(pMe->uMapIndexTop != QCBOR_MAP_INDEX_NONE) {
+      const QCBORMapIndexEntry *pMap = MapIndex_Map(pMe);
+      if(pMap->map.uStart == uStart) {
+         return pMap->map.uCount != QCBOR_MAP_INDEX_UNUSABLE;
+      }
+      if(pMap->map.uStart < uStart && uStart < pMap->map.uEnd) {
+         /* The current map is in this one */
+         uSlot = pMe->uMapIndexTop + 1 + pMap->map.uCount;
+         break;
+      }
+      pMe->uMapIndexTop = pMap->map.uPrevious;
+   }
+
+   if((uSlot >= pMe->uMapIndexSize || MapIndex_Build(pMe, uSlot)) && uSlot != 0) {
+      /* No room after the enclosing maps, so index it in their place */
+      MapIndex_Build(pMe, 0);
+   }
+   return MapIndex_Map(pMe)->map.uCount != QCBOR_MAP_INDEX_UNUSABLE;
+}
+
+
+static bool
+MapIndex_Find(const QCBORDecodeContext *pMe, const MapIndexKey *pKey, uint32_t *puIndex)
+{
+   const QCBORMapIndexEntry *pEntries = MapIndex_Entries(pMe);
+   const uint32_t            uCount   = MapIndex_Map(pMe)->map.uCount;
+   MapIndexKey               EntryKey;
+
+   /* Direct addressing of dense small integer labels. In the sorted
+    * index, label n at position n means labels 0 to n are all there. */
+   if(pKey->nRank == 0 && pKey->uValue < uCount) {
+      MapIndex_EntryKey(pMe, &pEntries[pKey->uValue], &EntryKey);
+      if(MapIndex_CompareKeys(&EntryKey, pKey) == 0) {
+         *puIndex = (uint32_t)pKey->uValue;
+         return true;
+      }
+   }
+
+   uint32_t uLow  = 0;
+   uint32_t uHigh = uCount;
+   while(uLow < uHigh) {
+      const uint32_t uMid = uLow + (uHigh - uLow) / 2;
+      MapIndex_EntryKey(pMe, &pEntries[uMid], &EntryKey);
+      const int nCompare = MapIndex_CompareKeys(&EntryKey, pKey);
+      if(nCompare == 0) {
+         *puIndex = uMid;
+         return true;
+      } else if(nCompare < 0) {
+         uLow = uMid + 1;
+      } else {
+         uHigh = uMid;
+      }
+   }
+   return false;
+}
+
+
+/**
+ @brief MapSearch() using the index of the current bounded map.
+
+ @param[in]  pMe                The decode context to search.
+ @param[in,out] pItemArray      The items to search for and the items found.
+ @param[out] puOffset           Byte offset of last item matched.
+ @param[out] puFoundItemBitMap  Bit set for each item found.
+
+ Same results as MapSearch() without a callback. Only the items found
+ are decoded. The cursor is left at the end of the map as MapSearch()
+ leaves it.
+ */
+static QCBORError
+MapIndex_Search(QCBORDecodeContext *pMe,
+                QCBORItem          *pItemArray,
+                size_t             *puOffset,
+                uint64_t           *puFoundItemBitMap)
+{
+   QCBORError                uReturn = QCBOR_SUCCESS;
+   const QCBORMapIndexEntry *pMap    = MapIndex_Map(pMe);
+
+   QCBORDecodeNesting SaveNesting;
+   DecodeNesting_PrepareForMapSearch(&(pMe->nesting), &SaveNesting);
+
+   for(int nIndex = 0; pItemArray[nIndex].uLabelType != QCBOR_TYPE_NONE; nIndex++) {
+      MapIndexKey Key;
+      uint32_t    uFound;
+      if(!MapIndex_ItemKey(&pItemArray[nIndex], &Key) || !MapIndex_Find(pMe, &Key, &uFound)) {
+         continue;
+      }
+
+      /* Equal labels are next to each other in the sorted index */
+      if((uFound > 0 && MapIndex_CompareEntries(pMe, uFound - 1, uFound) == 0) ||
+         (uFound + 1 < pMap->map.uCount && MapIndex_CompareEntries(pMe, uFound, uFound + 1) == 0)) {
+         uReturn = QCBOR_ERR_DUPLICATE_LABEL;
+         goto Done;
+      }
+
+      /* Decode just this item with the nesting as if it had been
+       * reached by traversal. */
+      const QCBORMapIndexEntry *pEntry = &(pMap[1 + uFound]);
+      DecodeNesting_SetCurrentToBoundedLevel(&(pMe->nesting));
+      DecodeNesting_SetMapOrArrayPosition(&(pMe->nesting), pEntry->item.uPosition);
+      UsefulInputBuf_Seek(&(pMe->InBuf), pEntry->item.uItemOffset);
+
+      QCBORItem Item;
+      uReturn = QCBORDecode_GetNextTagContent(pMe, &Item);
+      DecodeNesting_RestoreFromMapSearch(&(pMe->nesting), &SaveNesting);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+      if(!MatchType(Item, pItemArray[nIndex])) {
+         uReturn = QCBOR_ERR_UNEXPECTED_TYPE;
+         goto Done;
+      }
+
+      pItemArray[nIndex] = Item;
+      *puFoundItemBitMap |= 0x01ULL << nIndex;
+      if(puOffset) {
+         *puOffset = pEntry->item.uItemOffset;
+      }
+   }
+
+Done:
+   DecodeNesting_RestoreFromMapSearch(&(pMe->nesting), &SaveNesting);
+   UsefulInputBuf_Seek(&(pMe->InBuf), pMap->map.uEnd);
+   pMe->uMapEndOffsetCache = pMap->map.uEnd;
+
+   return uReturn;
+}
+
+#endif /* QCBOR_ENABLE_MAP_INDEX */
+
+
+/**
+ @brief Find the end of the current bounded map or array by heads only.
+
+ @param[in]  pMe           The decode context.
+
+ @return true if the end was found, false if full decoding is needed.
+
+ This is for exiting a map or array without a cached end. No items
+ are decoded so the label order check needs full decoding. On
+ success the cursor is at the end as MapSearch() leaves it.
  */
-static inline bool
-MatchType(QCBORItem Item1, QCBORItem Item2)
+static bool
+SkipToBoundedEnd(QCBORDecodeContext *pMe)
 {
-   if(Item1.uDataType == Item2.uDataType) {
-      return true;
-   } else if(Item1.uDataType == QCBOR_TYPE_ANY) {
-      return true;
-   } else if(Item2.uDataType == QCBOR_TYPE_ANY) {
-      return true;
+   if(!SkipByHeadsAllowed(pMe) || MapLabelOrder_IsChecked(pMe)) {
+      return false;
    }
-   return false;
+
+   const QCBORDecodeNesting *pNesting = &(pMe->nesting);
+   const bool bIsMap = pNesting->pCurrentBounded->uLevelType == QCBOR_TYPE_MAP;
+   uint32_t   uItems = pNesting->pCurrentBounded->u.ma.uCountTotal;
+   if(uItems == QCBOR_COUNT_INDICATES_INDEFINITE_LENGTH) {
+      uItems = QCBOR_SKIP_TO_BREAK;
+   } else if(bIsMap) {
+      uItems *= 2;
+   }
+
+   const size_t uSaveCursor = UsefulInputBuf_Tell(&(pMe->InBuf));
+   UsefulInputBuf_Seek(&(pMe->InBuf), DecodeNesting_GetMapOrArrayStart(pNesting));
+   if(!SkipByHeads(pMe, DecodeNesting_GetBoundedModeLevel(pNesting), uItems, bIsMap)) {
+      UsefulInputBuf_Seek(&(pMe->InBuf), uSaveCursor);
+      return false;
+   }
+
+   const size_t uEndOffset = UsefulInputBuf_Tell(&(pMe->InBuf));
+   if((uint32_t)uEndOffset >= QCBOR_MAX_DECODE_INPUT_SIZE) {
+      UsefulInputBuf_Seek(&(pMe->InBuf), uSaveCursor);
+      return false;
+   }
+   /* Cast OK because encoded CBOR is limited to UINT32_MAX */
+   pMe->uMapEndOffsetCache = (uint32_t)uEndOffset;
+   return true;
 }
 
 
@@ -2972,7 +4447,21 @@ MapSearch(QCBORDecodeContext *pMe,
       goto Done2;
    }
 
-   QCBORDecodeNesting SaveNesting;
+#ifdef QCBOR_ENABLE_MAP_INDEX
+   if(pfCallback == NULL && MapIndex_IsUsable(pMe)) {
+      uReturn = MapIndex_Search(pMe, pItemArray, puOffset, &uFoundItemBitMap);
+      goto Done2;
+   }
+#endif /* QCBOR_ENABLE_MAP_INDEX */
+
+   if(pItemArray->uLabelType == QCBOR_TYPE_NONE && pfCallback == NULL &&
+      SkipToBoundedEnd(pMe)) {
+      uReturn = QCBOR_SUCCESS;
+      goto Done2;
+   }
+
+   const UsefulInputBuf SaveInBuf = pMe->InBuf;
+   QCBORDecodeNesting   SaveNesting;
    DecodeNesting_PrepareForMapSearch(&(pMe->nesting), &SaveNesting);
 
    /* Reposition to search from the start of the map / array */
@@ -3014,6 +4503,12 @@ MapSearch(QCBORDecodeContext *pMe,
          uReturn = uResult;
          goto Done;
       }
+      if(uResult == QCBOR_ERR_UNSORTED_LABEL || uResult == QCBOR_ERR_DUPLICATE_LABEL) {
+         /* From QCBORDecode_SetMapLabelOrderCheck(). It applies to
+          * all the labels, not just those of interest. */
+         uReturn = uResult;
+         goto Done;
+      }
 
       /* See if item has one of the labels that are of interest */
       bool bMatched = false;
@@ -3090,6 +4585,11 @@ MapSearch(QCBORDecodeContext *pMe,
 
  Done:
    DecodeNesting_RestoreFromMapSearch(&(pMe->nesting), &SaveNesting);
+   if(uReturn == QCBOR_ERR_NEED_MORE_INPUT) {
+      /* So the search can be repeated when there is more input */
+      pMe->InBuf = SaveInBuf;
+      uReturn = Incremental_CheckRoom(pMe);
+   }
 
  Done2:
    /* For all items not found, set the data and label type to QCBOR_TYPE_NONE */
@@ -3104,6 +4604,215 @@ MapSearch(QCBORDecodeContext *pMe,
 }
 
 
+/* The most items that can be searched for at once. One bit each in
+ * the found item bit map. */
+#define QCBOR_MAX_ITEMS_IN_SEARCH 64
+
+
+/**
+ @brief Search a map in deterministic label order for a set of items.
+
+ @param[in]  pMe           The decode context to search.
+ @param[in,out] pItemArray The items to search for and the items found.
+
+ @retval QCBOR_ERR_UNSORTED_LABEL  The labels in the map are not in order.
+
+ @retval QCBOR_ERR_ARRAY_DECODE_TOO_LONG  More than
+                                          QCBOR_MAX_ITEMS_IN_SEARCH items
+                                          in pItemArray.
+
+ Otherwise the same results as MapSearch() without a callback for the
+ part of the map walked.
+
+ The labels searched for are put in deterministic order and merged
+ with the labels in the map. The walk through the map stops at the
+ first label past the largest one searched for. Because equal labels
+ must be next to each other in an ordered map, duplicates of the
+ labels searched for are still detected. Like MapSearch(), duplicates
+ of other labels are not errors. Unlike MapSearch(), the cursor is not
+ changed, since moving it to the end of the map would mean walking
+ all of it.
+ */
+static QCBORError
+MapSearchSorted(QCBORDecodeContext *pMe, QCBORItem *pItemArray)
+{
+   QCBORError uReturn;
+   uint64_t   uFoundItemBitMap = 0;
+   uint8_t    auOrder[QCBOR_MAX_ITEMS_IN_SEARCH];
+   int        nSorted = 0;
+
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      uReturn = pMe->uLastError;
+      goto Done2;
+   }
+
+   if(!DecodeNesting_IsBoundedType(&(pMe->nesting), QCBOR_TYPE_MAP)) {
+      uReturn = QCBOR_ERR_MAP_NOT_ENTERED;
+      goto Done2;
+   }
+
+   /* Insertion sort of the item positions by label. The list is short. */
+   for(int nIndex = 0; pItemArray[nIndex].uLabelType != QCBOR_TYPE_NONE; nIndex++) {
+      if(nIndex == QCBOR_MAX_ITEMS_IN_SEARCH) {
+         uReturn = QCBOR_ERR_ARRAY_DECODE_TOO_LONG;
+         goto Done2;
+      }
+      MapIndexKey Key;
+      if(!MapIndex_ItemKey(&pItemArray[nIndex], &Key)) {
+         /* Other label types are never matched */
+         continue;
+      }
+      int nInsert = nSorted;
+      while(nInsert > 0) {
+         MapIndexKey Before;
+         MapIndex_ItemKey(&pItemArray[auOrder[nInsert - 1]], &Before);
+         if(MapIndex_CompareKeys(&Before, &Key) <= 0) {
+            break;
+         }
+         auOrder[nInsert] = auOrder[nInsert - 1];
+         nInsert--;
+      }
+      /* Cast is OK because of the check against QCBOR_MAX_ITEMS_IN_SEARCH */
+      auOrder[nInsert] = (uint8_t)nIndex;
+      nSorted++;
+   }
+
+   if(DecodeNesting_IsBoundedEmpty(&(pMe->nesting)) || nSorted == 0) {
+      /* Nothing is ever found. All items are marked as not found below. */
+      uReturn = QCBOR_SUCCESS;
+      goto Done2;
+   }
+
+   const UsefulInputBuf SaveInBuf = pMe->InBuf;
+
+#ifdef QCBOR_ENABLE_MAP_INDEX
+   if(MapIndex_IsUsable(pMe)) {
+      uReturn = MapIndex_Search(pMe, pItemArray, NULL, &uFoundItemBitMap);
+      pMe->InBuf = SaveInBuf;
+      goto Done2;
+   }
+#endif /* QCBOR_ENABLE_MAP_INDEX */
+
+   QCBORDecodeNesting SaveNesting;
+   DecodeNesting_PrepareForMapSearch(&(pMe->nesting), &SaveNesting);
+
+   RewindMapOrArray(pMe);
+
+   MapIndexKey Largest;
+   MapIndex_ItemKey(&pItemArray[auOrder[nSorted - 1]], &Largest);
+
+   /* Not compared until bHavePrevious is set */
+   MapIndexKey   Previous        = Largest;
+   bool          bHavePrevious   = false;
+   bool          bPreviousSought = false;
+   int           nNext           = 0;
+   const uint8_t uMapNestLevel   = DecodeNesting_GetBoundedModeLevel(&(pMe->nesting));
+   uint8_t       uNextNestLevel;
+   do {
+      QCBORItem  Item;
+      QCBORError uResult = QCBORDecode_GetNextTagContent(pMe, &Item);
+      if(QCBORDecode_IsUnrecoverableError(uResult) ||
+         uResult == QCBOR_ERR_NO_MORE_ITEMS ||
+         uResult == QCBOR_ERR_UNSORTED_LABEL ||
+         uResult == QCBOR_ERR_DUPLICATE_LABEL) {
+         uReturn = uResult;
+         goto Done;
+      }
+
+      MapIndexKey Key;
+      if(MapIndex_ItemKey(&Item, &Key)) {
+         if(bHavePrevious) {
+            const int nCompare = MapIndex_CompareKeys(&Previous, &Key);
+            if(nCompare == 0 && bPreviousSought) {
+               uReturn = QCBOR_ERR_DUPLICATE_LABEL;
+               goto Done;
+            } else if(nCompare > 0) {
+               uReturn = QCBOR_ERR_UNSORTED_LABEL;
+               goto Done;
+            }
+         }
+
+         if(MapIndex_CompareKeys(&Key, &Largest) > 0) {
+            /* Past all the labels of interest */
+            uReturn = QCBOR_SUCCESS;
+            goto Done;
+         }
+
+         /* Skip the labels searched for that are not in the map */
+         MapIndexKey Sought   = Key;
+         int         nCompare = -1;
+         while(nNext < nSorted) {
+            MapIndex_ItemKey(&pItemArray[auOrder[nNext]], &Sought);
+            nCompare = MapIndex_CompareKeys(&Sought, &Key);
+            if(nCompare >= 0) {
+               break;
+            }
+            nNext++;
+         }
+
+         /* The same label may be searched for more than once */
+         const bool bSought = nNext < nSorted && nCompare == 0;
+         while(nNext < nSorted && nCompare == 0) {
+            const int nIndex = auOrder[nNext];
+            if(uResult != QCBOR_SUCCESS) {
+               /* The label matches, but the data item is in error */
+               uReturn = uResult;
+               goto Done;
+            }
+            if(!MatchType(Item, pItemArray[nIndex])) {
+               uReturn = QCBOR_ERR_UNEXPECTED_TYPE;
+               goto Done;
+            }
+            pItemArray[nIndex] = Item;
+            uFoundItemBitMap |= 0x01ULL << nIndex;
+            nNext++;
+            if(nNext < nSorted) {
+               MapIndex_ItemKey(&pItemArray[auOrder[nNext]], &Sought);
+               nCompare = MapIndex_CompareKeys(&Sought, &Key);
+            }
+         }
+
+         Previous        = Key;
+         bHavePrevious   = true;
+         bPreviousSought = bSought;
+      }
+
+      uReturn = ConsumeItem(pMe, &Item, &uNextNestLevel);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   } while(uNextNestLevel >= uMapNestLevel);
+
+   uReturn = QCBOR_SUCCESS;
+
+   /* The whole map was traversed so its end is known */
+   const size_t uEndOffset = UsefulInputBuf_Tell(&(pMe->InBuf));
+   if((uint32_t)uEndOffset >= QCBOR_MAX_DECODE_INPUT_SIZE) {
+      uReturn = QCBOR_ERR_INPUT_TOO_LARGE;
+      goto Done;
+   }
+   /* Cast OK because encoded CBOR is limited to UINT32_MAX */
+   pMe->uMapEndOffsetCache = (uint32_t)uEndOffset;
+
+Done:
+   DecodeNesting_RestoreFromMapSearch(&(pMe->nesting), &SaveNesting);
+   pMe->InBuf = SaveInBuf;
+   if(uReturn == QCBOR_ERR_NEED_MORE_INPUT) {
+      uReturn = Incremental_CheckRoom(pMe);
+   }
+
+Done2:
+   for(int i = 0; pItemArray[i].uLabelType != QCBOR_TYPE_NONE && i < QCBOR_MAX_ITEMS_IN_SEARCH; i++) {
+      if(!(uFoundItemBitMap & (0x01ULL << i))) {
+         pItemArray[i].uDataType  = QCBOR_TYPE_NONE;
+         pItemArray[i].uLabelType = QCBOR_TYPE_NONE;
+      }
+   }
+
+   return uReturn;
+}
+
+
 /*
  Public function, see header qcbor/qcbor_decode.h file
 */
@@ -3300,6 +5009,15 @@ void QCBORDecode_GetItemsInMap(QCBORDecodeContext *pMe, QCBORItem *pItemList)
    pMe->uLastError = (uint8_t)uErr;
 }
 
+/*
+ Public function, see header qcbor/qcbor_spiffy_decode.h file
+*/
+void QCBORDecode_GetItemsInSortedMap(QCBORDecodeContext *pMe, QCBORItem *pItemList)
+{
+   QCBORError uErr = MapSearchSorted(pMe, pItemList);
+   pMe->uLastError = (uint8_t)uErr;
+}
+
 /*
  Public function, see header qcbor/qcbor_decode.h file
 */
@@ -3477,6 +5195,12 @@ void QCBORDecode_EnterBoundedMapOrArray(QCBORDecodeContext *pMe, uint8_t uType,
    uErr = DecodeNesting_EnterBoundedMapOrArray(&(pMe->nesting), bIsEmpty,
                                                UsefulInputBuf_Tell(&(pMe->InBuf)));
 
+#ifdef QCBOR_ENABLE_MAP_INDEX
+   if(uErr == QCBOR_SUCCESS && uType == QCBOR_TYPE_MAP && !bIsEmpty) {
+      (void)MapIndex_IsUsable(pMe);
+   }
+#endif /* QCBOR_ENABLE_MAP_INDEX */
+
    if(pItem != NULL) {
       *pItem = Item;
    }
@@ -3571,7 +5295,13 @@ void QCBORDecode_ExitBoundedMapOrArray(QCBORDecodeContext *pMe, uint8_t uType)
       }
    }
 
+   const UsefulInputBuf     SaveInBuf   = pMe->InBuf;
+   const QCBORDecodeNesting SaveNesting = pMe->nesting;
+
    uErr = ExitBoundedLevel(pMe, pMe->uMapEndOffsetCache);
+   if(uErr != QCBOR_SUCCESS && Incremental_IsEnabled(pMe)) {
+      uErr = Incremental_Rollback(pMe, uErr, &SaveInBuf, &SaveNesting);
+   }
 
 Done:
    pMe->uLastError = (uint8_t)uErr;
@@ -3736,6 +5466,8 @@ void QCBORDecode_ExitBstrWrapped(QCBORDecodeContext *pMe)
    }
 
    const uint32_t uEndOfBstr = (uint32_t)UsefulInputBuf_GetBufferLength(&(pMe->InBuf));
+   const UsefulInputBuf     SaveInBuf   = pMe->InBuf;
+   const QCBORDecodeNesting SaveNesting = pMe->nesting;
 
    /*
     Reset the length of the UsefulInputBuf to what it was before
@@ -3746,6 +5478,9 @@ void QCBORDecode_ExitBstrWrapped(QCBORDecodeContext *pMe)
 
 
    QCBORError uErr = ExitBoundedLevel(pMe, uEndOfBstr);
+   if(uErr != QCBOR_SUCCESS && Incremental_IsEnabled(pMe)) {
+      uErr = Incremental_Rollback(pMe, uErr, &SaveInBuf, &SaveNesting);
+   }
    pMe->uLastError = (uint8_t)uErr;
 }
 
@@ -4178,6 +5913,40 @@ QCBORError QCBORDecode_GetMIMEInternal(uint8_t     uTagRequirement,
 typedef QCBORError (*fExponentiator)(uint64_t uMantissa, int64_t nExponent, uint64_t *puResult);
 
 
+/* 10^0 to 10^19. UINT64_MAX < 10^20 */
+static const uint64_t puPowersOf10[] = {
+   1ULL,
+   10ULL,
+   100ULL,
+   1000ULL,
+   10000ULL,
+   100000ULL,
+   1000000ULL,
+   10000000ULL,
+   100000000ULL,
+   1000000000ULL,
+   10000000000ULL,
+   100000000000ULL,
+   1000000000000ULL,
+   10000000000000ULL,
+   100000000000000ULL,
+   1000000000000000ULL,
+   10000000000000000ULL,
+   100000000000000000ULL,
+   1000000000000000000ULL,
+   10000000000000000000ULL
+};
+
+#define MAX_POWER_OF_10_IN_UINT64 \
+   ((int64_t)(SIZEOF_C_ARRAY(puPowersOf10, uint64_t) - 1))
+
+#ifdef __SIZEOF_INT128__
+/* __extension__ so -pedantic doesn't warn. Only compilers with the
+ * extension define __SIZEOF_INT128__. */
+__extension__ typedef unsigned __int128 QCBORUint128;
+#endif /* __SIZEOF_INT128__ */
+
+
 // The exponentiator that works on only positive numbers
 static QCBORError
 Exponentitate10(uint64_t uMantissa, int64_t nExponent, uint64_t *puResult)
@@ -4185,19 +5954,33 @@ Exponentitate10(uint64_t uMantissa, int64_t nExponent, uint64_t *puResult)
    uint64_t uResult = uMantissa;
 
    if(uResult != 0) {
-      /* This loop will run a maximum of 19 times because
-       * UINT64_MAX < 10 ^^ 19. More than that will cause
-       * exit with the overflow error
+      /* A non-zero mantissa times more than 10^19 or divided by more
+       * than 10^19 always overflows or underflows. Otherwise it is one
+       * multiply or divide by a power from the table. The result is the
+       * same as multiplying or dividing by 10 that many times.
        */
-      for(; nExponent > 0; nExponent--) {
-         if(uResult > UINT64_MAX / 10) {
+      if(nExponent > 0) {
+         if(nExponent > MAX_POWER_OF_10_IN_UINT64) {
             return QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW; // Error overflow
          }
-         uResult = uResult * 10;
-      }
+#ifdef __SIZEOF_INT128__
+         const QCBORUint128 uProduct = (QCBORUint128)uResult * puPowersOf10[nExponent];
+         if(uProduct >> 64) {
+            return QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW; // Error overflow
+         }
+         uResult = (uint64_t)uProduct;
+#else /* __SIZEOF_INT128__ */
+         if(uResult > UINT64_MAX / puPowersOf10[nExponent]) {
+            return QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW; // Error overflow
+         }
+         uResult = uResult * puPowersOf10[nExponent];
+#endif /* __SIZEOF_INT128__ */
 
-      for(; nExponent < 0; nExponent++) {
-         uResult = uResult / 10;
+      } else if(nExponent < 0) {
+         if(nExponent < -MAX_POWER_OF_10_IN_UINT64) {
+            return QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW; // Underflow error
+         }
+         uResult = uResult / puPowersOf10[-nExponent];
          if(uResult == 0) {
             return QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW; // Underflow error
          }
@@ -4219,24 +6002,24 @@ Exponentitate2(uint64_t uMantissa, int64_t nExponent, uint64_t *puResult)
 
    uResult = uMantissa;
 
-   /* This loop will run a maximum of 64 times because
-    * INT64_MAX < 2^31. More than that will cause
-    * exit with the overflow error
+   /* These are single shifts giving the same results as shifting one
+    * bit at a time and checking each time.
     */
-   while(nExponent > 0) {
-      if(uResult > UINT64_MAX >> 1) {
+   if(nExponent > 0) {
+      /* Overflow if any one bits would be shifted out. Zero can be
+       * shifted any amount.
+       */
+      if(uResult != 0 && (nExponent >= 64 || uResult > UINT64_MAX >> nExponent)) {
          return QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW; // Error overflow
       }
-      uResult = uResult << 1;
-      nExponent--;
-   }
+      uResult = nExponent >= 64 ? 0 : uResult << nExponent;
 
-   while(nExponent < 0 ) {
-      if(uResult == 0) {
+   } else if(nExponent < 0) {
+      /* Underflow if the value becomes zero before the last shift */
+      if(nExponent < -64 || uResult >> (-nExponent - 1) == 0) {
          return QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW; // Underflow error
       }
-      uResult = uResult >> 1;
-      nExponent++;
+      uResult = nExponent == -64 ? 0 : uResult >> -nExponent;
    }
 
    *puResult = uResult;
@@ -4326,19 +6109,61 @@ static inline QCBORError ExponentitateUU(uint64_t       uMantissa,
 
 
 
-static QCBORError ConvertBigNumToUnsigned(const UsefulBufC BigNum, uint64_t uMax, uint64_t *pResult)
+/*
+ * Skips the leading zero bytes of a big number, which don't count
+ * toward its size.
+ */
+static inline UsefulBufC BigNumSignificantBytes(UsefulBufC BigNum)
 {
-   uint64_t uResult;
-
-   uResult = 0;
    const uint8_t *pByte = BigNum.ptr;
-   size_t uLen = BigNum.len;
+   size_t         uLen  = BigNum.len;
+
+   while(uLen && *pByte == 0) {
+      pByte++;
+      uLen--;
+   }
+
+   return (UsefulBufC){pByte, uLen};
+}
+
+
+/*
+ * The first uLen bytes, no more than 8, as a big-endian integer. All 8
+ * are one expression that compilers make into a load and a byte swap
+ * like UsefulInputBuf_GetUint64().
+ */
+static inline uint64_t BigNumTopBytes(const uint8_t *pByte, size_t uLen)
+{
+   if(uLen == sizeof(uint64_t)) {
+      return ((uint64_t)pByte[0]<<56) +
+             ((uint64_t)pByte[1]<<48) +
+             ((uint64_t)pByte[2]<<40) +
+             ((uint64_t)pByte[3]<<32) +
+             ((uint64_t)pByte[4]<<24) +
+             ((uint64_t)pByte[5]<<16) +
+             ((uint64_t)pByte[6]<<8) +
+             (uint64_t)pByte[7];
+   }
+
+   uint64_t uResult = 0;
    while(uLen--) {
-      if(uResult > (uMax >> 8)) {
-         return QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW;
-      }
       uResult = (uResult << 8) + *pByte++;
    }
+   return uResult;
+}
+
+
+static QCBORError ConvertBigNumToUnsigned(const UsefulBufC BigNum, uint64_t uMax, uint64_t *pResult)
+{
+   const UsefulBufC Significant = BigNumSignificantBytes(BigNum);
+   if(Significant.len > sizeof(uint64_t)) {
+      return QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW;
+   }
+
+   const uint64_t uResult = BigNumTopBytes(Significant.ptr, Significant.len);
+   if(uResult > uMax) {
+      return QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW;
+   }
 
    *pResult = uResult;
    return QCBOR_SUCCESS;
@@ -5195,21 +7020,127 @@ void QCBORDecode_GetDoubleConvertInternalInMapSZ(QCBORDecodeContext *pMe,
 
 
 #ifndef QCBOR_DISABLE_FLOAT_HW_USE
-static double ConvertBigNumToDouble(const UsefulBufC BigNum)
+/*
+ * Correctly rounded conversion of the big number n, or of n + 1 for
+ * negative big numbers, which are -n - 1. The first 8 significant
+ * bytes, 57 to 64 bits, are exact in a uint64_t. The bytes after them
+ * only matter for rounding, so they are reduced to a sticky bit in the
+ * least significant bit. That bit is below the rounding position, so
+ * the conversion of the uint64_t rounds correctly. Scaling by a power
+ * of two after that is exact. Numbers too large to fit become
+ * INFINITY.
+ */
+static double BigNumToDouble(const UsefulBufC BigNum, bool bPlusOne)
 {
-   double dResult;
+   const UsefulBufC Significant = BigNumSignificantBytes(BigNum);
+   const uint8_t   *pByte       = Significant.ptr;
 
-   dResult = 0.0;
-   const uint8_t *pByte = BigNum.ptr;
-   size_t uLen = BigNum.len;
-   /* This will overflow and become the float value INFINITY if the number
-    is too large to fit. */
-   while(uLen--) {
-      dResult = (dResult * 256.0) + (double)*pByte++;
+   if(Significant.len <= sizeof(uint64_t)) {
+      /* Up to 64 bits, the common case */
+      const uint64_t uValue = BigNumTopBytes(pByte, Significant.len);
+      if(bPlusOne) {
+         return uValue == UINT64_MAX ? 18446744073709551616.0 : (double)(uValue + 1);
+      }
+      return (double)uValue;
+   }
+
+   /* The top is at least 2^56, so 2^(56 + 8 * 121) is past DBL_MAX */
+   const size_t uRestLen = Significant.len - sizeof(uint64_t);
+   if(uRestLen > 120) {
+      return INFINITY;
+   }
+
+   const uint64_t uTop = BigNumTopBytes(pByte, sizeof(uint64_t));
+   uint8_t uRestOr  = 0;
+   uint8_t uRestAnd = 0xff;
+   for(pByte += sizeof(uint64_t); pByte < (const uint8_t *)Significant.ptr + Significant.len; pByte++) {
+      uRestOr  |= *pByte;
+      uRestAnd &= *pByte;
+   }
+
+   double dTop;
+   if(bPlusOne && uRestAnd == 0xff) {
+      /* The rest is all ones so the one carries into the top and the
+       * rest becomes zero */
+      dTop = uTop == UINT64_MAX ? 18446744073709551616.0 : (double)(uTop + 1);
+   } else {
+      /* n + 1 has a non-zero rest whenever the carry stops in the rest */
+      dTop = (double)(uTop | (uRestOr != 0 || bPlusOne));
+   }
+
+   /* 2^(8 * uRestLen) made directly from its biased exponent */
+   const double dScale = UsefulBufUtil_CopyUint64ToDouble((uint64_t)(1023 + 8 * uRestLen) << 52);
+
+   return dTop * dScale;
+}
+
+
+static inline double ConvertBigNumToDouble(const UsefulBufC BigNum)
+{
+   return BigNumToDouble(BigNum, false);
+}
+
+
+static inline double ConvertNegativeBigNumToDouble(const UsefulBufC BigNum)
+{
+   return -BigNumToDouble(BigNum, true);
+}
+
+
+#ifndef QCBOR_DISABLE_EXP_AND_MANTISSA
+/* 10^0 to 10^22 are exact in a double. 10^23 is not. */
+static const double pdPowersOf10[] = {
+   1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+   1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+   1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MAX_EXACT_POWER_OF_10_IN_DOUBLE \
+   ((int64_t)(SIZEOF_C_ARRAY(pdPowersOf10, double) - 1))
+
+/* 2^53, past which not all integers are exact in a double */
+#define DOUBLE_EXACT_INTEGER_LIMIT 9007199254740992.0
+
+
+/*
+ * When the mantissa and the power of ten are both exact, one multiply
+ * or divide gives the correctly rounded result. This is most decimal
+ * fractions, such as prices. The rest use pow() and may be off in the
+ * last bit.
+ */
+static double DecimalFractionToDouble(double dMantissa, int64_t nExponent)
+{
+   if(dMantissa > -DOUBLE_EXACT_INTEGER_LIMIT && dMantissa < DOUBLE_EXACT_INTEGER_LIMIT) {
+      if(nExponent >= 0 && nExponent <= MAX_EXACT_POWER_OF_10_IN_DOUBLE) {
+         return dMantissa * pdPowersOf10[nExponent];
+      }
+      if(nExponent < 0 && nExponent >= -MAX_EXACT_POWER_OF_10_IN_DOUBLE) {
+         return dMantissa / pdPowersOf10[-nExponent];
+      }
+   }
+
+   // Underflow gives 0, overflow gives infinity
+   return dMantissa * pow(10.0, (double)nExponent);
+}
+
+
+/*
+ * Scaling by a power of two is exact unless the result is out of range
+ * for a double. Exponents past +/-2200 give zero or infinity for any
+ * mantissa, so they are clamped to fit in an int.
+ */
+static double BigFloatToDouble(double dMantissa, int64_t nExponent)
+{
+   if(nExponent > 2200) {
+      nExponent = 2200;
+   } else if(nExponent < -2200) {
+      nExponent = -2200;
    }
 
-   return dResult;
+   // Underflow gives 0, overflow gives infinity
+   return ldexp(dMantissa, (int)nExponent);
 }
+#endif /* ! QCBOR_DISABLE_EXP_AND_MANTISSA */
 #endif /* QCBOR_DISABLE_FLOAT_HW_USE */
 
 
@@ -5226,9 +7157,8 @@ DoubleConvertAll(const QCBORItem *pItem, uint32_t uConvertTypes, double *pdValue
 #ifndef QCBOR_DISABLE_EXP_AND_MANTISSA
       case QCBOR_TYPE_DECIMAL_FRACTION:
          if(uConvertTypes & QCBOR_CONVERT_TYPE_DECIMAL_FRACTION) {
-            // Underflow gives 0, overflow gives infinity
-            *pdValue = (double)pItem->val.expAndMantissa.Mantissa.nInt *
-                        pow(10.0, (double)pItem->val.expAndMantissa.nExponent);
+            *pdValue = DecimalFractionToDouble((double)pItem->val.expAndMantissa.Mantissa.nInt,
+                                               pItem->val.expAndMantissa.nExponent);
          } else {
             return QCBOR_ERR_UNEXPECTED_TYPE;
          }
@@ -5236,9 +7166,8 @@ DoubleConvertAll(const QCBORItem *pItem, uint32_t uConvertTypes, double *pdValue
 
       case QCBOR_TYPE_BIGFLOAT:
          if(uConvertTypes & QCBOR_CONVERT_TYPE_BIGFLOAT ) {
-            // Underflow gives 0, overflow gives infinity
-            *pdValue = (double)pItem->val.expAndMantissa.Mantissa.nInt *
-                              exp2((double)pItem->val.expAndMantissa.nExponent);
+            *pdValue = BigFloatToDouble((double)pItem->val.expAndMantissa.Mantissa.nInt,
+                                        pItem->val.expAndMantissa.nExponent);
          } else {
             return QCBOR_ERR_UNEXPECTED_TYPE;
          }
@@ -5255,7 +7184,7 @@ DoubleConvertAll(const QCBORItem *pItem, uint32_t uConvertTypes, double *pdValue
 
       case QCBOR_TYPE_NEGBIGNUM:
          if(uConvertTypes & QCBOR_CONVERT_TYPE_BIG_NUM) {
-            *pdValue = -1-ConvertBigNumToDouble(pItem->val.bigNum);
+            *pdValue = ConvertNegativeBigNumToDouble(pItem->val.bigNum);
          } else {
             return QCBOR_ERR_UNEXPECTED_TYPE;
          }
@@ -5265,7 +7194,7 @@ DoubleConvertAll(const QCBORItem *pItem, uint32_t uConvertTypes, double *pdValue
       case QCBOR_TYPE_DECIMAL_FRACTION_POS_BIGNUM:
          if(uConvertTypes & QCBOR_CONVERT_TYPE_DECIMAL_FRACTION) {
             double dMantissa = ConvertBigNumToDouble(pItem->val.expAndMantissa.Mantissa.bigNum);
-            *pdValue = dMantissa * pow(10, (double)pItem->val.expAndMantissa.nExponent);
+            *pdValue = DecimalFractionToDouble(dMantissa, pItem->val.expAndMantissa.nExponent);
          } else {
             return QCBOR_ERR_UNEXPECTED_TYPE;
          }
@@ -5273,8 +7202,8 @@ DoubleConvertAll(const QCBORItem *pItem, uint32_t uConvertTypes, double *pdValue
 
       case QCBOR_TYPE_DECIMAL_FRACTION_NEG_BIGNUM:
         if(uConvertTypes & QCBOR_CONVERT_TYPE_DECIMAL_FRACTION) {
-         double dMantissa = -ConvertBigNumToDouble(pItem->val.expAndMantissa.Mantissa.bigNum);
-         *pdValue = dMantissa * pow(10, (double)pItem->val.expAndMantissa.nExponent);
+         double dMantissa = ConvertNegativeBigNumToDouble(pItem->val.expAndMantissa.Mantissa.bigNum);
+         *pdValue = DecimalFractionToDouble(dMantissa, pItem->val.expAndMantissa.nExponent);
          } else {
             return QCBOR_ERR_UNEXPECTED_TYPE;
          }
@@ -5283,7 +7212,7 @@ DoubleConvertAll(const QCBORItem *pItem, uint32_t uConvertTypes, double *pdValue
       case QCBOR_TYPE_BIGFLOAT_POS_BIGNUM:
         if(uConvertTypes & QCBOR_CONVERT_TYPE_BIGFLOAT) {
          double dMantissa = ConvertBigNumToDouble(pItem->val.expAndMantissa.Mantissa.bigNum);
-         *pdValue = dMantissa * exp2((double)pItem->val.expAndMantissa.nExponent);
+         *pdValue = BigFloatToDouble(dMantissa, pItem->val.expAndMantissa.nExponent);
          } else {
             return QCBOR_ERR_UNEXPECTED_TYPE;
          }
@@ -5291,8 +7220,8 @@ DoubleConvertAll(const QCBORItem *pItem, uint32_t uConvertTypes, double *pdValue
 
       case QCBOR_TYPE_BIGFLOAT_NEG_BIGNUM:
         if(uConvertTypes & QCBOR_CONVERT_TYPE_BIGFLOAT) {
-         double dMantissa = -1-ConvertBigNumToDouble(pItem->val.expAndMantissa.Mantissa.bigNum);
-         *pdValue = dMantissa * exp2((double)pItem->val.expAndMantissa.nExponent);
+         double dMantissa = ConvertNegativeBigNumToDouble(pItem->val.expAndMantissa.Mantissa.bigNum);
+         *pdValue = BigFloatToDouble(dMantissa, pItem->val.expAndMantissa.nExponent);
          } else {
             return QCBOR_ERR_UNEXPECTED_TYPE;
          }
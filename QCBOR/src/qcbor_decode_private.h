@@ -0,0 +1,217 @@
+/*==============================================================================
+ Copyright (c) 2016-2018, The Linux Foundation.
+ Copyright (c) 2018-2021, Laurence Lundblade.
+ Copyright (c) 2021, Arm Limited.
+ All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors, nor the name "Laurence Lundblade" may be used to
+      endorse or promote products derived from this software without
+      specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ =============================================================================*/
+
+
+#ifndef qcbor_decode_private_h
+#define qcbor_decode_private_h
+
+#include "qcbor/qcbor_decode.h"
+
+
+/*
+ * These are for the source files that implement parts of the decoder
+ * outside qcbor_decode.c. They are not part of the public interface
+ * and may change at any time.
+ */
+
+
+static inline bool
+QCBORItem_IsMapOrArray(const QCBORItem *pMe)
+{
+   const uint8_t uDataType = pMe->uDataType;
+   return uDataType == QCBOR_TYPE_MAP ||
+          uDataType == QCBOR_TYPE_ARRAY ||
+          uDataType == QCBOR_TYPE_MAP_AS_ARRAY;
+}
+
+
+/**
+ * @brief Decode the CBOR head, the type and argument.
+ *
+ * @param[in] pUInBuf            The input buffer to read from.
+ * @param[out] pnMajorType       The decoded major type.
+ * @param[out] puArgument        The decoded argument.
+ * @param[out] pnAdditionalInfo  The decoded Lower 5 bits of initial byte.
+ * @param[in] bDCBOR             Reject non-minimal and indefinite heads.
+ *
+ * @retval QCBOR_ERR_UNSUPPORTED
+ * @retval QCBOR_ERR_HIT_END
+ * @retval QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD
+ * @retval QCBOR_ERR_DCBOR_INDEFINITE_LENGTH
+ *
+ * This decodes the CBOR "head" that every CBOR data item has. See
+ * longer explaination of the head in documentation for
+ * QCBOREncode_EncodeHead().
+ *
+ * This does the network->host byte order conversion. The conversion
+ * here also results in the conversion for floats in addition to that
+ * for lengths, tags and integer values.
+ *
+ * The int type is preferred to uint8_t for some variables as this
+ * avoids integer promotions, can reduce code size and makes static
+ * analyzers happier.
+ */
+static inline QCBORError
+DecodeHead(UsefulInputBuf *pUInBuf,
+           int            *pnMajorType,
+           uint64_t       *puArgument,
+           int            *pnAdditionalInfo,
+           bool            bDCBOR)
+{
+   QCBORError uReturn;
+
+   /* Get the initial byte that every CBOR data item has and break it
+    * down. */
+   const int nInitialByte    = (int)UsefulInputBuf_GetByte(pUInBuf);
+   const int nTmpMajorType   = nInitialByte >> 5;
+   const int nAdditionalInfo = nInitialByte & 0x1f;
+
+   /* Where the argument accumulates */
+   uint64_t uArgument;
+
+   if(nAdditionalInfo >= LEN_IS_ONE_BYTE && nAdditionalInfo <= LEN_IS_EIGHT_BYTES) {
+      /* Need to get 1,2,4 or 8 additional argument bytes. Map
+       * LEN_IS_ONE_BYTE..LEN_IS_EIGHT_BYTES to actual length.
+       */
+      static const uint8_t aIterate[] = {1,2,4,8};
+
+      /* Loop getting all the bytes in the argument */
+      uArgument = 0;
+      for(int i = aIterate[nAdditionalInfo - LEN_IS_ONE_BYTE]; i; i--) {
+         /* This shift and add gives the endian conversion. */
+         uArgument = (uArgument << 8) + UsefulInputBuf_GetByte(pUInBuf);
+      }
+   } else if(nAdditionalInfo >= ADDINFO_RESERVED1 && nAdditionalInfo <= ADDINFO_RESERVED3) {
+      /* The reserved and thus-far unused additional info values */
+      uReturn = QCBOR_ERR_UNSUPPORTED;
+      goto Done;
+   } else {
+      /* Less than 24, additional info is argument or 31, an
+       * indefinite-length.  No more bytes to get.
+       */
+      uArgument = (uint64_t)nAdditionalInfo;
+   }
+
+   if(UsefulInputBuf_GetError(pUInBuf)) {
+      uReturn = QCBOR_ERR_HIT_END;
+      goto Done;
+   }
+
+   if(bDCBOR) {
+      /* The smallest argument for each of 1, 2, 4 and 8 argument
+       * bytes. Major type 7 is left to DecodeType7() since these
+       * sizes are the float precisions there.
+       */
+      static const uint64_t aMinimum[] = {24, 0x100, 0x10000, 0x100000000};
+
+      if(nAdditionalInfo >= LEN_IS_ONE_BYTE &&
+         nAdditionalInfo <= LEN_IS_EIGHT_BYTES &&
+         nTmpMajorType != CBOR_MAJOR_TYPE_SIMPLE &&
+         uArgument < aMinimum[nAdditionalInfo - LEN_IS_ONE_BYTE]) {
+         uReturn = QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD;
+         goto Done;
+      }
+      if(nAdditionalInfo == LEN_IS_INDEFINITE &&
+         nTmpMajorType >= CBOR_MAJOR_TYPE_BYTE_STRING &&
+         nTmpMajorType <= CBOR_MAJOR_TYPE_MAP) {
+         uReturn = QCBOR_ERR_DCBOR_INDEFINITE_LENGTH;
+         goto Done;
+      }
+   }
+
+   /* All successful if arrived here. */
+   uReturn           = QCBOR_SUCCESS;
+   *pnMajorType      = nTmpMajorType;
+   *puArgument       = uArgument;
+   *pnAdditionalInfo = nAdditionalInfo;
+
+Done:
+   return uReturn;
+}
+
+
+/**
+ * @brief Decode one atomic data item, see DecodeAtomicDataItem().
+ *
+ * @param[in] pUInBuf        The input buffer to read from.
+ * @param[out] pDecodedItem  The filled-in decoded item.
+ *
+ * No strings are allocated and none of the optional checks are made.
+ */
+QCBORError
+QCBORDecode_Private_DecodeAtomicDataItem(UsefulInputBuf *pUInBuf,
+                                         QCBORItem      *pDecodedItem);
+
+
+/**
+ * @brief Decode the next item without decoding tag content.
+ *
+ * @param[in] pMe            The decode context.
+ * @param[out] pDecodedItem  The decoded item.
+ *
+ * @return The error for the item.
+ *
+ * This is layers 1 to 6 of QCBORDecode_GetNextTagContent(), taking
+ * the same fast path as QCBORDecode_GetNextPlain() when it can.
+ */
+QCBORError
+QCBORDecode_Private_GetNextNoTagContent(QCBORDecodeContext *pMe,
+                                        QCBORItem          *pDecodedItem);
+
+
+/**
+ * @brief The items left in the entered array to decode from the input.
+ *
+ * @param[in] pMe  The decode context.
+ *
+ * @return The number of items left in the entered definite-length
+ *         array, or zero if there are none or they must go through
+ *         the full pipeline.
+ *
+ * Non-zero only when the entered array is the current level and the
+ * decode mode allows QCBORDecode_GetNextPlain() its fast path.
+ */
+uint16_t
+QCBORDecode_Private_PlainArrayCount(const QCBORDecodeContext *pMe);
+
+
+/**
+ * @brief Whether the end of the entered map or array is reached.
+ *
+ * @param[in] pMe  The decode context.
+ */
+bool
+QCBORDecode_Private_IsAtEndOfBounded(const QCBORDecodeContext *pMe);
+
+
+#endif /* qcbor_decode_private_h */
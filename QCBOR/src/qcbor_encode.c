@@ -742,6 +742,134 @@ void QCBOREncode_AddFloat(QCBOREncodeContext *me, float fNum)
    QCBOREncode_AddFloatNoPreferred(me, fNum);
 #endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
 }
+
+
+/* Numbers of an array classified for preferred serialization at a time */
+#define ENCODE_ARRAY_BATCH 32
+
+
+#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
+/**
+ * @brief Append a batch of classified floating-point numbers.
+ *
+ * @param me     Encoder context.
+ * @param pNums  The numbers from IEEE754_DoubleToSmallestBlock() or
+ *               IEEE754_FloatToSmallestBlock().
+ * @param uNum   The number of them, up to @ref ENCODE_ARRAY_BATCH.
+ *
+ * The heads are the same as from AppendCBORHead(). They are formatted
+ * together into a buffer that goes to the output in one append.
+ */
+static void
+AppendFloatBatch(QCBOREncodeContext *me, const IEEE754_union *pNums, size_t uNum)
+{
+   uint8_t  aBuffer[ENCODE_ARRAY_BATCH * (1 + sizeof(uint64_t))];
+   uint8_t *pByte = aBuffer;
+
+   for(size_t i = 0; i < uNum; i++) {
+      const uint8_t uSize  = pNums[i].uSize;
+      uint64_t      uValue = pNums[i].uValue;
+
+      /* Sizes 2, 4 and 8 are half, single and double-precision */
+      *pByte++ = (uint8_t)((CBOR_MAJOR_TYPE_SIMPLE << 5) + HALF_PREC_FLOAT + (uSize >> 2));
+      for(int j = uSize - 1; j >= 0; j--) {
+         pByte[j] = (uint8_t)uValue;
+         uValue >>= 8;
+      }
+      pByte += uSize;
+   }
+
+   UsefulOutBuf_AppendData(&(me->OutBuf), aBuffer, (size_t)(pByte - aBuffer));
+}
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+
+
+/**
+ * @brief Start an array of floating-point numbers.
+ *
+ * @param me      Encoder context.
+ * @param uCount  The number of items in the array.
+ *
+ * @return false if the array can't be added.
+ *
+ * The number of items is known so the head goes out first rather than
+ * being inserted at the close as QCBOREncode_OpenArray() does. The
+ * array is a single item in the enclosing map or array.
+ */
+static bool
+AppendFloatArrayHead(QCBOREncodeContext *me, size_t uCount)
+{
+#ifndef QCBOR_DISABLE_ENCODE_USAGE_GUARDS
+   if(uCount > QCBOR_MAX_ITEMS_IN_ARRAY) {
+      if(me->uError == QCBOR_SUCCESS) {
+         me->uError = QCBOR_ERR_ARRAY_TOO_LONG;
+      }
+      return false;
+   }
+#endif /* QCBOR_DISABLE_ENCODE_USAGE_GUARDS */
+
+   AppendCBORHead(me, CBOR_MAJOR_TYPE_ARRAY, uCount, 0);
+   IncrementMapOrArrayCount(me);
+   return true;
+}
+
+
+/*
+ * Public functions for adding an array of doubles. See
+ * qcbor/qcbor_encode.h
+ */
+void QCBOREncode_AddDoubleArray(QCBOREncodeContext *me, const double *pdValues, size_t uCount)
+{
+   if(!AppendFloatArrayHead(me, uCount)) {
+      return;
+   }
+
+#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
+   IEEE754_union aNums[ENCODE_ARRAY_BATCH];
+
+   for(size_t uStart = 0; uStart < uCount; uStart += ENCODE_ARRAY_BATCH) {
+      const size_t uBatch = uCount - uStart < ENCODE_ARRAY_BATCH ? uCount - uStart : ENCODE_ARRAY_BATCH;
+      IEEE754_DoubleToSmallestBlock(&pdValues[uStart], aNums, uBatch, 1);
+      AppendFloatBatch(me, aNums, uBatch);
+   }
+#else /* QCBOR_DISABLE_PREFERRED_FLOAT */
+   for(size_t i = 0; i < uCount; i++) {
+      AppendCBORHead(me,
+                     CBOR_MAJOR_TYPE_SIMPLE,
+                     UsefulBufUtil_CopyDoubleToUint64(pdValues[i]),
+                     sizeof(uint64_t));
+   }
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+}
+
+
+/*
+ * Public functions for adding an array of floats. See
+ * qcbor/qcbor_encode.h
+ */
+void QCBOREncode_AddFloatArray(QCBOREncodeContext *me, const float *pfValues, size_t uCount)
+{
+   if(!AppendFloatArrayHead(me, uCount)) {
+      return;
+   }
+
+#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
+   IEEE754_union aNums[ENCODE_ARRAY_BATCH];
+
+   for(size_t uStart = 0; uStart < uCount; uStart += ENCODE_ARRAY_BATCH) {
+      const size_t uBatch = uCount - uStart < ENCODE_ARRAY_BATCH ? uCount - uStart : ENCODE_ARRAY_BATCH;
+      IEEE754_FloatToSmallestBlock(&pfValues[uStart], aNums, uBatch);
+      AppendFloatBatch(me, aNums, uBatch);
+   }
+#else /* QCBOR_DISABLE_PREFERRED_FLOAT */
+   for(size_t i = 0; i < uCount; i++) {
+      AppendCBORHead(me,
+                     CBOR_MAJOR_TYPE_SIMPLE,
+                     UsefulBufUtil_CopyFloatToUint32(pfValues[i]),
+                     sizeof(uint32_t));
+   }
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+}
 #endif /* USEFULBUF_DISABLE_ALL_FLOAT */
 
 
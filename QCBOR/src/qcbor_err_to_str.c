@@ -62,6 +62,15 @@ const char *qcbor_err_to_str(QCBORError err) {
     _ERR_TO_STR(ERR_HW_FLOAT_DISABLED)
     _ERR_TO_STR(ERR_FLOAT_EXCEPTION)
     _ERR_TO_STR(ERR_ALL_FLOAT_DISABLED)
+    _ERR_TO_STR(ERR_BAD_UTF8)
+    _ERR_TO_STR(ERR_DCBOR_NON_MINIMAL_HEAD)
+    _ERR_TO_STR(ERR_DCBOR_INDEFINITE_LENGTH)
+    _ERR_TO_STR(ERR_DCBOR_NON_SHORTEST_FLOAT)
+    _ERR_TO_STR(ERR_UNSORTED_LABEL)
+    _ERR_TO_STR(ERR_TAPE_TOO_SMALL)
+    _ERR_TO_STR(ERR_NEED_MORE_INPUT)
+    _ERR_TO_STR(ERR_THREAD_START)
+    _ERR_TO_STR(ERR_ALLOCATED_STRING)
 
     default:
         return "Unidentified error";
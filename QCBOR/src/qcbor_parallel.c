@@ -0,0 +1,422 @@
+/*==============================================================================
+ Copyright (c) 2016-2018, The Linux Foundation.
+ Copyright (c) 2018-2021, Laurence Lundblade.
+ Copyright (c) 2021, Arm Limited.
+ All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors, nor the name "Laurence Lundblade" may be used to
+      endorse or promote products derived from this software without
+      specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_parallel.h"
+#include "qcbor/qcbor_sequence.h"
+
+#ifndef QCBOR_DISABLE_PARALLEL
+
+#include <pthread.h>
+
+
+/* The life of a chunk. Its slot in the workspace is reused for the
+ * chunk that many chunks later after it is delivered. */
+#define PARALLEL_CHUNK_FREE     0
+#define PARALLEL_CHUNK_READY    1 /* Split and waiting for a worker */
+#define PARALLEL_CHUNK_DECODING 2
+#define PARALLEL_CHUNK_DONE     3 /* Decoded and waiting to be delivered */
+
+/* How many chunks each worker can have split, decoded or waiting */
+#define PARALLEL_SLOTS_PER_THREAD 2
+
+#define PARALLEL_DEFAULT_CHUNK_SIZE  (64 * 1024)
+#define PARALLEL_DEFAULT_CHUNK_ITEMS 1024
+
+
+/* A run of whole items of the sequence */
+typedef struct {
+   UsefulBufC Items;
+   uint64_t   uFirstIndex; /* Index of the first item in the sequence */
+   uint32_t   uCount;
+   uint8_t    uState;
+   uint8_t   *puErrors;    /* uCount errors from the decode callback */
+   uint8_t   *pResults;    /* uCount results */
+} ParallelChunk;
+
+
+/* What the splitting thread and the workers share. uChunksMade,
+ * uNextToDecode, uNextToDeliver, the chunk states and the flags are
+ * only accessed with Mutex locked. */
+typedef struct {
+   const QCBORParallelConfig *pConfig;
+   size_t                     uResultStride;
+   uint32_t                   uChunkItems;
+   ParallelChunk             *pChunks;
+   uint32_t                   uSlots;
+
+   pthread_mutex_t            Mutex;
+   pthread_cond_t             Changed;
+   pthread_mutex_t            DeliverMutex; /* For unordered delivery */
+
+   uint64_t                   uChunksMade;
+   uint64_t                   uNextToDecode;
+   uint64_t                   uNextToDeliver; /* For ordered delivery */
+   bool                       bSplitDone;
+   bool                       bDelivering;    /* For ordered delivery */
+   QCBORError                 uStopError;
+} ParallelContext;
+
+
+typedef struct {
+   ParallelContext *pCtx;
+   UsefulBuf        Pool;
+   pthread_t        Thread;
+} ParallelWorker;
+
+
+/* Everything in the workspace is aligned for any integer or pointer */
+static size_t
+Parallel_Align(size_t uSize)
+{
+   const size_t uAlign = sizeof(uint64_t) > sizeof(void *) ? sizeof(uint64_t) : sizeof(void *);
+
+   return (uSize + uAlign - 1) & ~(uAlign - 1);
+}
+
+
+/* Sizes from the configuration with the defaults filled in */
+typedef struct {
+   unsigned uThreads;
+   uint32_t uSlots;
+   size_t   uChunkSize;
+   uint32_t uChunkItems;
+   size_t   uResultStride;
+   size_t   uPoolSize;
+} ParallelSizes;
+
+
+static size_t
+Parallel_Sizes(const QCBORParallelConfig *pConfig, ParallelSizes *pSizes)
+{
+   pSizes->uThreads      = pConfig->uThreads ? pConfig->uThreads : 1;
+   pSizes->uSlots        = pSizes->uThreads * PARALLEL_SLOTS_PER_THREAD;
+   pSizes->uChunkSize    = pConfig->uChunkSize ? pConfig->uChunkSize : PARALLEL_DEFAULT_CHUNK_SIZE;
+   pSizes->uChunkItems   = pConfig->uChunkItems ? pConfig->uChunkItems : PARALLEL_DEFAULT_CHUNK_ITEMS;
+   pSizes->uResultStride = Parallel_Align(pConfig->uResultSize);
+   pSizes->uPoolSize     = Parallel_Align(pConfig->uPoolSize);
+
+   const size_t uPerSlot = Parallel_Align(sizeof(ParallelChunk)) +
+                           Parallel_Align(pSizes->uChunkItems) +
+                           pSizes->uResultStride * pSizes->uChunkItems;
+   const size_t uPerThread = Parallel_Align(sizeof(ParallelWorker)) + pSizes->uPoolSize;
+
+   /* One more alignment unit to align the start of the workspace */
+   return Parallel_Align(1) + uPerSlot * pSizes->uSlots + uPerThread * pSizes->uThreads;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_parallel.h file
+ */
+size_t
+QCBORParallel_WorkspaceSize(const QCBORParallelConfig *pConfig)
+{
+   ParallelSizes Sizes;
+
+   return Parallel_Sizes(pConfig, &Sizes);
+}
+
+
+static void
+Parallel_DecodeChunk(ParallelContext *pCtx, ParallelChunk *pChunk, UsefulBuf Pool)
+{
+   const QCBORParallelConfig *pConfig = pCtx->pConfig;
+   QCBORSequenceReader        Reader;
+   QCBORDecodeContext         DCtx;
+   QCBORError                 uErr;
+
+   /* The chunk was split once already so this only fails for an
+    * item too large to decode */
+   QCBORSequence_Init(&Reader, pChunk->Items);
+   for(uint32_t uItem = 0; uItem < pChunk->uCount; uItem++) {
+      uErr = QCBORSequence_NextDecoder(&Reader, &DCtx, pConfig->nDecodeMode);
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+      if(uErr == QCBOR_SUCCESS && Pool.len) {
+         uErr = QCBORDecode_SetMemPool(&DCtx, Pool, false);
+      }
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+      (void)Pool;
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+      if(uErr == QCBOR_SUCCESS) {
+         uErr = (*pConfig->pfDecode)(pConfig->pCallbackCtx,
+                                     &DCtx,
+                                     pChunk->pResults + uItem * pCtx->uResultStride);
+      }
+      pChunk->puErrors[uItem] = (uint8_t)uErr;
+   }
+}
+
+
+static QCBORError
+Parallel_DeliverChunk(ParallelContext *pCtx, const ParallelChunk *pChunk)
+{
+   const QCBORParallelConfig *pConfig = pCtx->pConfig;
+   QCBORError                 uErr;
+
+   for(uint32_t uItem = 0; uItem < pChunk->uCount; uItem++) {
+      uErr = (*pConfig->pfDeliver)(pConfig->pCallbackCtx,
+                                   pChunk->uFirstIndex + uItem,
+                                   (QCBORError)pChunk->puErrors[uItem],
+                                   pChunk->pResults + uItem * pCtx->uResultStride);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
+/* Called with Mutex locked. Delivers the chunks that are next in order
+ * and decoded unless another worker is already doing that. */
+static void
+Parallel_DeliverInOrder(ParallelContext *pCtx)
+{
+   if(pCtx->bDelivering) {
+      /* That worker will find the chunk just decoded */
+      return;
+   }
+   pCtx->bDelivering = true;
+   while(pCtx->uStopError == QCBOR_SUCCESS) {
+      ParallelChunk *pChunk = &pCtx->pChunks[pCtx->uNextToDeliver % pCtx->uSlots];
+      if(pChunk->uState != PARALLEL_CHUNK_DONE) {
+         break;
+      }
+      pthread_mutex_unlock(&pCtx->Mutex);
+      const QCBORError uErr = Parallel_DeliverChunk(pCtx, pChunk);
+      pthread_mutex_lock(&pCtx->Mutex);
+
+      pChunk->uState = PARALLEL_CHUNK_FREE;
+      pCtx->uNextToDeliver++;
+      if(uErr != QCBOR_SUCCESS) {
+         pCtx->uStopError = uErr;
+      }
+      pthread_cond_broadcast(&pCtx->Changed);
+   }
+   pCtx->bDelivering = false;
+}
+
+
+static void *
+Parallel_Worker(void *pArg)
+{
+   ParallelWorker  *pWorker = (ParallelWorker *)pArg;
+   ParallelContext *pCtx    = pWorker->pCtx;
+   QCBORError       uErr;
+
+   pthread_mutex_lock(&pCtx->Mutex);
+   while(1) {
+      while(pCtx->uStopError == QCBOR_SUCCESS &&
+            pCtx->uNextToDecode == pCtx->uChunksMade &&
+            !pCtx->bSplitDone) {
+         pthread_cond_wait(&pCtx->Changed, &pCtx->Mutex);
+      }
+      if(pCtx->uStopError != QCBOR_SUCCESS || pCtx->uNextToDecode == pCtx->uChunksMade) {
+         break;
+      }
+      ParallelChunk *pChunk = &pCtx->pChunks[pCtx->uNextToDecode % pCtx->uSlots];
+      pCtx->uNextToDecode++;
+      pChunk->uState = PARALLEL_CHUNK_DECODING;
+      pthread_mutex_unlock(&pCtx->Mutex);
+
+      Parallel_DecodeChunk(pCtx, pChunk, pWorker->Pool);
+
+      if(pCtx->pConfig->bOrdered) {
+         pthread_mutex_lock(&pCtx->Mutex);
+         pChunk->uState = PARALLEL_CHUNK_DONE;
+         Parallel_DeliverInOrder(pCtx);
+      } else {
+         pthread_mutex_lock(&pCtx->DeliverMutex);
+         uErr = Parallel_DeliverChunk(pCtx, pChunk);
+         pthread_mutex_unlock(&pCtx->DeliverMutex);
+
+         pthread_mutex_lock(&pCtx->Mutex);
+         pChunk->uState = PARALLEL_CHUNK_FREE;
+         if(uErr != QCBOR_SUCCESS && pCtx->uStopError == QCBOR_SUCCESS) {
+            pCtx->uStopError = uErr;
+         }
+         pthread_cond_broadcast(&pCtx->Changed);
+      }
+   }
+   pthread_mutex_unlock(&pCtx->Mutex);
+
+   return NULL;
+}
+
+
+/* Splits the sequence into chunks for the workers until the end, an
+ * item that is not well-formed or a stop by the deliver callback. */
+static QCBORError
+Parallel_Split(ParallelContext *pCtx, UsefulBufC Sequence, size_t uChunkSize)
+{
+   QCBORSequenceReader Reader;
+   UsefulBufC          Item;
+   QCBORError          uErr   = QCBOR_SUCCESS;
+   uint64_t            uIndex = 0;
+
+   QCBORSequence_Init(&Reader, Sequence);
+   while(uErr == QCBOR_SUCCESS) {
+      /* Only this thread changes uChunksMade */
+      ParallelChunk *pChunk = &pCtx->pChunks[pCtx->uChunksMade % pCtx->uSlots];
+
+      pthread_mutex_lock(&pCtx->Mutex);
+      while(pCtx->uStopError == QCBOR_SUCCESS && pChunk->uState != PARALLEL_CHUNK_FREE) {
+         pthread_cond_wait(&pCtx->Changed, &pCtx->Mutex);
+      }
+      const bool bStop = pCtx->uStopError != QCBOR_SUCCESS;
+      pthread_mutex_unlock(&pCtx->Mutex);
+      if(bStop) {
+         break;
+      }
+
+      const size_t uStart = (size_t)QCBORSequence_Tell(&Reader);
+      uint32_t     uCount = 0;
+      while(uCount < pCtx->uChunkItems && (size_t)QCBORSequence_Tell(&Reader) - uStart < uChunkSize) {
+         uErr = QCBORSequence_Next(&Reader, &Item);
+         if(uErr != QCBOR_SUCCESS) {
+            break;
+         }
+         uCount++;
+      }
+      if(uCount == 0) {
+         break;
+      }
+
+      pChunk->Items       = UsefulBuf_Head(UsefulBuf_Tail(Sequence, uStart),
+                                           (size_t)QCBORSequence_Tell(&Reader) - uStart);
+      pChunk->uFirstIndex = uIndex;
+      pChunk->uCount      = uCount;
+      uIndex += uCount;
+
+      pthread_mutex_lock(&pCtx->Mutex);
+      pChunk->uState = PARALLEL_CHUNK_READY;
+      pCtx->uChunksMade++;
+      pthread_cond_broadcast(&pCtx->Changed);
+      pthread_mutex_unlock(&pCtx->Mutex);
+   }
+
+   return uErr == QCBOR_ERR_NO_MORE_ITEMS ? QCBOR_SUCCESS : uErr;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_parallel.h file
+ */
+QCBORError
+QCBORParallel_Decode(const QCBORParallelConfig *pConfig,
+                     UsefulBufC                 Sequence,
+                     UsefulBuf                  Workspace)
+{
+   ParallelSizes   Sizes;
+   ParallelContext Ctx;
+   QCBORError      uReturn;
+   unsigned        uStarted;
+
+   if(Workspace.ptr == NULL || Workspace.len < Parallel_Sizes(pConfig, &Sizes)) {
+      return QCBOR_ERR_BUFFER_TOO_SMALL;
+   }
+
+   /* Lay out the workspace */
+   uint8_t *pNext = (uint8_t *)Workspace.ptr;
+   pNext += Parallel_Align((uintptr_t)pNext) - (uintptr_t)pNext;
+
+   ParallelWorker *pWorkers = (ParallelWorker *)(void *)pNext;
+   pNext += Parallel_Align(sizeof(ParallelWorker)) * Sizes.uThreads;
+   for(unsigned uThread = 0; uThread < Sizes.uThreads; uThread++) {
+      pWorkers[uThread].pCtx = &Ctx;
+      pWorkers[uThread].Pool = (UsefulBuf){Sizes.uPoolSize ? pNext : NULL, Sizes.uPoolSize};
+      pNext += Sizes.uPoolSize;
+   }
+
+   Ctx.pChunks = (ParallelChunk *)(void *)pNext;
+   pNext += Parallel_Align(sizeof(ParallelChunk)) * Sizes.uSlots;
+   for(uint32_t uSlot = 0; uSlot < Sizes.uSlots; uSlot++) {
+      Ctx.pChunks[uSlot].uState   = PARALLEL_CHUNK_FREE;
+      Ctx.pChunks[uSlot].puErrors = pNext;
+      pNext += Parallel_Align(Sizes.uChunkItems);
+      Ctx.pChunks[uSlot].pResults = pNext;
+      pNext += Sizes.uResultStride * Sizes.uChunkItems;
+   }
+
+   Ctx.pConfig        = pConfig;
+   Ctx.uResultStride  = Sizes.uResultStride;
+   Ctx.uChunkItems    = Sizes.uChunkItems;
+   Ctx.uSlots         = Sizes.uSlots;
+   Ctx.uChunksMade    = 0;
+   Ctx.uNextToDecode  = 0;
+   Ctx.uNextToDeliver = 0;
+   Ctx.bSplitDone     = false;
+   Ctx.bDelivering    = false;
+   Ctx.uStopError     = QCBOR_SUCCESS;
+   pthread_mutex_init(&Ctx.Mutex, NULL);
+   pthread_mutex_init(&Ctx.DeliverMutex, NULL);
+   pthread_cond_init(&Ctx.Changed, NULL);
+
+   for(uStarted = 0; uStarted < Sizes.uThreads; uStarted++) {
+      if(pthread_create(&pWorkers[uStarted].Thread, NULL, Parallel_Worker, &pWorkers[uStarted])) {
+         /* Go on with the workers there are */
+         break;
+      }
+   }
+   if(uStarted == 0) {
+      uReturn = QCBOR_ERR_THREAD_START;
+      goto Done;
+   }
+
+   uReturn = Parallel_Split(&Ctx, Sequence, Sizes.uChunkSize);
+
+   pthread_mutex_lock(&Ctx.Mutex);
+   Ctx.bSplitDone = true;
+   pthread_cond_broadcast(&Ctx.Changed);
+   pthread_mutex_unlock(&Ctx.Mutex);
+
+   for(unsigned uThread = 0; uThread < uStarted; uThread++) {
+      pthread_join(pWorkers[uThread].Thread, NULL);
+   }
+
+   /* A stop by the deliver callback is first since the items the
+    * splitting error came after were not all delivered */
+   if(Ctx.uStopError != QCBOR_SUCCESS) {
+      uReturn = Ctx.uStopError;
+   }
+
+Done:
+   pthread_cond_destroy(&Ctx.Changed);
+   pthread_mutex_destroy(&Ctx.DeliverMutex);
+   pthread_mutex_destroy(&Ctx.Mutex);
+
+   return uReturn;
+}
+
+#endif /* QCBOR_DISABLE_PARALLEL */
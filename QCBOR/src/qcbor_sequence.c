@@ -0,0 +1,256 @@
+/*==============================================================================
+ Copyright (c) 2016-2018, The Linux Foundation.
+ Copyright (c) 2018-2021, Laurence Lundblade.
+ Copyright (c) 2021, Arm Limited.
+ All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors, nor the name "Laurence Lundblade" may be used to
+      endorse or promote products derived from this software without
+      specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_sequence.h"
+#include "qcbor_decode_private.h"
+
+
+/* ===========================================================================
+   Sequence reader -- split a CBOR sequence into its top-level items
+
+   The end of an item is found with DecodeHead() alone, counting the
+   items left in each open array or map and seeking over string
+   content. Tags are not counted as they are part of the item they
+   tag. Only the part of the sequence that is left is given to the
+   UsefulInputBuf so offsets within it fit in a size_t no matter how
+   large the sequence.
+   ========================================================================== */
+
+
+/* An open array or map in QCBORSequence_Next() */
+typedef struct {
+   uint64_t uRemaining;  /* Items left or UINT64_MAX for indefinite length */
+   uint8_t  uMajorType;
+   uint8_t  bHalfPair;   /* A label without its value in an indefinite-length map */
+} SequenceLevel;
+
+
+/*
+ * Public function, see header qcbor/qcbor_sequence.h file
+ */
+void
+QCBORSequence_Init(QCBORSequenceReader *pReader, UsefulBufC Sequence)
+{
+   pReader->Sequence = Sequence;
+   pReader->uOffset  = 0;
+   pReader->uErr     = QCBOR_SUCCESS;
+   if(Sequence.len > QCBOR_MAX_SEQUENCE_SIZE) {
+      pReader->uErr = QCBOR_ERR_INPUT_TOO_LARGE;
+   }
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_sequence.h file
+ */
+void
+QCBORSequence_Seek(QCBORSequenceReader *pReader, QCBORSequenceOffset uOffset)
+{
+   if(pReader->uErr == QCBOR_ERR_INPUT_TOO_LARGE) {
+      return;
+   }
+   pReader->uErr = QCBOR_SUCCESS;
+   if(uOffset > pReader->Sequence.len) {
+      pReader->uOffset = pReader->Sequence.len;
+      pReader->uErr    = QCBOR_ERR_HIT_END;
+   } else {
+      pReader->uOffset = (size_t)uOffset;
+   }
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_sequence.h file
+ */
+QCBORError
+QCBORSequence_Next(QCBORSequenceReader *pReader, UsefulBufC *pItem)
+{
+   QCBORError     uReturn;
+   UsefulInputBuf InBuf;
+   SequenceLevel  aLevels[QCBOR_MAX_ARRAY_NESTING];
+   int            nDepth      = 0;
+   int            nStringType = -1; /* Major type of an open indefinite-length string */
+   bool           bTagged     = false;
+
+   if(pReader->uErr != QCBOR_SUCCESS) {
+      return pReader->uErr;
+   }
+   if(pReader->uOffset >= pReader->Sequence.len) {
+      return QCBOR_ERR_NO_MORE_ITEMS;
+   }
+
+   UsefulInputBuf_Init(&InBuf, UsefulBuf_Tail(pReader->Sequence, pReader->uOffset));
+
+   do {
+      int      nMajorType;
+      uint64_t uArgument;
+      int      nAdditionalInfo;
+
+      uReturn = DecodeHead(&InBuf, &nMajorType, &uArgument, &nAdditionalInfo, false);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+      const bool bIndefinite = nAdditionalInfo == LEN_IS_INDEFINITE;
+
+      if(nMajorType == CBOR_MAJOR_TYPE_SIMPLE && nAdditionalInfo == CBOR_SIMPLE_BREAK) {
+         if(nStringType >= 0) {
+            nStringType = -1;
+         } else if(nDepth == 0 || bTagged ||
+                   aLevels[nDepth-1].uRemaining != UINT64_MAX ||
+                   aLevels[nDepth-1].bHalfPair) {
+            uReturn = QCBOR_ERR_BAD_BREAK;
+            goto Done;
+         } else {
+            nDepth--;
+         }
+
+      } else if(nStringType >= 0) {
+         /* Chunks must be definite-length strings of the same type */
+         if(nMajorType != nStringType || bIndefinite) {
+            uReturn = QCBOR_ERR_INDEFINITE_STRING_CHUNK;
+            goto Done;
+         }
+         if(uArgument > UsefulInputBuf_BytesUnconsumed(&InBuf)) {
+            uReturn = QCBOR_ERR_HIT_END;
+            goto Done;
+         }
+         UsefulInputBuf_Seek(&InBuf, UsefulInputBuf_Tell(&InBuf) + (size_t)uArgument);
+         continue;
+
+      } else {
+         bTagged = false;
+
+         switch(nMajorType) {
+            case CBOR_MAJOR_TYPE_POSITIVE_INT:
+            case CBOR_MAJOR_TYPE_NEGATIVE_INT:
+               if(bIndefinite) {
+                  uReturn = QCBOR_ERR_BAD_INT;
+                  goto Done;
+               }
+               break;
+
+            case CBOR_MAJOR_TYPE_BYTE_STRING:
+            case CBOR_MAJOR_TYPE_TEXT_STRING:
+               if(bIndefinite) {
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+                  nStringType = nMajorType;
+                  continue;
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+                  uReturn = QCBOR_ERR_INDEF_LEN_STRINGS_DISABLED;
+                  goto Done;
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+               }
+               if(uArgument > UsefulInputBuf_BytesUnconsumed(&InBuf)) {
+                  uReturn = QCBOR_ERR_HIT_END;
+                  goto Done;
+               }
+               UsefulInputBuf_Seek(&InBuf, UsefulInputBuf_Tell(&InBuf) + (size_t)uArgument);
+               break;
+
+            case CBOR_MAJOR_TYPE_ARRAY:
+            case CBOR_MAJOR_TYPE_MAP:
+               if(bIndefinite) {
+#ifdef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+                  uReturn = QCBOR_ERR_INDEF_LEN_ARRAYS_DISABLED;
+                  goto Done;
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+                  uArgument = UINT64_MAX;
+               } else if(nMajorType == CBOR_MAJOR_TYPE_MAP) {
+                  /* More pairs than this can't fit in any input */
+                  if(uArgument > UINT64_MAX / 4) {
+                     uReturn = QCBOR_ERR_HIT_END;
+                     goto Done;
+                  }
+                  uArgument *= 2;
+               }
+               if(uArgument == 0) {
+                  break;
+               }
+               if(nDepth >= QCBOR_MAX_ARRAY_NESTING) {
+                  uReturn = QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP;
+                  goto Done;
+               }
+               aLevels[nDepth].uRemaining = uArgument;
+               aLevels[nDepth].uMajorType = (uint8_t)nMajorType;
+               aLevels[nDepth].bHalfPair  = false;
+               nDepth++;
+               continue;
+
+            case CBOR_MAJOR_TYPE_TAG:
+               if(bIndefinite) {
+                  uReturn = QCBOR_ERR_BAD_INT;
+                  goto Done;
+               }
+               bTagged = true;
+               continue;
+
+            default:
+               /* Major type 7. A break was handled above and the
+                * reserved additional info by DecodeHead(). This takes
+                * out f8 00 ... f8 1f as DecodeType7() does. */
+               if(nAdditionalInfo == LEN_IS_ONE_BYTE && uArgument <= CBOR_SIMPLE_BREAK) {
+                  uReturn = QCBOR_ERR_BAD_TYPE_7;
+                  goto Done;
+               }
+               break;
+         }
+      }
+
+      /* An item is complete. It may be the last one of the levels it
+       * is in. */
+      while(nDepth > 0) {
+         SequenceLevel *pLevel = &aLevels[nDepth - 1];
+         if(pLevel->uRemaining == UINT64_MAX) {
+            if(pLevel->uMajorType == CBOR_MAJOR_TYPE_MAP) {
+               pLevel->bHalfPair = !pLevel->bHalfPair;
+            }
+            break;
+         }
+         if(--pLevel->uRemaining > 0) {
+            break;
+         }
+         nDepth--;
+      }
+   } while(nDepth > 0 || nStringType >= 0 || bTagged);
+
+   const size_t uLength = UsefulInputBuf_Tell(&InBuf);
+   *pItem = UsefulBuf_Head(UsefulBuf_Tail(pReader->Sequence, pReader->uOffset), uLength);
+   pReader->uOffset += uLength;
+
+Done:
+   if(uReturn != QCBOR_SUCCESS) {
+      pReader->uErr = (uint8_t)uReturn;
+   }
+   return uReturn;
+}
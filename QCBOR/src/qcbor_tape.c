@@ -0,0 +1,373 @@
+/*==============================================================================
+ Copyright (c) 2016-2018, The Linux Foundation.
+ Copyright (c) 2018-2021, Laurence Lundblade.
+ Copyright (c) 2021, Arm Limited.
+ All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors, nor the name "Laurence Lundblade" may be used to
+      endorse or promote products derived from this software without
+      specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_tape.h"
+#include "qcbor_decode_private.h"
+
+
+/* ===========================================================================
+   Tape -- flat structural index of encoded CBOR
+
+   QCBORTape_Build() records every data item with DecodeHead() in one
+   pass without filling in QCBORItems. Arrays, maps, tags and
+   indefinite-length strings are closed when their last item is
+   counted or their break is found. Values are decoded later from
+   the recorded offsets with DecodeAtomicDataItem().
+   ========================================================================== */
+
+
+/* An open array, map, tag or indefinite-length string in QCBORTape_Build() */
+typedef struct {
+   uint32_t uIndex;     /* Its entry in the tape */
+   uint64_t uRemaining; /* Items left or UINT64_MAX for indefinite length */
+   uint64_t uItems;     /* Items found so far */
+} TapeLevel;
+
+
+/*
+ * Public function, see header qcbor/qcbor_tape.h file
+ */
+QCBORError
+QCBORTape_Build(QCBORTape *pTape, UsefulBufC Encoded, UsefulBuf TapeBuffer)
+{
+   QCBORError     uReturn;
+   UsefulInputBuf InBuf;
+   TapeLevel      aLevels[QCBOR_TAPE_MAX_NESTING];
+   int            nDepth = 0;
+   uint32_t       uCount = 0;
+   size_t         uSize  = 0;
+
+   /* Align the entries for their 64-bit arguments */
+   const size_t uAlignMask = sizeof(uint64_t) - 1;
+   const size_t uSkip = (sizeof(uint64_t) - ((uintptr_t)TapeBuffer.ptr & uAlignMask)) & uAlignMask;
+
+   pTape->Encoded  = Encoded;
+   pTape->pEntries = NULL;
+   pTape->uCount   = 0;
+   if(TapeBuffer.ptr != NULL && TapeBuffer.len >= uSkip) {
+      pTape->pEntries = (QCBORTapeEntry *)(void *)((uint8_t *)TapeBuffer.ptr + uSkip);
+      uSize = (TapeBuffer.len - uSkip) / sizeof(QCBORTapeEntry);
+   }
+   QCBORTapeEntry *pEntries = pTape->pEntries;
+
+   if(Encoded.len > QCBOR_MAX_DECODE_INPUT_SIZE) {
+      return QCBOR_ERR_INPUT_TOO_LARGE;
+   }
+   UsefulInputBuf_Init(&InBuf, Encoded);
+
+   while(UsefulInputBuf_BytesUnconsumed(&InBuf) || nDepth > 0) {
+      const uint32_t uOffset = (uint32_t)UsefulInputBuf_Tell(&InBuf);
+      int            nMajorType;
+      uint64_t       uArgument;
+      int            nAdditionalInfo;
+
+      /* Hitting the end with levels still open is caught here */
+      uReturn = DecodeHead(&InBuf, &nMajorType, &uArgument, &nAdditionalInfo, false);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+
+      TapeLevel *pLevel = nDepth > 0 ? &aLevels[nDepth - 1] : NULL;
+      QCBORTapeEntry *pOpen = pLevel ? &pEntries[pLevel->uIndex] : NULL;
+      const int nOpenMajorType = pOpen ? pOpen->uInitialByte >> 5 : -1;
+
+      if(nMajorType == CBOR_MAJOR_TYPE_SIMPLE && nAdditionalInfo == CBOR_SIMPLE_BREAK) {
+         if(pLevel == NULL || pLevel->uRemaining != UINT64_MAX ||
+            (nOpenMajorType == CBOR_MAJOR_TYPE_MAP && (pLevel->uItems & 1))) {
+            uReturn = QCBOR_ERR_BAD_BREAK;
+            goto Done;
+         }
+         pOpen->uArgument = nOpenMajorType == CBOR_MAJOR_TYPE_MAP ? pLevel->uItems / 2 : pLevel->uItems;
+         pOpen->uNext     = uCount;
+         pOpen->uEnd      = (uint32_t)UsefulInputBuf_Tell(&InBuf);
+         nDepth--;
+
+      } else {
+         if(pLevel && pLevel->uRemaining == UINT64_MAX &&
+            (nOpenMajorType == CBOR_MAJOR_TYPE_BYTE_STRING ||
+             nOpenMajorType == CBOR_MAJOR_TYPE_TEXT_STRING) &&
+            (nMajorType != nOpenMajorType || nAdditionalInfo == LEN_IS_INDEFINITE)) {
+            /* Chunks must be definite-length strings of the same type */
+            uReturn = QCBOR_ERR_INDEFINITE_STRING_CHUNK;
+            goto Done;
+         }
+
+         if(uCount >= uSize) {
+            uReturn = QCBOR_ERR_TAPE_TOO_SMALL;
+            goto Done;
+         }
+         QCBORTapeEntry *pEntry = &pEntries[uCount];
+         const uint32_t  uThis  = uCount++;
+         pEntry->uOffset      = uOffset;
+         pEntry->uArgument    = uArgument;
+         pEntry->uInitialByte = (uint8_t)((nMajorType << 5) | nAdditionalInfo);
+
+         /* How many items are in this one. Zero for leaves. */
+         uint64_t uItems = 0;
+         const bool bIndefinite = nAdditionalInfo == LEN_IS_INDEFINITE;
+
+         switch(nMajorType) {
+            case CBOR_MAJOR_TYPE_POSITIVE_INT:
+            case CBOR_MAJOR_TYPE_NEGATIVE_INT:
+               if(bIndefinite) {
+                  uReturn = QCBOR_ERR_BAD_INT;
+                  goto Done;
+               }
+               break;
+
+            case CBOR_MAJOR_TYPE_BYTE_STRING:
+            case CBOR_MAJOR_TYPE_TEXT_STRING:
+               if(bIndefinite) {
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+                  uItems = UINT64_MAX;
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+                  uReturn = QCBOR_ERR_INDEF_LEN_STRINGS_DISABLED;
+                  goto Done;
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+               } else {
+                  if(uArgument > UsefulInputBuf_BytesUnconsumed(&InBuf)) {
+                     uReturn = QCBOR_ERR_HIT_END;
+                     goto Done;
+                  }
+                  UsefulInputBuf_Seek(&InBuf, UsefulInputBuf_Tell(&InBuf) + (size_t)uArgument);
+               }
+               break;
+
+            case CBOR_MAJOR_TYPE_ARRAY:
+            case CBOR_MAJOR_TYPE_MAP:
+               if(bIndefinite) {
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+                  uItems = UINT64_MAX;
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+                  uReturn = QCBOR_ERR_INDEF_LEN_ARRAYS_DISABLED;
+                  goto Done;
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+               } else {
+                  if(uArgument > QCBOR_MAX_ITEMS_IN_ARRAY) {
+                     uReturn = QCBOR_ERR_ARRAY_DECODE_TOO_LONG;
+                     goto Done;
+                  }
+                  uItems = nMajorType == CBOR_MAJOR_TYPE_MAP ? uArgument * 2 : uArgument;
+               }
+               break;
+
+            case CBOR_MAJOR_TYPE_TAG:
+               if(bIndefinite) {
+                  uReturn = QCBOR_ERR_BAD_INT;
+                  goto Done;
+               }
+               uItems = 1;
+               break;
+
+            default:
+               /* Major type 7. A break was handled above and the
+                * reserved additional info by DecodeHead(). This takes
+                * out f8 00 ... f8 1f as DecodeType7() does. */
+               if(nAdditionalInfo == LEN_IS_ONE_BYTE && uArgument <= CBOR_SIMPLE_BREAK) {
+                  uReturn = QCBOR_ERR_BAD_TYPE_7;
+                  goto Done;
+               }
+               break;
+         }
+
+         if(uItems != 0) {
+            if(nDepth >= QCBOR_TAPE_MAX_NESTING) {
+               uReturn = QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP;
+               goto Done;
+            }
+            aLevels[nDepth].uIndex     = uThis;
+            aLevels[nDepth].uRemaining = uItems;
+            aLevels[nDepth].uItems     = 0;
+            nDepth++;
+            continue;
+         }
+         pEntry->uNext = uCount;
+         pEntry->uEnd  = (uint32_t)UsefulInputBuf_Tell(&InBuf);
+      }
+
+      /* An item is complete. It may be the last one of the levels it
+       * is in. */
+      while(nDepth > 0) {
+         pLevel = &aLevels[nDepth - 1];
+         pLevel->uItems++;
+         if(pLevel->uRemaining == UINT64_MAX || --pLevel->uRemaining > 0) {
+            break;
+         }
+         pEntries[pLevel->uIndex].uNext = uCount;
+         pEntries[pLevel->uIndex].uEnd  = (uint32_t)UsefulInputBuf_Tell(&InBuf);
+         nDepth--;
+      }
+   }
+
+   pTape->uCount = uCount;
+   uReturn = QCBOR_SUCCESS;
+
+Done:
+   return uReturn;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_tape.h file
+ */
+UsefulBufC
+QCBORTape_GetEncoded(const QCBORTape *pTape, uint32_t uIndex)
+{
+   const QCBORTapeEntry *pEntry = &(pTape->pEntries[uIndex]);
+
+   return UsefulBuf_Tail(UsefulBuf_Head(pTape->Encoded, pEntry->uEnd), pEntry->uOffset);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_tape.h file
+ */
+QCBORError
+QCBORTape_GetItem(const QCBORTape *pTape, uint32_t uIndex, QCBORItem *pItem)
+{
+   QCBORError     uReturn;
+   UsefulInputBuf InBuf;
+
+   /* A tag's only child is the item it tags */
+   while(uIndex < pTape->uCount && QCBORTape_MajorType(pTape, uIndex) == CBOR_MAJOR_TYPE_TAG) {
+      uIndex++;
+   }
+   if(uIndex >= pTape->uCount) {
+      return QCBOR_ERR_NO_MORE_ITEMS;
+   }
+
+   const QCBORTapeEntry *pEntry = &(pTape->pEntries[uIndex]);
+
+   UsefulInputBuf_Init(&InBuf, pTape->Encoded);
+   UsefulInputBuf_Seek(&InBuf, pEntry->uOffset);
+   uReturn = QCBORDecode_Private_DecodeAtomicDataItem(&InBuf, pItem);
+
+   if(uReturn == QCBOR_SUCCESS &&
+      QCBORItem_IsMapOrArray(pItem) &&
+      pItem->val.uCount == QCBOR_COUNT_INDICATES_INDEFINITE_LENGTH &&
+      pEntry->uArgument <= QCBOR_MAX_ITEMS_IN_ARRAY) {
+      /* Counted when the tape was built */
+      pItem->val.uCount = (uint16_t)pEntry->uArgument;
+   }
+
+   return uReturn;
+}
+
+
+/*
+ * The label is matched by its head and, for strings, the content
+ * which is at the end of the entry.
+ */
+static QCBORError
+Tape_FindLabel(const QCBORTape *pTape,
+               uint32_t         uMapIndex,
+               uint8_t          uMajorType,
+               uint64_t         uArgument,
+               const void      *pContent,
+               uint32_t        *puValueIndex)
+{
+   if(uMapIndex >= pTape->uCount ||
+      QCBORTape_MajorType(pTape, uMapIndex) != CBOR_MAJOR_TYPE_MAP) {
+      return QCBOR_ERR_UNEXPECTED_TYPE;
+   }
+
+   const QCBORTapeEntry *pEntries = pTape->pEntries;
+   const uint32_t        uEnd     = pEntries[uMapIndex].uNext;
+   uint32_t              uLabel   = uMapIndex + 1;
+
+   while(uLabel < uEnd) {
+      const QCBORTapeEntry *pLabel = &pEntries[uLabel];
+      const uint32_t        uValue = pLabel->uNext;
+
+      if((pLabel->uInitialByte >> 5) == uMajorType &&
+         (pLabel->uInitialByte & 0x1f) != LEN_IS_INDEFINITE &&
+         pLabel->uArgument == uArgument &&
+         (pContent == NULL ||
+          memcmp((const uint8_t *)pTape->Encoded.ptr + pLabel->uEnd - uArgument,
+                 pContent,
+                 (size_t)uArgument) == 0)) {
+         *puValueIndex = uValue;
+         return QCBOR_SUCCESS;
+      }
+      uLabel = pEntries[uValue].uNext;
+   }
+
+   return QCBOR_ERR_LABEL_NOT_FOUND;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_tape.h file
+ */
+QCBORError
+QCBORTape_GetInMapN(const QCBORTape *pTape,
+                    uint32_t         uMapIndex,
+                    int64_t          nLabel,
+                    uint32_t        *puValueIndex)
+{
+   if(nLabel >= 0) {
+      return Tape_FindLabel(pTape,
+                            uMapIndex,
+                            CBOR_MAJOR_TYPE_POSITIVE_INT,
+                            (uint64_t)nLabel,
+                            NULL,
+                            puValueIndex);
+   } else {
+      /* -1 - nLabel can't overflow for any negative nLabel */
+      return Tape_FindLabel(pTape,
+                            uMapIndex,
+                            CBOR_MAJOR_TYPE_NEGATIVE_INT,
+                            (uint64_t)(-1 - nLabel),
+                            NULL,
+                            puValueIndex);
+   }
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_tape.h file
+ */
+QCBORError
+QCBORTape_GetInMapSZ(const QCBORTape *pTape,
+                     uint32_t         uMapIndex,
+                     const char      *szLabel,
+                     uint32_t        *puValueIndex)
+{
+   return Tape_FindLabel(pTape,
+                         uMapIndex,
+                         CBOR_MAJOR_TYPE_TEXT_STRING,
+                         strlen(szLabel),
+                         szLabel,
+                         puValueIndex);
+}
@@ -0,0 +1,506 @@
+/*==============================================================================
+ Copyright (c) 2016-2018, The Linux Foundation.
+ Copyright (c) 2018-2021, Laurence Lundblade.
+ Copyright (c) 2021, Arm Limited.
+ All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors, nor the name "Laurence Lundblade" may be used to
+      endorse or promote products derived from this software without
+      specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_spiffy_decode.h"
+#include "qcbor_decode_private.h"
+#include "ieee754.h" /* Does not use math.h */
+
+#ifndef QCBOR_DISABLE_FLOAT_HW_USE
+#include <math.h> /* For isnan() */
+#endif /* QCBOR_DISABLE_FLOAT_HW_USE */
+
+
+/* Half-precision values collected before they are widened together */
+#define ARRAY_HALF_BATCH 32
+
+static inline void
+ArrayFlushHalves(uint8_t         uType,
+                 void           *pValues,
+                 size_t          uFirst,
+                 const uint16_t *puHalves,
+                 size_t          uNumHalves)
+{
+#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
+   if(uType == QCBOR_TYPE_DOUBLE) {
+      IEEE754_HalfToDoubleBlock(puHalves, (double *)pValues + uFirst, uNumHalves);
+   } else {
+      IEEE754_HalfToFloatBlock(puHalves, (float *)pValues + uFirst, uNumHalves);
+   }
+#else /* QCBOR_DISABLE_PREFERRED_FLOAT */
+   (void)uType;
+   (void)pValues;
+   (void)uFirst;
+   (void)puHalves;
+   (void)uNumHalves;
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+}
+
+
+/**
+ * @brief Decode plain numbers of an entered array straight from the input.
+ *
+ * @param[in] pMe       The decode context.
+ * @param[in] uType     @ref QCBOR_TYPE_INT64, @ref QCBOR_TYPE_UINT64,
+ *                      @ref QCBOR_TYPE_DOUBLE or @ref QCBOR_TYPE_FLOAT.
+ * @param[out] pValues  The C array of @c uType.
+ * @param[in] uIndex    The first entry of @c pValues to fill in.
+ * @param[in] uEnd      One past the last entry to fill in.
+ *
+ * @return The number of items consumed.
+ *
+ * Must only be called when the current level is the entered
+ * definite-length array and @c uEnd is no more than its remaining
+ * count. Only the head of each item is decoded. It stops, with the
+ * input put back to the start of the item, at the first item that
+ * isn't an untagged number of the type, or that would give an error
+ * or a conversion. The full pipeline then decodes that item, so the
+ * result and error are the same. Half-precision values are collected
+ * and widened in blocks.
+ */
+static size_t
+QCBORDecode_Private_GetArrayBlock(QCBORDecodeContext *pMe,
+                                  uint8_t             uType,
+                                  void               *pValues,
+                                  size_t              uIndex,
+                                  size_t              uEnd)
+{
+   const UsefulInputBuf SaveInBuf = pMe->InBuf;
+   const bool           bDCBOR    = pMe->uDecodeMode == QCBOR_DECODE_MODE_DCBOR;
+   uint16_t             auHalves[ARRAY_HALF_BATCH];
+   size_t               uNumHalves = 0;
+   size_t               uHalfFirst = 0;
+   size_t               i;
+
+   for(i = uIndex; i < uEnd; i++) {
+      const size_t uItemStart = UsefulInputBuf_Tell(&(pMe->InBuf));
+      int          nMajorType;
+      uint64_t     uArgument;
+      int          nAdditionalInfo;
+
+      if(DecodeHead(&(pMe->InBuf), &nMajorType, &uArgument, &nAdditionalInfo, bDCBOR) != QCBOR_SUCCESS ||
+         nAdditionalInfo == LEN_IS_INDEFINITE) {
+         goto PutBack;
+      }
+
+      if(uType == QCBOR_TYPE_INT64 || uType == QCBOR_TYPE_UINT64) {
+         if(nMajorType == CBOR_MAJOR_TYPE_POSITIVE_INT &&
+            (uType == QCBOR_TYPE_UINT64 || uArgument <= INT64_MAX)) {
+            /* Same bits for int64_t and uint64_t */
+            ((uint64_t *)pValues)[i] = uArgument;
+         } else if(nMajorType == CBOR_MAJOR_TYPE_NEGATIVE_INT &&
+                   uType == QCBOR_TYPE_INT64 && uArgument <= INT64_MAX) {
+            /* Cast is safe because of the check against INT64_MAX */
+            ((int64_t *)pValues)[i] = -(int64_t)uArgument - 1;
+         } else {
+            goto PutBack;
+         }
+         continue;
+      }
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+      /* Floating-point. HALF_PREC_FLOAT..DOUBLE_PREC_FLOAT line up
+       * with IEEE754_UNION_IS_HALF..IEEE754_UNION_IS_DOUBLE as in
+       * DecodeType7().
+       */
+      if(nMajorType != CBOR_MAJOR_TYPE_SIMPLE ||
+         nAdditionalInfo < HALF_PREC_FLOAT || nAdditionalInfo > DOUBLE_PREC_FLOAT) {
+         goto PutBack;
+      }
+#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
+      if(bDCBOR && IEEE754_IsNotShortest(uArgument, (uint8_t)(2 << (nAdditionalInfo - HALF_PREC_FLOAT)))) {
+         goto PutBack;
+      }
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+
+      if(nAdditionalInfo == HALF_PREC_FLOAT) {
+#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
+         if(uNumHalves == 0) {
+            uHalfFirst = i;
+         }
+         /* Cast is safe because the encoded value was 16 bits */
+         auHalves[uNumHalves++] = (uint16_t)uArgument;
+         if(uNumHalves == ARRAY_HALF_BATCH) {
+            ArrayFlushHalves(uType, pValues, uHalfFirst, auHalves, uNumHalves);
+            uNumHalves = 0;
+         }
+         continue;
+#else /* QCBOR_DISABLE_PREFERRED_FLOAT */
+         goto PutBack;
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+      }
+
+      if(uNumHalves) {
+         /* The run of halves collected so far ends here */
+         ArrayFlushHalves(uType, pValues, uHalfFirst, auHalves, uNumHalves);
+         uNumHalves = 0;
+      }
+
+      if(uType == QCBOR_TYPE_FLOAT) {
+         if(nAdditionalInfo != SINGLE_PREC_FLOAT) {
+            /* Narrowing a double is left to ConvertFloat() */
+            goto PutBack;
+         }
+         /* Cast is safe because the encoded value was 32 bits */
+         ((float *)pValues)[i] = UsefulBufUtil_CopyUint32ToFloat((uint32_t)uArgument);
+      } else if(nAdditionalInfo == SINGLE_PREC_FLOAT) {
+#ifndef QCBOR_DISABLE_FLOAT_HW_USE
+         ((double *)pValues)[i] = (double)UsefulBufUtil_CopyUint32ToFloat((uint32_t)uArgument);
+#else /* QCBOR_DISABLE_FLOAT_HW_USE */
+         goto PutBack;
+#endif /* QCBOR_DISABLE_FLOAT_HW_USE */
+      } else {
+         ((double *)pValues)[i] = UsefulBufUtil_CopyUint64ToDouble(uArgument);
+      }
+      continue;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+   PutBack:
+      pMe->InBuf = SaveInBuf;
+      UsefulInputBuf_Seek(&(pMe->InBuf), uItemStart);
+      break;
+   }
+
+   if(uNumHalves) {
+      ArrayFlushHalves(uType, pValues, uHalfFirst, auHalves, uNumHalves);
+   }
+
+   /* The same count the ascender would leave, including zero for the
+    * end of the bounded array. Cast is safe because the count is
+    * limited to the remaining uint16_t count. */
+   pMe->nesting.pCurrent->u.ma.uCountCursor = (uint16_t)(pMe->nesting.pCurrent->u.ma.uCountCursor - (i - uIndex));
+
+   return i - uIndex;
+}
+
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+static QCBORError
+ConvertFloat(const QCBORItem *pItem, float *pfValue)
+{
+   switch(pItem->uDataType) {
+      case QCBOR_TYPE_FLOAT:
+         *pfValue = pItem->val.fnum;
+         break;
+
+      case QCBOR_TYPE_DOUBLE:
+#ifndef QCBOR_DISABLE_FLOAT_HW_USE
+         *pfValue = (float)pItem->val.dfnum;
+         if((double)*pfValue != pItem->val.dfnum && !isnan(pItem->val.dfnum)) {
+            /* Doesn't fit or loses precision */
+            return QCBOR_ERR_FLOAT_EXCEPTION;
+         }
+         break;
+#else /* QCBOR_DISABLE_FLOAT_HW_USE */
+         return QCBOR_ERR_HW_FLOAT_DISABLED;
+#endif /* QCBOR_DISABLE_FLOAT_HW_USE */
+
+      default:
+         return QCBOR_ERR_UNEXPECTED_TYPE;
+   }
+
+   return QCBOR_SUCCESS;
+}
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+
+/* One item of a typed array through the full pipeline. This is the
+ * getter the typed array is documented to be the same as. */
+static void
+QCBORDecode_Private_GetArrayItem(QCBORDecodeContext *pMe,
+                                 uint8_t             uType,
+                                 void               *pValues,
+                                 size_t              uIndex)
+{
+   switch(uType) {
+      case QCBOR_TYPE_INT64:
+         QCBORDecode_GetInt64ConvertInternal(pMe, QCBOR_CONVERT_TYPE_XINT64, (int64_t *)pValues + uIndex, NULL);
+         break;
+
+      case QCBOR_TYPE_UINT64:
+         QCBORDecode_GetUInt64ConvertInternal(pMe, QCBOR_CONVERT_TYPE_XINT64, (uint64_t *)pValues + uIndex, NULL);
+         break;
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+      case QCBOR_TYPE_DOUBLE:
+         QCBORDecode_GetDoubleConvertInternal(pMe, QCBOR_CONVERT_TYPE_FLOAT, (double *)pValues + uIndex, NULL);
+         break;
+
+      case QCBOR_TYPE_FLOAT:
+         {
+            QCBORItem        Item;
+            const QCBORError uErr = QCBORDecode_GetNext(pMe, &Item);
+            if(uErr != QCBOR_SUCCESS) {
+               pMe->uLastError = (uint8_t)uErr;
+               break;
+            }
+            pMe->uLastError = (uint8_t)ConvertFloat(&Item, (float *)pValues + uIndex);
+         }
+         break;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+      default:
+         break;
+   }
+}
+
+
+/**
+ * @brief Decode the rest of an entered array into a C array and exit it.
+ *
+ * @param[in] pMe           The decode context.
+ * @param[in] uType         @ref QCBOR_TYPE_INT64, @ref QCBOR_TYPE_UINT64,
+ *                          @ref QCBOR_TYPE_DOUBLE or @ref QCBOR_TYPE_FLOAT.
+ * @param[out] pValues      The C array of @c uType.
+ * @param[in] uMaxValues    The number of entries in @c pValues.
+ * @param[out] puNumValues  The number of entries filled in.
+ *
+ * Runs of plain numbers go through
+ * QCBORDecode_Private_GetArrayBlock() and anything else, one item at
+ * a time, through QCBORDecode_Private_GetArrayItem().
+ */
+static void
+QCBORDecode_Private_GetArray(QCBORDecodeContext *pMe,
+                             uint8_t             uType,
+                             void               *pValues,
+                             size_t              uMaxValues,
+                             size_t             *puNumValues)
+{
+   size_t uIndex = 0;
+
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   while(1) {
+      const uint16_t uCount = QCBORDecode_Private_PlainArrayCount(pMe);
+      if(uCount != 0) {
+         size_t uEnd = uIndex + uCount;
+         if(uEnd > uMaxValues) {
+            uEnd = uMaxValues;
+         }
+         uIndex += QCBORDecode_Private_GetArrayBlock(pMe, uType, pValues, uIndex, uEnd);
+      }
+
+      if(QCBORDecode_Private_IsAtEndOfBounded(pMe)) {
+         break;
+      }
+      if(uIndex == uMaxValues) {
+         pMe->uLastError = QCBOR_ERR_ARRAY_DECODE_TOO_LONG;
+         goto Done;
+      }
+
+      QCBORDecode_Private_GetArrayItem(pMe, uType, pValues, uIndex);
+      if(pMe->uLastError != QCBOR_SUCCESS) {
+         goto Done;
+      }
+      uIndex++;
+   }
+
+   /* Everything in the array was consumed so its end is here. This
+    * saves QCBORDecode_ExitBoundedMapOrArray() traversing the array
+    * again to find it. */
+   pMe->uMapEndOffsetCache = (uint32_t)UsefulInputBuf_Tell(&(pMe->InBuf));
+   QCBORDecode_ExitArray(pMe);
+
+Done:
+   *puNumValues = uIndex;
+}
+
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_GetInt64Array(QCBORDecodeContext *pMe,
+                               int64_t            *pnValues,
+                               size_t              uMaxValues,
+                               size_t             *puNumValues)
+{
+   QCBORDecode_EnterBoundedMapOrArray(pMe, QCBOR_TYPE_ARRAY, NULL);
+   QCBORDecode_Private_GetArray(pMe, QCBOR_TYPE_INT64, pnValues, uMaxValues, puNumValues);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_GetInt64ArrayInMapN(QCBORDecodeContext *pMe,
+                                     int64_t             nLabel,
+                                     int64_t            *pnValues,
+                                     size_t              uMaxValues,
+                                     size_t             *puNumValues)
+{
+   QCBORDecode_EnterArrayFromMapN(pMe, nLabel);
+   QCBORDecode_Private_GetArray(pMe, QCBOR_TYPE_INT64, pnValues, uMaxValues, puNumValues);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_GetInt64ArrayInMapSZ(QCBORDecodeContext *pMe,
+                                      const char         *szLabel,
+                                      int64_t            *pnValues,
+                                      size_t              uMaxValues,
+                                      size_t             *puNumValues)
+{
+   QCBORDecode_EnterArrayFromMapSZ(pMe, szLabel);
+   QCBORDecode_Private_GetArray(pMe, QCBOR_TYPE_INT64, pnValues, uMaxValues, puNumValues);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_GetUInt64Array(QCBORDecodeContext *pMe,
+                                uint64_t           *puValues,
+                                size_t              uMaxValues,
+                                size_t             *puNumValues)
+{
+   QCBORDecode_EnterBoundedMapOrArray(pMe, QCBOR_TYPE_ARRAY, NULL);
+   QCBORDecode_Private_GetArray(pMe, QCBOR_TYPE_UINT64, puValues, uMaxValues, puNumValues);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_GetUInt64ArrayInMapN(QCBORDecodeContext *pMe,
+                                      int64_t             nLabel,
+                                      uint64_t           *puValues,
+                                      size_t              uMaxValues,
+                                      size_t             *puNumValues)
+{
+   QCBORDecode_EnterArrayFromMapN(pMe, nLabel);
+   QCBORDecode_Private_GetArray(pMe, QCBOR_TYPE_UINT64, puValues, uMaxValues, puNumValues);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_GetUInt64ArrayInMapSZ(QCBORDecodeContext *pMe,
+                                       const char         *szLabel,
+                                       uint64_t           *puValues,
+                                       size_t              uMaxValues,
+                                       size_t             *puNumValues)
+{
+   QCBORDecode_EnterArrayFromMapSZ(pMe, szLabel);
+   QCBORDecode_Private_GetArray(pMe, QCBOR_TYPE_UINT64, puValues, uMaxValues, puNumValues);
+}
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_GetDoubleArray(QCBORDecodeContext *pMe,
+                                double             *pdValues,
+                                size_t              uMaxValues,
+                                size_t             *puNumValues)
+{
+   QCBORDecode_EnterBoundedMapOrArray(pMe, QCBOR_TYPE_ARRAY, NULL);
+   QCBORDecode_Private_GetArray(pMe, QCBOR_TYPE_DOUBLE, pdValues, uMaxValues, puNumValues);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_GetDoubleArrayInMapN(QCBORDecodeContext *pMe,
+                                      int64_t             nLabel,
+                                      double             *pdValues,
+                                      size_t              uMaxValues,
+                                      size_t             *puNumValues)
+{
+   QCBORDecode_EnterArrayFromMapN(pMe, nLabel);
+   QCBORDecode_Private_GetArray(pMe, QCBOR_TYPE_DOUBLE, pdValues, uMaxValues, puNumValues);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_GetDoubleArrayInMapSZ(QCBORDecodeContext *pMe,
+                                       const char         *szLabel,
+                                       double             *pdValues,
+                                       size_t              uMaxValues,
+                                       size_t             *puNumValues)
+{
+   QCBORDecode_EnterArrayFromMapSZ(pMe, szLabel);
+   QCBORDecode_Private_GetArray(pMe, QCBOR_TYPE_DOUBLE, pdValues, uMaxValues, puNumValues);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_GetFloatArray(QCBORDecodeContext *pMe,
+                               float              *pfValues,
+                               size_t              uMaxValues,
+                               size_t             *puNumValues)
+{
+   QCBORDecode_EnterBoundedMapOrArray(pMe, QCBOR_TYPE_ARRAY, NULL);
+   QCBORDecode_Private_GetArray(pMe, QCBOR_TYPE_FLOAT, pfValues, uMaxValues, puNumValues);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_GetFloatArrayInMapN(QCBORDecodeContext *pMe,
+                                     int64_t             nLabel,
+                                     float              *pfValues,
+                                     size_t              uMaxValues,
+                                     size_t             *puNumValues)
+{
+   QCBORDecode_EnterArrayFromMapN(pMe, nLabel);
+   QCBORDecode_Private_GetArray(pMe, QCBOR_TYPE_FLOAT, pfValues, uMaxValues, puNumValues);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_GetFloatArrayInMapSZ(QCBORDecodeContext *pMe,
+                                      const char         *szLabel,
+                                      float              *pfValues,
+                                      size_t              uMaxValues,
+                                      size_t             *puNumValues)
+{
+   QCBORDecode_EnterArrayFromMapSZ(pMe, szLabel);
+   QCBORDecode_Private_GetArray(pMe, QCBOR_TYPE_FLOAT, pfValues, uMaxValues, puNumValues);
+}
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
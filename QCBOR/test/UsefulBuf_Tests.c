@@ -815,4 +815,86 @@ const char *UBUTest_CopyUtil(void)
 #endif /* USEFULBUF_DISABLE_ALL_FLOAT */
 
 
+static const struct {
+   const char *szBytes;
+   int         bValid;
+} sUTF8Vectors[] = {
+   {"",                         1},
+   {"Hello D-CBOR world!",      1},
+   {"\xc3\xa5\xc3\xa4\xc3\xb6", 1},
+   {"\xe2\x82\xac",             1},
+   {"\xef\xbf\xbf",             1},
+   {"\xf0\x9f\x98\x80",         1},
+   {"\xf4\x8f\xbf\xbf",         1},
+   {"\xed\x9f\xbf",             1},
+   {"\x80",                     0}, /* Lone continuation */
+   {"\xbf\x80",                 0},
+   {"\xc0\xaf",                 0}, /* Overlong 2-byte */
+   {"\xc1\xbf",                 0},
+   {"\xe0\x80\xaf",             0}, /* Overlong 3-byte */
+   {"\xe0\x9f\xbf",             0},
+   {"\xf0\x80\x80\xaf",         0}, /* Overlong 4-byte */
+   {"\xf0\x8f\xbf\xbf",         0},
+   {"\xed\xa0\x80",             0}, /* Surrogates */
+   {"\xed\xbf\xbf",             0},
+   {"\xf4\x90\x80\x80",         0}, /* Above U+10FFFF */
+   {"\xf5\x80\x80\x80",         0},
+   {"\xf8\x88\x80\x80\x80",     0},
+   {"\xff",                     0},
+   {"\xc3",                     0}, /* Truncated */
+   {"\xe2\x82",                 0},
+   {"\xf0\x9f\x98",             0},
+   {"\xc3\x41",                 0}, /* Missing continuation */
+   {"\xe2\x41\xac",             0},
+   {"\xf0\x9f\x41\x80",         0},
+};
+
+
+const char *UBUTF8Test(void)
+{
+   if(!UsefulBuf_IsValidUTF8(NULLUsefulBufC)) {
+      return "NULL not valid";
+   }
+
+   /* Each vector at every offset of a 16-byte block, followed by
+    * both end of input and more ASCII.
+    */
+   for(size_t uVector = 0; uVector < sizeof(sUTF8Vectors)/sizeof(sUTF8Vectors[0]); uVector++) {
+      const size_t uLen = strlen(sUTF8Vectors[uVector].szBytes);
+      for(size_t uOffset = 0; uOffset < 32; uOffset++) {
+         uint8_t  pBuf[64];
+         memset(pBuf, 'x', sizeof(pBuf));
+         memcpy(pBuf + uOffset, sUTF8Vectors[uVector].szBytes, uLen);
+
+         if(UsefulBuf_IsValidUTF8((UsefulBufC){pBuf, uOffset + uLen}) !=
+               sUTF8Vectors[uVector].bValid) {
+            return "Vector at end failed";
+         }
+         if(UsefulBuf_IsValidUTF8((UsefulBufC){pBuf, sizeof(pBuf)}) !=
+               sUTF8Vectors[uVector].bValid) {
+            return "Vector in middle failed";
+         }
+      }
+   }
+
+   /* A sequence split across two 16-byte blocks */
+   uint8_t pLong[40];
+   memset(pLong, 'x', sizeof(pLong));
+   memcpy(pLong + 14, "\xf0\x9f\x98\x80", 4);
+   if(!UsefulBuf_IsValidUTF8((UsefulBufC){pLong, sizeof(pLong)})) {
+      return "Split sequence failed";
+   }
+   pLong[17] = 'x';
+   if(UsefulBuf_IsValidUTF8((UsefulBufC){pLong, sizeof(pLong)})) {
+      return "Split truncated sequence failed";
+   }
+
+   /* Lead byte ending a block followed by an ASCII-only block */
+   memset(pLong, 'x', sizeof(pLong));
+   pLong[15] = 0xc3;
+   if(UsefulBuf_IsValidUTF8((UsefulBufC){pLong, 32})) {
+      return "Incomplete block failed";
+   }
 
+   return NULL;
+}
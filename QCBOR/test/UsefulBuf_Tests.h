@@ -46,6 +46,8 @@ const char *  UBUtilTests(void);
 
 const char *  UIBTest_IntegerFormat(void);
 
+const char *  UBUTF8Test(void);
+
 #ifndef USEFULBUF_DISABLE_ALL_FLOAT
 const char *  UBUTest_CopyUtil(void);
 #endif /* USEFULBUF_DISABLE_ALL_FLOAT */
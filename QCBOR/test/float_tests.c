@@ -619,6 +619,239 @@ int32_t DoubleAsSmallestTest()
 
    return 0;
 }
+
+
+/* Number of values in the arrays of FloatArrayTest(). Not a multiple
+ * of the SIMD or batch sizes so the ends of blocks get tested. */
+#define FLOAT_ARRAY_COUNT 1003
+
+static uint64_t FloatArrayRandom(uint64_t *puState)
+{
+   *puState = *puState * 6364136223846793005ULL + 1442695040888963407ULL;
+   return *puState ^ (*puState >> 29);
+}
+
+/* Bits of a double that mostly has a shorter form, or almost does. */
+static uint64_t FloatArrayDoubleBits(uint64_t *puState)
+{
+   const uint64_t uRandom   = FloatArrayRandom(puState);
+   const uint64_t uExponent = (uRandom >> 32) % 300;
+   uint64_t       uBits;
+
+   switch(uRandom % 8) {
+      case 0:
+         /* Anything, including NaN payloads and subnormals */
+         return FloatArrayRandom(puState);
+      case 1:
+         /* Half significand around the half exponent range */
+         uBits = FloatArrayRandom(puState) & 0x800ffc0000000000ULL;
+         return uBits | ((1000 + uExponent % 50) << 52);
+      case 2:
+         /* Single significand around the single exponent range */
+         uBits = FloatArrayRandom(puState) & 0x800fffffe0000000ULL;
+         return uBits | ((890 + uExponent) << 52);
+      case 3:
+         /* One bit more than a half significand */
+         uBits = FloatArrayRandom(puState) & 0x800ffe0000000000ULL;
+         return uBits | ((1009 + uExponent % 30) << 52);
+      case 4:
+         /* Infinity and NaN, some with payloads */
+         return 0x7ff0000000000000ULL | (FloatArrayRandom(puState) & 0x8000000000000fffULL) | ((uRandom >> 8) & 0x0008000000000000ULL);
+      case 5:
+         /* Zero */
+         return uRandom & 0x8000000000000000ULL;
+      case 6:
+         /* Subnormal */
+         return uRandom & 0x800000000000ffffULL;
+      default:
+         /* Small integers */
+         return UsefulBufUtil_CopyDoubleToUint64((double)(int32_t)(uRandom >> 48) - 32768.0);
+   }
+}
+
+
+/* The same kind of bits as a float. The exponent is moved so the
+ * double exponents around the half range stay around it. */
+static uint32_t FloatArrayFloatBits(uint64_t uBits)
+{
+   uint64_t uExponent = uBits >> 52 & 0x7ff;
+
+   if(uExponent == 0x7ff) {
+      uExponent = 0xff;
+   } else if(uExponent != 0) {
+      uExponent = (uExponent - 896) & 0xff;
+   }
+   return (uint32_t)((uBits >> 32 & 0x80000000) | uExponent << 23 | (uBits >> 29 & 0x7fffff));
+}
+
+
+static const uint64_t spSpecialDoubles[] = {
+   0x0000000000000000ULL, 0x8000000000000000ULL, 0x7ff0000000000000ULL,
+   0xfff0000000000000ULL, 0x7ff8000000000000ULL, 0xfff8000000000000ULL,
+   0x7ff0000000000001ULL, 0x7ff80000000001ffULL, 0x7ff4000000000000ULL,
+   0x3f10000000000000ULL, 0x3f0fffffffffffffULL, 0x40effc0000000000ULL,
+   0x40f0000000000000ULL, 0x3e70000000000000ULL, 0x47efffffe0000000ULL,
+   0x3810000000000000ULL, 0x380fffffffffffffULL, 0x0000000000000001ULL
+};
+
+
+/* Encodes FLOAT_ARRAY_COUNT pdValues with QCBOREncode_AddDoubleArray()
+ * or QCBOREncode_AddFloatArray() and compares with one at a time. */
+static int32_t
+FloatArrayEncodeCompare(const double *pdValues, const float *pfValues, UsefulBuf Storage1, UsefulBuf Storage2)
+{
+   QCBOREncodeContext EC;
+   UsefulBufC         Expected;
+   UsefulBufC         Encoded;
+
+   QCBOREncode_Init(&EC, Storage1);
+   QCBOREncode_OpenMap(&EC);
+   QCBOREncode_OpenArrayInMapN(&EC, 1);
+   for(size_t i = 0; i < FLOAT_ARRAY_COUNT; i++) {
+      if(pdValues) {
+         QCBOREncode_AddDouble(&EC, pdValues[i]);
+      } else {
+         QCBOREncode_AddFloat(&EC, pfValues[i]);
+      }
+   }
+   QCBOREncode_CloseArray(&EC);
+   QCBOREncode_OpenArrayInMap(&EC, "a");
+   QCBOREncode_CloseArray(&EC);
+   QCBOREncode_CloseMap(&EC);
+   if(QCBOREncode_Finish(&EC, &Expected)) {
+      return 1;
+   }
+
+   QCBOREncode_Init(&EC, Storage2);
+   QCBOREncode_OpenMap(&EC);
+   if(pdValues) {
+      QCBOREncode_AddDoubleArrayToMapN(&EC, 1, pdValues, FLOAT_ARRAY_COUNT);
+      QCBOREncode_AddDoubleArrayToMap(&EC, "a", pdValues, 0);
+   } else {
+      QCBOREncode_AddFloatArrayToMapN(&EC, 1, pfValues, FLOAT_ARRAY_COUNT);
+      QCBOREncode_AddFloatArrayToMap(&EC, "a", pfValues, 0);
+   }
+   QCBOREncode_CloseMap(&EC);
+   if(QCBOREncode_Finish(&EC, &Encoded)) {
+      return 2;
+   }
+
+   if(UsefulBuf_Compare(Encoded, Expected)) {
+      return 3;
+   }
+   return 0;
+}
+
+
+/* Every half-precision value, in two arrays of 32768 */
+#define FLOAT_ARRAY_HALVES 32768
+
+int32_t FloatArrayTest()
+{
+   static double   adValues[FLOAT_ARRAY_HALVES];
+   static float    afValues[FLOAT_ARRAY_HALVES];
+   static uint8_t  auStorage1[FLOAT_ARRAY_HALVES * 3 + 10];
+   static uint8_t  auStorage2[FLOAT_ARRAY_HALVES * 3 + 10];
+   UsefulBuf       Storage1 = UsefulBuf_FROM_BYTE_ARRAY(auStorage1);
+   UsefulBuf       Storage2 = UsefulBuf_FROM_BYTE_ARRAY(auStorage2);
+   uint64_t        uState = 1;
+   int32_t         nResult;
+   size_t          i;
+
+   /* Encoding against QCBOREncode_AddDouble() and QCBOREncode_AddFloat() */
+   for(int nRound = 0; nRound < 40; nRound++) {
+      for(i = 0; i < FLOAT_ARRAY_COUNT; i++) {
+         uint64_t uBits = FloatArrayDoubleBits(&uState);
+         if(nRound == 0 && i < sizeof(spSpecialDoubles)/sizeof(spSpecialDoubles[0])) {
+            uBits = spSpecialDoubles[i];
+         }
+         adValues[i] = UsefulBufUtil_CopyUint64ToDouble(uBits);
+         afValues[i] = UsefulBufUtil_CopyUint32ToFloat(FloatArrayFloatBits(uBits));
+      }
+      nResult = FloatArrayEncodeCompare(adValues, NULL, Storage1, Storage2);
+      if(nResult) {
+         return MakeTestResultCode((uint32_t)nRound, 1, (QCBORError)nResult);
+      }
+      nResult = FloatArrayEncodeCompare(NULL, afValues, Storage1, Storage2);
+      if(nResult) {
+         return MakeTestResultCode((uint32_t)nRound, 2, (QCBORError)nResult);
+      }
+   }
+
+   /* Decoding every half-precision value into arrays against
+    * decoding them one at a time */
+   for(uint32_t uFirst = 0; uFirst < 0x10000; uFirst += FLOAT_ARRAY_HALVES) {
+      UsefulOutBuf       OB;
+      UsefulBufC         Encoded;
+      QCBORDecodeContext DC;
+      QCBORItem          Item;
+      size_t             uNumValues;
+
+      /* QCBOREncode_AddType7() won't output the halves 24 to 31 as
+       * they look like simple values */
+      UsefulOutBuf_Init(&OB, Storage1);
+      UsefulOutBuf_AppendByte(&OB, 0x99);
+      UsefulOutBuf_AppendUint16(&OB, FLOAT_ARRAY_HALVES);
+      for(i = 0; i < FLOAT_ARRAY_HALVES; i++) {
+         UsefulOutBuf_AppendByte(&OB, 0xf9);
+         UsefulOutBuf_AppendUint16(&OB, (uint16_t)(uFirst + i));
+      }
+      Encoded = UsefulOutBuf_OutUBuf(&OB);
+      if(UsefulBuf_IsNULLC(Encoded)) {
+         return MakeTestResultCode(uFirst / FLOAT_ARRAY_HALVES, 3, 0);
+      }
+
+      QCBORDecode_Init(&DC, Encoded, QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_GetDoubleArray(&DC, adValues, FLOAT_ARRAY_HALVES, &uNumValues);
+      if(QCBORDecode_Finish(&DC) || uNumValues != FLOAT_ARRAY_HALVES) {
+         return MakeTestResultCode(uFirst / FLOAT_ARRAY_HALVES, 4, 0);
+      }
+      QCBORDecode_Init(&DC, Encoded, QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_GetFloatArray(&DC, afValues, FLOAT_ARRAY_HALVES, &uNumValues);
+      if(QCBORDecode_Finish(&DC) || uNumValues != FLOAT_ARRAY_HALVES) {
+         return MakeTestResultCode(uFirst / FLOAT_ARRAY_HALVES, 5, 0);
+      }
+
+      QCBORDecode_Init(&DC, Encoded, QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_EnterArray(&DC, NULL);
+      for(i = 0; i < FLOAT_ARRAY_HALVES; i++) {
+         const uint32_t uHalf = uFirst + (uint32_t)i;
+         QCBORDecode_VGetNext(&DC, &Item);
+         if(Item.uDataType != QCBOR_TYPE_DOUBLE ||
+            UsefulBufUtil_CopyDoubleToUint64(Item.val.dfnum) != UsefulBufUtil_CopyDoubleToUint64(adValues[i])) {
+            return MakeTestResultCode(uFirst / FLOAT_ARRAY_HALVES, 6, 0);
+         }
+         /* NaN payloads stay aligned on the LSB, which a cast to
+          * float would not do */
+         uint32_t uExpected;
+         if((uHalf & 0x7c00) == 0x7c00 && (uHalf & 0x3ff)) {
+            uExpected = (uHalf & 0x8000) << 16 | 0x7f800000 | (uHalf & 0x1ff) | (uHalf & 0x200) << 13;
+         } else {
+            uExpected = UsefulBufUtil_CopyFloatToUint32((float)Item.val.dfnum);
+         }
+         if(UsefulBufUtil_CopyFloatToUint32(afValues[i]) != uExpected) {
+            return MakeTestResultCode(uFirst / FLOAT_ARRAY_HALVES, 7, 0);
+         }
+      }
+      QCBORDecode_ExitArray(&DC);
+      if(QCBORDecode_Finish(&DC)) {
+         return MakeTestResultCode(uFirst / FLOAT_ARRAY_HALVES, 8, 0);
+      }
+   }
+
+#ifndef QCBOR_DISABLE_ENCODE_USAGE_GUARDS
+   QCBOREncodeContext EC;
+   UsefulBufC         Encoded;
+
+   QCBOREncode_Init(&EC, Storage1);
+   QCBOREncode_AddDoubleArray(&EC, adValues, QCBOR_MAX_ITEMS_IN_ARRAY + 1);
+   if(QCBOREncode_Finish(&EC, &Encoded) != QCBOR_ERR_ARRAY_TOO_LONG) {
+      return 9;
+   }
+#endif /* QCBOR_DISABLE_ENCODE_USAGE_GUARDS */
+
+   return 0;
+}
 #endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
 
 
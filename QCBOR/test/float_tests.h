@@ -23,6 +23,13 @@ int32_t DoubleAsSmallestTest(void);
 
 int32_t HalfPrecisionAgainstRFCCodeTest(void);
 
+
+/*
+ Encodes and decodes arrays of floating-point numbers with the block
+ conversions and compares with doing them one at a time.
+ */
+int32_t FloatArrayTest(void);
+
 #endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
 
 /*
@@ -35,6 +35,11 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "qcbor/qcbor_encode.h"
 #include "qcbor/qcbor_decode.h"
 #include "qcbor/qcbor_spiffy_decode.h"
+#include "qcbor/qcbor_tape.h"
+#include "qcbor/qcbor_sequence.h"
+#include "qcbor/qcbor_parallel.h"
+#include "qcbor/qcbor_arena.h"
+#include "qcbor/qcbor_compact.h"
 #include <string.h>
 #include <math.h> // for fabs()
 #include "not_well_formed_cbor.h"
@@ -5793,9 +5798,69 @@ static const struct NumberConversion NumberConversions[] = {
       EXP_AND_MANTISSA_ERROR(QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW),
       0,
       EXP_AND_MANTISSA_ERROR(QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW),
-      0.30000000000000004,
+      0.3,
       FLOAT_ERR_CODE_NO_FLOAT_HW(EXP_AND_MANTISSA_ERROR(QCBOR_SUCCESS))
    },
+   {
+      "Decimal fraction 10^19, the largest power of 10 in a uint64_t",
+      {(uint8_t[]){0xC4, 0x82, 0x13, 0x01}, 4},
+      0,
+      EXP_AND_MANTISSA_ERROR(QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW),
+      10000000000000000000ULL,
+      EXP_AND_MANTISSA_ERROR(QCBOR_SUCCESS),
+      1e19,
+      FLOAT_ERR_CODE_NO_FLOAT_HW(EXP_AND_MANTISSA_ERROR(QCBOR_SUCCESS))
+   },
+   {
+      "Decimal fraction 10^20",
+      {(uint8_t[]){0xC4, 0x82, 0x14, 0x01}, 4},
+      0,
+      EXP_AND_MANTISSA_ERROR(QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW),
+      0,
+      EXP_AND_MANTISSA_ERROR(QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW),
+      1e20,
+      FLOAT_ERR_CODE_NO_FLOAT_HW(EXP_AND_MANTISSA_ERROR(QCBOR_SUCCESS))
+   },
+   {
+      "Decimal fraction with negative bignum -5 * 10^1",
+      {(uint8_t[]){0xC4, 0x82, 0x01, 0xC3, 0x41, 0x04}, 6},
+      -50,
+      EXP_AND_MANTISSA_ERROR(QCBOR_SUCCESS),
+      0,
+      EXP_AND_MANTISSA_ERROR(QCBOR_ERR_NUMBER_SIGN_CONVERSION),
+      -50.0,
+      FLOAT_ERR_CODE_NO_FLOAT_HW(EXP_AND_MANTISSA_ERROR(QCBOR_SUCCESS))
+   },
+   {
+      "Big float 2^63",
+      {(uint8_t[]){0xC5, 0x82, 0x18, 0x3F, 0x01}, 5},
+      0,
+      EXP_AND_MANTISSA_ERROR(QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW),
+      9223372036854775808ULL,
+      EXP_AND_MANTISSA_ERROR(QCBOR_SUCCESS),
+      9223372036854775808.0,
+      FLOAT_ERR_CODE_NO_FLOAT_HW(EXP_AND_MANTISSA_ERROR(QCBOR_SUCCESS))
+   },
+   {
+      "Positive bignum 2^64 + 2^11 + 1 rounded up to 2^64 + 2^12",
+      {(uint8_t[]){0xC2, 0x49, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x01}, 11},
+      0,
+      QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW,
+      0,
+      QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW,
+      18446744073709555712.0,
+      FLOAT_ERR_CODE_NO_FLOAT_HW(QCBOR_SUCCESS)
+   },
+   {
+      "Negative bignum -(2^64 + 2^11 - 1) - 1 with leading zero",
+      {(uint8_t[]){0xC3, 0x4A, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xff}, 12},
+      0,
+      QCBOR_ERR_CONVERSION_UNDER_OVER_FLOW,
+      0,
+      QCBOR_ERR_NUMBER_SIGN_CONVERSION,
+      -18446744073709551616.0,
+      FLOAT_ERR_CODE_NO_FLOAT_HW(QCBOR_SUCCESS)
+   },
    {
       "+inifinity single precision",
       {(uint8_t[]){0xfa, 0x7f, 0x80, 0x00, 0x00}, 5},
@@ -7881,3 +7946,2504 @@ int32_t BoolTest(void)
 
    return 0;
 }
+
+
+/* ["€", h'C3', "\xC3", "ok"] */
+static const uint8_t spBadUTF8[] = {
+   0x84,
+   0x63, 0xe2, 0x82, 0xac,
+   0x41, 0xc3,
+   0x61, 0xc3,
+   0x62, 0x6f, 0x6b
+};
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+/* (_ "€", "\xED\xA0\x80") -- the second chunk is a surrogate */
+static const uint8_t spBadUTF8Chunk[] = {
+   0x7f,
+   0x63, 0xe2, 0x82, 0xac,
+   0x63, 0xed, 0xa0, 0x80,
+   0xff
+};
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+
+int32_t UTF8ValidationTest(void)
+{
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+
+   /* Off by default */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spBadUTF8), 0);
+   for(int n = 0; n < 5; n++) {
+      if(QCBORDecode_GetNext(&DCtx, &Item)) {
+         return 1;
+      }
+   }
+
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spBadUTF8), 0);
+   QCBORDecode_SetUTF8Validation(&DCtx, true);
+   if(QCBORDecode_GetNext(&DCtx, &Item) || Item.uDataType != QCBOR_TYPE_ARRAY) {
+      return 2;
+   }
+   if(QCBORDecode_GetNext(&DCtx, &Item) || Item.uDataType != QCBOR_TYPE_TEXT_STRING) {
+      return 3;
+   }
+   /* Byte strings are not checked */
+   if(QCBORDecode_GetNext(&DCtx, &Item) || Item.uDataType != QCBOR_TYPE_BYTE_STRING) {
+      return 4;
+   }
+   if(QCBORDecode_GetNext(&DCtx, &Item) != QCBOR_ERR_BAD_UTF8) {
+      return 5;
+   }
+   if(QCBORDecode_IsUnrecoverableError(QCBOR_ERR_BAD_UTF8)) {
+      return 6;
+   }
+   /* Decoding continues after the bad string */
+   if(QCBORDecode_GetNext(&DCtx, &Item) ||
+      UsefulBuf_Compare(Item.val.string, UsefulBuf_FROM_SZ_LITERAL("ok"))) {
+      return 7;
+   }
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 8;
+   }
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   UsefulBuf_MAKE_STACK_UB(Pool, 100);
+
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spBadUTF8Chunk), 0);
+   QCBORDecode_SetMemPool(&DCtx, Pool, false);
+   if(QCBORDecode_GetNext(&DCtx, &Item) || Item.val.string.len != 6) {
+      return 9;
+   }
+
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spBadUTF8Chunk), 0);
+   QCBORDecode_SetMemPool(&DCtx, Pool, false);
+   QCBORDecode_SetUTF8Validation(&DCtx, true);
+   if(QCBORDecode_GetNext(&DCtx, &Item) != QCBOR_ERR_BAD_UTF8) {
+      return 10;
+   }
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+
+   return 0;
+}
+
+
+static const struct FailInput DCBORInputs[] = {
+   /* Shortest heads are accepted */
+   { {(uint8_t[]){0x17}, 1}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0x18, 0x18}, 2}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0x19, 0x01, 0x00}, 3}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0x1a, 0x00, 0x01, 0x00, 0x00}, 5}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0x1b, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00}, 9}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0x38, 0x18}, 2}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0x61, 0x61}, 2}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0xc1, 0x00}, 2}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0xf8, 0x20}, 2}, QCBOR_SUCCESS },
+
+   /* Non-minimal integers, lengths and tag numbers */
+   { {(uint8_t[]){0x18, 0x17}, 2}, QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD },
+   { {(uint8_t[]){0x19, 0x00, 0xff}, 3}, QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD },
+   { {(uint8_t[]){0x1a, 0x00, 0x00, 0xff, 0xff}, 5}, QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD },
+   { {(uint8_t[]){0x1b, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff}, 9}, QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD },
+   { {(uint8_t[]){0x38, 0x00}, 2}, QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD },
+   { {(uint8_t[]){0x58, 0x00}, 2}, QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD },
+   { {(uint8_t[]){0x79, 0x00, 0x01, 0x61}, 4}, QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD },
+   { {(uint8_t[]){0x98, 0x00}, 2}, QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD },
+   { {(uint8_t[]){0xb8, 0x00}, 2}, QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD },
+   { {(uint8_t[]){0xd8, 0x01, 0x00}, 3}, QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD },
+   /* Still not well-formed rather than non-minimal */
+   { {(uint8_t[]){0xf8, 0x00}, 2}, QCBOR_ERR_BAD_TYPE_7 },
+
+   /* Indefinite lengths */
+   { {(uint8_t[]){0x5f, 0xff}, 2}, QCBOR_ERR_DCBOR_INDEFINITE_LENGTH },
+   { {(uint8_t[]){0x7f, 0xff}, 2}, QCBOR_ERR_DCBOR_INDEFINITE_LENGTH },
+   { {(uint8_t[]){0x9f, 0xff}, 2}, QCBOR_ERR_DCBOR_INDEFINITE_LENGTH },
+   { {(uint8_t[]){0xbf, 0xff}, 2}, QCBOR_ERR_DCBOR_INDEFINITE_LENGTH },
+
+   /* Text strings are checked for UTF-8 */
+   { {(uint8_t[]){0x62, 0xc3, 0x28}, 3}, QCBOR_ERR_BAD_UTF8 },
+};
+
+
+#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
+static const struct FailInput DCBORFloatInputs[] = {
+   /* Shortest form as produced by addDouble() */
+   { {(uint8_t[]){0xf9, 0x7e, 0x00}, 3}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0xf9, 0x80, 0x00}, 3}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0xf9, 0x7c, 0x00}, 3}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0xf9, 0x00, 0x01}, 3}, QCBOR_SUCCESS },
+   /* 1.5 * 2^-24 needs a float32 */
+   { {(uint8_t[]){0xfa, 0x33, 0xc0, 0x00, 0x00}, 5}, QCBOR_SUCCESS },
+   /* 65520 has one significant bit too many for float16 */
+   { {(uint8_t[]){0xfa, 0x47, 0x7f, 0xf0, 0x00}, 5}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0xfa, 0x00, 0x00, 0x00, 0x01}, 5}, QCBOR_SUCCESS },
+   /* 1.5 * 2^-149 needs a float64 */
+   { {(uint8_t[]){0xfb, 0x36, 0xa8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, 9}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0xfb, 0x47, 0xef, 0xff, 0xff, 0xe0, 0x00, 0x00, 0x01}, 9}, QCBOR_SUCCESS },
+   { {(uint8_t[]){0xfb, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01}, 9}, QCBOR_SUCCESS },
+
+   /* NaN other than 0x7e00 */
+   { {(uint8_t[]){0xf9, 0x7e, 0x01}, 3}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+   { {(uint8_t[]){0xf9, 0xfe, 0x00}, 3}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+   { {(uint8_t[]){0xfa, 0x7f, 0xc0, 0x00, 0x00}, 5}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+   { {(uint8_t[]){0xfb, 0x7f, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, 9}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+
+   /* Zero, infinity and values that fit float16 */
+   { {(uint8_t[]){0xfa, 0x80, 0x00, 0x00, 0x00}, 5}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+   { {(uint8_t[]){0xfa, 0x7f, 0x80, 0x00, 0x00}, 5}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+   { {(uint8_t[]){0xfa, 0x3f, 0xc0, 0x00, 0x00}, 5}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+   { {(uint8_t[]){0xfa, 0x47, 0x7f, 0xe0, 0x00}, 5}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+   /* 2^-24, the smallest float16 subnormal */
+   { {(uint8_t[]){0xfa, 0x33, 0x80, 0x00, 0x00}, 5}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+   { {(uint8_t[]){0xfb, 0x3e, 0x70, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, 9}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+   { {(uint8_t[]){0xfb, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, 9}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+
+   /* Values that fit float32 */
+   { {(uint8_t[]){0xfb, 0x3f, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, 9}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+   { {(uint8_t[]){0xfb, 0x47, 0xef, 0xff, 0xff, 0xe0, 0x00, 0x00, 0x00}, 9}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+   /* 2^-149, the smallest float32 subnormal */
+   { {(uint8_t[]){0xfb, 0x36, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, 9}, QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT },
+};
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+
+
+static int32_t ProcessDCBORInputs(const struct FailInput *pInputs, size_t nNumInputs)
+{
+   for(const struct FailInput *pF = pInputs; pF < pInputs + nNumInputs; pF++) {
+      QCBORDecodeContext DCtx;
+      QCBORItem          Item;
+
+      QCBORDecode_Init(&DCtx, pF->Input, QCBOR_DECODE_MODE_DCBOR);
+      QCBORError uErr = QCBORDecode_GetNext(&DCtx, &Item);
+      if(uErr == QCBOR_SUCCESS) {
+         uErr = QCBORDecode_Finish(&DCtx);
+      }
+      if(uErr != pF->nError) {
+         return (int32_t)((size_t)(pF - pInputs) * 100 + uErr);
+      }
+   }
+   return 0;
+}
+
+
+int32_t DCBORModeTest(void)
+{
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   QCBORError         uErr;
+   int32_t            nResult;
+
+   nResult = ProcessDCBORInputs(DCBORInputs, C_ARRAY_COUNT(DCBORInputs, struct FailInput));
+   if(nResult) {
+      return nResult;
+   }
+
+#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
+   nResult = ProcessDCBORInputs(DCBORFloatInputs, C_ARRAY_COUNT(DCBORFloatInputs, struct FailInput));
+   if(nResult) {
+      return 10000 + nResult;
+   }
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+
+   /* The checks are only made in D-CBOR mode */
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   static const uint8_t spNonMinimal[] = {0x82, 0x18, 0x01, 0xfb, 0x3f, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+#else /* USEFULBUF_DISABLE_ALL_FLOAT */
+   static const uint8_t spNonMinimal[] = {0x82, 0x18, 0x01, 0x19, 0x00, 0x01};
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spNonMinimal), QCBOR_DECODE_MODE_NORMAL);
+   for(int n = 0; n < 3; n++) {
+      if(QCBORDecode_GetNext(&DCtx, &Item)) {
+         return 1;
+      }
+   }
+
+   /* Maps are decoded as in normal mode */
+   static const uint8_t spMap[] = {0xa2, 0x01, 0x02, 0x61, 0x61, 0xf9, 0x3e, 0x00};
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spMap), QCBOR_DECODE_MODE_DCBOR);
+   if(QCBORDecode_GetNext(&DCtx, &Item) || Item.uDataType != QCBOR_TYPE_MAP) {
+      return 2;
+   }
+   if(QCBORDecode_GetNext(&DCtx, &Item) ||
+      Item.uLabelType != QCBOR_TYPE_INT64 ||
+      Item.val.int64 != 2) {
+      return 3;
+   }
+   uErr = QCBORDecode_GetNext(&DCtx, &Item);
+   if(uErr != FLOAT_ERR_CODE_NO_HALF_PREC(QCBOR_SUCCESS) ||
+      (uErr == QCBOR_SUCCESS &&
+       (Item.uLabelType != QCBOR_TYPE_TEXT_STRING ||
+        Item.uDataType != QCBOR_TYPE_DOUBLE))) {
+      return 4;
+   }
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 5;
+   }
+
+   /* The contents after a non-minimal or indefinite-length head are
+    * not consumed so decoding can't go on. ["ab", 1] with the string
+    * length in two bytes must not decode "ab" as items.
+    */
+   static const uint8_t spNonMinimalString[] = {0x82, 0x78, 0x02, 0x61, 0x62, 0x01};
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spNonMinimalString), QCBOR_DECODE_MODE_DCBOR);
+   if(QCBORDecode_GetNext(&DCtx, &Item) || Item.uDataType != QCBOR_TYPE_ARRAY) {
+      return 6;
+   }
+   uErr = QCBORDecode_GetNext(&DCtx, &Item);
+   if(uErr != QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD || !QCBORDecode_IsUnrecoverableError(uErr)) {
+      return 7;
+   }
+
+   /* [[_ 1], 2] */
+   static const uint8_t spIndefiniteInArray[] = {0x82, 0x9f, 0x01, 0xff, 0x02};
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefiniteInArray), QCBOR_DECODE_MODE_DCBOR);
+   if(QCBORDecode_GetNext(&DCtx, &Item) || Item.uDataType != QCBOR_TYPE_ARRAY) {
+      return 8;
+   }
+   uErr = QCBORDecode_GetNext(&DCtx, &Item);
+   if(uErr != QCBOR_ERR_DCBOR_INDEFINITE_LENGTH || !QCBORDecode_IsUnrecoverableError(uErr)) {
+      return 9;
+   }
+
+   /* A float not in shortest form is consumed, so decoding continues */
+#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
+   static const uint8_t spNonShortestFloat[] = {0x82, 0xfa, 0x3f, 0xc0, 0x00, 0x00, 0x01};
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spNonShortestFloat), QCBOR_DECODE_MODE_DCBOR);
+   if(QCBORDecode_GetNext(&DCtx, &Item) || Item.uDataType != QCBOR_TYPE_ARRAY) {
+      return 10;
+   }
+   uErr = QCBORDecode_GetNext(&DCtx, &Item);
+   if(uErr != QCBOR_ERR_DCBOR_NON_SHORTEST_FLOAT || QCBORDecode_IsUnrecoverableError(uErr)) {
+      return 11;
+   }
+   if(QCBORDecode_GetNext(&DCtx, &Item) || Item.val.int64 != 1 || Item.uNestingLevel != 1) {
+      return 12;
+   }
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 13;
+   }
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+
+   /* Searching a map stops at the error rather than finding 2 in "ab".
+    * {1: "ab", 2: 3} with the string length in two bytes.
+    */
+   static const uint8_t spNonMinimalInMap[] = {0xa2, 0x01, 0x78, 0x02, 0x61, 0x62, 0x02, 0x03};
+   int64_t nInt;
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spNonMinimalInMap), QCBOR_DECODE_MODE_DCBOR);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetInt64InMapN(&DCtx, 2, &nInt);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_DCBOR_NON_MINIMAL_HEAD) {
+      return 14;
+   }
+
+   return 0;
+}
+
+
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+/* {1: 0, 2: {1: 0, 2: 0}, "a": 0, "b": 0} */
+static const uint8_t spSortedMap[] = {
+   0xa4, 0x01, 0x00, 0x02, 0xa2, 0x01, 0x00, 0x02, 0x00,
+   0x61, 0x61, 0x00, 0x61, 0x62, 0x00};
+
+/* {2: 0, 1: 0, 3: 0} */
+static const uint8_t spUnsortedMap[] = {0xa3, 0x02, 0x00, 0x01, 0x00, 0x03, 0x00};
+
+/* {1: 0, 1: 0} */
+static const uint8_t spDuplicateMap[] = {0xa2, 0x01, 0x00, 0x01, 0x00};
+
+/* {2: {5: 0}, 1: 0} The inner map doesn't affect the outer */
+static const uint8_t spUnsortedOuterMap[] = {0xa2, 0x02, 0xa1, 0x05, 0x00, 0x01, 0x00};
+
+
+static QCBORError DecodeAllItems(UsefulBufC Encoded, QCBORDecodeMode nMode, bool bCheck, int *pnIndex)
+{
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   QCBORError         uErr;
+
+   QCBORDecode_Init(&DCtx, Encoded, nMode);
+   QCBORDecode_SetMapLabelOrderCheck(&DCtx, bCheck);
+   for(*pnIndex = 0; ; (*pnIndex)++) {
+      uErr = QCBORDecode_GetNext(&DCtx, &Item);
+      if(uErr == QCBOR_ERR_NO_MORE_ITEMS) {
+         return QCBOR_SUCCESS;
+      }
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+   }
+}
+
+
+int32_t MapLabelOrderTest(void)
+{
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   int                nIndex;
+   int64_t            nInt;
+
+   if(DecodeAllItems(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSortedMap), QCBOR_DECODE_MODE_NORMAL, true, &nIndex) ||
+      nIndex != 7) {
+      return 1;
+   }
+
+   /* Off by default */
+   if(DecodeAllItems(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnsortedMap), QCBOR_DECODE_MODE_NORMAL, false, &nIndex)) {
+      return 2;
+   }
+   if(DecodeAllItems(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnsortedMap), QCBOR_DECODE_MODE_NORMAL, true, &nIndex) != QCBOR_ERR_UNSORTED_LABEL ||
+      nIndex != 2) {
+      return 3;
+   }
+   if(DecodeAllItems(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDuplicateMap), QCBOR_DECODE_MODE_NORMAL, true, &nIndex) != QCBOR_ERR_DUPLICATE_LABEL ||
+      nIndex != 2) {
+      return 4;
+   }
+   if(DecodeAllItems(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnsortedOuterMap), QCBOR_DECODE_MODE_NORMAL, true, &nIndex) != QCBOR_ERR_UNSORTED_LABEL ||
+      nIndex != 3) {
+      return 5;
+   }
+   /* Always on in D-CBOR mode and never in map-as-array mode */
+   if(DecodeAllItems(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnsortedMap), QCBOR_DECODE_MODE_DCBOR, false, &nIndex) != QCBOR_ERR_UNSORTED_LABEL) {
+      return 6;
+   }
+   if(DecodeAllItems(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDuplicateMap), QCBOR_DECODE_MODE_MAP_AS_ARRAY, true, &nIndex)) {
+      return 7;
+   }
+
+   /* Traversal continues after the error and the next label is
+    * compared with the one in error */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnsortedMap), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetMapLabelOrderCheck(&DCtx, true);
+   QCBORDecode_GetNext(&DCtx, &Item);
+   QCBORDecode_GetNext(&DCtx, &Item);
+   if(QCBORDecode_GetNext(&DCtx, &Item) != QCBOR_ERR_UNSORTED_LABEL) {
+      return 8;
+   }
+   if(QCBORDecode_GetNext(&DCtx, &Item) || Item.label.int64 != 3) {
+      return 9;
+   }
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 10;
+   }
+
+   /* Searching an entered map rewinds without false errors */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSortedMap), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetMapLabelOrderCheck(&DCtx, true);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetInt64InMapSZ(&DCtx, "b", &nInt);
+   QCBORDecode_EnterMapFromMapN(&DCtx, 2);
+   QCBORDecode_GetInt64InMapN(&DCtx, 2, &nInt);
+   QCBORDecode_GetInt64InMapN(&DCtx, 1, &nInt);
+   QCBORDecode_ExitMap(&DCtx);
+   QCBORDecode_GetInt64InMapN(&DCtx, 1, &nInt);
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 11;
+   }
+
+   /* Any out of order label in a searched map is an error */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnsortedMap), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetMapLabelOrderCheck(&DCtx, true);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetInt64InMapN(&DCtx, 3, &nInt);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_UNSORTED_LABEL) {
+      return 12;
+   }
+
+   return 0;
+}
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+
+
+#define MAP_INDEX_INTS      200
+#define MAP_INDEX_NEGATIVES 20
+#define MAP_INDEX_STRINGS   30
+
+/* A big map of integer, negative and string labels and a nested map,
+ * in D-CBOR order or reversed. */
+static UsefulBufC EncodeIndexedMap(UsefulBuf Buffer, bool bReversed)
+{
+   QCBOREncodeContext ECtx;
+   char               szLabel[4];
+
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenMap(&ECtx);
+   for(int n = 0; n < MAP_INDEX_INTS + MAP_INDEX_NEGATIVES + MAP_INDEX_STRINGS + 1; n++) {
+      const int i = bReversed ? MAP_INDEX_INTS + MAP_INDEX_NEGATIVES + MAP_INDEX_STRINGS - n : n;
+      if(i < MAP_INDEX_INTS) {
+         QCBOREncode_AddInt64ToMapN(&ECtx, i, i * 3);
+      } else if(i < MAP_INDEX_INTS + MAP_INDEX_NEGATIVES) {
+         QCBOREncode_AddInt64ToMapN(&ECtx, MAP_INDEX_INTS - 1 - i, i);
+      } else if(i < MAP_INDEX_INTS + MAP_INDEX_NEGATIVES + MAP_INDEX_STRINGS) {
+         szLabel[0] = 'k';
+         szLabel[1] = (char)('0' + i % 100 / 10);
+         szLabel[2] = (char)('0' + i % 10);
+         szLabel[3] = '\0';
+         QCBOREncode_AddInt64ToMap(&ECtx, szLabel, i);
+      } else {
+         QCBOREncode_OpenMapInMap(&ECtx, "nested");
+         QCBOREncode_AddInt64ToMapN(&ECtx, 2, 22);
+         QCBOREncode_AddInt64ToMapN(&ECtx, 1, 11);
+         QCBOREncode_CloseMap(&ECtx);
+      }
+   }
+   QCBOREncode_CloseMap(&ECtx);
+
+   UsefulBufC Encoded;
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return NULLUsefulBufC;
+   }
+   return Encoded;
+}
+
+
+#ifdef QCBOR_ENABLE_MAP_INDEX
+static int32_t CheckIndexedMap(UsefulBufC Encoded, UsefulBuf Index)
+{
+   QCBORDecodeContext DCtx;
+   int64_t            nInt;
+   char               szLabel[4];
+
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetMapIndex(&DCtx, Index);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+
+   for(int i = 0; i < MAP_INDEX_INTS; i++) {
+      QCBORDecode_GetInt64InMapN(&DCtx, i, &nInt);
+      if(QCBORDecode_GetError(&DCtx) || nInt != i * 3) {
+         return 1;
+      }
+   }
+   for(int i = MAP_INDEX_INTS; i < MAP_INDEX_INTS + MAP_INDEX_NEGATIVES; i++) {
+      QCBORDecode_GetInt64InMapN(&DCtx, MAP_INDEX_INTS - 1 - i, &nInt);
+      if(QCBORDecode_GetError(&DCtx) || nInt != i) {
+         return 2;
+      }
+   }
+
+   /* The nested map is indexed after the outer or, if there is no
+    * room, in its place */
+   QCBORDecode_EnterMapFromMapSZ(&DCtx, "nested");
+   QCBORDecode_GetInt64InMapN(&DCtx, 1, &nInt);
+   if(QCBORDecode_GetError(&DCtx) || nInt != 11) {
+      return 3;
+   }
+   QCBORDecode_GetInt64InMapN(&DCtx, 3, &nInt);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_LABEL_NOT_FOUND) {
+      return 4;
+   }
+   QCBORDecode_ExitMap(&DCtx);
+
+   for(int i = MAP_INDEX_INTS + MAP_INDEX_NEGATIVES; i < MAP_INDEX_INTS + MAP_INDEX_NEGATIVES + MAP_INDEX_STRINGS; i++) {
+      szLabel[0] = 'k';
+      szLabel[1] = (char)('0' + i % 100 / 10);
+      szLabel[2] = (char)('0' + i % 10);
+      szLabel[3] = '\0';
+      QCBORDecode_GetInt64InMapSZ(&DCtx, szLabel, &nInt);
+      if(QCBORDecode_GetError(&DCtx) || nInt != i) {
+         return 5;
+      }
+   }
+
+   QCBORItem Items[4];
+   Items[0].uLabelType  = QCBOR_TYPE_INT64;
+   Items[0].label.int64 = -5;
+   Items[0].uDataType   = QCBOR_TYPE_INT64;
+   Items[1].uLabelType  = QCBOR_TYPE_TEXT_STRING;
+   Items[1].label.string = UsefulBuf_FROM_SZ_LITERAL("nested");
+   Items[1].uDataType   = QCBOR_TYPE_MAP;
+   Items[2].uLabelType  = QCBOR_TYPE_INT64;
+   Items[2].label.int64 = 1000;
+   Items[2].uDataType   = QCBOR_TYPE_ANY;
+   Items[3].uLabelType  = QCBOR_TYPE_NONE;
+   QCBORDecode_GetItemsInMap(&DCtx, Items);
+   if(QCBORDecode_GetError(&DCtx) ||
+      Items[0].val.int64 != MAP_INDEX_INTS + 4 ||
+      Items[1].val.uCount != 2 ||
+      Items[2].uDataType != QCBOR_TYPE_NONE) {
+      return 6;
+   }
+
+   QCBORDecode_GetInt64InMapSZ(&DCtx, "nested", &nInt);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_UNEXPECTED_TYPE) {
+      return 7;
+   }
+
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 8;
+   }
+
+   return 0;
+}
+
+
+int32_t MapIndexTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(EncodeBuffer, 2000);
+   UsefulBuf_MAKE_STACK_UB(BigIndex, 300 * QCBOR_MAP_INDEX_BYTES_PER_LABEL + 7);
+   UsefulBuf_MAKE_STACK_UB(SmallIndex, 10 * QCBOR_MAP_INDEX_BYTES_PER_LABEL);
+   QCBORDecodeContext DCtx;
+   int64_t            nInt;
+   int32_t            nResult;
+
+   for(int nReversed = 0; nReversed < 2; nReversed++) {
+      UsefulBufC Encoded = EncodeIndexedMap(EncodeBuffer, nReversed);
+      if(UsefulBuf_IsNULLC(Encoded)) {
+         return 1;
+      }
+
+      /* No index, an index too small for the outer map and one that
+       * fits all. Also with an unaligned buffer. */
+      nResult = CheckIndexedMap(Encoded, NULLUsefulBuf);
+      if(nResult) {
+         return 10 + nResult;
+      }
+      nResult = CheckIndexedMap(Encoded, SmallIndex);
+      if(nResult) {
+         return 20 + nResult;
+      }
+      nResult = CheckIndexedMap(Encoded, BigIndex);
+      if(nResult) {
+         return 30 + nResult;
+      }
+      nResult = CheckIndexedMap(Encoded, (UsefulBuf){(uint8_t *)BigIndex.ptr + 1, BigIndex.len - 1});
+      if(nResult) {
+         return 40 + nResult;
+      }
+   }
+
+   /* {0: {0: 0, 1: 1}, 1: {0: 1, 1: 2}, ...} Each nested map is
+    * indexed after the outer, which is kept through the exits. An
+    * index too small for both replaces the outer with each nested. */
+   QCBOREncodeContext ECtx;
+   QCBOREncode_Init(&ECtx, EncodeBuffer);
+   QCBOREncode_OpenMap(&ECtx);
+   for(int i = 0; i < 20; i++) {
+      QCBOREncode_OpenMapInMapN(&ECtx, i);
+      QCBOREncode_AddInt64ToMapN(&ECtx, 0, i);
+      QCBOREncode_AddInt64ToMapN(&ECtx, 1, i + 1);
+      QCBOREncode_CloseMap(&ECtx);
+   }
+   QCBOREncode_CloseMap(&ECtx);
+   UsefulBufC Nested;
+   if(QCBOREncode_Finish(&ECtx, &Nested)) {
+      return 5;
+   }
+   for(size_t uSlots = 21; uSlots <= 24; uSlots += 3) {
+      QCBORDecode_Init(&DCtx, Nested, QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_SetMapIndex(&DCtx, (UsefulBuf){BigIndex.ptr, uSlots * QCBOR_MAP_INDEX_BYTES_PER_LABEL + 7});
+      QCBORDecode_EnterMap(&DCtx, NULL);
+      for(int i = 19; i >= 0; i--) {
+         QCBORDecode_EnterMapFromMapN(&DCtx, i);
+         if((DCtx.uMapIndexTop == 0) != (uSlots == 21)) {
+            return 6;
+         }
+         QCBORDecode_GetInt64InMapN(&DCtx, 1, &nInt);
+         if(QCBORDecode_GetError(&DCtx) || nInt != i + 1) {
+            return 7;
+         }
+         QCBORDecode_ExitMap(&DCtx);
+      }
+      QCBORDecode_ExitMap(&DCtx);
+      if(QCBORDecode_Finish(&DCtx)) {
+         return 8;
+      }
+   }
+
+   /* Duplicates are detected for the label sought as without an index */
+   static const uint8_t spDuplicate[] = {0xa3, 0x01, 0x01, 0x02, 0x02, 0x01, 0x03};
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDuplicate), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetMapIndex(&DCtx, SmallIndex);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetInt64InMapN(&DCtx, 2, &nInt);
+   if(QCBORDecode_GetError(&DCtx) || nInt != 2) {
+      return 2;
+   }
+   QCBORDecode_GetInt64InMapN(&DCtx, 1, &nInt);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 3;
+   }
+
+   /* Errors anywhere in the map are reported as without an index */
+   static const uint8_t spBadItem[] = {0xa2, 0x01, 0x01, 0x02};
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spBadItem), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetMapIndex(&DCtx, SmallIndex);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetInt64InMapN(&DCtx, 1, &nInt);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_HIT_END) {
+      return 4;
+   }
+
+   return 0;
+}
+#endif /* QCBOR_ENABLE_MAP_INDEX */
+
+
+int32_t SortedMapSearchTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(EncodeBuffer, 2000);
+#ifdef QCBOR_ENABLE_MAP_INDEX
+   UsefulBuf_MAKE_STACK_UB(Index, 300 * QCBOR_MAP_INDEX_BYTES_PER_LABEL + 7);
+#endif /* QCBOR_ENABLE_MAP_INDEX */
+   QCBORDecodeContext DCtx;
+   QCBORItem          Items[66];
+   QCBORItem          Item;
+
+   for(int nReversed = 0; nReversed < 2; nReversed++) {
+      UsefulBufC Encoded = EncodeIndexedMap(EncodeBuffer, nReversed);
+      if(UsefulBuf_IsNULLC(Encoded)) {
+         return 1;
+      }
+
+      for(int nIndexed = 0; nIndexed < 2; nIndexed++) {
+         QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+#ifdef QCBOR_ENABLE_MAP_INDEX
+         if(nIndexed) {
+            QCBORDecode_SetMapIndex(&DCtx, Index);
+         }
+#endif /* QCBOR_ENABLE_MAP_INDEX */
+         QCBORDecode_EnterMap(&DCtx, NULL);
+
+         /* Out of order with a label that is not there and one that is
+          * searched for twice */
+         Items[0].uLabelType   = QCBOR_TYPE_TEXT_STRING;
+         Items[0].label.string = UsefulBuf_FROM_SZ_LITERAL("k30");
+         Items[0].uDataType    = QCBOR_TYPE_INT64;
+         Items[1].uLabelType   = QCBOR_TYPE_INT64;
+         Items[1].label.int64  = 150;
+         Items[1].uDataType    = QCBOR_TYPE_ANY;
+         Items[2].uLabelType   = QCBOR_TYPE_INT64;
+         Items[2].label.int64  = -3;
+         Items[2].uDataType    = QCBOR_TYPE_INT64;
+         Items[3].uLabelType   = QCBOR_TYPE_INT64;
+         Items[3].label.int64  = 1000;
+         Items[3].uDataType    = QCBOR_TYPE_ANY;
+         Items[4].uLabelType   = QCBOR_TYPE_INT64;
+         Items[4].label.int64  = 5;
+         Items[4].uDataType    = QCBOR_TYPE_INT64;
+         Items[5].uLabelType   = QCBOR_TYPE_INT64;
+         Items[5].label.int64  = 150;
+         Items[5].uDataType    = QCBOR_TYPE_INT64;
+         Items[6].uLabelType   = QCBOR_TYPE_NONE;
+         QCBORDecode_GetItemsInSortedMap(&DCtx, Items);
+
+         if(nReversed && !nIndexed) {
+            /* Stops at "nested" which is past all sought */
+            if(QCBORDecode_GetError(&DCtx) || Items[0].uDataType != QCBOR_TYPE_NONE) {
+               return 2;
+            }
+            continue;
+         }
+         if(QCBORDecode_GetError(&DCtx) ||
+            Items[0].val.int64 != 230 ||
+            Items[1].val.int64 != 450 ||
+            Items[2].val.int64 != MAP_INDEX_INTS + 2 ||
+            Items[3].uDataType != QCBOR_TYPE_NONE ||
+            Items[4].val.int64 != 15 ||
+            Items[5].val.int64 != 450) {
+            return 3 + nReversed * 10 + nIndexed * 20;
+         }
+
+         /* The cursor is not moved */
+         QCBORDecode_VGetNext(&DCtx, &Item);
+         if(QCBORDecode_GetError(&DCtx) ||
+            Item.uDataType != (nReversed ? QCBOR_TYPE_MAP : QCBOR_TYPE_INT64)) {
+            return 4 + nReversed * 10 + nIndexed * 20;
+         }
+         QCBORDecode_ExitMap(&DCtx);
+         if(QCBORDecode_Finish(&DCtx)) {
+            return 5 + nReversed * 10 + nIndexed * 20;
+         }
+      }
+   }
+
+   /* Labels out of order are found up to the largest sought */
+   static const uint8_t spUnsorted[] = {0xa3, 0x02, 0x02, 0x01, 0x01, 0x03, 0x03};
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnsorted), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   Items[0].uLabelType  = QCBOR_TYPE_INT64;
+   Items[0].label.int64 = 2;
+   Items[0].uDataType   = QCBOR_TYPE_ANY;
+   Items[1].uLabelType  = QCBOR_TYPE_NONE;
+   QCBORDecode_GetItemsInSortedMap(&DCtx, Items);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_UNSORTED_LABEL) {
+      return 49;
+   }
+
+   /* A duplicate of the largest label sought is found */
+   static const uint8_t spDuplicate[] = {0xa4, 0x01, 0x01, 0x02, 0x02, 0x02, 0x03, 0x03, 0x04};
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDuplicate), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   Items[0].uLabelType  = QCBOR_TYPE_INT64;
+   Items[0].label.int64 = 2;
+   Items[0].uDataType   = QCBOR_TYPE_ANY;
+   Items[1].uLabelType  = QCBOR_TYPE_NONE;
+   QCBORDecode_GetItemsInSortedMap(&DCtx, Items);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 50;
+   }
+
+   /* Duplicates of other labels are not errors, as with
+    * QCBORDecode_GetItemsInMap() */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDuplicate), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   Items[0].uLabelType  = QCBOR_TYPE_INT64;
+   Items[0].label.int64 = 3;
+   Items[0].uDataType   = QCBOR_TYPE_ANY;
+   QCBORDecode_GetItemsInSortedMap(&DCtx, Items);
+   if(QCBORDecode_GetError(&DCtx) || Items[0].val.int64 != 4) {
+      return 54;
+   }
+
+   /* The map is not decoded past the largest label sought */
+   static const uint8_t spTruncated[] = {0xa3, 0x01, 0x01, 0x02, 0x02, 0x03};
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTruncated), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   Items[0].label.int64 = 1;
+   QCBORDecode_GetItemsInSortedMap(&DCtx, Items);
+   if(QCBORDecode_GetError(&DCtx) || Items[0].val.int64 != 1) {
+      return 51;
+   }
+   Items[0].uLabelType  = QCBOR_TYPE_INT64;
+   Items[0].label.int64 = 3;
+   Items[0].uDataType   = QCBOR_TYPE_ANY;
+   QCBORDecode_GetItemsInSortedMap(&DCtx, Items);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_HIT_END) {
+      return 52;
+   }
+
+   /* Too many labels */
+   for(int i = 0; i < 65; i++) {
+      Items[i].uLabelType  = QCBOR_TYPE_INT64;
+      Items[i].label.int64 = i;
+      Items[i].uDataType   = QCBOR_TYPE_ANY;
+   }
+   Items[65].uLabelType = QCBOR_TYPE_NONE;
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDuplicate), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetItemsInSortedMap(&DCtx, Items);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_ARRAY_DECODE_TOO_LONG) {
+      return 53;
+   }
+
+   return 0;
+}
+
+
+/* [[1, [2, h'0102'], 1(3)], {1: [4], 2: "ab"}, 7] */
+static const uint8_t spSkipNested[] = {
+   0x83, 0x83, 0x01, 0x82, 0x02, 0x42, 0x01, 0x02, 0xc1, 0x03,
+   0xa2, 0x01, 0x81, 0x04, 0x02, 0x62, 0x61, 0x62, 0x07};
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+/* [_ 1, {_ 1: 2}, [_ ]] followed by 7, all in an array */
+static const uint8_t spSkipIndefinite[] = {
+   0x82, 0x9f, 0x01, 0xbf, 0x01, 0x02, 0xff, 0x9f, 0xff, 0xff, 0x07};
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+int32_t SkipScanTest(void)
+{
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   int64_t            nInt;
+
+   /* Whole arrays and maps are skipped */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSkipNested), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   QCBORDecode_VGetNextConsume(&DCtx, &Item);
+   if(Item.uDataType != QCBOR_TYPE_ARRAY || Item.uNextNestLevel != 1) {
+      return 1;
+   }
+   QCBORDecode_VGetNextConsume(&DCtx, &Item);
+   if(Item.uDataType != QCBOR_TYPE_MAP || Item.uNextNestLevel != 1) {
+      return 2;
+   }
+   QCBORDecode_GetInt64(&DCtx, &nInt);
+   QCBORDecode_ExitArray(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) || nInt != 7) {
+      return 3;
+   }
+
+   /* Exiting a map part way through skips the rest of it */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSkipNested), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   QCBORDecode_GetInt64(&DCtx, &nInt);
+   QCBORDecode_ExitArray(&DCtx);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_ExitMap(&DCtx);
+   QCBORDecode_GetInt64(&DCtx, &nInt);
+   QCBORDecode_ExitArray(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) || nInt != 7) {
+      return 4;
+   }
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+   /* Indefinite-length arrays and maps */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSkipIndefinite), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   QCBORDecode_VGetNextConsume(&DCtx, &Item);
+   if(QCBORDecode_GetError(&DCtx) || Item.uNextNestLevel != 1) {
+      return 5;
+   }
+   QCBORDecode_GetInt64(&DCtx, &nInt);
+   QCBORDecode_ExitArray(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) || nInt != 7) {
+      return 6;
+   }
+
+   /* The same at the top level with the low-level interface */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSkipIndefinite), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_VGetNextConsume(&DCtx, &Item);
+   if(QCBORDecode_GetError(&DCtx) || Item.uNextNestLevel != 0) {
+      return 7;
+   }
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 8;
+   }
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+   /* Skipped items the scanner can't handle get the full decode.
+    * As before, recoverable errors in them don't stop the skip. */
+   static const uint8_t spReserved[]   = {0x82, 0x81, 0x1c, 0x07};
+   static const uint8_t spIndefStr[]   = {0x82, 0x81, 0x5f, 0x41, 0x00, 0xff, 0x07};
+   static const uint8_t spTruncInt[]   = {0x82, 0x81, 0x3b, 0xff, 0xff, 0xff, 0xff};
+   static const uint8_t spTruncMap[]   = {0x82, 0xa1, 0x01};
+   static const uint8_t spBadSimple[]  = {0x82, 0x81, 0xf8, 0x01, 0x07};
+   struct {
+      UsefulBufC Input;
+      QCBORError uError;
+   } SkipErrors[5];
+   SkipErrors[0].Input  = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spReserved);
+   SkipErrors[0].uError = QCBOR_SUCCESS;
+   SkipErrors[1].Input  = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefStr);
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   SkipErrors[1].uError = QCBOR_ERR_NO_STRING_ALLOCATOR;
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+   /* Recoverable like spReserved */
+   SkipErrors[1].uError = QCBOR_SUCCESS;
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+   SkipErrors[2].Input  = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTruncInt);
+   SkipErrors[2].uError = QCBOR_ERR_HIT_END;
+   SkipErrors[3].Input  = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTruncMap);
+   SkipErrors[3].uError = QCBOR_ERR_HIT_END;
+   SkipErrors[4].Input  = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spBadSimple);
+   SkipErrors[4].uError = QCBOR_SUCCESS;
+   for(size_t i = 0; i < sizeof(SkipErrors)/sizeof(SkipErrors[0]); i++) {
+      QCBORDecode_Init(&DCtx, SkipErrors[i].Input, QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_EnterArray(&DCtx, NULL);
+      QCBORDecode_VGetNextConsume(&DCtx, &Item);
+      if(QCBORDecode_GetError(&DCtx) != SkipErrors[i].uError) {
+         return (int32_t)(10 + i);
+      }
+   }
+
+   /* Nesting too deep for the decoder is still an error when skipped */
+   uint8_t uDeep[QCBOR_MAX_ARRAY_NESTING + 2];
+   memset(uDeep, 0x81, sizeof(uDeep));
+   uDeep[sizeof(uDeep) - 1] = 0x01;
+   QCBORDecode_Init(&DCtx, (UsefulBufC){uDeep, sizeof(uDeep)}, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   QCBORDecode_VGetNextConsume(&DCtx, &Item);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP) {
+      return 20;
+   }
+
+   return 0;
+}
+
+
+#if !defined(QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS) && \
+    !defined(QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS)
+/*
+ [1, {1: "a", -2: [_ 3, 4], "key": 24(h'01'), "z": (_ "ab", "c")}, true]
+ followed by 5 in a CBOR sequence
+ */
+static const uint8_t spTapeInput[] = {
+   0x83, 0x01, 0xa4, 0x01, 0x61, 0x61, 0x21, 0x9f, 0x03, 0x04, 0xff,
+   0x63, 0x6b, 0x65, 0x79, 0xd8, 0x18, 0x41, 0x01, 0x61, 0x7a, 0x7f,
+   0x62, 0x61, 0x62, 0x61, 0x63, 0xff, 0xf5, 0x05};
+
+/* QCBORTape_Next() for each entry of spTapeInput */
+static const uint32_t spTapeNext[] = {
+   17, 2, 16, 4, 5, 6, 9, 8, 9, 10, 12, 12, 13, 16, 15, 16, 17, 18};
+#endif /* !QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS && !QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+
+int32_t TapeTest(void)
+{
+   QCBORTapeEntry Entries[40];
+   QCBORTape      Tape;
+   QCBORError     uErr;
+
+#if !defined(QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS) && \
+    !defined(QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS)
+   QCBORItem      Item;
+   uint32_t       uIndex;
+
+   uErr = QCBORTape_Build(&Tape,
+                          UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTapeInput),
+                          UsefulBuf_FROM_BYTE_ARRAY(Entries));
+   if(uErr != QCBOR_SUCCESS || QCBORTape_Count(&Tape) != 18) {
+      return 1;
+   }
+   for(uIndex = 0; uIndex < 18; uIndex++) {
+      if(QCBORTape_Next(&Tape, uIndex) != spTapeNext[uIndex]) {
+         return 2;
+      }
+   }
+
+   if(QCBORTape_GetInMapN(&Tape, 2, 1, &uIndex) || uIndex != 4) {
+      return 3;
+   }
+   uErr = QCBORTape_GetItem(&Tape, uIndex, &Item);
+   if(uErr != QCBOR_SUCCESS ||
+      Item.uDataType != QCBOR_TYPE_TEXT_STRING ||
+      UsefulBuf_Compare(Item.val.string, UsefulBuf_FROM_SZ_LITERAL("a"))) {
+      return 4;
+   }
+
+   /* Indefinite-length array has its count filled in */
+   if(QCBORTape_GetInMapN(&Tape, 2, -2, &uIndex) || uIndex != 6) {
+      return 5;
+   }
+   uErr = QCBORTape_GetItem(&Tape, uIndex, &Item);
+   if(uErr != QCBOR_SUCCESS || Item.uDataType != QCBOR_TYPE_ARRAY || Item.val.uCount != 2) {
+      return 6;
+   }
+   if(UsefulBuf_Compare(QCBORTape_GetEncoded(&Tape, uIndex),
+                        UsefulBuf_FROM_SZ_LITERAL("\x9f\x03\x04\xff"))) {
+      return 7;
+   }
+
+   /* A tag gives the tagged item */
+   if(QCBORTape_GetInMapSZ(&Tape, 2, "key", &uIndex) || uIndex != 10) {
+      return 8;
+   }
+   if(QCBORTape_MajorType(&Tape, uIndex) != CBOR_MAJOR_TYPE_TAG ||
+      QCBORTape_Argument(&Tape, uIndex) != 24) {
+      return 9;
+   }
+   uErr = QCBORTape_GetItem(&Tape, uIndex, &Item);
+   if(uErr != QCBOR_SUCCESS ||
+      Item.uDataType != QCBOR_TYPE_BYTE_STRING ||
+      UsefulBuf_Compare(Item.val.string, UsefulBuf_FROM_SZ_LITERAL("\x01"))) {
+      return 10;
+   }
+
+   /* Indefinite-length string is its chunks */
+   if(QCBORTape_GetInMapSZ(&Tape, 2, "z", &uIndex) || uIndex != 13) {
+      return 11;
+   }
+   uErr = QCBORTape_GetItem(&Tape, uIndex, &Item);
+   if(uErr != QCBOR_SUCCESS ||
+      Item.val.string.len != QCBOR_STRING_LENGTH_INDEFINITE ||
+      QCBORTape_Argument(&Tape, uIndex) != 2) {
+      return 12;
+   }
+   uErr = QCBORTape_GetItem(&Tape, uIndex + 1, &Item);
+   if(uErr != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Item.val.string, UsefulBuf_FROM_SZ_LITERAL("ab"))) {
+      return 13;
+   }
+
+   if(QCBORTape_GetInMapN(&Tape, 2, 2, &uIndex) != QCBOR_ERR_LABEL_NOT_FOUND ||
+      QCBORTape_GetInMapSZ(&Tape, 2, "ke", &uIndex) != QCBOR_ERR_LABEL_NOT_FOUND ||
+      QCBORTape_GetInMapN(&Tape, 6, 0, &uIndex) != QCBOR_ERR_UNEXPECTED_TYPE) {
+      return 14;
+   }
+
+   /* The second item of the sequence */
+   uErr = QCBORTape_GetItem(&Tape, QCBORTape_Next(&Tape, 0), &Item);
+   if(uErr != QCBOR_SUCCESS || Item.uDataType != QCBOR_TYPE_INT64 || Item.val.int64 != 5) {
+      return 15;
+   }
+   if(QCBORTape_GetItem(&Tape, 18, &Item) != QCBOR_ERR_NO_MORE_ITEMS) {
+      return 16;
+   }
+
+   /* Not enough room for the last item */
+   uErr = QCBORTape_Build(&Tape,
+                          UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTapeInput),
+                          (UsefulBuf){Entries, 17 * QCBOR_TAPE_BYTES_PER_ITEM});
+   if(uErr != QCBOR_ERR_TAPE_TOO_SMALL || QCBORTape_Count(&Tape) != 0) {
+      return 17;
+   }
+#endif /* !QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS && !QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+   /* An empty sequence */
+   uErr = QCBORTape_Build(&Tape, NULLUsefulBufC, UsefulBuf_FROM_BYTE_ARRAY(Entries));
+   if(uErr != QCBOR_SUCCESS || QCBORTape_Count(&Tape) != 0) {
+      return 18;
+   }
+
+   static const struct {
+      UsefulBufC Input;
+      QCBORError uError;
+   } TapeErrors[] = {
+      {{"\x82\x01", 2},         QCBOR_ERR_HIT_END},
+      {{"\x42\x01", 2},         QCBOR_ERR_HIT_END},
+      {{"\xc1", 1},             QCBOR_ERR_HIT_END},
+      {{"\xff", 1},             QCBOR_ERR_BAD_BREAK},
+      {{"\xc1\xff", 2},         QCBOR_ERR_BAD_BREAK},
+      {{"\xa1\x01\xff", 3},     QCBOR_ERR_BAD_BREAK},
+      {{"\x1c", 1},             QCBOR_ERR_UNSUPPORTED},
+      {{"\x1f", 1},             QCBOR_ERR_BAD_INT},
+      {{"\xf8\x10", 2},         QCBOR_ERR_BAD_TYPE_7},
+      {{"\x9a\x00\x01\x00\x00", 5}, QCBOR_ERR_ARRAY_DECODE_TOO_LONG},
+#if !defined(QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS) && \
+    !defined(QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS)
+      {{"\xbf\x01\xff", 3},     QCBOR_ERR_BAD_BREAK},
+      {{"\x7f\x01\xff", 3},     QCBOR_ERR_INDEFINITE_STRING_CHUNK},
+      {{"\x5f\x5f\xff\xff", 4}, QCBOR_ERR_INDEFINITE_STRING_CHUNK},
+#endif /* !QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS && !QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+   };
+   for(size_t i = 0; i < sizeof(TapeErrors)/sizeof(TapeErrors[0]); i++) {
+      uErr = QCBORTape_Build(&Tape, TapeErrors[i].Input, UsefulBuf_FROM_BYTE_ARRAY(Entries));
+      if(uErr != TapeErrors[i].uError) {
+         return (int32_t)(20 + i);
+      }
+   }
+
+   /* Nesting at and beyond the limit */
+   uint8_t uDeep[QCBOR_TAPE_MAX_NESTING + 2];
+   memset(uDeep, 0x81, sizeof(uDeep));
+   uDeep[QCBOR_TAPE_MAX_NESTING] = 0x01;
+   uErr = QCBORTape_Build(&Tape,
+                          (UsefulBufC){uDeep, QCBOR_TAPE_MAX_NESTING + 1},
+                          UsefulBuf_FROM_BYTE_ARRAY(Entries));
+   if(uErr != QCBOR_SUCCESS || QCBORTape_Next(&Tape, 0) != QCBOR_TAPE_MAX_NESTING + 1) {
+      return 40;
+   }
+   uDeep[QCBOR_TAPE_MAX_NESTING] = 0x81;
+   uDeep[QCBOR_TAPE_MAX_NESTING + 1] = 0x01;
+   uErr = QCBORTape_Build(&Tape,
+                          (UsefulBufC){uDeep, sizeof(uDeep)},
+                          UsefulBuf_FROM_BYTE_ARRAY(Entries));
+   if(uErr != QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP) {
+      return 41;
+   }
+
+   return 0;
+}
+
+
+#ifdef QCBOR_ENABLE_INCREMENTAL_INPUT
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+/*
+ [_ 1, {"a": 256, "bc": [h'010203', true]}, 1(1600000000), [], -500]
+ followed by 42 in a CBOR sequence
+ */
+static const uint8_t spIncrementalInput[] = {
+   0x9f, 0x01, 0xa2, 0x61, 0x61, 0x19, 0x01, 0x00, 0x62, 0x62, 0x63,
+   0x82, 0x43, 0x01, 0x02, 0x03, 0xf5, 0xc1, 0x1a, 0x5f, 0x5e, 0x10,
+   0x00, 0x80, 0x39, 0x01, 0xf3, 0xff, 0x18, 0x2a};
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+/* {1: 100, 2: "hi", 3: [1, 2], 4: h'820102'} */
+static const uint8_t spIncrementalMap[] = {
+   0xa4, 0x01, 0x18, 0x64, 0x02, 0x62, 0x68, 0x69, 0x03, 0x82, 0x01,
+   0x02, 0x04, 0x43, 0x82, 0x01, 0x02};
+
+
+/* Decode Input fed to the decoder uChunk bytes at a time and compare
+ * every item and error to decoding all of it at once. */
+static int32_t
+IncrementalCompare(UsefulBufC Input, size_t uBufferSize, size_t uChunk)
+{
+   QCBORDecodeContext DCtx;
+   QCBORDecodeContext RefCtx;
+   QCBORItem          Item;
+   QCBORItem          RefItem;
+   QCBORError         uErr;
+   QCBORError         uRefErr;
+   UsefulBufC         Rest;
+   UsefulBufC         Chunk;
+   size_t             uConsumed;
+   uint8_t            Buffer[64];
+
+   QCBORDecode_Init(&RefCtx, Input, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_InitIncremental(&DCtx,
+                               (UsefulBuf){Buffer, uBufferSize},
+                               QCBOR_DECODE_MODE_NORMAL);
+   Rest = Input;
+   while(1) {
+      uErr = QCBORDecode_GetNext(&DCtx, &Item);
+      if(uErr == QCBOR_ERR_NEED_MORE_INPUT) {
+         if(Rest.len == 0) {
+            QCBORDecode_EndInput(&DCtx);
+         } else {
+            Chunk = UsefulBuf_Head(Rest, uChunk < Rest.len ? uChunk : Rest.len);
+            Rest  = UsefulBuf_Tail(Rest, Chunk.len - QCBORDecode_AddInput(&DCtx, Chunk).len);
+         }
+         continue;
+      }
+      uRefErr = QCBORDecode_GetNext(&RefCtx, &RefItem);
+      if(uErr != uRefErr) {
+         return 1;
+      }
+      if(uErr != QCBOR_SUCCESS) {
+         break;
+      }
+      if(Item.uDataType != RefItem.uDataType ||
+         Item.uLabelType != RefItem.uLabelType ||
+         Item.uNestingLevel != RefItem.uNestingLevel ||
+         Item.uNextNestLevel != RefItem.uNextNestLevel) {
+         return 2;
+      }
+      if(Item.uDataType == QCBOR_TYPE_INT64 && Item.val.int64 != RefItem.val.int64) {
+         return 3;
+      }
+      if((Item.uDataType == QCBOR_TYPE_BYTE_STRING || Item.uDataType == QCBOR_TYPE_TEXT_STRING) &&
+         UsefulBuf_Compare(Item.val.string, RefItem.val.string)) {
+         return 4;
+      }
+      if(Item.uLabelType == QCBOR_TYPE_TEXT_STRING &&
+         UsefulBuf_Compare(Item.label.string, RefItem.label.string)) {
+         return 5;
+      }
+   }
+
+   if(QCBORDecode_PartialFinish(&DCtx, &uConsumed) != QCBORDecode_Finish(&RefCtx) ||
+      uConsumed != UsefulInputBuf_Tell(&(RefCtx.InBuf))) {
+      return 6;
+   }
+
+   return 0;
+}
+
+
+/* After a spiffy decode call, add one byte and return true if the
+ * call should be repeated. */
+static bool
+IncrementalFeed(QCBORDecodeContext *pDCtx, UsefulBufC *pRest)
+{
+   if(QCBORDecode_GetError(pDCtx) != QCBOR_ERR_NEED_MORE_INPUT) {
+      return false;
+   }
+   if(pRest->len == 0) {
+      QCBORDecode_EndInput(pDCtx);
+   } else {
+      QCBORDecode_AddInput(pDCtx, UsefulBuf_Head(*pRest, 1));
+      *pRest = UsefulBuf_Tail(*pRest, 1);
+   }
+   return true;
+}
+
+#define INCREMENTAL_RETRY(pDCtx, pRest, Call) \
+   do { Call; } while(IncrementalFeed(pDCtx, pRest))
+
+
+int32_t IncrementalTest(void)
+{
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   UsefulBufC         Rest;
+   UsefulBufC         String;
+   int64_t            nInt;
+   int32_t            nResult;
+   uint8_t            Buffer[20];
+
+   /* Every split of the input and buffers down to the largest item */
+   for(size_t uBufferSize = 7; uBufferSize <= 64; uBufferSize += 3) {
+      for(size_t uChunk = 1; uChunk < 8; uChunk++) {
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+         const UsefulBufC Input = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIncrementalInput);
+         nResult = IncrementalCompare(Input, uBufferSize, uChunk);
+         if(nResult) {
+            return (int32_t)(uBufferSize * 100 + uChunk * 10) + nResult;
+         }
+         /* Truncated input gives the same error as without chunks */
+         nResult = IncrementalCompare(UsefulBuf_Head(Input, 20), uBufferSize, uChunk);
+         if(nResult) {
+            return (int32_t)(uBufferSize * 100 + uChunk * 10) + nResult;
+         }
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+         nResult = IncrementalCompare(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIncrementalMap),
+                                      uBufferSize + 12, uChunk);
+         if(nResult) {
+            return (int32_t)(10000 + uBufferSize * 100 + uChunk * 10) + nResult;
+         }
+      }
+   }
+
+   /* An item bigger than the buffer */
+   QCBORDecode_InitIncremental(&DCtx, (UsefulBuf){Buffer, 4}, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_AddInput(&DCtx, UsefulBuf_FROM_SZ_LITERAL("\x44\x01\x02\x03"));
+   if(QCBORDecode_GetNext(&DCtx, &Item) != QCBOR_ERR_INPUT_TOO_LARGE) {
+      return 1;
+   }
+
+   /* Spiffy decode of an entered map that arrives a byte at a time */
+   QCBORDecode_InitIncremental(&DCtx, UsefulBuf_FROM_BYTE_ARRAY(Buffer), QCBOR_DECODE_MODE_NORMAL);
+   Rest = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIncrementalMap);
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_EnterMap(&DCtx, NULL));
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_GetInt64InMapN(&DCtx, 1, &nInt));
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS || nInt != 100) {
+      return 2;
+   }
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_GetTextStringInMapN(&DCtx, 2, &String));
+   if(UsefulBuf_Compare(String, UsefulBuf_FROM_SZ_LITERAL("hi"))) {
+      return 3;
+   }
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_EnterArrayFromMapN(&DCtx, 3));
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_GetInt64(&DCtx, &nInt));
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_GetInt64(&DCtx, &nInt));
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_ExitArray(&DCtx));
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS || nInt != 2) {
+      return 4;
+   }
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_EnterBstrWrappedFromMapN(&DCtx, 4, QCBOR_TAG_REQUIREMENT_NOT_A_TAG, NULL));
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_EnterArray(&DCtx, NULL));
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_GetInt64(&DCtx, &nInt));
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_ExitArray(&DCtx));
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_ExitBstrWrapped(&DCtx));
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_ExitMap(&DCtx));
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS || nInt != 1) {
+      return 5;
+   }
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_VGetNext(&DCtx, &Item));
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_NO_MORE_ITEMS || Rest.len != 0) {
+      return 6;
+   }
+
+   /* The entered map is kept, so it must fit */
+   QCBORDecode_InitIncremental(&DCtx, (UsefulBuf){Buffer, 15}, QCBOR_DECODE_MODE_NORMAL);
+   Rest = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIncrementalMap);
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_EnterMap(&DCtx, NULL));
+   INCREMENTAL_RETRY(&DCtx, &Rest, QCBORDecode_GetInt64InMapN(&DCtx, 1, &nInt));
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_INPUT_TOO_LARGE) {
+      return 7;
+   }
+
+   return 0;
+}
+#endif /* QCBOR_ENABLE_INCREMENTAL_INPUT */
+
+
+
+/*
+ 1, 1(h'0102'), {"a": [2, [3]]}, 0([]), true
+ */
+static const uint8_t spSequence[] = {
+   0x01, 0xc1, 0x42, 0x01, 0x02, 0xa1, 0x61, 0x61, 0x82, 0x02,
+   0x81, 0x03, 0xc0, 0x80, 0xf5};
+
+/* Where each item of spSequence starts and the end */
+static const size_t spSequenceOffsets[] = {0, 1, 5, 12, 14, 15};
+
+
+int32_t SequenceReaderTest(void)
+{
+   QCBORSequenceReader Reader;
+   QCBORDecodeContext  DCtx;
+   QCBORItem           Item;
+   UsefulBufC          Encoded;
+   QCBORError          uErr;
+   size_t              uIndex;
+
+   const UsefulBufC Sequence = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSequence);
+
+   QCBORSequence_Init(&Reader, Sequence);
+   for(uIndex = 0; uIndex < 5; uIndex++) {
+      if(QCBORSequence_Tell(&Reader) != spSequenceOffsets[uIndex]) {
+         return 1;
+      }
+      uErr = QCBORSequence_Next(&Reader, &Encoded);
+      if(uErr != QCBOR_SUCCESS ||
+         Encoded.ptr != spSequence + spSequenceOffsets[uIndex] ||
+         Encoded.len != spSequenceOffsets[uIndex+1] - spSequenceOffsets[uIndex]) {
+         return 2;
+      }
+   }
+   if(QCBORSequence_Next(&Reader, &Encoded) != QCBOR_ERR_NO_MORE_ITEMS ||
+      QCBORSequence_Tell(&Reader) != sizeof(spSequence)) {
+      return 3;
+   }
+
+   /* Each item decodes on its own */
+   QCBORSequence_Seek(&Reader, (QCBORSequenceOffset)spSequenceOffsets[2]);
+   if(QCBORSequence_NextDecoder(&Reader, &DCtx, QCBOR_DECODE_MODE_NORMAL)) {
+      return 4;
+   }
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_EnterArrayFromMapSZ(&DCtx, "a");
+   QCBORDecode_VGetNextConsume(&DCtx, &Item);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   QCBORDecode_GetNext(&DCtx, &Item);
+   QCBORDecode_ExitArray(&DCtx);
+   QCBORDecode_ExitArray(&DCtx);
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS || Item.val.int64 != 3) {
+      return 5;
+   }
+
+   /* An error stays at the item in error until a seek */
+   static const uint8_t spBadBreak[] = {0x01, 0x82, 0x01, 0xff, 0x02};
+   QCBORSequence_Init(&Reader, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spBadBreak));
+   if(QCBORSequence_Next(&Reader, &Encoded) != QCBOR_SUCCESS ||
+      QCBORSequence_Next(&Reader, &Encoded) != QCBOR_ERR_BAD_BREAK ||
+      QCBORSequence_Next(&Reader, &Encoded) != QCBOR_ERR_BAD_BREAK ||
+      QCBORSequence_Tell(&Reader) != 1) {
+      return 6;
+   }
+   QCBORSequence_Seek(&Reader, 4);
+   if(QCBORSequence_NextDecoder(&Reader, &DCtx, QCBOR_DECODE_MODE_NORMAL) ||
+      QCBORDecode_GetNext(&DCtx, &Item) ||
+      Item.val.int64 != 2) {
+      return 7;
+   }
+   QCBORSequence_Seek(&Reader, 6);
+   if(QCBORSequence_Next(&Reader, &Encoded) != QCBOR_ERR_HIT_END) {
+      return 8;
+   }
+
+   static const struct {
+      UsefulBufC Input;
+      QCBORError uError;
+   } SequenceErrors[] = {
+      {{"\x82\x01", 2},         QCBOR_ERR_HIT_END},
+      {{"\x42\x01", 2},         QCBOR_ERR_HIT_END},
+      {{"\xc1", 1},             QCBOR_ERR_HIT_END},
+      {{"\xff", 1},             QCBOR_ERR_BAD_BREAK},
+      {{"\x1c", 1},             QCBOR_ERR_UNSUPPORTED},
+      {{"\x1f", 1},             QCBOR_ERR_BAD_INT},
+      {{"\xdf", 1},             QCBOR_ERR_BAD_INT},
+      {{"\xf8\x10", 2},         QCBOR_ERR_BAD_TYPE_7},
+      {{"\xbb\x40\x00\x00\x00\x00\x00\x00\x00", 9}, QCBOR_ERR_HIT_END},
+#if !defined(QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS) && \
+    !defined(QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS)
+      {{"\x9f\xc1\xff", 3},     QCBOR_ERR_BAD_BREAK},
+      {{"\xbf\x01\xff", 3},     QCBOR_ERR_BAD_BREAK},
+      {{"\x9f\x01", 2},         QCBOR_ERR_HIT_END},
+      {{"\x7f\x01\xff", 3},     QCBOR_ERR_INDEFINITE_STRING_CHUNK},
+      {{"\x5f\x5f\xff\xff", 4}, QCBOR_ERR_INDEFINITE_STRING_CHUNK},
+      {{"\x5f\x41", 2},         QCBOR_ERR_HIT_END},
+#endif /* !QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS && !QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+   };
+   for(uIndex = 0; uIndex < sizeof(SequenceErrors)/sizeof(SequenceErrors[0]); uIndex++) {
+      QCBORSequence_Init(&Reader, SequenceErrors[uIndex].Input);
+      if(QCBORSequence_Next(&Reader, &Encoded) != SequenceErrors[uIndex].uError ||
+         QCBORSequence_Tell(&Reader) != 0) {
+         return (int32_t)(20 + uIndex);
+      }
+   }
+
+#if !defined(QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS) && \
+    !defined(QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS)
+   /* [_ {_ "a": (_ 'b', 'c')}, 1(2)] then 3 */
+   static const uint8_t spIndefinite[] = {
+      0x9f, 0xbf, 0x61, 0x61, 0x5f, 0x41, 0x62, 0x41, 0x63, 0xff,
+      0xff, 0xc1, 0x02, 0xff, 0x03};
+   QCBORSequence_Init(&Reader, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefinite));
+   if(QCBORSequence_Next(&Reader, &Encoded) != QCBOR_SUCCESS ||
+      Encoded.len != sizeof(spIndefinite) - 1 ||
+      QCBORSequence_Next(&Reader, &Encoded) != QCBOR_SUCCESS ||
+      Encoded.len != 1) {
+      return 40;
+   }
+#endif /* !QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS && !QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+   /* Tags are not nesting, but arrays past the decoder's limit are */
+   uint8_t uDeep[QCBOR_MAX_ARRAY_NESTING + 2];
+   memset(uDeep, 0xc1, sizeof(uDeep));
+   uDeep[sizeof(uDeep) - 1] = 0x01;
+   QCBORSequence_Init(&Reader, (UsefulBufC){uDeep, sizeof(uDeep)});
+   if(QCBORSequence_Next(&Reader, &Encoded) != QCBOR_SUCCESS) {
+      return 41;
+   }
+   memset(uDeep, 0x81, sizeof(uDeep));
+   uDeep[QCBOR_MAX_ARRAY_NESTING] = 0x01;
+   QCBORSequence_Init(&Reader, (UsefulBufC){uDeep, QCBOR_MAX_ARRAY_NESTING + 1});
+   if(QCBORSequence_Next(&Reader, &Encoded) != QCBOR_SUCCESS) {
+      return 42;
+   }
+   uDeep[QCBOR_MAX_ARRAY_NESTING] = 0x81;
+   uDeep[sizeof(uDeep) - 1] = 0x01;
+   QCBORSequence_Init(&Reader, (UsefulBufC){uDeep, sizeof(uDeep)});
+   if(QCBORSequence_Next(&Reader, &Encoded) != QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP) {
+      return 43;
+   }
+
+   /* Every not-well-formed input fails to split */
+   const uint16_t nArraySize = C_ARRAY_COUNT(paNotWellFormedCBOR, struct someBinaryBytes);
+   for(uint16_t nIterate = 0; nIterate < nArraySize; nIterate++) {
+      const struct someBinaryBytes *pBytes = &paNotWellFormedCBOR[nIterate];
+      QCBORSequence_Init(&Reader, (UsefulBufC){pBytes->p, pBytes->n});
+      do {
+         uErr = QCBORSequence_Next(&Reader, &Encoded);
+      } while(uErr == QCBOR_SUCCESS);
+      if(uErr == QCBOR_ERR_NO_MORE_ITEMS) {
+         return (int32_t)(1000 + nIterate);
+      }
+   }
+
+   return 0;
+}
+
+
+
+#ifndef QCBOR_DISABLE_PARALLEL
+
+#define PARALLEL_TEST_RECORDS 200
+
+/* What the decode callback of ParallelDecodeTest() gives for an item */
+typedef struct {
+   uint64_t uHash;
+   uint32_t uItems;
+} ParallelTestResult;
+
+typedef struct {
+   ParallelTestResult Expected[PARALLEL_TEST_RECORDS + 1];
+   uint8_t            uDelivered[PARALLEL_TEST_RECORDS + 1];
+   uint64_t           uCount;
+   uint64_t           uStopAt;
+   bool               bOrdered;
+   int32_t            nFailure;
+} ParallelTestCtx;
+
+
+static void
+ParallelTestHash(ParallelTestResult *pResult, const QCBORItem *pItem)
+{
+   uint64_t uHash = pResult->uHash;
+
+   uHash = (uHash ^ pItem->uDataType) * 0x100000001b3;
+   uHash = (uHash ^ pItem->uNestingLevel) * 0x100000001b3;
+   uHash = (uHash ^ pItem->uLabelType) * 0x100000001b3;
+   if(pItem->uLabelType == QCBOR_TYPE_INT64) {
+      uHash = (uHash ^ (uint64_t)pItem->label.int64) * 0x100000001b3;
+   }
+   switch(pItem->uDataType) {
+      case QCBOR_TYPE_INT64:
+         uHash = (uHash ^ (uint64_t)pItem->val.int64) * 0x100000001b3;
+         break;
+
+      case QCBOR_TYPE_BYTE_STRING:
+      case QCBOR_TYPE_TEXT_STRING:
+         for(size_t u = 0; u < pItem->val.string.len; u++) {
+            uHash = (uHash ^ ((const uint8_t *)pItem->val.string.ptr)[u]) * 0x100000001b3;
+         }
+         break;
+
+      case QCBOR_TYPE_ARRAY:
+      case QCBOR_TYPE_MAP:
+         uHash = (uHash ^ pItem->val.uCount) * 0x100000001b3;
+         break;
+
+      default:
+         break;
+   }
+   pResult->uHash = uHash;
+   pResult->uItems++;
+}
+
+
+static QCBORError
+ParallelTestDecode(void *pCallbackCtx, QCBORDecodeContext *pDCtx, void *pResult)
+{
+   ParallelTestResult *pTestResult = (ParallelTestResult *)pResult;
+   QCBORItem           Item;
+
+   (void)pCallbackCtx;
+   pTestResult->uHash  = 0xcbf29ce484222325;
+   pTestResult->uItems = 0;
+   while(QCBORDecode_GetNext(pDCtx, &Item) == QCBOR_SUCCESS) {
+      ParallelTestHash(pTestResult, &Item);
+   }
+
+   return QCBORDecode_Finish(pDCtx);
+}
+
+
+static QCBORError
+ParallelTestDeliver(void *pCallbackCtx, uint64_t uIndex, QCBORError uError, const void *pResult)
+{
+   ParallelTestCtx          *pCtx    = (ParallelTestCtx *)pCallbackCtx;
+   const ParallelTestResult *pResult2 = (const ParallelTestResult *)pResult;
+
+   if(uIndex >= PARALLEL_TEST_RECORDS + 1 || pCtx->uDelivered[uIndex]) {
+      pCtx->nFailure = 1;
+   } else if(pCtx->bOrdered && uIndex != pCtx->uCount) {
+      pCtx->nFailure = 2;
+   } else if(uError != QCBOR_SUCCESS ||
+             pResult2->uHash != pCtx->Expected[uIndex].uHash ||
+             pResult2->uItems != pCtx->Expected[uIndex].uItems) {
+      pCtx->nFailure = 3;
+   } else {
+      pCtx->uDelivered[uIndex] = 1;
+   }
+   pCtx->uCount++;
+
+   return pCtx->uCount == pCtx->uStopAt ? QCBOR_ERR_CALLBACK_FAIL : QCBOR_SUCCESS;
+}
+
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+/* {1: (_ "ab", "c"), 2: 258(h'01')}, the last record */
+static const uint8_t spParallelLast[] = {
+   0xa2, 0x01, 0x7f, 0x62, 0x61, 0x62, 0x61, 0x63, 0xff, 0x02, 0xd9, 0x01, 0x02, 0x41, 0x01};
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+static const uint8_t spParallelLast[] = {0xa1, 0x02, 0xd9, 0x01, 0x02, 0x41, 0x01};
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+
+
+int32_t ParallelDecodeTest(void)
+{
+   static uint8_t      spSequenceBuf[16000];
+   static uint8_t      spWorkspace[40000];
+   static ParallelTestCtx TestCtx;
+   QCBOREncodeContext  ECtx;
+   QCBORDecodeContext  DCtx;
+   QCBORItem           Item;
+   UsefulBufC          Sequence;
+   QCBORError          uErr;
+   uint64_t            uRecord;
+
+   /* Records that differ in size, type and nesting */
+   QCBOREncode_Init(&ECtx, UsefulBuf_FROM_BYTE_ARRAY(spSequenceBuf));
+   for(int64_t n = 0; n < PARALLEL_TEST_RECORDS; n++) {
+      QCBOREncode_OpenMap(&ECtx);
+      QCBOREncode_AddInt64ToMapN(&ECtx, 1, n * 1000 - 50000);
+      QCBOREncode_OpenArrayInMapN(&ECtx, 2);
+      for(int64_t m = 0; m < n % 5; m++) {
+         QCBOREncode_AddInt64(&ECtx, m);
+      }
+      QCBOREncode_CloseArray(&ECtx);
+      QCBOREncode_AddBytesToMapN(&ECtx, 3, (UsefulBufC){spSequenceBuf, (size_t)(n % 9)});
+      QCBOREncode_AddSZStringToMapN(&ECtx, 4, n % 2 ? "odd" : "even");
+      QCBOREncode_CloseMap(&ECtx);
+   }
+   QCBOREncode_AddEncoded(&ECtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spParallelLast));
+   if(QCBOREncode_Finish(&ECtx, &Sequence)) {
+      return 1;
+   }
+
+   /* What sequential decoding gives for each record */
+   QCBORDecode_Init(&DCtx, Sequence, QCBOR_DECODE_MODE_NORMAL);
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   UsefulBuf_MAKE_STACK_UB(Pool, 100);
+   QCBORDecode_SetMemPool(&DCtx, Pool, false);
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+   uRecord = 0;
+   while(QCBORDecode_GetNext(&DCtx, &Item) == QCBOR_SUCCESS) {
+      ParallelTestResult *pExpected = &TestCtx.Expected[uRecord];
+      if(Item.uNestingLevel == 0) {
+         pExpected->uHash  = 0xcbf29ce484222325;
+         pExpected->uItems = 0;
+      }
+      ParallelTestHash(pExpected, &Item);
+      if(Item.uNextNestLevel == 0) {
+         uRecord++;
+      }
+   }
+   if(QCBORDecode_Finish(&DCtx) || uRecord != PARALLEL_TEST_RECORDS + 1) {
+      return 2;
+   }
+
+   QCBORParallelConfig Config;
+   Config.uThreads     = 3;
+   Config.uChunkSize   = 200;
+   Config.uChunkItems  = 7;
+   Config.uResultSize  = sizeof(ParallelTestResult);
+   Config.uPoolSize    = 100;
+   Config.nDecodeMode  = QCBOR_DECODE_MODE_NORMAL;
+   Config.pfDecode     = ParallelTestDecode;
+   Config.pfDeliver    = ParallelTestDeliver;
+   Config.pCallbackCtx = &TestCtx;
+   if(QCBORParallel_WorkspaceSize(&Config) > sizeof(spWorkspace)) {
+      return 3;
+   }
+
+   for(int nOrdered = 0; nOrdered < 2; nOrdered++) {
+      Config.bOrdered = nOrdered;
+      for(int nRun = 0; nRun < 10; nRun++) {
+         memset(TestCtx.uDelivered, 0, sizeof(TestCtx.uDelivered));
+         TestCtx.uCount   = 0;
+         TestCtx.uStopAt  = 0;
+         TestCtx.bOrdered = nOrdered;
+         TestCtx.nFailure = 0;
+         uErr = QCBORParallel_Decode(&Config, Sequence, UsefulBuf_FROM_BYTE_ARRAY(spWorkspace));
+         if(uErr != QCBOR_SUCCESS ||
+            TestCtx.nFailure ||
+            TestCtx.uCount != PARALLEL_TEST_RECORDS + 1) {
+            return 10 + nOrdered * 10 + TestCtx.nFailure;
+         }
+      }
+   }
+
+   /* Stopped by the deliver callback */
+   TestCtx.uCount   = 0;
+   TestCtx.uStopAt  = 50;
+   TestCtx.bOrdered = true;
+   memset(TestCtx.uDelivered, 0, sizeof(TestCtx.uDelivered));
+   uErr = QCBORParallel_Decode(&Config, Sequence, UsefulBuf_FROM_BYTE_ARRAY(spWorkspace));
+   if(uErr != QCBOR_ERR_CALLBACK_FAIL || TestCtx.uCount != 50) {
+      return 30;
+   }
+
+   /* Everything before an item that is not well-formed is delivered */
+   TestCtx.uCount  = 0;
+   TestCtx.uStopAt = 0;
+   memset(TestCtx.uDelivered, 0, sizeof(TestCtx.uDelivered));
+   uErr = QCBORParallel_Decode(&Config,
+                               UsefulBuf_Head(Sequence, Sequence.len - 1),
+                               UsefulBuf_FROM_BYTE_ARRAY(spWorkspace));
+   if(uErr != QCBOR_ERR_HIT_END || TestCtx.nFailure || TestCtx.uCount != PARALLEL_TEST_RECORDS) {
+      return 31;
+   }
+
+   uErr = QCBORParallel_Decode(&Config,
+                               Sequence,
+                               (UsefulBuf){spWorkspace, QCBORParallel_WorkspaceSize(&Config) - 1});
+   if(uErr != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return 32;
+   }
+
+   return 0;
+}
+
+#endif /* QCBOR_DISABLE_PARALLEL */
+
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+
+/* Gives out regions from a static buffer and counts them */
+typedef struct {
+   uint8_t  Buf[4096];
+   size_t   uUsed;
+   int      nOutstanding;
+   int      nAllocated;
+} ArenaTestRegions;
+
+static UsefulBuf
+ArenaTestRegionAllocate(void *pRegionCtx, size_t uSize)
+{
+   ArenaTestRegions *pMe = (ArenaTestRegions *)pRegionCtx;
+
+   /* Keep the regions aligned */
+   uSize = (uSize + 7) & ~(size_t)7;
+   if(uSize > sizeof(pMe->Buf) - pMe->uUsed) {
+      return NULLUsefulBuf;
+   }
+   UsefulBuf Region = {pMe->Buf + pMe->uUsed, uSize};
+   pMe->uUsed += uSize;
+   pMe->nOutstanding++;
+   pMe->nAllocated++;
+
+   return Region;
+}
+
+static void
+ArenaTestRegionFree(void *pRegionCtx, UsefulBuf Region)
+{
+   ArenaTestRegions *pMe = (ArenaTestRegions *)pRegionCtx;
+
+   (void)Region;
+   pMe->nOutstanding--;
+}
+
+
+/* [(_ "ab", "c"), "def"] */
+static const uint8_t spArenaSmall[] = {
+   0x82, 0x7f, 0x62, 0x61, 0x62, 0x61, 0x63, 0xff, 0x63, 0x64, 0x65, 0x66};
+
+
+/* Gets the big string made by MakeIndefiniteBigBstr() */
+static QCBORError
+ArenaTestBigBstr(QCBORArena *pArena, UsefulBufC Encoded)
+{
+   QCBORDecodeContext DC;
+   QCBORItem          Item;
+   QCBORError         uErr;
+
+   QCBORDecode_Init(&DC, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetArena(&DC, pArena, false);
+   QCBORDecode_GetNext(&DC, &Item);
+   uErr = QCBORDecode_GetNext(&DC, &Item);
+   if(uErr != QCBOR_SUCCESS) {
+      return uErr;
+   }
+   if(Item.uDataType != QCBOR_TYPE_BYTE_STRING || CheckBigString(Item.val.string)) {
+      return QCBOR_ERR_UNEXPECTED_TYPE;
+   }
+   return QCBORDecode_Finish(&DC);
+}
+
+
+int32_t ArenaTest(void)
+{
+   QCBORDecodeContext      DC;
+   QCBORItem               Item;
+   QCBORArena              Arena;
+   static ArenaTestRegions Regions;
+   uint8_t                 Initial[64];
+   UsefulBuf_MAKE_STACK_UB(BigIndefBStrStorage, 290);
+   const UsefulBufC        BigIndefBStr = MakeIndefiniteBigBstr(BigIndefBStrStorage);
+
+   /* A fixed arena decodes what fits and fails like the MemPool */
+   QCBORArena_Init(&Arena, UsefulBuf_FROM_BYTE_ARRAY(Initial));
+   QCBORDecode_Init(&DC, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArenaSmall), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetArena(&DC, &Arena, false);
+   QCBORDecode_GetNext(&DC, &Item);
+   QCBORDecode_GetNext(&DC, &Item);
+   if(Item.uDataType != QCBOR_TYPE_TEXT_STRING ||
+      UsefulBufCompareToSZ(Item.val.string, "abc") ||
+      Item.val.string.ptr < (void *)Initial ||
+      Item.val.string.ptr >= (void *)(Initial + sizeof(Initial))) {
+      return 1;
+   }
+   QCBORDecode_GetNext(&DC, &Item);
+   if(Item.val.string.ptr != (const uint8_t *)spArenaSmall + 9) {
+      /* Definite-length strings are not allocated */
+      return 2;
+   }
+   if(QCBORDecode_Finish(&DC) != QCBOR_SUCCESS) {
+      return 3;
+   }
+
+   QCBORArena_Reset(&Arena);
+   if(ArenaTestBigBstr(&Arena, BigIndefBStr) != QCBOR_ERR_STRING_ALLOCATE) {
+      return 4;
+   }
+
+   /* A growing arena gets regions for the big string, moving it from
+    * region to region as it grows */
+   QCBORArena_Init(&Arena, UsefulBuf_FROM_BYTE_ARRAY(Initial));
+   QCBORArena_SetGrowth(&Arena, ArenaTestRegionAllocate, ArenaTestRegionFree, &Regions);
+   if(ArenaTestBigBstr(&Arena, BigIndefBStr) != QCBOR_SUCCESS) {
+      return 5;
+   }
+   if(Regions.nAllocated == 0) {
+      return 6;
+   }
+
+   /* After a reset the same regions are used */
+   const int nAllocated = Regions.nAllocated;
+   for(int i = 0; i < 3; i++) {
+      QCBORArena_Reset(&Arena);
+      if(ArenaTestBigBstr(&Arena, BigIndefBStr) != QCBOR_SUCCESS) {
+         return 7;
+      }
+   }
+   if(Regions.nAllocated != nAllocated) {
+      return 8;
+   }
+
+   /* Without a reset the arena grows more */
+   for(int i = 0; i < 6; i++) {
+      if(ArenaTestBigBstr(&Arena, BigIndefBStr) != QCBOR_SUCCESS) {
+         return 9;
+      }
+   }
+   if(Regions.nAllocated == nAllocated) {
+      return 10;
+   }
+
+   /* All strings are allocated with bAllStrings */
+   QCBORArena_Reset(&Arena);
+   QCBORDecode_Init(&DC, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArenaSmall), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetArena(&DC, &Arena, true);
+   QCBORDecode_GetNext(&DC, &Item);
+   QCBORDecode_GetNext(&DC, &Item);
+   QCBORDecode_GetNext(&DC, &Item);
+   if(Item.uDataType != QCBOR_TYPE_TEXT_STRING ||
+      UsefulBufCompareToSZ(Item.val.string, "def") ||
+      Item.val.string.ptr == (const uint8_t *)spArenaSmall + 9) {
+      return 11;
+   }
+   if(QCBORDecode_Finish(&DC) != QCBOR_SUCCESS) {
+      return 12;
+   }
+
+   /* Release gives back all the regions and the arena still works */
+   QCBORArena_Release(&Arena);
+   if(Regions.nOutstanding != 0) {
+      return 13;
+   }
+   QCBORDecode_Init(&DC, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArenaSmall), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetArena(&DC, &Arena, false);
+   QCBORDecode_GetNext(&DC, &Item);
+   QCBORDecode_GetNext(&DC, &Item);
+   if(UsefulBufCompareToSZ(Item.val.string, "abc") ||
+      Item.val.string.ptr < (void *)Initial ||
+      Item.val.string.ptr >= (void *)(Initial + sizeof(Initial))) {
+      return 14;
+   }
+
+   /* An arena with no initial region */
+   Regions.uUsed = 0;
+   QCBORArena_Init(&Arena, NULLUsefulBuf);
+   QCBORArena_SetGrowth(&Arena, ArenaTestRegionAllocate, NULL, &Regions);
+   if(ArenaTestBigBstr(&Arena, BigIndefBStr) != QCBOR_SUCCESS) {
+      return 15;
+   }
+
+   /* Running out of regions */
+   Regions.uUsed = sizeof(Regions.Buf) - 100;
+   QCBORArena_Init(&Arena, NULLUsefulBuf);
+   QCBORArena_SetGrowth(&Arena, ArenaTestRegionAllocate, NULL, &Regions);
+   if(ArenaTestBigBstr(&Arena, BigIndefBStr) != QCBOR_ERR_STRING_ALLOCATE) {
+      return 16;
+   }
+
+   return 0;
+}
+
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+
+
+/* Compares what QCBORDecode_GetNext() and QCBORDecode_GetNextPlain()
+ * give. Allocated strings are compared by content. */
+static int
+CompareGetNextItems(const QCBORItem *pItem1, const QCBORItem *pItem2)
+{
+   if(pItem1->uDataType != pItem2->uDataType ||
+      pItem1->uLabelType != pItem2->uLabelType ||
+      pItem1->uNestingLevel != pItem2->uNestingLevel ||
+      pItem1->uNextNestLevel != pItem2->uNextNestLevel ||
+      pItem1->uDataAlloc != pItem2->uDataAlloc ||
+      pItem1->uLabelAlloc != pItem2->uLabelAlloc ||
+      memcmp(pItem1->uTags, pItem2->uTags, sizeof(pItem1->uTags))) {
+      return 1;
+   }
+
+   if(pItem1->uDataType == QCBOR_TYPE_TEXT_STRING ||
+      pItem1->uDataType == QCBOR_TYPE_BYTE_STRING) {
+      if(UsefulBuf_Compare(pItem1->val.string, pItem2->val.string)) {
+         return 2;
+      }
+   } else if(memcmp(&(pItem1->val), &(pItem2->val), sizeof(pItem1->val))) {
+      return 3;
+   }
+
+   if(pItem1->uLabelType == QCBOR_TYPE_TEXT_STRING ||
+      pItem1->uLabelType == QCBOR_TYPE_BYTE_STRING) {
+      if(UsefulBuf_Compare(pItem1->label.string, pItem2->label.string)) {
+         return 4;
+      }
+   } else if(pItem1->uLabelType != QCBOR_TYPE_NONE &&
+             pItem1->label.int64 != pItem2->label.int64) {
+      return 5;
+   }
+
+   return 0;
+}
+
+
+/* Decodes Input with both and compares item by item */
+static int32_t
+CompareGetNextPlain(UsefulBufC Input, QCBORDecodeMode nMode, bool bCheckLabelOrder)
+{
+   QCBORDecodeContext DCtx1;
+   QCBORDecodeContext DCtx2;
+   QCBORItem          Item1;
+   QCBORItem          Item2;
+   QCBORError         uErr1;
+   QCBORError         uErr2;
+
+   QCBORDecode_Init(&DCtx1, Input, nMode);
+   QCBORDecode_Init(&DCtx2, Input, nMode);
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+   QCBORDecode_SetMapLabelOrderCheck(&DCtx1, bCheckLabelOrder);
+   QCBORDecode_SetMapLabelOrderCheck(&DCtx2, bCheckLabelOrder);
+#else /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+   (void)bCheckLabelOrder;
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   UsefulBuf_MAKE_STACK_UB(Pool1, 400);
+   UsefulBuf_MAKE_STACK_UB(Pool2, 400);
+   QCBORDecode_SetMemPool(&DCtx1, Pool1, false);
+   QCBORDecode_SetMemPool(&DCtx2, Pool2, false);
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+
+   /* Enough for every input and stops the loop if one never ends */
+   for(int nItem = 0; nItem < 200; nItem++) {
+      uErr1 = QCBORDecode_GetNext(&DCtx1, &Item1);
+      uErr2 = QCBORDecode_GetNextPlain(&DCtx2, &Item2);
+      if(uErr1 != uErr2) {
+         return nItem * 100 + 1;
+      }
+      if(uErr1 == QCBOR_SUCCESS && CompareGetNextItems(&Item1, &Item2)) {
+         return nItem * 100 + 2;
+      }
+      if(UsefulInputBuf_Tell(&(DCtx1.InBuf)) != UsefulInputBuf_Tell(&(DCtx2.InBuf))) {
+         return nItem * 100 + 3;
+      }
+      if(uErr1 == QCBOR_ERR_NO_MORE_ITEMS || QCBORDecode_IsUnrecoverableError(uErr1)) {
+         break;
+      }
+   }
+
+   if(QCBORDecode_Finish(&DCtx1) != QCBORDecode_Finish(&DCtx2)) {
+      return 99;
+   }
+
+   return 0;
+}
+
+
+int32_t GetNextPlainTest(void)
+{
+   UsefulBufC aInputs[40];
+   size_t     uNumInputs = 0;
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spExpectedEncodedInts);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(pValidMapEncoded);
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(pValidMapIndefEncoded);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spMapOfEmpty);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnRecoverableMapError2);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnRecoverableMapError3);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnRecoverableMapError4);
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDeepArrays);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTooDeepArrays);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSimpleValues);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTagInput);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spCSRWithTags);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spCSRInput);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spCSRInputIndefLen);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefiniteArray);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefiniteArrayBad2);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefiniteArrayBad3);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefiniteArrayBad5);
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefiniteLenString);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefiniteLenStringLabel);
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayOfEmpty);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spRecoverableMapErrors);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnRecoverableMapError1);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTaggedTypes);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spBadUTF8);
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnsortedMap);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDuplicateMap);
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spUnsortedOuterMap);
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+#if !defined(QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS) && \
+    !defined(QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS)
+   aInputs[uNumInputs++] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTapeInput);
+#endif /* !QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS && !QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+   static const QCBORDecodeMode anModes[] = {
+      QCBOR_DECODE_MODE_NORMAL,
+      QCBOR_DECODE_MODE_DCBOR,
+      QCBOR_DECODE_MODE_MAP_AS_ARRAY
+   };
+   int32_t nResult;
+
+   for(size_t uMode = 0; uMode < C_ARRAY_COUNT(anModes, QCBORDecodeMode); uMode++) {
+      for(size_t uInput = 0; uInput < uNumInputs; uInput++) {
+         for(int nCheck = 0; nCheck <= 1; nCheck++) {
+            nResult = CompareGetNextPlain(aInputs[uInput], anModes[uMode], nCheck);
+            if(nResult) {
+               return (int32_t)(uMode * 1000000 + uInput * 10000) + nResult;
+            }
+         }
+      }
+   }
+
+   /* The not-well-formed inputs give the same errors */
+   for(size_t uInput = 0; uInput < C_ARRAY_COUNT(paNotWellFormedCBOR, struct someBinaryBytes); uInput++) {
+      const UsefulBufC Input = {paNotWellFormedCBOR[uInput].p, paNotWellFormedCBOR[uInput].n};
+      nResult = CompareGetNextPlain(Input, QCBOR_DECODE_MODE_NORMAL, false);
+      if(nResult) {
+         return (int32_t)(9000000 + uInput * 10000) + nResult;
+      }
+   }
+
+   return 0;
+}
+
+
+/*
+ [1, -2, {1: "a", "k": h'0102', -3: 1(1000)}, 24(h'01'), true, null, [],
+  18446744073709551615]
+ */
+static const uint8_t spCompactInput[] = {
+   0x88, 0x01, 0x21, 0xa3, 0x01, 0x61, 0x61, 0x61, 0x6b, 0x42, 0x01, 0x02,
+   0x22, 0xc1, 0x19, 0x03, 0xe8, 0xd8, 0x18, 0x41, 0x01, 0xf5, 0xf6, 0x80,
+   0x1b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+
+struct CompactTestExpected {
+   uint8_t  uDataType;
+   uint8_t  uLabelType;
+   uint8_t  uNestingLevel;
+   uint8_t  uNextNestLevel;
+   uint8_t  uFlags;
+   uint64_t uValue;   /* Integer, count or string offset */
+   uint64_t uLabel;   /* Integer or string offset */
+};
+
+static const struct CompactTestExpected aCompactExpected[] = {
+   {QCBOR_TYPE_ARRAY,       QCBOR_TYPE_NONE,        0, 1, 0, 8, 0},
+   {QCBOR_TYPE_INT64,       QCBOR_TYPE_NONE,        1, 1, 0, 1, 0},
+   {QCBOR_TYPE_INT64,       QCBOR_TYPE_NONE,        1, 1, 0, (uint64_t)-2, 0},
+   {QCBOR_TYPE_MAP,         QCBOR_TYPE_NONE,        1, 2, 0, 3, 0},
+   {QCBOR_TYPE_TEXT_STRING, QCBOR_TYPE_INT64,       2, 2, 0, 6, 1},
+   {QCBOR_TYPE_BYTE_STRING, QCBOR_TYPE_TEXT_STRING, 2, 2, 0, 10, 8},
+   {QCBOR_TYPE_INT64,       QCBOR_TYPE_INT64,       2, 1, QCBOR_COMPACT_TAGGED, 1000, (uint64_t)-3},
+   {QCBOR_TYPE_BYTE_STRING, QCBOR_TYPE_NONE,        1, 1, QCBOR_COMPACT_TAGGED, 20, 0},
+   {QCBOR_TYPE_TRUE,        QCBOR_TYPE_NONE,        1, 1, 0, 0, 0},
+   {QCBOR_TYPE_NULL,        QCBOR_TYPE_NONE,        1, 1, 0, 0, 0},
+   {QCBOR_TYPE_ARRAY,       QCBOR_TYPE_NONE,        1, 1, 0, 0, 0},
+   {QCBOR_TYPE_UINT64,      QCBOR_TYPE_NONE,        1, 0, 0, UINT64_MAX, 0}
+};
+
+
+int32_t CompactItemTest(void)
+{
+   QCBORDecodeContext DCtx;
+   QCBORCompactItem   Compact;
+   QCBORError         uErr;
+   const UsefulBufC   Input = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spCompactInput);
+
+   if(sizeof(QCBORCompactItem) > 24) {
+      return 1;
+   }
+
+   QCBORDecode_Init(&DCtx, Input, QCBOR_DECODE_MODE_NORMAL);
+   for(size_t uIndex = 0; uIndex < C_ARRAY_COUNT(aCompactExpected, struct CompactTestExpected); uIndex++) {
+      const struct CompactTestExpected *pExpected = &aCompactExpected[uIndex];
+      const int32_t nFail = (int32_t)(uIndex + 1) * 10;
+
+      uErr = QCBORDecode_GetNextCompact(&DCtx, &Compact);
+      if(uErr != QCBOR_SUCCESS) {
+         return nFail + 1;
+      }
+      if(Compact.uDataType != pExpected->uDataType ||
+         Compact.uLabelType != pExpected->uLabelType ||
+         Compact.uNestingLevel != pExpected->uNestingLevel ||
+         Compact.uNextNestLevel != pExpected->uNextNestLevel ||
+         Compact.uFlags != pExpected->uFlags) {
+         return nFail + 2;
+      }
+
+      switch(Compact.uDataType) {
+         case QCBOR_TYPE_ARRAY:
+         case QCBOR_TYPE_MAP:
+            if(Compact.val.uCount != pExpected->uValue) {
+               return nFail + 3;
+            }
+            break;
+
+         case QCBOR_TYPE_TEXT_STRING:
+         case QCBOR_TYPE_BYTE_STRING:
+            if(Compact.val.string.uOffset != pExpected->uValue) {
+               return nFail + 4;
+            }
+            if(QCBORCompact_String(&Compact, Input).ptr != (const uint8_t *)Input.ptr + pExpected->uValue) {
+               return nFail + 5;
+            }
+            break;
+
+         case QCBOR_TYPE_INT64:
+         case QCBOR_TYPE_UINT64:
+            if(Compact.val.uint64 != pExpected->uValue) {
+               return nFail + 6;
+            }
+            break;
+
+         default:
+            break;
+      }
+
+      if(Compact.uLabelType == QCBOR_TYPE_TEXT_STRING) {
+         if(Compact.label.string.uOffset != pExpected->uLabel ||
+            UsefulBufCompareToSZ(QCBORCompact_LabelString(&Compact, Input), "k")) {
+            return nFail + 7;
+         }
+      } else if(Compact.uLabelType == QCBOR_TYPE_INT64 &&
+                Compact.label.uint64 != pExpected->uLabel) {
+         return nFail + 8;
+      }
+   }
+
+   /* The tags of the last item are available */
+   if(QCBORDecode_GetNthTagOfLast(&DCtx, 0) != CBOR_TAG_INVALID64) {
+      return 200;
+   }
+
+   if(QCBORDecode_GetNextCompact(&DCtx, &Compact) != QCBOR_ERR_NO_MORE_ITEMS ||
+      Compact.uDataType != QCBOR_TYPE_NONE) {
+      return 201;
+   }
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS) {
+      return 202;
+   }
+
+   /* Tags of a tagged item */
+   QCBORDecode_Init(&DCtx, Input, QCBOR_DECODE_MODE_NORMAL);
+   do {
+      uErr = QCBORDecode_GetNextCompact(&DCtx, &Compact);
+   } while(uErr == QCBOR_SUCCESS && !(Compact.uFlags & QCBOR_COMPACT_TAGGED));
+   if(uErr != QCBOR_SUCCESS ||
+      QCBORDecode_GetNthTagOfLast(&DCtx, 0) != CBOR_TAG_DATE_EPOCH ||
+      QCBORDecode_GetNthTagOfLast(&DCtx, 1) != CBOR_TAG_INVALID64) {
+      return 210;
+   }
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   /* [(_ "a"), 1] An allocated string is an error and decoding goes on */
+   static const uint8_t spIndefString[] = {0x82, 0x7f, 0x61, 0x61, 0xff, 0x01};
+   UsefulBuf_MAKE_STACK_UB(Pool, 100);
+
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefString), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetMemPool(&DCtx, Pool, false);
+   QCBORDecode_GetNextCompact(&DCtx, &Compact);
+   if(QCBORDecode_GetNextCompact(&DCtx, &Compact) != QCBOR_ERR_ALLOCATED_STRING ||
+      Compact.uDataType != QCBOR_TYPE_NONE) {
+      return 220;
+   }
+   if(QCBORDecode_GetNextCompact(&DCtx, &Compact) != QCBOR_SUCCESS ||
+      Compact.uDataType != QCBOR_TYPE_INT64 ||
+      Compact.val.int64 != 1) {
+      return 221;
+   }
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+
+   return 0;
+}
+
+
+/* The arrays for the typed array getters. Each is decoded as the
+ * first item of [array, 99] so that going on after it is checked too.
+ */
+static const uint8_t spArrayInts[] = {
+   0x86, 0x00, 0x20, 0x18, 0x18, 0x1a, 0x00, 0x0f, 0x42, 0x40,
+   0x3b, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+   0x1b, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+static const uint8_t spArrayUIntMax[] = {
+   0x82, 0x00, 0x1b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+static const uint8_t spArrayNegMax[] = {
+   0x82, 0x01, 0x3b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+static const uint8_t spArrayEmpty[] = {0x80};
+static const uint8_t spArrayTagged[] = {0x83, 0x01, 0xd8, 0x64, 0x02, 0x03};
+static const uint8_t spArrayNested[] = {0x82, 0x01, 0x81, 0x02};
+static const uint8_t spArrayNotArray[] = {0x01};
+static const uint8_t spArrayTruncated[] = {0x83, 0x01, 0x02};
+static const uint8_t spArrayNotShortest[] = {0x83, 0x18, 0x01, 0xfa, 0x3f, 0xc0, 0x00, 0x00, 0x01};
+static const uint8_t spArrayFloats[] = {
+   0x85, 0xf9, 0x3c, 0x00, 0xfa, 0x40, 0x49, 0x0f, 0xdb,
+   0xfb, 0x40, 0x09, 0x21, 0xfb, 0x54, 0x44, 0x2d, 0x18,
+   0xf9, 0x7c, 0x00, 0xf9, 0x7e, 0x00};
+static const uint8_t spArrayFloatsEdge[] = {
+   0x86, 0xf9, 0x00, 0x01, 0xf9, 0x80, 0x00, 0xf9, 0x7b, 0xff,
+   0xfb, 0x47, 0xef, 0xff, 0xff, 0xe0, 0x00, 0x00, 0x00,
+   0xfb, 0x47, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0xfb, 0x3f, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+static const uint8_t spArrayFloatAndInt[] = {0x82, 0xf9, 0x3c, 0x00, 0x01};
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+static const uint8_t spArrayIndefinite[] = {0x9f, 0x01, 0x02, 0xf9, 0x3c, 0x00, 0xff};
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+
+#define TYPED_ARRAY_MAX 64
+
+/* What the typed array getters are documented to be the same as. As
+ * there is no way to set the error of a decoder this returns it. */
+static QCBORError
+TypedArrayByItems(QCBORDecodeContext *pDCtx,
+                  uint8_t             uType,
+                  uint64_t           *pValues,
+                  size_t              uMaxValues,
+                  size_t             *puNumValues)
+{
+   size_t uIndex;
+
+   QCBORDecode_EnterArray(pDCtx, NULL);
+   for(uIndex = 0; QCBORDecode_GetError(pDCtx) == QCBOR_SUCCESS; uIndex++) {
+      uint64_t  uValue = 0;
+      QCBORItem Peek;
+      if(uIndex == uMaxValues && QCBORDecode_PeekNext(pDCtx, &Peek) != QCBOR_ERR_NO_MORE_ITEMS) {
+         /* The getters stop without decoding the item that doesn't fit */
+         *puNumValues = uIndex;
+         return QCBOR_ERR_ARRAY_DECODE_TOO_LONG;
+      }
+      switch(uType) {
+         case QCBOR_TYPE_INT64:
+            QCBORDecode_GetInt64(pDCtx, (int64_t *)&uValue);
+            break;
+
+         case QCBOR_TYPE_UINT64:
+            QCBORDecode_GetUInt64(pDCtx, &uValue);
+            break;
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+         case QCBOR_TYPE_DOUBLE:
+            {
+               double d = 0;
+               QCBORDecode_GetDouble(pDCtx, &d);
+               memcpy(&uValue, &d, sizeof(d));
+            }
+            break;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+      }
+      if(QCBORDecode_GetError(pDCtx) == QCBOR_ERR_NO_MORE_ITEMS) {
+         QCBORDecode_GetAndResetError(pDCtx);
+         QCBORDecode_ExitArray(pDCtx);
+         break;
+      }
+      if(QCBORDecode_GetError(pDCtx) != QCBOR_SUCCESS) {
+         break;
+      }
+      pValues[uIndex] = uValue;
+   }
+   *puNumValues = uIndex;
+   return QCBORDecode_GetError(pDCtx);
+}
+
+
+static int32_t
+TypedArrayCompare(UsefulBufC Array, QCBORDecodeMode uMode, uint8_t uType, size_t uMaxValues)
+{
+   QCBORDecodeContext DCtx;
+   uint64_t           auExpected[TYPED_ARRAY_MAX];
+   uint64_t           auValues[TYPED_ARRAY_MAX];
+   size_t             uNumExpected;
+   size_t             uNumValues;
+   int64_t            nNextExpected = 0;
+   int64_t            nNext = 0;
+   QCBORError         uFinishExpected;
+   UsefulBuf_MAKE_STACK_UB(Buffer, 400);
+
+   UsefulOutBuf UOB;
+   UsefulOutBuf_Init(&UOB, Buffer);
+   UsefulOutBuf_AppendByte(&UOB, 0x82);
+   UsefulOutBuf_AppendUsefulBuf(&UOB, Array);
+   UsefulOutBuf_AppendByte(&UOB, 0x18);
+   UsefulOutBuf_AppendByte(&UOB, 0x63);
+   const UsefulBufC Input = UsefulOutBuf_OutUBuf(&UOB);
+
+   QCBORDecode_Init(&DCtx, Input, uMode);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   const QCBORError uExpectedErr = TypedArrayByItems(&DCtx, uType, auExpected, uMaxValues, &uNumExpected);
+   QCBORDecode_GetInt64(&DCtx, &nNextExpected);
+   QCBORDecode_ExitArray(&DCtx);
+   uFinishExpected = QCBORDecode_Finish(&DCtx);
+
+   QCBORDecode_Init(&DCtx, Input, uMode);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   switch(uType) {
+      case QCBOR_TYPE_INT64:
+         QCBORDecode_GetInt64Array(&DCtx, (int64_t *)auValues, uMaxValues, &uNumValues);
+         break;
+
+      case QCBOR_TYPE_UINT64:
+         QCBORDecode_GetUInt64Array(&DCtx, auValues, uMaxValues, &uNumValues);
+         break;
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+      case QCBOR_TYPE_DOUBLE:
+         QCBORDecode_GetDoubleArray(&DCtx, (double *)auValues, uMaxValues, &uNumValues);
+         break;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+   }
+
+   if(QCBORDecode_GetError(&DCtx) != uExpectedErr) {
+      return 1;
+   }
+   if(uNumValues != uNumExpected) {
+      return 2;
+   }
+   if(memcmp(auValues, auExpected, uNumValues * sizeof(uint64_t))) {
+      return 3;
+   }
+
+   /* Going on after the array is the same too, except after the error
+    * TypedArrayByItems() can't set */
+   if(uExpectedErr != QCBOR_ERR_ARRAY_DECODE_TOO_LONG) {
+      QCBORDecode_GetInt64(&DCtx, &nNext);
+      QCBORDecode_ExitArray(&DCtx);
+      if(QCBORDecode_Finish(&DCtx) != uFinishExpected || nNext != nNextExpected) {
+         return 4;
+      }
+   }
+
+   return 0;
+}
+
+
+int32_t TypedArrayTest(void)
+{
+   QCBORDecodeContext DCtx;
+   int64_t            anValues[TYPED_ARRAY_MAX];
+   size_t             uNumValues;
+   size_t             uIndex;
+
+   UsefulBuf_MAKE_STACK_UB(HalvesBuffer, 200);
+   UsefulOutBuf UOB;
+
+   /* 33 halves, a single and 6 more halves to cross a batch of halves */
+   UsefulOutBuf_Init(&UOB, HalvesBuffer);
+   UsefulOutBuf_AppendByte(&UOB, 0x98);
+   UsefulOutBuf_AppendByte(&UOB, 40);
+   for(uIndex = 0; uIndex < 40; uIndex++) {
+      if(uIndex == 33) {
+         UsefulOutBuf_AppendByte(&UOB, 0xfa);
+         UsefulOutBuf_AppendUint32(&UOB, 0x40490fdb);
+      } else {
+         UsefulOutBuf_AppendByte(&UOB, 0xf9);
+         UsefulOutBuf_AppendUint16(&UOB, (uint16_t)(0x3c00 + uIndex * 0x101));
+      }
+   }
+   const UsefulBufC Halves = UsefulOutBuf_OutUBuf(&UOB);
+
+   const UsefulBufC aArrays[] = {
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayInts),
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayUIntMax),
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayNegMax),
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayEmpty),
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayTagged),
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayNested),
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayNotArray),
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayTruncated),
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayNotShortest),
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayFloats),
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayFloatsEdge),
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayFloatAndInt),
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+      UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayIndefinite),
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+      Halves
+   };
+   static const uint8_t auTypes[] = {
+      QCBOR_TYPE_INT64,
+      QCBOR_TYPE_UINT64,
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+      QCBOR_TYPE_DOUBLE
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+   };
+   static const QCBORDecodeMode auModes[] = {
+      QCBOR_DECODE_MODE_NORMAL,
+      QCBOR_DECODE_MODE_DCBOR,
+      QCBOR_DECODE_MODE_MAP_AS_ARRAY
+   };
+
+   /* The same as decoding item by item in every mode */
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(aArrays, UsefulBufC); uIndex++) {
+      for(size_t uType = 0; uType < sizeof(auTypes); uType++) {
+         for(size_t uMode = 0; uMode < C_ARRAY_COUNT(auModes, QCBORDecodeMode); uMode++) {
+            const int32_t nFail = (int32_t)(uIndex * 1000 + uType * 100 + uMode * 10);
+            int32_t nResult = TypedArrayCompare(aArrays[uIndex], auModes[uMode], auTypes[uType], TYPED_ARRAY_MAX);
+            if(nResult) {
+               return nFail + nResult;
+            }
+            nResult = TypedArrayCompare(aArrays[uIndex], auModes[uMode], auTypes[uType], 2);
+            if(nResult) {
+               return nFail + 5 + nResult;
+            }
+         }
+      }
+   }
+
+   /* The values themselves */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayInts), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetInt64Array(&DCtx, anValues, TYPED_ARRAY_MAX, &uNumValues);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS ||
+      uNumValues != 6 ||
+      anValues[0] != 0 || anValues[1] != -1 || anValues[2] != 24 ||
+      anValues[3] != 1000000 || anValues[4] != INT64_MIN || anValues[5] != INT64_MAX) {
+      return 50000;
+   }
+
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayInts), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetInt64Array(&DCtx, anValues, 3, &uNumValues);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_ARRAY_DECODE_TOO_LONG || uNumValues != 3) {
+      return 50001;
+   }
+
+   /* {1: [1, 2], "a": [3]} */
+   static const uint8_t spInMap[] = {0xa2, 0x01, 0x82, 0x01, 0x02, 0x61, 0x61, 0x81, 0x03};
+   uint64_t auValues[2];
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spInMap), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetUInt64ArrayInMapSZ(&DCtx, "a", auValues, 2, &uNumValues);
+   if(uNumValues != 1 || auValues[0] != 3) {
+      return 50002;
+   }
+   QCBORDecode_GetInt64ArrayInMapN(&DCtx, 1, anValues, 2, &uNumValues);
+   if(uNumValues != 2 || anValues[0] != 1 || anValues[1] != 2) {
+      return 50003;
+   }
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS) {
+      return 50004;
+   }
+
+#if !defined(USEFULBUF_DISABLE_ALL_FLOAT) && !defined(QCBOR_DISABLE_FLOAT_HW_USE)
+   float afValues[TYPED_ARRAY_MAX];
+
+#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
+   double adValues[TYPED_ARRAY_MAX];
+
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayFloats), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetDoubleArray(&DCtx, adValues, TYPED_ARRAY_MAX, &uNumValues);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS ||
+      uNumValues != 5 ||
+      adValues[0] != 1.0 || adValues[1] != (double)3.14159274f ||
+      adValues[2] != 3.141592653589793 || adValues[3] != INFINITY || !isnan(adValues[4])) {
+      return 50010;
+   }
+
+   /* Each half the same as one at a time, across the batches */
+   QCBORDecode_Init(&DCtx, Halves, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetDoubleArray(&DCtx, adValues, TYPED_ARRAY_MAX, &uNumValues);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS || uNumValues != 40) {
+      return 50011;
+   }
+   QCBORDecode_Init(&DCtx, Halves, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetFloatArray(&DCtx, afValues, TYPED_ARRAY_MAX, &uNumValues);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS || uNumValues != 40) {
+      return 50012;
+   }
+   QCBORDecode_Init(&DCtx, Halves, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   for(uIndex = 0; uIndex < 40; uIndex++) {
+      double d;
+      QCBORDecode_GetDouble(&DCtx, &d);
+      if(d != adValues[uIndex] || (float)d != afValues[uIndex]) {
+         return 50013 + (int32_t)uIndex * 10;
+      }
+   }
+
+   /* Subnormal, -0, largest half, FLT_MAX, then a double too big for a float */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spArrayFloatsEdge), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetFloatArray(&DCtx, afValues, TYPED_ARRAY_MAX, &uNumValues);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_FLOAT_EXCEPTION ||
+      uNumValues != 4 ||
+      afValues[0] != 0x1p-24f || afValues[1] != 0.0f || !signbit(afValues[1]) ||
+      afValues[2] != 65504.0f || afValues[3] != 0x1.fffffep127f) {
+      return 50500;
+   }
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+
+   /* A double that loses precision as a float */
+   static const uint8_t spInexact[] = {0x81, 0xfb, 0x3f, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spInexact), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetFloatArray(&DCtx, afValues, TYPED_ARRAY_MAX, &uNumValues);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_FLOAT_EXCEPTION || uNumValues != 0) {
+      return 50501;
+   }
+
+   /* Singles and doubles that fit */
+   static const uint8_t spFloats[] = {0x82, 0xfa, 0x40, 0x49, 0x0f, 0xdb, 0xfb, 0x3f, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spFloats), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetFloatArrayInMapN(&DCtx, 1, afValues, TYPED_ARRAY_MAX, &uNumValues);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_MAP_NOT_ENTERED) {
+      return 50502;
+   }
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spFloats), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetFloatArray(&DCtx, afValues, TYPED_ARRAY_MAX, &uNumValues);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS ||
+      uNumValues != 2 || afValues[0] != 3.14159274f || afValues[1] != 1.5f) {
+      return 50503;
+   }
+#endif /* !USEFULBUF_DISABLE_ALL_FLOAT && !QCBOR_DISABLE_FLOAT_HW_USE */
+
+   return 0;
+}
@@ -314,4 +314,99 @@ Test decoding of booleans
 int32_t BoolTest(void);
 
 
+/*
+ Test UTF-8 validation of text strings
+ */
+int32_t UTF8ValidationTest(void);
+
+
+/*
+ Test the deterministic encoding checks of QCBOR_DECODE_MODE_DCBOR
+ */
+int32_t DCBORModeTest(void);
+
+
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+/*
+ Test the map label order and duplicate check
+ */
+int32_t MapLabelOrderTest(void);
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+
+
+#ifdef QCBOR_ENABLE_MAP_INDEX
+/*
+ Test lookups in maps with a label index
+ */
+int32_t MapIndexTest(void);
+#endif /* QCBOR_ENABLE_MAP_INDEX */
+
+
+/*
+ Test getting several items from a map in label order
+ */
+int32_t SortedMapSearchTest(void);
+
+
+/*
+ Test skipping nested items without fully decoding them
+ */
+int32_t SkipScanTest(void);
+
+
+/*
+ Test building and navigating a tape
+ */
+int32_t TapeTest(void);
+
+
+#ifdef QCBOR_ENABLE_INCREMENTAL_INPUT
+/*
+ Test decoding input added in chunks
+ */
+int32_t IncrementalTest(void);
+#endif /* QCBOR_ENABLE_INCREMENTAL_INPUT */
+
+
+/*
+ Test splitting a CBOR sequence into its items
+ */
+int32_t SequenceReaderTest(void);
+
+
+#ifndef QCBOR_DISABLE_PARALLEL
+/*
+ Test decoding a CBOR sequence on several threads
+ */
+int32_t ParallelDecodeTest(void);
+#endif /* QCBOR_DISABLE_PARALLEL */
+
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+/*
+ Test the growable arena string allocator
+ */
+int32_t ArenaTest(void);
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+
+
+/*
+ Test QCBORDecode_GetNextPlain() gives the same as QCBORDecode_GetNext()
+ */
+int32_t GetNextPlainTest(void);
+
+
+/*
+ Test QCBORDecode_GetNextCompact()
+ */
+int32_t CompactItemTest(void);
+
+
+
+/*
+ Test the typed array getters like QCBORDecode_GetInt64Array()
+ */
+int32_t TypedArrayTest(void);
+
+
 #endif /* defined(__QCBOR__qcbort_decode_tests__) */
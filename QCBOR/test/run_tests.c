@@ -60,7 +60,8 @@ static test_entry2 s_tests2[] = {
     TEST_ENTRY(UOBTest_BoundaryConditionsTest),
     TEST_ENTRY(UBMacroConversionsTest),
     TEST_ENTRY(UBUtilTests),
-    TEST_ENTRY(UIBTest_IntegerFormat)
+    TEST_ENTRY(UIBTest_IntegerFormat),
+    TEST_ENTRY(UBUTF8Test)
 };
 
 
@@ -116,6 +117,7 @@ static test_entry s_tests[] = {
     TEST_ENTRY(HalfPrecisionDecodeBasicTests),
     TEST_ENTRY(DoubleAsSmallestTest),
     TEST_ENTRY(HalfPrecisionAgainstRFCCodeTest),
+    TEST_ENTRY(FloatArrayTest),
 #endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
 #ifndef USEFULBUF_DISABLE_ALL_FLOAT
     TEST_ENTRY(GeneralFloatEncodeTests),
@@ -142,7 +144,31 @@ static test_entry s_tests[] = {
     TEST_ENTRY(ExponentAndMantissaEncodeTests),
 #endif /* QCBOR_DISABLE_EXP_AND_MANTISSA */
     TEST_ENTRY(ParseEmptyMapInMapTest),
-    TEST_ENTRY(BoolTest)
+    TEST_ENTRY(BoolTest),
+    TEST_ENTRY(UTF8ValidationTest),
+    TEST_ENTRY(DCBORModeTest),
+#ifdef QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK
+    TEST_ENTRY(MapLabelOrderTest),
+#endif /* QCBOR_ENABLE_MAP_LABEL_ORDER_CHECK */
+#ifdef QCBOR_ENABLE_MAP_INDEX
+    TEST_ENTRY(MapIndexTest),
+#endif /* QCBOR_ENABLE_MAP_INDEX */
+    TEST_ENTRY(SortedMapSearchTest),
+    TEST_ENTRY(SkipScanTest),
+    TEST_ENTRY(TapeTest),
+#ifdef QCBOR_ENABLE_INCREMENTAL_INPUT
+    TEST_ENTRY(IncrementalTest),
+#endif /* QCBOR_ENABLE_INCREMENTAL_INPUT */
+    TEST_ENTRY(SequenceReaderTest),
+#ifndef QCBOR_DISABLE_PARALLEL
+    TEST_ENTRY(ParallelDecodeTest),
+#endif /* QCBOR_DISABLE_PARALLEL */
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+    TEST_ENTRY(ArenaTest),
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+    TEST_ENTRY(GetNextPlainTest),
+    TEST_ENTRY(CompactItemTest),
+    TEST_ENTRY(TypedArrayTest),
 };
 
 
@@ -0,0 +1,174 @@
+// arena-benchmark.c
+
+// Decodes string-heavy messages with the QCBOR MemPool and with the
+// growable arena, both as the allocator for indefinite-length strings
+// only and for all strings.  The MemPool is sized for the largest
+// message; the arena starts small, grows from malloc() and is reset
+// before each message.
+
+#include "qcbor/qcbor_encode.h"
+#include "qcbor/qcbor_decode.h"
+#include "qcbor/qcbor_arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MESSAGES 64
+#define STRINGS_PER_MESSAGE 200
+#define DECODE_ROUNDS 200
+
+static int failures = 0;
+
+static double wallClock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// Counts what the arena gets from malloc().
+typedef struct {
+    size_t regions;
+    size_t bytes;
+} RegionStats;
+
+static UsefulBuf regionAllocate(void* context, size_t size) {
+    RegionStats* stats = (RegionStats*)context;
+    void* region = malloc(size);
+    if (region) {
+        stats->regions++;
+        stats->bytes += size;
+    }
+    return (UsefulBuf){ region, region ? size : 0 };
+}
+
+static void regionFree(void* context, UsefulBuf region) {
+    RegionStats* stats = (RegionStats*)context;
+    stats->bytes -= region.len;
+    free(region.ptr);
+}
+
+// A map of STRINGS_PER_MESSAGE text strings, each sent as an indefinite-length
+// string of chunks.  Message n has strings of 1 to 8 + n / 2 chunks.
+static UsefulBufC makeMessage(UsefulBuf storage, int n) {
+    UsefulOutBuf out;
+    UsefulOutBuf_Init(&out, storage);
+    UsefulOutBuf_AppendByte(&out, 0xb9);
+    UsefulOutBuf_AppendUint16(&out, STRINGS_PER_MESSAGE);
+    for (int i = 0; i < STRINGS_PER_MESSAGE; i++) {
+        UsefulOutBuf_AppendByte(&out, 0x19);
+        UsefulOutBuf_AppendUint16(&out, (uint16_t)i);
+        UsefulOutBuf_AppendByte(&out, 0x7f);
+        int chunks = 1 + (i * 7 + n) % (8 + n / 2);
+        for (int j = 0; j < chunks; j++) {
+            UsefulOutBuf_AppendByte(&out, 0x68);
+            UsefulOutBuf_AppendData(&out, "abcdefgh", 8);
+        }
+        UsefulOutBuf_AppendByte(&out, 0xff);
+    }
+    return UsefulOutBuf_OutUBuf(&out);
+}
+
+// Decodes a message and returns the total length of its strings or 0 on error.
+static size_t decodeMessage(QCBORDecodeContext* decoder) {
+    QCBORItem item;
+    size_t total = 0;
+    while (QCBORDecode_GetNext(decoder, &item) == QCBOR_SUCCESS) {
+        if (item.uDataType == QCBOR_TYPE_TEXT_STRING) {
+            total += item.val.string.len;
+        }
+    }
+    return QCBORDecode_Finish(decoder) == QCBOR_SUCCESS ? total : 0;
+}
+
+static void report(const char* name, size_t bytes, double time, size_t memory) {
+    printf("%-28s %8.1f MB/s %9zu bytes of string memory\n", name, (double)bytes / time / 1e6, memory);
+}
+
+int main(void) {
+    static uint8_t storage[MESSAGES][60000];
+    UsefulBufC messages[MESSAGES];
+    size_t expected[MESSAGES];
+    size_t inputSize = 0;
+    size_t largest = 0;
+    for (int n = 0; n < MESSAGES; n++) {
+        messages[n] = makeMessage(UsefulBuf_FROM_BYTE_ARRAY(storage[n]), n);
+        if (UsefulBuf_IsNULLC(messages[n])) {
+            printf("\n*** message %d does not fit ***\n", n);
+            return 1;
+        }
+        inputSize += messages[n].len;
+        if (messages[n].len > largest) {
+            largest = messages[n].len;
+        }
+    }
+    printf("%d messages, %zu bytes\n", MESSAGES, inputSize);
+
+    for (int allStrings = 0; allStrings <= 1; allStrings++) {
+        printf("%s\n", allStrings ? "All strings allocated" : "Indefinite-length strings allocated");
+
+        // The strings of a message take less space than its encoding, plus
+        // the MemPool overhead.
+        size_t poolSize = largest + QCBOR_DECODE_MIN_MEM_POOL_SIZE;
+        UsefulBuf pool = { malloc(poolSize), poolSize };
+        QCBORDecodeContext decoder;
+        double start = wallClock();
+        for (int round = 0; round < DECODE_ROUNDS; round++) {
+            for (int n = 0; n < MESSAGES; n++) {
+                QCBORDecode_Init(&decoder, messages[n], QCBOR_DECODE_MODE_NORMAL);
+                QCBORDecode_SetMemPool(&decoder, pool, allStrings);
+                size_t total = decodeMessage(&decoder);
+                if (round == 0) {
+                    expected[n] = total;
+                } else if (total != expected[n]) {
+                    failures++;
+                }
+            }
+        }
+        report("  MemPool, worst-case size", inputSize * DECODE_ROUNDS, wallClock() - start, poolSize);
+
+        RegionStats stats = { 0, 0 };
+        uint8_t initial[256];
+        QCBORArena arena;
+        QCBORArena_Init(&arena, UsefulBuf_FROM_BYTE_ARRAY(initial));
+        QCBORArena_SetGrowth(&arena, regionAllocate, regionFree, &stats);
+        start = wallClock();
+        for (int round = 0; round < DECODE_ROUNDS; round++) {
+            for (int n = 0; n < MESSAGES; n++) {
+                QCBORArena_Reset(&arena);
+                QCBORDecode_Init(&decoder, messages[n], QCBOR_DECODE_MODE_NORMAL);
+                QCBORDecode_SetArena(&decoder, &arena, allStrings);
+                if (decodeMessage(&decoder) != expected[n]) {
+                    failures++;
+                }
+            }
+        }
+        report("  Arena, reset per message", inputSize * DECODE_ROUNDS, wallClock() - start,
+               sizeof(initial) + stats.bytes);
+        printf("  Arena grew %zu times\n", stats.regions);
+        QCBORArena_Release(&arena);
+        if (stats.bytes != 0) {
+            printf("\n*** arena did not release its regions ***\n");
+            failures++;
+        }
+
+        // A MemPool sized for the smallest message fails on larger ones.
+        pool.len = messages[0].len + QCBOR_DECODE_MIN_MEM_POOL_SIZE;
+        int poolFailures = 0;
+        for (int n = 0; n < MESSAGES; n++) {
+            QCBORDecode_Init(&decoder, messages[n], QCBOR_DECODE_MODE_NORMAL);
+            QCBORDecode_SetMemPool(&decoder, pool, allStrings);
+            if (decodeMessage(&decoder) != expected[n]) {
+                poolFailures++;
+            }
+        }
+        printf("  MemPool of %zu bytes failed on %d of %d messages\n", pool.len, poolFailures, MESSAGES);
+        free(pool.ptr);
+    }
+
+    if (failures) {
+        printf("\n*** %d decodes did not match ***\n", failures);
+    }
+    printf(failures ? "Failed!\n" : "Done!\n");
+    return failures != 0;
+}
@@ -0,0 +1,205 @@
+// bignum-conversion-benchmark.c
+
+// Measures QCBORDecode_GetDoubleConvertAll() and
+// QCBORDecode_GetInt64ConvertAll() on arrays of decimal fractions (tag 4)
+// like those of a price feed, with integer and big number mantissas, and on
+// positive and negative big numbers (tags 2 and 3). Decoding the same items
+// with QCBORDecode_VGetNext() is the floor the conversions are measured
+// against. Every converted value is checked against one computed from the
+// numbers that went into the encoding.
+
+#include "qcbor/qcbor_encode.h"
+#include "qcbor/qcbor_spiffy_decode.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define SAMPLES 10000
+#define DECODE_ROUNDS 500
+
+enum { PRICES, BIGNUM_PRICES, POSITIVE_BIGNUMS, NEGATIVE_BIGNUMS, LARGE_BIGNUMS, SETS };
+
+static const char* setNames[SETS] = {
+    "Decimal fractions",
+    "Decimal fractions, bignum mantissa",
+    "Positive bignums",
+    "Negative bignums",
+    "Bignums of 9 to 16 bytes",
+};
+
+static int failures = 0;
+
+static double wallClock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static uint64_t splitMix(uint64_t index) {
+    uint64_t z = index * 0x9e3779b97f4a7c15ull + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6 };
+
+// Big-endian bytes of the value, without leading zeros, and then some zero bytes
+static UsefulBufC bignumBytes(uint8_t* bytes, uint64_t value, int zeroBytes) {
+    size_t len = 0;
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        if (len || value >> shift & 0xff || shift == 0) {
+            bytes[len++] = (uint8_t)(value >> shift);
+        }
+    }
+    memset(bytes + len, 0, (size_t)zeroBytes);
+    return (UsefulBufC){ bytes, len + (size_t)zeroBytes };
+}
+
+// Adds one item of the set and returns the values it should convert to.
+static void addItem(QCBOREncodeContext* encoder, int set, uint64_t index, int64_t* expectedInt,
+                    double* expectedDouble) {
+    uint64_t z = splitMix(index);
+    uint8_t bytes[16];
+    switch (set) {
+        case PRICES: {
+            // At least 1.000000 so none of them truncate to 0
+            int64_t mantissa = 1000000 + (int64_t)(z >> 40);
+            int exponent = (int)(z % 7);
+            if (z & 0x80) {
+                mantissa = -mantissa;
+            }
+            QCBOREncode_AddDecimalFraction(encoder, mantissa, -exponent);
+            *expectedInt = mantissa / (int64_t)powersOf10[exponent];
+            *expectedDouble = (double)mantissa / powersOf10[exponent];
+            break;
+        }
+        case BIGNUM_PRICES: {
+            uint64_t n = 1000000 + (z >> 24);
+            int exponent = (int)(z % 7);
+            bool negative = z & 0x80;
+            QCBOREncode_AddDecimalFractionBigNum(encoder, bignumBytes(bytes, n, 0), negative, -exponent);
+            int64_t mantissa = negative ? -(int64_t)n - 1 : (int64_t)n;
+            *expectedInt = mantissa / (int64_t)powersOf10[exponent];
+            *expectedDouble = (double)mantissa / powersOf10[exponent];
+            break;
+        }
+        case POSITIVE_BIGNUMS: {
+            uint64_t n = z >> (1 + z % 56);
+            QCBOREncode_AddPositiveBignum(encoder, bignumBytes(bytes, n, 0));
+            *expectedInt = (int64_t)n;
+            *expectedDouble = (double)n;
+            break;
+        }
+        case NEGATIVE_BIGNUMS: {
+            uint64_t n = z >> (1 + z % 56);
+            QCBOREncode_AddNegativeBignum(encoder, bignumBytes(bytes, n, 0));
+            *expectedInt = -(int64_t)n - 1;
+            *expectedDouble = -(double)(n + 1);
+            break;
+        }
+        default: {
+            // With the top bit set all 64 bits are significant, so the
+            // conversion of the 64-bit value is the correctly rounded one.
+            uint64_t n = z | 1ull << 63;
+            int zeroBytes = 1 + (int)(z % 8);
+            QCBOREncode_AddPositiveBignum(encoder, bignumBytes(bytes, n, zeroBytes));
+            *expectedInt = 0;
+            *expectedDouble = ldexp((double)n, zeroBytes * 8);
+            break;
+        }
+    }
+}
+
+static void check(const char* what, int set, size_t index, int ok) {
+    if (!ok && failures++ < 10) {
+        printf("\n*** %s of %s %zu is wrong ***\n", what, setNames[set], index);
+    }
+}
+
+static void report(const char* name, double time, double floorTime) {
+    printf("  %-20s %6.1f M values/s  %5.1f ns per conversion\n", name,
+           (double)SAMPLES * DECODE_ROUNDS / time / 1e6,
+           (time - floorTime) * 1e9 / ((double)SAMPLES * DECODE_ROUNDS));
+}
+
+int main(void) {
+    static uint8_t buffers[SETS][SAMPLES * 24];
+    static int64_t expectedInts[SAMPLES];
+    static double expectedDoubles[SAMPLES];
+    static int64_t ints[SAMPLES];
+    static double doubles[SAMPLES];
+
+    for (int set = 0; set < SETS; set++) {
+        QCBOREncodeContext encoder;
+        QCBOREncode_Init(&encoder, UsefulBuf_FROM_BYTE_ARRAY(buffers[set]));
+        QCBOREncode_OpenArray(&encoder);
+        for (size_t i = 0; i < SAMPLES; i++) {
+            addItem(&encoder, set, set * SAMPLES + i, &expectedInts[i], &expectedDoubles[i]);
+        }
+        QCBOREncode_CloseArray(&encoder);
+        UsefulBufC encoded;
+        if (QCBOREncode_Finish(&encoder, &encoded) != QCBOR_SUCCESS) {
+            printf("\n*** encoding failed ***\n");
+            return 1;
+        }
+        printf("%s, %d in %zu bytes\n", setNames[set], SAMPLES, encoded.len);
+
+        double floorTime = 0, intTime = 0, doubleTime = 0;
+        for (int round = 0; round < DECODE_ROUNDS; round++) {
+            QCBORDecodeContext decoder;
+            QCBORItem item;
+            double start = wallClock();
+            QCBORDecode_Init(&decoder, encoded, QCBOR_DECODE_MODE_NORMAL);
+            QCBORDecode_EnterArray(&decoder, NULL);
+            for (size_t i = 0; i < SAMPLES; i++) {
+                QCBORDecode_VGetNext(&decoder, &item);
+            }
+            QCBORDecode_ExitArray(&decoder);
+            floorTime += wallClock() - start;
+            check("decoding", set, 0, QCBORDecode_Finish(&decoder) == QCBOR_SUCCESS);
+
+            // All but the large bignums fit in an int64_t
+            if (set != LARGE_BIGNUMS) {
+                start = wallClock();
+                QCBORDecode_Init(&decoder, encoded, QCBOR_DECODE_MODE_NORMAL);
+                QCBORDecode_EnterArray(&decoder, NULL);
+                for (size_t i = 0; i < SAMPLES; i++) {
+                    QCBORDecode_GetInt64ConvertAll(&decoder, QCBOR_CONVERT_TYPE_BIG_NUM |
+                                                   QCBOR_CONVERT_TYPE_DECIMAL_FRACTION, &ints[i]);
+                }
+                QCBORDecode_ExitArray(&decoder);
+                intTime += wallClock() - start;
+                check("GetInt64ConvertAll", set, 0, QCBORDecode_Finish(&decoder) == QCBOR_SUCCESS);
+            }
+
+            start = wallClock();
+            QCBORDecode_Init(&decoder, encoded, QCBOR_DECODE_MODE_NORMAL);
+            QCBORDecode_EnterArray(&decoder, NULL);
+            for (size_t i = 0; i < SAMPLES; i++) {
+                QCBORDecode_GetDoubleConvertAll(&decoder, QCBOR_CONVERT_TYPE_BIG_NUM |
+                                                QCBOR_CONVERT_TYPE_DECIMAL_FRACTION, &doubles[i]);
+            }
+            QCBORDecode_ExitArray(&decoder);
+            doubleTime += wallClock() - start;
+            check("GetDoubleConvertAll", set, 0, QCBORDecode_Finish(&decoder) == QCBOR_SUCCESS);
+        }
+        for (size_t i = 0; i < SAMPLES; i++) {
+            if (set != LARGE_BIGNUMS) {
+                check("int64_t", set, i, ints[i] == expectedInts[i]);
+            }
+            check("double", set, i, doubles[i] == expectedDoubles[i]);
+        }
+
+        report("VGetNext", floorTime, floorTime);
+        if (set != LARGE_BIGNUMS) {
+            report("GetInt64ConvertAll", intTime, floorTime);
+        }
+        report("GetDoubleConvertAll", doubleTime, floorTime);
+    }
+
+    printf(failures ? "Failed!\n" : "Done!\n");
+    return failures != 0;
+}
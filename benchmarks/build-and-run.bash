@@ -0,0 +1,41 @@
+#!/bin/bash
+
+# Rudimentary Linux bash script for building and running the D-CBOR benchmarks.
+#
+# Run from any directory: $ bash path-to-this-script
+#
+pushd $(dirname "${BASH_SOURCE[0]}")
+gcc -o fixup-benchmark -O2 -DPLATFORM_SUPPORTS_FLOAT_CAST -DINDEFINITE_LENGTH_EMULATION -I ../lib fixup-benchmark.c ../lib/*.c
+./fixup-benchmark
+# The UTF-8 validator is vectorized when SSSE3 is enabled.
+SIMD=$(grep -q ssse3 /proc/cpuinfo && echo -mssse3)
+gcc -o utf8-benchmark -O2 $SIMD -I ../lib utf8-benchmark.c ../lib/*.c
+./utf8-benchmark
+# Both builds of the IEEE-754 encoder are linked side by side under different names.
+for BUILD in FloatCast IntegerOnly; do
+  FLAGS=$([ $BUILD = FloatCast ] && echo -DPLATFORM_SUPPORTS_FLOAT_CAST)
+  gcc -c -O2 $FLAGS -DaddDouble=addDouble$BUILD -DaddDoubleArray=addDoubleArray$BUILD \
+      -DaddFloatArray=addFloatArray$BUILD -I ../lib -o ieee754-$BUILD.o ../lib/d-cbor-ieee754.c
+done
+gcc -o ieee754-harness -O2 -I ../lib -I ../QCBOR/inc -I ../QCBOR/src ieee754-harness.c ieee754-*.o \
+    $(ls ../lib/*.c | grep -v ieee754) ../QCBOR/src/ieee754.c -lpthread
+rm ieee754-*.o
+# The harness supports at most 64 threads.
+./ieee754-harness $(( $(nproc) > 64 ? 64 : $(nproc) ))
+# Reads a 10 GB CBOR sequence file, which needs 64-bit sequence offsets.
+gcc -o sequence-benchmark -O2 -DQCBOR_SEQUENCE_64BIT_OFFSETS -I ../QCBOR/inc sequence-benchmark.c \
+    ../QCBOR/src/*.c -lm -lpthread
+./sequence-benchmark
+gcc -o arena-benchmark -O2 -I ../QCBOR/inc arena-benchmark.c ../QCBOR/src/*.c -lm -lpthread
+./arena-benchmark
+gcc -o getnext-benchmark -O2 -I ../QCBOR/inc getnext-benchmark.c ../QCBOR/src/*.c -lm -lpthread
+./getnext-benchmark
+gcc -o typed-array-benchmark -O2 -I ../QCBOR/inc typed-array-benchmark.c ../QCBOR/src/*.c -lm -lpthread
+./typed-array-benchmark
+# The SIMD kernels are compiled with target attributes and picked at run time, so no -m flags.
+gcc -o float-kernel-benchmark -O2 -I ../QCBOR/inc -I ../QCBOR/src float-kernel-benchmark.c ../QCBOR/src/*.c \
+    -lm -lpthread
+./float-kernel-benchmark
+gcc -o bignum-conversion-benchmark -O2 -I ../QCBOR/inc bignum-conversion-benchmark.c ../QCBOR/src/*.c -lm -lpthread
+./bignum-conversion-benchmark
+popd
@@ -0,0 +1,177 @@
+// fixup-benchmark.c
+
+// Compares insertArray() fixups with batched fixups and a two-pass approach
+// using dry-run mode.
+
+#include <d-cbor.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define GROUPS_PER_LEVEL 8
+#define MAX_ARRAYS (1 + GROUPS_PER_LEVEL + GROUPS_PER_LEVEL * GROUPS_PER_LEVEL)
+
+// Simulated sensor readings where only "interesting" values are reported.
+// Consequently the number of array elements is not known in advance.
+static int64_t reading(int index) {
+    return ((int64_t)index * 7919) % 100003;
+}
+
+static int reported(int index) {
+    return reading(index) % 3 != 0;
+}
+
+// [[[#,#,...],...],...] using fixups.  Each level is fixed up after the fact.
+static void encodeWithFixups(CBOR_BUFFER* cborBuffer, int elements) {
+    int index = 0;
+    size_t outerPos = cborBuffer->pos;
+    for (int i = 0; i < GROUPS_PER_LEVEL; i++) {
+        size_t middlePos = cborBuffer->pos;
+        for (int j = 0; j < GROUPS_PER_LEVEL; j++) {
+            size_t innerPos = cborBuffer->pos;
+            int count = 0;
+            int last = (i * GROUPS_PER_LEVEL + j + 1) * elements / (GROUPS_PER_LEVEL * GROUPS_PER_LEVEL);
+            for (; index < last; index++) {
+                if (reported(index)) {
+                    addInt(cborBuffer, reading(index));
+                    count++;
+                }
+            }
+            insertArray(cborBuffer, innerPos, count);
+        }
+        insertArray(cborBuffer, middlePos, GROUPS_PER_LEVEL);
+    }
+    insertArray(cborBuffer, outerPos, GROUPS_PER_LEVEL);
+}
+
+// Same structure, but all heads are inserted in a single compaction pass.
+static void encodeWithBatchedFixups(CBOR_BUFFER* cborBuffer, int elements) {
+    CBOR_FIXUP fixups[MAX_ARRAYS];
+    CBOR_FIXUP_LIST fixupList;
+    initFixupList(cborBuffer, &fixupList, fixups, MAX_ARRAYS);
+    int index = 0;
+    int outer = addArrayPlaceholder(cborBuffer, &fixupList);
+    for (int i = 0; i < GROUPS_PER_LEVEL; i++) {
+        int middle = addArrayPlaceholder(cborBuffer, &fixupList);
+        for (int j = 0; j < GROUPS_PER_LEVEL; j++) {
+            int inner = addArrayPlaceholder(cborBuffer, &fixupList);
+            int count = 0;
+            int last = (i * GROUPS_PER_LEVEL + j + 1) * elements / (GROUPS_PER_LEVEL * GROUPS_PER_LEVEL);
+            for (; index < last; index++) {
+                if (reported(index)) {
+                    addInt(cborBuffer, reading(index));
+                    count++;
+                }
+            }
+            setPlaceholder(&fixupList, inner, count);
+        }
+        setPlaceholder(&fixupList, middle, GROUPS_PER_LEVEL);
+    }
+    setPlaceholder(&fixupList, outer, GROUPS_PER_LEVEL);
+    resolveFixups(cborBuffer, &fixupList);
+}
+
+// Same structure, but element counts are collected in a dry-run first pass.
+static void producer(CBOR_BUFFER* cborBuffer, int elements, int* counts) {
+    int index = 0;
+    addArray(cborBuffer, GROUPS_PER_LEVEL);
+    for (int i = 0; i < GROUPS_PER_LEVEL; i++) {
+        addArray(cborBuffer, GROUPS_PER_LEVEL);
+        for (int j = 0; j < GROUPS_PER_LEVEL; j++) {
+            int* count = &counts[i * GROUPS_PER_LEVEL + j];
+            if (cborBuffer->data) {
+                addArray(cborBuffer, *count);
+            }
+            int last = (i * GROUPS_PER_LEVEL + j + 1) * elements / (GROUPS_PER_LEVEL * GROUPS_PER_LEVEL);
+            for (; index < last; index++) {
+                if (reported(index)) {
+                    addInt(cborBuffer, reading(index));
+                    if (cborBuffer->data == NULL) {
+                        (*count)++;
+                    }
+                }
+            }
+            if (cborBuffer->data == NULL) {
+                // Account for the now known array head.
+                addArray(cborBuffer, *count);
+            }
+        }
+    }
+}
+
+static size_t encodeTwoPass(CBOR_BUFFER* cborBuffer, int elements) {
+    int counts[MAX_ARRAYS] = { 0 };
+    CBOR_BUFFER dryRun;
+    initCborDryRun(&dryRun);
+    producer(&dryRun, elements, counts);
+    // Exact size is now known.
+    if (dryRun.pos > cborBuffer->length - cborBuffer->pos) {
+        return 0;
+    }
+    producer(cborBuffer, elements, counts);
+    if (cborBuffer->pos != dryRun.pos) {
+        printf("\n*** dry-run size mismatch ***\n");
+    }
+    return dryRun.pos;
+}
+
+static double seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, const char* argv[]) {
+    (void)argc; // Avoid unused parameter error
+    (void)argv;
+
+    size_t bufferSize = 8 * 1024 * 1024;
+    uint8_t* fixupBuffer = malloc(bufferSize);
+    uint8_t* batchedBuffer = malloc(bufferSize);
+    uint8_t* twoPassBuffer = malloc(bufferSize);
+    if (!fixupBuffer || !batchedBuffer || !twoPassBuffer) {
+        return 1;
+    }
+
+    printf("%10s %10s %14s %14s %14s\n",
+           "Elements", "Bytes", "Fixups us/op", "Batched us/op", "Two-pass us/op");
+    for (int elements = 1000; elements <= 1000000; elements *= 4) {
+        int rounds = 20000000 / elements + 1;
+        CBOR_BUFFER fixups;
+        CBOR_BUFFER batched;
+        CBOR_BUFFER twoPass;
+
+        clock_t start = clock();
+        for (int i = 0; i < rounds; i++) {
+            initCborBuffer(&fixups, fixupBuffer, bufferSize);
+            encodeWithFixups(&fixups, elements);
+        }
+        double fixupTime = seconds(start);
+
+        start = clock();
+        for (int i = 0; i < rounds; i++) {
+            initCborBuffer(&batched, batchedBuffer, bufferSize);
+            encodeWithBatchedFixups(&batched, elements);
+        }
+        double batchedTime = seconds(start);
+
+        start = clock();
+        for (int i = 0; i < rounds; i++) {
+            initCborBuffer(&twoPass, twoPassBuffer, bufferSize);
+            encodeTwoPass(&twoPass, elements);
+        }
+        double twoPassTime = seconds(start);
+
+        if (!fixups.length || !batched.length || !twoPass.length ||
+            fixups.pos != batched.pos || memcmp(fixupBuffer, batchedBuffer, fixups.pos) ||
+            fixups.pos != twoPass.pos || memcmp(fixupBuffer, twoPassBuffer, fixups.pos)) {
+            printf("\n*** output mismatch for %d elements ***\n", elements);
+            return 1;
+        }
+        printf("%10d %10zu %14.2f %14.2f %14.2f\n", elements, fixups.pos, fixupTime * 1e6 / rounds,
+               batchedTime * 1e6 / rounds, twoPassTime * 1e6 / rounds);
+    }
+    free(fixupBuffer);
+    free(batchedBuffer);
+    free(twoPassBuffer);
+}
@@ -0,0 +1,233 @@
+// float-kernel-benchmark.c
+
+// Checks and times each of QCBOR's block floating-point conversion
+// kernels (portable, SSE2, AVX2 with F16C) that the CPU has.  Every
+// result is compared against the one-at-a-time conversion:
+//   - half to double and float: all 65536 values
+//   - double to smallest: a random sample, most of which fit a half
+//     or single, plus every value that is exact as a half
+//   - float to smallest: a sample of float bit patterns
+// Then QCBOREncode_AddDoubleArray() is timed against QCBOREncode_AddDouble()
+// one at a time, and QCBORDecode_GetDoubleArray() on an array of halves.
+
+#include "qcbor/qcbor_encode.h"
+#include "qcbor/qcbor_decode.h"
+#include "qcbor/qcbor_spiffy_decode.h"
+#include "ieee754.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SAMPLES (1 << 20)
+#define ROUNDS 50
+#define ARRAY_VALUES 50000
+// Values converted at a time when timing, as an encoder would
+#define BLOCK 256
+
+static int failures = 0;
+
+static double wallClock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static uint64_t splitMix(uint64_t index) {
+    uint64_t z = index * 0x9e3779b97f4a7c15ull + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Sensor-like data: mostly small values with few significant bits.
+static double sampleDouble(uint64_t index) {
+    uint64_t z = splitMix(index);
+    switch (z % 4) {
+        case 0:
+            return (double)(int)(z >> 40 & 0xfff) / 16.0;
+        case 1:
+            return (double)(float)((double)(z >> 20 & 0xffffff) / 1024.0);
+        case 2:
+            return IEEE754_HalfToDouble((uint16_t)(z >> 16));
+        default: {
+            double d;
+            memcpy(&d, &z, sizeof(double));
+            return d;
+        }
+    }
+}
+
+static int sameUnion(IEEE754_union a, IEEE754_union b) {
+    return a.uSize == b.uSize && a.uValue == b.uValue;
+}
+
+static void mismatch(const char* what, int kernel, size_t index) {
+    if (failures++ < 10) {
+        printf("\n*** kernel %d differs on %s %zu ***\n", kernel, what, index);
+    }
+}
+
+static void checkAndTime(int kernel, const uint16_t* halves, const double* doubles,
+                         const float* floats, double* doubleOut, float* floatOut, IEEE754_union* unionOut) {
+    IEEE754_LimitKernel(kernel);
+
+    IEEE754_HalfToDoubleBlock(halves, doubleOut, 65536);
+    IEEE754_HalfToFloatBlock(halves, floatOut, 65536);
+    for (size_t i = 0; i < 65536; i++) {
+        double d = IEEE754_HalfToDouble(halves[i]);
+        float f = IEEE754_HalfToFloat(halves[i]);
+        if (memcmp(&d, &doubleOut[i], sizeof(double))) {
+            mismatch("half to double", kernel, i);
+        }
+        if (memcmp(&f, &floatOut[i], sizeof(float))) {
+            mismatch("half to float", kernel, i);
+        }
+    }
+    IEEE754_DoubleToSmallestBlock(doubles, unionOut, SAMPLES, 1);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        if (!sameUnion(unionOut[i], IEEE754_DoubleToSmallest(doubles[i]))) {
+            mismatch("double to smallest", kernel, i);
+        }
+    }
+    IEEE754_DoubleToSmallestBlock(doubles, unionOut, SAMPLES, 0);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        if (!sameUnion(unionOut[i], IEEE754_DoubleToSmall(doubles[i]))) {
+            mismatch("double to small", kernel, i);
+        }
+    }
+    IEEE754_FloatToSmallestBlock(floats, unionOut, SAMPLES);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        if (!sameUnion(unionOut[i], IEEE754_FloatToSmallest(floats[i]))) {
+            mismatch("float to smallest", kernel, i);
+        }
+    }
+
+    double start = wallClock();
+    for (int round = 0; round < ROUNDS * 16; round++) {
+        IEEE754_HalfToDoubleBlock(halves, doubleOut, 65536);
+    }
+    double halfToDouble = (wallClock() - start) * 1e9 / (ROUNDS * 16 * 65536.0);
+    start = wallClock();
+    for (int round = 0; round < ROUNDS * 16; round++) {
+        IEEE754_HalfToFloatBlock(halves, floatOut, 65536);
+    }
+    double halfToFloat = (wallClock() - start) * 1e9 / (ROUNDS * 16 * 65536.0);
+    start = wallClock();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (size_t i = 0; i < SAMPLES; i += BLOCK) {
+            IEEE754_DoubleToSmallestBlock(&doubles[i], unionOut, BLOCK, 1);
+        }
+    }
+    double doubleToSmallest = (wallClock() - start) * 1e9 / ((double)ROUNDS * SAMPLES);
+    start = wallClock();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (size_t i = 0; i < SAMPLES; i += BLOCK) {
+            IEEE754_FloatToSmallestBlock(&floats[i], unionOut, BLOCK);
+        }
+    }
+    double floatToSmallest = (wallClock() - start) * 1e9 / ((double)ROUNDS * SAMPLES);
+    printf("%-8s %14.2f %14.2f %14.2f %14.2f\n",
+           kernel == IEEE754_KERNEL_AVX2 ? "AVX2" : kernel == IEEE754_KERNEL_SSE2 ? "SSE2" : "Portable",
+           halfToDouble, halfToFloat, doubleToSmallest, floatToSmallest);
+}
+
+static UsefulBufC encodeArray(UsefulBuf buffer, const double* values, int oneAtATime) {
+    QCBOREncodeContext encoder;
+    UsefulBufC encoded;
+    QCBOREncode_Init(&encoder, buffer);
+    if (oneAtATime) {
+        QCBOREncode_OpenArray(&encoder);
+        for (size_t i = 0; i < ARRAY_VALUES; i++) {
+            QCBOREncode_AddDouble(&encoder, values[i]);
+        }
+        QCBOREncode_CloseArray(&encoder);
+    } else {
+        QCBOREncode_AddDoubleArray(&encoder, values, ARRAY_VALUES);
+    }
+    return QCBOREncode_Finish(&encoder, &encoded) == QCBOR_SUCCESS ? encoded : NULLUsefulBufC;
+}
+
+int main(void) {
+    uint16_t* halves = malloc(65536 * sizeof(uint16_t));
+    double* doubles = malloc(SAMPLES * sizeof(double));
+    float* floats = malloc(SAMPLES * sizeof(float));
+    double* doubleOut = malloc(SAMPLES * sizeof(double));
+    float* floatOut = malloc(SAMPLES * sizeof(float));
+    IEEE754_union* unionOut = malloc(SAMPLES * sizeof(IEEE754_union));
+    if (!halves || !doubles || !floats || !doubleOut || !floatOut || !unionOut) {
+        printf("\n*** out of memory ***\n");
+        return 1;
+    }
+    for (size_t i = 0; i < 65536; i++) {
+        halves[i] = (uint16_t)i;
+    }
+    for (size_t i = 0; i < SAMPLES; i++) {
+        doubles[i] = i < 65536 ? IEEE754_HalfToDouble(halves[i]) : sampleDouble(i);
+        uint32_t bits = (uint32_t)splitMix(i);
+        // Half the floats have the exponent and significand of a half
+        if (i & 1) {
+            bits = (bits & 0x8000e000) | ((113 + bits % 32) << 23);
+        }
+        memcpy(&floats[i], &bits, sizeof(float));
+    }
+
+    int best = IEEE754_Kernel();
+    printf("%-8s %14s %14s %14s %14s\n", "Kernel", "half>double ns", "half>float ns", "dbl>small ns", "flt>small ns");
+    for (int kernel = IEEE754_KERNEL_PORTABLE; kernel <= best; kernel++) {
+        checkAndTime(kernel, halves, doubles, floats, doubleOut, floatOut, unionOut);
+    }
+    IEEE754_LimitKernel(best);
+
+    // Encoding and decoding arrays of sensor-like doubles
+    static uint8_t oneAtATimeData[ARRAY_VALUES * 9 + 9];
+    static uint8_t arrayData[ARRAY_VALUES * 9 + 9];
+    UsefulBufC oneAtATime = encodeArray(UsefulBuf_FROM_BYTE_ARRAY(oneAtATimeData), &doubles[65536], 1);
+    UsefulBufC array = encodeArray(UsefulBuf_FROM_BYTE_ARRAY(arrayData), &doubles[65536], 0);
+    if (UsefulBuf_IsNULLC(array) || UsefulBuf_Compare(oneAtATime, array)) {
+        printf("\n*** encoded arrays differ ***\n");
+        failures++;
+    }
+    double start = wallClock();
+    for (int round = 0; round < ROUNDS; round++) {
+        encodeArray(UsefulBuf_FROM_BYTE_ARRAY(oneAtATimeData), &doubles[65536], 1);
+    }
+    double oneAtATimeTime = wallClock() - start;
+    start = wallClock();
+    for (int round = 0; round < ROUNDS; round++) {
+        encodeArray(UsefulBuf_FROM_BYTE_ARRAY(arrayData), &doubles[65536], 0);
+    }
+    double arrayTime = wallClock() - start;
+    printf("Encoding %d doubles, %zu bytes\n", ARRAY_VALUES, array.len);
+    printf("  AddDouble       %8.1f M values/s\n", ARRAY_VALUES * ROUNDS / oneAtATimeTime / 1e6);
+    printf("  AddDoubleArray  %8.1f M values/s  (%.2fx)\n", ARRAY_VALUES * ROUNDS / arrayTime / 1e6,
+           oneAtATimeTime / arrayTime);
+
+    // Decoding an array of halves
+    UsefulBufC halfArray = encodeArray(UsefulBuf_FROM_BYTE_ARRAY(arrayData), doubles + 15360, 0);
+    start = wallClock();
+    for (int round = 0; round < ROUNDS; round++) {
+        QCBORDecodeContext decoder;
+        size_t count;
+        QCBORDecode_Init(&decoder, halfArray, QCBOR_DECODE_MODE_NORMAL);
+        QCBORDecode_GetDoubleArray(&decoder, doubleOut, ARRAY_VALUES, &count);
+        if (QCBORDecode_Finish(&decoder) != QCBOR_SUCCESS || count != ARRAY_VALUES ||
+            memcmp(doubleOut, doubles + 15360, 16384 * sizeof(double))) {
+            printf("\n*** decoding halves failed ***\n");
+            failures++;
+            break;
+        }
+    }
+    printf("Decoding %d halves with GetDoubleArray  %8.1f M values/s\n", ARRAY_VALUES,
+           ARRAY_VALUES * ROUNDS / (wallClock() - start) / 1e6);
+
+    free(halves);
+    free(doubles);
+    free(floats);
+    free(doubleOut);
+    free(floatOut);
+    free(unionOut);
+    printf(failures ? "Failed!\n" : "Done!\n");
+    return failures != 0;
+}
@@ -0,0 +1,173 @@
+// getnext-benchmark.c
+
+// Measures QCBORDecode_GetNext() against QCBORDecode_GetNextPlain() on
+// deterministically encoded integer-keyed maps, in normal and D-CBOR
+// decode modes, and decoding all the items into an array of QCBORItem
+// against an array of QCBORCompactItem.
+
+#include "qcbor/qcbor_encode.h"
+#include "qcbor/qcbor_decode.h"
+#include "qcbor/qcbor_compact.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define RECORDS 20000
+#define DECODE_ROUNDS 50
+// Items per record, plus the array around them all
+#define ITEMS (RECORDS * 11 + 1)
+
+static int failures = 0;
+
+static double wallClock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// {1: n, 2: -n, 3: "reading", 4: h'0102', 5: 1.5, 6: [n, n + 1, n + 2], 7: true}
+static void addRecord(QCBOREncodeContext* encoder, int64_t n) {
+    static const uint8_t ID[2] = { 1, 2 };
+    QCBOREncode_OpenMap(encoder);
+    QCBOREncode_AddInt64ToMapN(encoder, 1, n);
+    QCBOREncode_AddInt64ToMapN(encoder, 2, -n);
+    QCBOREncode_AddSZStringToMapN(encoder, 3, "reading");
+    QCBOREncode_AddBytesToMapN(encoder, 4, (UsefulBufC){ ID, sizeof(ID) });
+    QCBOREncode_AddDoubleToMapN(encoder, 5, 1.5);
+    QCBOREncode_OpenArrayInMapN(encoder, 6);
+    QCBOREncode_AddInt64(encoder, n);
+    QCBOREncode_AddInt64(encoder, n + 1);
+    QCBOREncode_AddInt64(encoder, n + 2);
+    QCBOREncode_CloseArray(encoder);
+    QCBOREncode_AddBoolToMapN(encoder, 7, true);
+    QCBOREncode_CloseMap(encoder);
+}
+
+typedef QCBORError (*GetNextFunction)(QCBORDecodeContext*, QCBORItem*);
+
+// Returns a sum of the integers and labels so the results can be compared.
+static int64_t decodeAll(UsefulBufC encoded, QCBORDecodeMode mode, GetNextFunction getNext) {
+    QCBORDecodeContext decoder;
+    QCBORItem item;
+    int64_t sum = 0;
+    QCBORDecode_Init(&decoder, encoded, mode);
+    while (getNext(&decoder, &item) == QCBOR_SUCCESS) {
+        if (item.uDataType == QCBOR_TYPE_INT64) {
+            sum += item.val.int64;
+        }
+        if (item.uLabelType == QCBOR_TYPE_INT64) {
+            sum += item.label.int64 * item.uNestingLevel;
+        }
+    }
+    return QCBORDecode_Finish(&decoder) == QCBOR_SUCCESS ? sum : -1;
+}
+
+static double timeDecode(UsefulBufC encoded, QCBORDecodeMode mode, GetNextFunction getNext,
+                         int64_t* sum) {
+    double start = wallClock();
+    for (int round = 0; round < DECODE_ROUNDS; round++) {
+        *sum = decodeAll(encoded, mode, getNext);
+    }
+    return wallClock() - start;
+}
+
+int main(void) {
+    static uint8_t buffer[RECORDS * 64];
+    QCBOREncodeContext encoder;
+    QCBOREncode_Init(&encoder, UsefulBuf_FROM_BYTE_ARRAY(buffer));
+    QCBOREncode_OpenArray(&encoder);
+    for (int64_t n = 0; n < RECORDS; n++) {
+        addRecord(&encoder, n);
+    }
+    QCBOREncode_CloseArray(&encoder);
+    UsefulBufC encoded;
+    if (QCBOREncode_Finish(&encoder, &encoded) != QCBOR_SUCCESS) {
+        printf("\n*** encoding failed ***\n");
+        return 1;
+    }
+    printf("%d records, %zu bytes\n", RECORDS, encoded.len);
+
+    static const struct {
+        const char* name;
+        QCBORDecodeMode mode;
+    } modes[] = {
+        { "Normal", QCBOR_DECODE_MODE_NORMAL },
+        { "D-CBOR", QCBOR_DECODE_MODE_DCBOR },
+    };
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        int64_t sumGetNext, sumPlain;
+        double getNextTime = timeDecode(encoded, modes[i].mode, QCBORDecode_GetNext, &sumGetNext);
+        double plainTime = timeDecode(encoded, modes[i].mode, QCBORDecode_GetNextPlain, &sumPlain);
+        double bytes = (double)encoded.len * DECODE_ROUNDS;
+        printf("%s\n", modes[i].name);
+        printf("  GetNext       %8.1f MB/s\n", bytes / getNextTime / 1e6);
+        printf("  GetNextPlain  %8.1f MB/s  (%.2fx)\n", bytes / plainTime / 1e6, getNextTime / plainTime);
+        if (sumGetNext < 0 || sumGetNext != sumPlain) {
+            printf("\n*** results differ ***\n");
+            failures++;
+        }
+    }
+
+    // Keeping every decoded item
+    QCBORItem* items = malloc(ITEMS * sizeof(QCBORItem));
+    QCBORCompactItem* compactItems = malloc(ITEMS * sizeof(QCBORCompactItem));
+    if (!items || !compactItems) {
+        printf("\n*** out of memory ***\n");
+        return 1;
+    }
+    size_t count = 0, compactCount = 0;
+    double itemTime = 0, compactTime = 0;
+    for (int round = 0; round < DECODE_ROUNDS; round++) {
+        QCBORDecodeContext decoder;
+        double start = wallClock();
+        QCBORDecode_Init(&decoder, encoded, QCBOR_DECODE_MODE_NORMAL);
+        for (count = 0; count < ITEMS && QCBORDecode_GetNextPlain(&decoder, &items[count]) == QCBOR_SUCCESS; count++) {
+        }
+        itemTime += wallClock() - start;
+
+        start = wallClock();
+        QCBORDecode_Init(&decoder, encoded, QCBOR_DECODE_MODE_NORMAL);
+        for (compactCount = 0;
+             compactCount < ITEMS && QCBORDecode_GetNextCompact(&decoder, &compactItems[compactCount]) == QCBOR_SUCCESS;
+             compactCount++) {
+        }
+        compactTime += wallClock() - start;
+    }
+    // Going through the kept items again, as later processing does
+    int64_t sum = 0, compactSum = 0;
+    double scanTime = 0, compactScanTime = 0;
+    for (int round = 0; round < DECODE_ROUNDS; round++) {
+        double start = wallClock();
+        for (size_t i = 0; i < count; i++) {
+            if (items[i].uDataType == QCBOR_TYPE_INT64) {
+                sum += items[i].val.int64;
+            }
+        }
+        scanTime += wallClock() - start;
+        start = wallClock();
+        for (size_t i = 0; i < compactCount; i++) {
+            if (compactItems[i].uDataType == QCBOR_TYPE_INT64) {
+                compactSum += compactItems[i].val.int64;
+            }
+        }
+        compactScanTime += wallClock() - start;
+    }
+    double bytes = (double)encoded.len * DECODE_ROUNDS;
+    printf("Into an array of %zu items, then summing the integers\n", count);
+    printf("  QCBORItem         %8.1f MB/s  %5.1f MB of items  %6.0f M items/s summed\n", bytes / itemTime / 1e6,
+           (double)(count * sizeof(QCBORItem)) / 1e6, (double)count * DECODE_ROUNDS / scanTime / 1e6);
+    printf("  QCBORCompactItem  %8.1f MB/s  %5.1f MB of items  %6.0f M items/s summed\n", bytes / compactTime / 1e6,
+           (double)(compactCount * sizeof(QCBORCompactItem)) / 1e6,
+           (double)compactCount * DECODE_ROUNDS / compactScanTime / 1e6);
+    if (count != ITEMS || compactCount != ITEMS || sum != compactSum ||
+        items[ITEMS - 1].val.int64 != compactItems[ITEMS - 1].val.int64) {
+        printf("\n*** array decodes differ ***\n");
+        failures++;
+    }
+    free(items);
+    free(compactItems);
+
+    printf(failures ? "Failed!\n" : "Done!\n");
+    return failures != 0;
+}
@@ -0,0 +1,244 @@
+// ieee754-harness.c
+
+// Exhaustive conformance and speed harness for addDouble().  The two
+// builds of "d-cbor-ieee754.c" (PLATFORM_SUPPORTS_FLOAT_CAST and the
+// integer-only version) are linked side by side under different names,
+// see build-and-run.bash.
+//
+// Every float16 and float32 bit pattern plus a random float64 sample is
+// checked for:
+//   - identical output from both builds
+//   - agreement with QCBOR's IEEE754_DoubleToSmallest() which, unlike
+//     D-CBOR, does not reduce to subnormal float16/float32 values and
+//     keeps NaN payloads.  In those cases D-CBOR must be shorter or equal
+//   - a lossless round trip through QCBOR's float16 decoder
+//   - minimal size: no shorter representation may exist
+//
+// Usage: ieee754-harness [threads] [random-samples]
+
+#include <d-cbor.h>
+#include "ieee754.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void addDoubleFloatCast(CBOR_BUFFER* cborBuffer, double value);
+void addDoubleIntegerOnly(CBOR_BUFFER* cborBuffer, double value);
+
+#define MAX_THREADS 64
+#define MAX_FAILURES_SHOWN 10
+
+typedef enum {
+    SWEEP_FLOAT16,
+    SWEEP_FLOAT32,
+    SWEEP_RANDOM
+} SWEEP;
+
+typedef struct {
+    SWEEP sweep;
+    uint64_t first;
+    uint64_t last;         // Exclusive
+    uint64_t failures;
+    uint64_t shorterThanQcbor;
+    double floatCastSeconds;
+    double integerOnlySeconds;
+    uint64_t checksum;     // Keeps the timed loops from being optimized away
+} SHARD;
+
+static pthread_mutex_t reportLock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t failuresShown = 0;
+
+static uint64_t bitsOf(double d) {
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(double));
+    return bits;
+}
+
+static double doubleOf(uint64_t bits) {
+    double d;
+    memcpy(&d, &bits, sizeof(double));
+    return d;
+}
+
+static double floatOf(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(float));
+    return f;
+}
+
+static uint64_t splitMix(uint64_t index) {
+    uint64_t z = index * 0x9e3779b97f4a7c15ull + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static double valueAt(SWEEP sweep, uint64_t index) {
+    switch (sweep) {
+        case SWEEP_FLOAT16:
+            return IEEE754_HalfToDouble((uint16_t)index);
+        case SWEEP_FLOAT32:
+            return floatOf((uint32_t)index);
+        default:
+            return doubleOf(splitMix(index));
+    }
+}
+
+static void failure(double d, const char* reason) {
+    pthread_mutex_lock(&reportLock);
+    if (failuresShown++ < MAX_FAILURES_SHOWN) {
+        printf("\n*** failed on %016llx: %s ***\n", (unsigned long long)bitsOf(d), reason);
+    }
+    pthread_mutex_unlock(&reportLock);
+}
+
+// Returns the argument of an encoded float and its size.
+static int parse(const CBOR_BUFFER* cborBuffer, uint64_t* argument) {
+    int size = cborBuffer->pos - 1;
+    *argument = 0;
+    for (int i = 1; i <= size; i++) {
+        *argument = (*argument << 8) | cborBuffer->data[i];
+    }
+    return size;
+}
+
+// Same conversions as in QCBOR's decoder.
+static double decode(int size, uint64_t argument) {
+    return size == 2 ? IEEE754_HalfToDouble((uint16_t)argument) :
+           size == 4 ? floatOf((uint32_t)argument) : doubleOf(argument);
+}
+
+static int fitsHalf(double d) {
+    return IEEE754_HalfToDouble(IEEE754_DoubleToHalf(d)) == d;
+}
+
+static int check(double d, SHARD* shard) {
+    uint8_t floatCastData[9];
+    uint8_t integerOnlyData[9];
+    CBOR_BUFFER floatCast;
+    CBOR_BUFFER integerOnly;
+    initCborBuffer(&floatCast, floatCastData, sizeof(floatCastData));
+    initCborBuffer(&integerOnly, integerOnlyData, sizeof(integerOnlyData));
+    addDoubleFloatCast(&floatCast, d);
+    addDoubleIntegerOnly(&integerOnly, d);
+    if (!floatCast.length || !integerOnly.length) {
+        failure(d, "overflow");
+        return 0;
+    }
+    if (floatCast.pos != integerOnly.pos || memcmp(floatCastData, integerOnlyData, floatCast.pos)) {
+        failure(d, "builds differ");
+        return 0;
+    }
+    uint64_t argument;
+    int size = parse(&floatCast, &argument);
+    if (floatCastData[0] != (size == 2 ? 0xf9 : size == 4 ? 0xfa : 0xfb)) {
+        failure(d, "bad head");
+        return 0;
+    }
+
+    if (d != d) {
+        // Deterministic NaN.
+        if (size != 2 || argument != 0x7e00) {
+            failure(d, "NaN not 0x7e00");
+            return 0;
+        }
+        return 1;
+    }
+
+    IEEE754_union qcbor = IEEE754_DoubleToSmallest(d);
+    if (size > qcbor.uSize || (size == qcbor.uSize && argument != qcbor.uValue)) {
+        failure(d, "disagrees with IEEE754_DoubleToSmallest");
+        return 0;
+    }
+    if (size < qcbor.uSize) {
+        shard->shorterThanQcbor++;
+    }
+
+    if (bitsOf(decode(size, argument)) != bitsOf(d)) {
+        failure(d, "round trip");
+        return 0;
+    }
+    if ((size > 2 && fitsHalf(d)) || (size > 4 && (double)(float)d == d)) {
+        failure(d, "not minimal");
+        return 0;
+    }
+    return 1;
+}
+
+typedef void (*ADD_DOUBLE)(CBOR_BUFFER*, double);
+
+static double timeBuild(ADD_DOUBLE addDouble, SHARD* shard) {
+    uint8_t data[9];
+    CBOR_BUFFER cborBuffer;
+    struct timespec start, stop;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+    for (uint64_t i = shard->first; i < shard->last; i++) {
+        initCborBuffer(&cborBuffer, data, sizeof(data));
+        addDouble(&cborBuffer, valueAt(shard->sweep, i));
+        shard->checksum += data[cborBuffer.pos - 1];
+    }
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &stop);
+    return (double)(stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static void* runShard(void* context) {
+    SHARD* shard = (SHARD*)context;
+    for (uint64_t i = shard->first; i < shard->last; i++) {
+        if (!check(valueAt(shard->sweep, i), shard)) {
+            shard->failures++;
+        }
+    }
+    shard->floatCastSeconds = timeBuild(addDoubleFloatCast, shard);
+    shard->integerOnlySeconds = timeBuild(addDoubleIntegerOnly, shard);
+    return NULL;
+}
+
+static uint64_t sweep(const char* name, SWEEP kind, uint64_t count, int threads) {
+    pthread_t workers[MAX_THREADS];
+    SHARD shards[MAX_THREADS];
+    for (int t = 0; t < threads; t++) {
+        memset(&shards[t], 0, sizeof(SHARD));
+        shards[t].sweep = kind;
+        shards[t].first = count * t / threads;
+        shards[t].last = count * (t + 1) / threads;
+        if (pthread_create(&workers[t], NULL, runShard, &shards[t])) {
+            printf("\n*** failed on thread creation ***\n");
+            exit(1);
+        }
+    }
+    SHARD total;
+    memset(&total, 0, sizeof(SHARD));
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t], NULL);
+        total.failures += shards[t].failures;
+        total.shorterThanQcbor += shards[t].shorterThanQcbor;
+        total.floatCastSeconds += shards[t].floatCastSeconds;
+        total.integerOnlySeconds += shards[t].integerOnlySeconds;
+    }
+    printf("%-8s %12llu %10llu %14llu %12.2f %12.2f\n", name, (unsigned long long)count,
+           (unsigned long long)total.failures, (unsigned long long)total.shorterThanQcbor,
+           total.floatCastSeconds * 1e9 / count, total.integerOnlySeconds * 1e9 / count);
+    fflush(stdout);
+    return total.failures;
+}
+
+int main(int argc, const char* argv[]) {
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    uint64_t randomSamples = argc > 2 ? strtoull(argv[2], NULL, 10) : 100000000ull;
+    if (threads < 1 || threads > MAX_THREADS) {
+        printf("Threads must be 1-%d\n", MAX_THREADS);
+        return 1;
+    }
+
+    printf("%-8s %12s %10s %14s %12s %12s\n",
+           "Sweep", "Values", "Failures", "Below QCBOR", "Cast ns/val", "Int ns/val");
+    uint64_t failures = sweep("float16", SWEEP_FLOAT16, 1ull << 16, threads);
+    failures += sweep("float32", SWEEP_FLOAT32, 1ull << 32, threads);
+    failures += sweep("random", SWEEP_RANDOM, randomSamples, threads);
+
+    printf(failures ? "Failed!\n" : "Done!\n");
+    return failures != 0;
+}
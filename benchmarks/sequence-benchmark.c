@@ -0,0 +1,202 @@
+// sequence-benchmark.c
+
+// Writes a large CBOR sequence file, memory-maps it and measures how fast
+// QCBORSequence_Next() splits it into items, how fast the items are then
+// decoded with QCBOR, and how that scales with QCBORParallel_Decode() on
+// more threads.
+//
+// Usage: sequence-benchmark [gigabytes [file]]
+//
+// The default is a 10 GB file in the current directory.  It is removed
+// when done.  QCBOR must be built with QCBOR_SEQUENCE_64BIT_OFFSETS for
+// files of 4 GB and more.
+
+#include "qcbor/qcbor_encode.h"
+#include "qcbor/qcbor_sequence.h"
+#include "qcbor/qcbor_parallel.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+static double wallClock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// One record: {1: counter, 2: "sensor", 3: [x, y, counter / 2], 4: h'00...0f'}
+static void addRecord(QCBOREncodeContext* encoder, int64_t counter) {
+    static const uint8_t ID[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+    QCBOREncode_OpenMap(encoder);
+    QCBOREncode_AddInt64ToMapN(encoder, 1, counter);
+    QCBOREncode_AddSZStringToMapN(encoder, 2, "sensor");
+    QCBOREncode_OpenArrayInMapN(encoder, 3);
+    QCBOREncode_AddDouble(encoder, 1.5);
+    QCBOREncode_AddDouble(encoder, -2.25);
+    QCBOREncode_AddDouble(encoder, (double)counter / 2);
+    QCBOREncode_CloseArray(encoder);
+    QCBOREncode_AddBytesToMapN(encoder, 4, (UsefulBufC){ ID, sizeof(ID) });
+    QCBOREncode_CloseMap(encoder);
+}
+
+// Writes records until the file has at least "size" bytes.
+// Returns the number of records or -1 on error.
+static int64_t writeSequence(const char* fileName, uint64_t size) {
+    FILE* file = fopen(fileName, "wb");
+    if (!file) {
+        return -1;
+    }
+    static uint8_t block[1024 * 1024];
+    int64_t counter = 0;
+    uint64_t written = 0;
+    while (written < size) {
+        QCBOREncodeContext encoder;
+        QCBOREncode_Init(&encoder, UsefulBuf_FROM_BYTE_ARRAY(block));
+        // Records are well under 128 bytes.
+        for (size_t i = 0; i < sizeof(block) / 128; i++) {
+            addRecord(&encoder, counter++);
+        }
+        UsefulBufC encoded;
+        if (QCBOREncode_Finish(&encoder, &encoded) != QCBOR_SUCCESS ||
+            fwrite(encoded.ptr, 1, encoded.len, file) != encoded.len) {
+            fclose(file);
+            return -1;
+        }
+        written += encoded.len;
+    }
+    return fclose(file) == 0 ? counter : -1;
+}
+
+static void report(const char* name, uint64_t size, double time) {
+    printf("%-24s %8.2f GB/s\n", name, (double)size / time / 1e9);
+}
+
+// Gets the counter of a record, or -1 if it is not there.
+static int64_t decodeRecord(QCBORDecodeContext* decoder) {
+    QCBORItem decoded;
+    int64_t counter = -1;
+    while (QCBORDecode_GetNext(decoder, &decoded) == QCBOR_SUCCESS) {
+        if (decoded.uLabelType == QCBOR_TYPE_INT64 && decoded.label.int64 == 1 &&
+            decoded.uNestingLevel == 1) {
+            counter = decoded.val.int64;
+        }
+    }
+    return QCBORDecode_Finish(decoder) == QCBOR_SUCCESS ? counter : -1;
+}
+
+static QCBORError decodeCallback(void* context, QCBORDecodeContext* decoder, void* result) {
+    (void)context;
+    *(int64_t*)result = decodeRecord(decoder);
+    return QCBOR_SUCCESS;
+}
+
+// Each record's counter is its index.
+static QCBORError deliverCallback(void* context, uint64_t index, QCBORError error, const void* result) {
+    int64_t* delivered = (int64_t*)context;
+    if (error != QCBOR_SUCCESS || *(const int64_t*)result != (int64_t)index) {
+        return QCBOR_ERR_CALLBACK_FAIL;
+    }
+    (*delivered)++;
+    return QCBOR_SUCCESS;
+}
+
+int main(int argc, const char* argv[]) {
+    double gigabytes = argc > 1 ? atof(argv[1]) : 10;
+    const char* fileName = argc > 2 ? argv[2] : "sequence-benchmark.cbor";
+
+    int64_t records = writeSequence(fileName, (uint64_t)(gigabytes * 1e9));
+    if (records < 0) {
+        printf("\n*** could not write %s ***\n", fileName);
+        remove(fileName);
+        return 1;
+    }
+
+    int fd = open(fileName, O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0) {
+        printf("\n*** could not open %s ***\n", fileName);
+        remove(fileName);
+        return 1;
+    }
+    size_t size = (size_t)status.st_size;
+    void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        printf("\n*** could not map %s ***\n", fileName);
+        remove(fileName);
+        return 1;
+    }
+    // The reader goes through the file once from start to end.
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    printf("%.2f GB, %lld items\n", (double)size / 1e9, (long long)records);
+
+    // Splitting only
+    QCBORSequenceReader reader;
+    UsefulBufC item;
+    int64_t count = 0;
+    double start = wallClock();
+    QCBORSequence_Init(&reader, (UsefulBufC){ mapped, size });
+    while (QCBORSequence_Next(&reader, &item) == QCBOR_SUCCESS) {
+        count++;
+    }
+    report("Split", size, wallClock() - start);
+    if (count != records || QCBORSequence_Tell(&reader) != size) {
+        printf("\n*** split failed at %llu ***\n", (unsigned long long)QCBORSequence_Tell(&reader));
+        failures++;
+    }
+
+    // Splitting and decoding every item
+    QCBORDecodeContext decoder;
+    int64_t expected = 0;
+    start = wallClock();
+    QCBORSequence_Init(&reader, (UsefulBufC){ mapped, size });
+    while (QCBORSequence_NextDecoder(&reader, &decoder, QCBOR_DECODE_MODE_NORMAL) == QCBOR_SUCCESS) {
+        if (decodeRecord(&decoder) != expected) {
+            break;
+        }
+        expected++;
+    }
+    report("Split and decode", size, wallClock() - start);
+    if (expected != records) {
+        printf("\n*** decode failed on item %lld ***\n", (long long)expected);
+        failures++;
+    }
+
+    // The same on worker threads, doubling them up to the number of cores
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    for (unsigned threads = 1; threads <= (unsigned)(cores > 0 ? cores : 1); threads *= 2) {
+        int64_t delivered = 0;
+        QCBORParallelConfig config = { 0 };
+        config.uThreads = threads;
+        config.uResultSize = sizeof(int64_t);
+        config.nDecodeMode = QCBOR_DECODE_MODE_NORMAL;
+        config.pfDecode = decodeCallback;
+        config.pfDeliver = deliverCallback;
+        config.pCallbackCtx = &delivered;
+        UsefulBuf workspace = { malloc(QCBORParallel_WorkspaceSize(&config)),
+                                QCBORParallel_WorkspaceSize(&config) };
+        start = wallClock();
+        QCBORError error = QCBORParallel_Decode(&config, (UsefulBufC){ mapped, size }, workspace);
+        char name[40];
+        snprintf(name, sizeof(name), "Parallel, %u threads", threads);
+        report(name, size, wallClock() - start);
+        free(workspace.ptr);
+        if (error != QCBOR_SUCCESS || delivered != records) {
+            printf("\n*** parallel decode failed with %s ***\n", qcbor_err_to_str(error));
+            failures++;
+        }
+    }
+
+    munmap(mapped, size);
+    remove(fileName);
+
+    printf(failures ? "Failed!\n" : "Done!\n");
+    return failures != 0;
+}
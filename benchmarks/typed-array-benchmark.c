@@ -0,0 +1,139 @@
+// typed-array-benchmark.c
+
+// Decodes sensor time series, an array of readings encoded with preferred
+// serialization (mostly half-precision) and an array of timestamps, item by
+// item with QCBORDecode_GetDouble() and QCBORDecode_GetInt64() against
+// QCBORDecode_GetDoubleArray(), QCBORDecode_GetFloatArray() and
+// QCBORDecode_GetInt64Array().
+
+#include "qcbor/qcbor_encode.h"
+#include "qcbor/qcbor_spiffy_decode.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define SAMPLES 10000
+#define DECODE_ROUNDS 2000
+
+static int failures = 0;
+
+static double wallClock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// Readings in quarter degrees, which are exact in half-precision, with an
+// occasional one that needs single precision.
+static double reading(int n) {
+    return n % 100 == 99 ? 20.1 + n % 7 : 20.0 + (n % 40) * 0.25;
+}
+
+static void report(const char* name, double time, double baseTime) {
+    printf("  %-16s %6.1f M values/s  (%.2fx)\n", name, (double)SAMPLES * DECODE_ROUNDS / time / 1e6,
+           baseTime / time);
+}
+
+int main(void) {
+    static uint8_t buffer[SAMPLES * 16];
+    static double expected[SAMPLES];
+    static double values[SAMPLES];
+    static float floatValues[SAMPLES];
+    static int64_t timestamps[SAMPLES];
+    QCBOREncodeContext encoder;
+
+    QCBOREncode_Init(&encoder, UsefulBuf_FROM_BYTE_ARRAY(buffer));
+    QCBOREncode_OpenArray(&encoder);
+    QCBOREncode_OpenArray(&encoder);
+    for (int n = 0; n < SAMPLES; n++) {
+        expected[n] = (double)(float)reading(n);
+        QCBOREncode_AddDouble(&encoder, expected[n]);
+    }
+    QCBOREncode_CloseArray(&encoder);
+    QCBOREncode_OpenArray(&encoder);
+    for (int n = 0; n < SAMPLES; n++) {
+        QCBOREncode_AddInt64(&encoder, 1700000000000 + n * 250);
+    }
+    QCBOREncode_CloseArray(&encoder);
+    QCBOREncode_CloseArray(&encoder);
+    UsefulBufC encoded;
+    if (QCBOREncode_Finish(&encoder, &encoded) != QCBOR_SUCCESS) {
+        printf("\n*** encoding failed ***\n");
+        return 1;
+    }
+    printf("%d readings and timestamps, %zu bytes\n", SAMPLES, encoded.len);
+
+    QCBORDecodeContext decoder;
+    double itemTime = 0, arrayTime = 0, floatTime = 0;
+    double intItemTime = 0, intArrayTime = 0;
+    for (int round = 0; round < DECODE_ROUNDS; round++) {
+        size_t count = 0;
+        double start = wallClock();
+        QCBORDecode_Init(&decoder, encoded, QCBOR_DECODE_MODE_NORMAL);
+        QCBORDecode_EnterArray(&decoder, NULL);
+        QCBORDecode_EnterArray(&decoder, NULL);
+        while (count < SAMPLES) {
+            QCBORDecode_GetDouble(&decoder, &values[count]);
+            if (QCBORDecode_GetError(&decoder) != QCBOR_SUCCESS) {
+                break;
+            }
+            count++;
+        }
+        QCBORDecode_ExitArray(&decoder);
+        itemTime += wallClock() - start;
+        start = wallClock();
+        QCBORDecode_EnterArray(&decoder, NULL);
+        for (size_t n = 0; n < SAMPLES; n++) {
+            QCBORDecode_GetInt64(&decoder, &timestamps[n]);
+        }
+        QCBORDecode_ExitArray(&decoder);
+        intItemTime += wallClock() - start;
+        QCBORDecode_ExitArray(&decoder);
+        if (QCBORDecode_Finish(&decoder) != QCBOR_SUCCESS || count != SAMPLES ||
+            memcmp(values, expected, sizeof(expected)) != 0 || timestamps[SAMPLES - 1] != 1700000000000 + (SAMPLES - 1) * 250) {
+            failures++;
+        }
+
+        memset(values, 0, sizeof(values));
+        memset(timestamps, 0, sizeof(timestamps));
+        start = wallClock();
+        QCBORDecode_Init(&decoder, encoded, QCBOR_DECODE_MODE_NORMAL);
+        QCBORDecode_EnterArray(&decoder, NULL);
+        QCBORDecode_GetDoubleArray(&decoder, values, SAMPLES, &count);
+        arrayTime += wallClock() - start;
+        start = wallClock();
+        size_t intCount;
+        QCBORDecode_GetInt64Array(&decoder, timestamps, SAMPLES, &intCount);
+        intArrayTime += wallClock() - start;
+        QCBORDecode_ExitArray(&decoder);
+        if (QCBORDecode_Finish(&decoder) != QCBOR_SUCCESS || count != SAMPLES || intCount != SAMPLES ||
+            memcmp(values, expected, sizeof(expected)) != 0 || timestamps[SAMPLES - 1] != 1700000000000 + (SAMPLES - 1) * 250) {
+            failures++;
+        }
+
+        start = wallClock();
+        QCBORDecode_Init(&decoder, encoded, QCBOR_DECODE_MODE_NORMAL);
+        QCBORDecode_EnterArray(&decoder, NULL);
+        QCBORDecode_GetFloatArray(&decoder, floatValues, SAMPLES, &count);
+        floatTime += wallClock() - start;
+        if (QCBORDecode_GetError(&decoder) != QCBOR_SUCCESS || count != SAMPLES ||
+            floatValues[SAMPLES - 1] != (float)expected[SAMPLES - 1]) {
+            failures++;
+        }
+    }
+
+    printf("Readings\n");
+    report("GetDouble each", itemTime, itemTime);
+    report("GetDoubleArray", arrayTime, itemTime);
+    report("GetFloatArray", floatTime, itemTime);
+    printf("Timestamps\n");
+    report("GetInt64 each", intItemTime, intItemTime);
+    report("GetInt64Array", intArrayTime, intItemTime);
+
+    if (failures) {
+        printf("\n*** %d decodes did not match ***\n", failures);
+    }
+    printf(failures ? "Failed!\n" : "Done!\n");
+    return failures != 0;
+}
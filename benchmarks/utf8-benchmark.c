@@ -0,0 +1,147 @@
+// utf8-benchmark.c
+
+// Verifies isValidUtf8() against a straightforward reference decoder and
+// measures its throughput on long strings.
+
+#include <d-cbor.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Decodes code points and checks the resulting values.
+static int referenceValidUtf8(const uint8_t* data, size_t length) {
+    size_t i = 0;
+    while (i < length) {
+        uint32_t codePoint = data[i];
+        size_t trailing = codePoint < 0x80 ? 0 : codePoint < 0xc0 ? 9 :
+                          codePoint < 0xe0 ? 1 : codePoint < 0xf0 ? 2 : codePoint < 0xf8 ? 3 : 9;
+        if (trailing == 9 || length - i <= trailing) {
+            return 0;
+        }
+        codePoint &= 0x7f >> trailing;
+        for (size_t q = 1; q <= trailing; q++) {
+            if ((data[i + q] & 0xc0) != 0x80) {
+                return 0;
+            }
+            codePoint = (codePoint << 6) | (data[i + q] & 0x3f);
+        }
+        static const uint32_t MINIMUM[] = { 0, 0x80, 0x800, 0x10000 };
+        if (codePoint < MINIMUM[trailing] || codePoint > 0x10ffff ||
+            (codePoint >= 0xd800 && codePoint <= 0xdfff)) {
+            return 0;
+        }
+        i += 1 + trailing;
+    }
+    return 1;
+}
+
+static int failures = 0;
+
+static void check(const char* name, const uint8_t* data, size_t length) {
+    if (isValidUtf8(data, length) != referenceValidUtf8(data, length)) {
+        printf("\n*** failed on %s (length=%zu) ***\n", name, length);
+        failures++;
+    }
+}
+
+static const char* VECTORS[] = {
+    "", "Hello D-CBOR world!", "\xc3\xa5\xc3\xa4\xc3\xb6", "\xe2\x82\xac", "\xf0\x9f\x98\x80",
+    "\xc0\xaf", "\xc1\xbf", "\xe0\x80\xaf", "\xe0\x9f\xbf", "\xf0\x80\x80\xaf", "\xf0\x8f\xbf\xbf",
+    "\xed\xa0\x80", "\xed\xbf\xbf", "\xed\x9f\xbf", "\xf4\x8f\xbf\xbf", "\xf4\x90\x80\x80",
+    "\xf5\x80\x80\x80", "\xf8\x88\x80\x80\x80", "\xff", "\x80", "\xbf\x80", "\xc3", "\xe2\x82",
+    "\xf0\x9f\x98", "\xc3\x41", "\xe2\x41\xac", "\xf0\x9f\x41\x80", "\xef\xbf\xbf", "\xee\x80\x80"
+};
+
+static double seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void measure(const char* name, const uint8_t* data, size_t length) {
+    int rounds = 200;
+    int valid = 0;
+    clock_t start = clock();
+    for (int i = 0; i < rounds; i++) {
+        valid += isValidUtf8(data, length);
+    }
+    double time = seconds(start);
+    if (valid != rounds) {
+        printf("\n*** %s unexpectedly invalid ***\n", name);
+        failures++;
+    }
+    printf("%-12s %8.2f GB/s\n", name, (double)length * rounds / time / 1e9);
+}
+
+// Fills "data" with repetitions of "pattern".
+static void fill(uint8_t* data, size_t length, const char* pattern) {
+    size_t patternLength = strlen(pattern);
+    for (size_t i = 0; i + patternLength <= length; i += patternLength) {
+        memcpy(&data[i], pattern, patternLength);
+    }
+}
+
+int main(int argc, const char* argv[]) {
+    (void)argc; // Avoid unused parameter error
+    (void)argv;
+
+    // Known vectors, also at every offset within a 16-byte block.
+    uint8_t padded[64];
+    for (size_t v = 0; v < sizeof(VECTORS) / sizeof(VECTORS[0]); v++) {
+        size_t length = strlen(VECTORS[v]);
+        for (size_t offset = 0; offset < 32; offset++) {
+            memset(padded, 'x', sizeof(padded));
+            memcpy(&padded[offset], VECTORS[v], length);
+            check(VECTORS[v], padded, offset + length);
+            check(VECTORS[v], padded, sizeof(padded));
+        }
+    }
+
+    // Random mutations of valid text.
+    uint8_t sample[100];
+    uint64_t seed = 1;
+    for (int i = 0; i < 1000000; i++) {
+        fill(sample, sizeof(sample), "a\xc3\xa5\xe2\x82\xac\xf0\x9f\x98\x80");
+        for (int q = 0; q < 3; q++) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            sample[(seed >> 33) % sizeof(sample)] = (uint8_t)(seed >> 17);
+        }
+        check("random", sample, (seed >> 40) % sizeof(sample));
+    }
+
+    // The encoder option.
+    uint8_t outputBuffer[100];
+    CBOR_BUFFER cborBuffer;
+    initCborBuffer(&cborBuffer, outputBuffer, sizeof(outputBuffer));
+    cborBuffer.validateUtf8 = 1;
+    addTstrWithLength(&cborBuffer, "\xe2\x82\xac", 3);
+    if (!cborBuffer.length || cborBuffer.invalidUtf8 || cborBuffer.pos != 4) {
+        printf("\n*** failed on valid addTstrWithLength ***\n");
+        failures++;
+    }
+    addTstrWithLength(&cborBuffer, "\xe2\x82\xac", 2);
+    if (cborBuffer.length || !cborBuffer.invalidUtf8) {
+        printf("\n*** failed on invalid addTstrWithLength ***\n");
+        failures++;
+    }
+
+    size_t length = 16 * 1024 * 1024;
+    uint8_t* data = malloc(length);
+    if (!data) {
+        return 1;
+    }
+    memset(data, 'a', length);
+    measure("ASCII", data, length);
+    fill(data, length, "Sm\xc3\xb6rg\xc3\xa5sbord ");
+    measure("Latin-1", data, length);
+    memset(data, 'a', length);
+    fill(data, length, "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e");
+    measure("CJK", data, length);
+    memset(data, 'a', length);
+    fill(data, length, "\xf0\x9f\x98\x80");
+    measure("Emoji", data, length);
+    free(data);
+
+    printf(failures ? "Failed!\n" : "Done!\n");
+    return failures != 0;
+}
@@ -0,0 +1,12 @@
+#!/bin/bash
+
+# Rudimentary Linux bash script for building and running the D-CBOR constexpr test.
+#
+# Run from any directory: $ bash path-to-this-script
+#
+pushd $(dirname "${BASH_SOURCE[0]}")
+gcc -c -Os -DPLATFORM_SUPPORTS_FLOAT_CAST -I ../lib ../lib/*.c
+g++ -o demo -std=c++17 -Os -I ../lib constexpr-test.cpp *.o
+rm -f *.o
+./demo
+popd
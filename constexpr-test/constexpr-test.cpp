@@ -0,0 +1,136 @@
+// constexpr-test.cpp
+
+// Verifies that compile-time fragments are identical to the runtime encoder output.
+
+#include <d-cbor.h>
+#include <d-cbor.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#define BUFFER_SIZE 300
+
+static int failures = 0;
+
+template <std::size_t N>
+static void compare(const char* name, const std::array<uint8_t, N>& fragment, CBOR_BUFFER* cborBuffer) {
+    if (!cborBuffer->length || cborBuffer->pos != N || memcmp(fragment.data(), cborBuffer->data, N)) {
+        printf("\n*** failed on %s ***\n", name);
+        failures++;
+    }
+}
+
+template <std::size_t N>
+static void oneDouble(const char* name, const std::array<uint8_t, N>& fragment, double value) {
+    uint8_t outputBuffer[BUFFER_SIZE];
+    CBOR_BUFFER cborBuffer;
+    initCborBuffer(&cborBuffer, outputBuffer, BUFFER_SIZE);
+    addDouble(&cborBuffer, value);
+    compare(name, fragment, &cborBuffer);
+}
+
+#define DOUBLE_TURN(value) oneDouble(#value, DCBOR_FRAGMENT(dcbor::Encoder<16>().addDouble(value)), value)
+
+static constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+static constexpr double Infinity = std::numeric_limits<double>::infinity();
+
+// COSE public key from signature-demo/csf-signer.c
+static constexpr std::array<uint8_t, 32> PUBLIC_KEY = {
+    0xfe, 0x49, 0xac, 0xf5, 0xb9, 0x2b, 0x6e, 0x92, 0x35, 0x94, 0xf2, 0xe8, 0x33, 0x68, 0xf6, 0x80,
+    0xac, 0x92, 0x4b, 0xe9, 0x3c, 0xf5, 0x33, 0xae, 0xca, 0xf8, 0x02, 0xe3, 0x77, 0x57, 0xf8, 0xc9
+};
+
+static constexpr auto COSE_KEY = DCBOR_FRAGMENT(dcbor::Encoder<>()
+    .addMap(3)
+      .addInt(1).addInt(1)
+      .addInt(-1).addInt(6)
+      .addInt(-2).addBstr(PUBLIC_KEY));
+
+static constexpr auto MIXED = DCBOR_FRAGMENT(dcbor::Encoder<>()
+    .addArray(7)
+      .addInt(9223372036854775807ll)
+      .addInt(-523)
+      .addInt(-9223372036854775807ll - 1)
+      .addTstr("Hello D-CBOR world!")
+      .addBool(true)
+      .addRawBytes(COSE_KEY)
+      .addArray(2)
+        .addDouble(35.6)
+        .addDouble(-0.0));
+
+// Small enough for checking at compile time: [-1, 1.5]
+static constexpr auto SMALL = DCBOR_FRAGMENT(dcbor::Encoder<>().addArray(2).addInt(-1).addDouble(1.5));
+static_assert(SMALL.size() == 5 && SMALL[0] == 0x82 && SMALL[1] == 0x20 &&
+              SMALL[2] == 0xf9 && SMALL[3] == 0x3e && SMALL[4] == 0x00, "Unexpected encoding");
+
+int main(int argc, const char* argv[]) {
+    (void)argc; // Avoid unused parameter error
+    (void)argv;
+
+    uint8_t outputBuffer[BUFFER_SIZE];
+    CBOR_BUFFER cborBuffer;
+
+    initCborBuffer(&cborBuffer, outputBuffer, BUFFER_SIZE);
+    addMap(&cborBuffer, 3);
+      addMappedInt(&cborBuffer, 1, 1);
+      addMappedInt(&cborBuffer, -1, 6);
+      addMappedBstr(&cborBuffer, -2, PUBLIC_KEY.data(), PUBLIC_KEY.size());
+    compare("COSE_KEY", COSE_KEY, &cborBuffer);
+
+    initCborBuffer(&cborBuffer, outputBuffer, BUFFER_SIZE);
+    addArray(&cborBuffer, 7);
+      addInt(&cborBuffer, 9223372036854775807ll);
+      addInt(&cborBuffer, -523);
+      addInt(&cborBuffer, -9223372036854775807ll - 1);
+      addTstr(&cborBuffer, "Hello D-CBOR world!");
+      addBool(&cborBuffer, 1);
+      addRawBytes(&cborBuffer, COSE_KEY.data(), COSE_KEY.size());
+      addArray(&cborBuffer, 2);
+        addDouble(&cborBuffer, 35.6);
+        addDouble(&cborBuffer, -0.0);
+    compare("MIXED", MIXED, &cborBuffer);
+
+    // Same values as in ieee754-test.c
+    DOUBLE_TURN(0.0);
+    DOUBLE_TURN(-0.0);
+    DOUBLE_TURN(NaN);
+    DOUBLE_TURN(Infinity);
+    DOUBLE_TURN(-Infinity);
+    DOUBLE_TURN(0.0000610649585723877);
+    DOUBLE_TURN(10.559998512268066);
+    DOUBLE_TURN(65472.0);
+    DOUBLE_TURN(65472.00390625);
+    DOUBLE_TURN(65503.0);
+    DOUBLE_TURN(65504.0);
+    DOUBLE_TURN(65504.00390625);
+    DOUBLE_TURN(65504.5);
+    DOUBLE_TURN(65505.0);
+    DOUBLE_TURN(131008.0);
+    DOUBLE_TURN(-5.960464477539062e-8);
+    DOUBLE_TURN(-5.960464477539063e-8);
+    DOUBLE_TURN(-5.960464477539064e-8);
+    DOUBLE_TURN(-5.960465188081798e-8);
+    DOUBLE_TURN(-5.963374860584736e-8);
+    DOUBLE_TURN(-5.966285243630409e-8);
+    DOUBLE_TURN(-8.940696716308594e-8);
+    DOUBLE_TURN(-0.00006097555160522461);
+    DOUBLE_TURN(-0.000060975551605224616);
+    DOUBLE_TURN(-0.000060975555243203416);
+    DOUBLE_TURN(0.00006103515625);
+    DOUBLE_TURN(0.00006103515625005551);
+    DOUBLE_TURN(1.401298464324817e-45);
+    DOUBLE_TURN(1.4012986313726115e-45);
+    DOUBLE_TURN(1.1754942106924411e-38);
+    DOUBLE_TURN(0.00006109476089477539);
+    DOUBLE_TURN(7.52316384526264e-37);
+    DOUBLE_TURN(1.1754943508222875e-38);
+    DOUBLE_TURN(5.0e-324);
+    DOUBLE_TURN(-1.7976931348623157e+308);
+    DOUBLE_TURN(3.4028234663852886e+38);
+    DOUBLE_TURN(-3.4028234663852889e+38);
+    DOUBLE_TURN(5.9604644775390625e-8);
+
+    printf(failures ? "Failed!\n" : "Done!\n");
+    return failures != 0;
+}
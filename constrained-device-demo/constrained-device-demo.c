@@ -23,9 +23,7 @@ int main(int argc, const char* argv[]) {
     // Buffer setup, here using the stack for storage.
     unsigned char outputBuffer[BUFFER_SIZE];
     CBOR_BUFFER cborBuffer;
-    cborBuffer.data = outputBuffer;
-    cborBuffer.length = BUFFER_SIZE;
-    cborBuffer.pos = 0;
+    initCborBuffer(&cborBuffer, outputBuffer, BUFFER_SIZE);
 
     // Generate deterministic CBOR using prearranged map key sorting.
 #ifndef CBOR_NO_DOUBLE
@@ -39,7 +37,7 @@ int main(int argc, const char* argv[]) {
       addBstr(&cborBuffer, blob2, sizeof(blob2));
       addInt(&cborBuffer, 3);  // key: 3
 #ifdef INDEFINITE_LENGTH_EMULATION
-      int savePos = cborBuffer.pos;
+      size_t savePos = cborBuffer.pos;
 #else
       addArray(&cborBuffer, 3);  // [#,#,#]
 #endif
@@ -66,4 +64,19 @@ int main(int argc, const char* argv[]) {
 
     // Do something with the generated CBOR.
     printCborBuffer(&cborBuffer, "Deterministic CBOR");
+
+    // Generate deterministic CBOR using automatic map key sorting.
+    CBOR_MAP_ENTRY entries[3];
+    CBOR_SORTED_MAP sortedMap;
+    initCborBuffer(&cborBuffer, outputBuffer, BUFFER_SIZE);
+    beginSortedMap(&cborBuffer, &sortedMap, entries, 3);  // {#,#,#}
+      addSortedMapKey(&cborBuffer, &sortedMap);
+      addTstr(&cborBuffer, "key");
+      addBool(&cborBuffer, 1);
+      addSortedMapKey(&cborBuffer, &sortedMap);
+      addMappedInt(&cborBuffer, -1, 256);
+      addSortedMapKey(&cborBuffer, &sortedMap);
+      addMappedTstr(&cborBuffer, 10, "ten");
+    endSortedMap(&cborBuffer, &sortedMap);
+    printCborBuffer(&cborBuffer, "Sorted CBOR map");
 }
\ No newline at end of file
@@ -0,0 +1,10 @@
+#!/bin/bash
+
+# Rudimentary Linux bash script for building and running the D-CBOR encoder test.
+#
+# Run from any directory: $ bash path-to-this-script
+#
+pushd $(dirname "${BASH_SOURCE[0]}")
+gcc -o demo -Os -DPLATFORM_SUPPORTS_FLOAT_CAST -DINDEFINITE_LENGTH_EMULATION -I ../lib encoder-test.c ../lib/*.c
+./demo
+popd
@@ -0,0 +1,308 @@
+// encoder-test.c
+
+// Checks encoder features that are not covered by ieee754-test.
+
+#include <d-cbor.h>
+
+#include <string.h>
+#include <stdio.h>
+
+static int failures = 0;
+
+static void check(int ok, const char* what) {
+    if (!ok) {
+        printf("\n*** failed on %s ***\n", what);
+        failures++;
+    }
+}
+
+static const uint8_t BSTR[] = { 1, 2, 3, 4, 5 };
+
+// The same document with the checked emitters.
+static void addDocument(CBOR_BUFFER* cborBuffer) {
+    addMap(cborBuffer, 4);
+    addInt(cborBuffer, 1);
+    addTstr(cborBuffer, "sensor");
+    addInt(cborBuffer, 2);
+    addBstr(cborBuffer, BSTR, sizeof(BSTR));
+    addInt(cborBuffer, 3);
+    addArray(cborBuffer, 3);
+    addInt(cborBuffer, -1000000);
+    addInt(cborBuffer, 23);
+    addInt(cborBuffer, 0x123456789);
+    addInt(cborBuffer, 4);
+    addInt(cborBuffer, -24);
+}
+
+// ...and with one reservation for all of it.
+static void addDocumentUnchecked(CBOR_BUFFER* cborBuffer, size_t length) {
+    if (!reserveBytes(cborBuffer, length)) {
+        return;
+    }
+    addMapUnchecked(cborBuffer, 4);
+    addIntUnchecked(cborBuffer, 1);
+    addTstrUnchecked(cborBuffer, "sensor");
+    addIntUnchecked(cborBuffer, 2);
+    addBstrUnchecked(cborBuffer, BSTR, sizeof(BSTR));
+    addIntUnchecked(cborBuffer, 3);
+    addArrayUnchecked(cborBuffer, 3);
+    addIntUnchecked(cborBuffer, -1000000);
+    addIntUnchecked(cborBuffer, 23);
+    addIntUnchecked(cborBuffer, 0x123456789);
+    addIntUnchecked(cborBuffer, 4);
+    addIntUnchecked(cborBuffer, -24);
+}
+
+static void reserveTest(void) {
+    uint8_t expected[100];
+    uint8_t actual[100];
+    CBOR_BUFFER cborBuffer;
+
+    initCborBuffer(&cborBuffer, expected, sizeof(expected));
+    addDocument(&cborBuffer);
+    size_t length = cborBuffer.pos;
+    check(cborBuffer.length != 0, "checked document");
+
+    // Reserving exactly the size of the document is enough.
+    initCborBuffer(&cborBuffer, actual, length);
+    addDocumentUnchecked(&cborBuffer, length);
+    check(cborBuffer.length != 0 && cborBuffer.pos == length && !memcmp(expected, actual, length),
+          "unchecked document");
+
+    // One byte short fails before anything is written.
+    initCborBuffer(&cborBuffer, actual, length - 1);
+    addDocumentUnchecked(&cborBuffer, length);
+    check(cborBuffer.length == 0 && cborBuffer.pos == 0, "unchecked document overflow");
+
+    // A buffer that ends exactly after an item: the item fits, the next one does not.
+    initCborBuffer(&cborBuffer, actual, 9);  // a4 01 66 "sensor"
+    addMap(&cborBuffer, 4);
+    addInt(&cborBuffer, 1);
+    check(reserveBytes(&cborBuffer, 7) && cborBuffer.length == 9, "reserve to the end");
+    addTstrUnchecked(&cborBuffer, "sensor");
+    check(cborBuffer.pos == 9 && !memcmp(expected, actual, 9), "item at the end");
+    check(!reserveBytes(&cborBuffer, 1) && cborBuffer.length == 0 && cborBuffer.pos == 9,
+          "reserve past the end");
+
+    // The checked emitters stop at the same boundary.
+    initCborBuffer(&cborBuffer, actual, 9);
+    addDocument(&cborBuffer);
+    check(cborBuffer.length == 0 && cborBuffer.pos == 9 && !memcmp(expected, actual, 9),
+          "checked emitters past the end");
+}
+
+// Collects what the sink is handed, refusing it once "limit" would be exceeded.
+typedef struct {
+    uint8_t data[200];
+    size_t length;
+    size_t limit;
+    int calls;
+} SINK_OUTPUT;
+
+static int collect(void* sinkContext, const uint8_t* data, size_t length) {
+    SINK_OUTPUT* output = (SINK_OUTPUT*)sinkContext;
+    output->calls++;
+    if (output->length + length > output->limit) {
+        return 0;
+    }
+    memcpy(&output->data[output->length], data, length);
+    output->length += length;
+    return 1;
+}
+
+static const char LONG_TSTR[] = "A text string that is longer than most of the sink buffers";
+
+// A document with strings longer than the smaller sink buffers.
+static void addLongDocument(CBOR_BUFFER* cborBuffer) {
+    addArray(cborBuffer, 3);
+    addDocument(cborBuffer);
+    addTstr(cborBuffer, LONG_TSTR);
+    addBstr(cborBuffer, (const uint8_t*)LONG_TSTR, sizeof(LONG_TSTR));
+}
+
+static void sinkTest(void) {
+    uint8_t expected[200];
+    uint8_t buffer[200];
+    CBOR_BUFFER cborBuffer;
+    char what[60];
+
+    initCborBuffer(&cborBuffer, expected, sizeof(expected));
+    addLongDocument(&cborBuffer);
+    size_t length = cborBuffer.pos;
+    check(cborBuffer.length != 0, "fixed buffer document");
+
+    for (size_t bufferSize = 1; bufferSize <= length + 1; bufferSize++) {
+        static SINK_OUTPUT output;
+        output.length = 0;
+        output.limit = sizeof(output.data);
+        output.calls = 0;
+        initCborSink(&cborBuffer, buffer, bufferSize, collect, &output);
+        addLongDocument(&cborBuffer);
+        int flushed = flushCborBuffer(&cborBuffer);
+        snprintf(what, sizeof(what), "sink buffer of %zu bytes", bufferSize);
+        if (bufferSize < CBOR_MAX_HEAD_SIZE) {
+            // The heads, up to 9 bytes, are never split, strings are.
+            check(!flushed && cborBuffer.length == 0 && !memcmp(expected, output.data, output.length), what);
+        } else {
+            check(flushed && cborBuffer.flushed == length && output.length == length &&
+                  !memcmp(expected, output.data, length), what);
+        }
+    }
+
+    // A sink that fails part way stops the encoding with length 0.
+    for (size_t limit = 0; limit < length; limit += 7) {
+        static SINK_OUTPUT output;
+        output.length = 0;
+        output.limit = limit;
+        output.calls = 0;
+        initCborSink(&cborBuffer, buffer, 16, collect, &output);
+        addLongDocument(&cborBuffer);
+        int flushed = flushCborBuffer(&cborBuffer);
+        snprintf(what, sizeof(what), "sink failing after %zu bytes", limit);
+        check(!flushed && cborBuffer.length == 0 && output.length <= limit &&
+              !memcmp(expected, output.data, output.length), what);
+        // Nothing more goes to the sink after it failed.
+        int calls = output.calls;
+        addInt(&cborBuffer, 1);
+        check(!flushCborBuffer(&cborBuffer) && output.calls == calls, "sink after failure");
+    }
+}
+
+#define MAX_KEYS 3000
+
+// Map entries in a scrambled order.  Even numbers become integer keys and
+// odd ones text keys, so keys of several lengths and types are mixed.
+// With "duplicate" set one key occurs twice.
+static void addScrambledMap(CBOR_BUFFER* cborBuffer, int keys, int duplicate) {
+    static CBOR_MAP_ENTRY entries[MAX_KEYS];
+    CBOR_SORTED_MAP sortedMap;
+    beginSortedMap(cborBuffer, &sortedMap, entries, keys);
+    for (int i = 0; i < keys; i++) {
+        int key = (int)(((unsigned)i * 7919u + 13u) % (unsigned)keys);
+        if (duplicate && i == keys - 1) {
+            key = (int)(13u % (unsigned)keys);  // The first key
+        }
+        addSortedMapKey(cborBuffer, &sortedMap);
+        if (key & 1) {
+            char text[20];
+            snprintf(text, sizeof(text), "k%d", key * 37);
+            addTstr(cborBuffer, text);
+        } else {
+            addInt(cborBuffer, key % 4 ? key * 1000 : -key);
+        }
+        addInt(cborBuffer, i);
+    }
+    endSortedMap(cborBuffer, &sortedMap);
+}
+
+static void sortedMapTest(void) {
+    static uint8_t expected[MAX_KEYS * 16];
+    static uint8_t actual[MAX_KEYS * 16];
+    static const int keyCounts[] = { 0, 1, 2, 3, 4, 5, 7, 10, 33, 100, 1000, MAX_KEYS };
+    CBOR_BUFFER cborBuffer;
+    char what[60];
+
+    for (size_t q = 0; q < sizeof(keyCounts) / sizeof(keyCounts[0]); q++) {
+        int keys = keyCounts[q];
+        // The size, from a dry run.
+        initCborDryRun(&cborBuffer);
+        addScrambledMap(&cborBuffer, keys, 0);
+        size_t length = cborBuffer.pos;
+
+        // With room for a scratch copy of the map.
+        initCborBuffer(&cborBuffer, expected, sizeof(expected));
+        addScrambledMap(&cborBuffer, keys, 0);
+        snprintf(what, sizeof(what), "sorted map of %d keys", keys);
+        check(cborBuffer.length != 0 && cborBuffer.pos == length && isSortedMap(&cborBuffer, 0), what);
+
+        // Without, sorting within the map itself.
+        initCborBuffer(&cborBuffer, actual, length);
+        addScrambledMap(&cborBuffer, keys, 0);
+        snprintf(what, sizeof(what), "sorted map of %d keys in place", keys);
+        check(cborBuffer.length != 0 && cborBuffer.pos == length && !memcmp(expected, actual, length), what);
+
+        if (keys > 1) {
+            initCborBuffer(&cborBuffer, expected, sizeof(expected));
+            addScrambledMap(&cborBuffer, keys, 1);
+            snprintf(what, sizeof(what), "duplicate key in %d keys", keys);
+            check(cborBuffer.length == 0, what);
+            initCborBuffer(&cborBuffer, actual, length);
+            addScrambledMap(&cborBuffer, keys, 1);
+            snprintf(what, sizeof(what), "duplicate key in %d keys in place", keys);
+            check(cborBuffer.length == 0, what);
+        }
+    }
+
+    // Fewer or more keys than declared.
+    CBOR_MAP_ENTRY entries[3];
+    CBOR_SORTED_MAP sortedMap;
+    initCborBuffer(&cborBuffer, actual, sizeof(actual));
+    beginSortedMap(&cborBuffer, &sortedMap, entries, 3);
+    for (int i = 0; i < 2; i++) {
+        addSortedMapKey(&cborBuffer, &sortedMap);
+        addInt(&cborBuffer, 2 - i);
+        addInt(&cborBuffer, i);
+    }
+    check(!endSortedMap(&cborBuffer, &sortedMap) && cborBuffer.length == 0, "too few keys");
+
+    initCborBuffer(&cborBuffer, actual, sizeof(actual));
+    beginSortedMap(&cborBuffer, &sortedMap, entries, 3);
+    for (int i = 0; i < 4; i++) {
+        addSortedMapKey(&cborBuffer, &sortedMap);
+        addInt(&cborBuffer, 4 - i);
+        addInt(&cborBuffer, i);
+    }
+    check(!endSortedMap(&cborBuffer, &sortedMap) && cborBuffer.length == 0, "too many keys");
+}
+
+#ifdef INDEFINITE_LENGTH_EMULATION
+static void fixupTest(void) {
+    uint8_t buffer[16];
+    CBOR_BUFFER cborBuffer;
+    CBOR_FIXUP fixups[3];
+    CBOR_FIXUP_LIST fixupList;
+
+    // [[1, 2], 3]
+    static const uint8_t expected[] = { 0x82, 0x82, 0x01, 0x02, 0x03 };
+    initCborBuffer(&cborBuffer, buffer, sizeof(buffer));
+    initFixupList(&cborBuffer, &fixupList, fixups, 2);
+    int outer = addArrayPlaceholder(&cborBuffer, &fixupList);
+    int inner = addArrayPlaceholder(&cborBuffer, &fixupList);
+    addInt(&cborBuffer, 1);
+    addInt(&cborBuffer, 2);
+    setPlaceholder(&fixupList, inner, 2);
+    addInt(&cborBuffer, 3);
+    setPlaceholder(&fixupList, outer, 2);
+    check(resolveFixups(&cborBuffer, &fixupList) && cborBuffer.pos == sizeof(expected) &&
+          !memcmp(buffer, expected, sizeof(expected)), "fixups");
+
+    // A full list must fail without touching fixups beyond the list.
+    for (int maxFixups = 0; maxFixups < 2; maxFixups++) {
+        fixups[maxFixups].elements = -1;
+        initCborBuffer(&cborBuffer, buffer, sizeof(buffer));
+        initFixupList(&cborBuffer, &fixupList, fixups, maxFixups);
+        int first = addArrayPlaceholder(&cborBuffer, &fixupList);
+        int failed = maxFixups ? addArrayPlaceholder(&cborBuffer, &fixupList) : first;
+        check(failed == -1 && cborBuffer.length == 0, "placeholder overflow");
+        setPlaceholder(&fixupList, failed, 1);
+        setPlaceholder(&fixupList, maxFixups, 1);
+        check(fixups[maxFixups].elements == -1, "ignored placeholder");
+        check(!resolveFixups(&cborBuffer, &fixupList), "fixups after overflow");
+    }
+}
+#endif
+
+int main(int argc, const char* argv[]) {
+    (void)argc; // Avoid unused parameter error
+    (void)argv;
+
+    reserveTest();
+    sinkTest();
+    sortedMapTest();
+#ifdef INDEFINITE_LENGTH_EMULATION
+    fixupTest();
+#endif
+
+    printf(failures ? "Failed!\n" : "Done!\n");
+    return failures != 0;
+}
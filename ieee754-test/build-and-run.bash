@@ -7,4 +7,9 @@
 pushd $(dirname "${BASH_SOURCE[0]}")
 gcc -o demo -Os -DPLATFORM_SUPPORTS_FLOAT_CAST -I ../lib ieee754-test.c ../lib/*.c
 ./demo
+if grep -q avx2 /proc/cpuinfo && grep -q f16c /proc/cpuinfo; then
+  # The same tests using the AVX2/F16C array classifier.
+  gcc -o demo -Os -mavx2 -mf16c -DPLATFORM_SUPPORTS_FLOAT_CAST -I ../lib ieee754-test.c ../lib/*.c
+  ./demo
+fi
 popd
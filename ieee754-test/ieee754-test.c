@@ -9,13 +9,17 @@
 
 #define BUFFER_SIZE 30
 
+#define MAX_VECTORS 50
+
+// The values of oneTurn(), for arrayTurn().
+static double vectors[MAX_VECTORS];
+static int vectorCount = 0;
+
 void oneTurn(char* valueText, char* cborHex) {
     // Buffer setup, here using the stack for storage.
     unsigned char outputBuffer[BUFFER_SIZE];
     CBOR_BUFFER cborBuffer;
-    cborBuffer.data = outputBuffer;
-    cborBuffer.length = BUFFER_SIZE;
-    cborBuffer.pos = 0;
+    initCborBuffer(&cborBuffer, outputBuffer, BUFFER_SIZE);
 
     double value = 0;
     if (!strcmp(valueText, "NaN")) {
@@ -27,13 +31,16 @@ void oneTurn(char* valueText, char* cborHex) {
     } else {
         value = atof(valueText);
     }
+    if (vectorCount < MAX_VECTORS) {
+        vectors[vectorCount++] = value;
+    }
     // One elemnt only.
     addDouble(&cborBuffer, value);
     
     // Compare the result with the expected hex string.
     char result[40] = { 0 };
     if (cborBuffer.length) {
-        for (int i = 0; i < cborBuffer.pos; i++) {
+        for (size_t i = 0; i < cborBuffer.pos; i++) {
 #ifdef _WIN32
             sprintf_s(&result[i << 1], 20, "%02x", (int)cborBuffer.data[i]);
 #else
@@ -49,6 +56,114 @@ void oneTurn(char* valueText, char* cborHex) {
     }
 }
 
+#define ARRAY_SIZE 1000
+
+static uint8_t sinkData[ARRAY_SIZE * 9 + 10];
+static size_t sinkLength;
+
+static int collect(void* sinkContext, const uint8_t* data, size_t length) {
+    (void)sinkContext;
+    memcpy(&sinkData[sinkLength], data, length);
+    sinkLength += length;
+    return 1;
+}
+
+// In sink mode, blocks larger than the sink buffer must be split.
+void sinkTurn(const char* what, const double* doubles, const int64_t* ints,
+              const uint8_t* expected, size_t expectedLength) {
+    static const size_t bufferSizes[] = { 9, 10, 14, 17, 30, 100, 1000 };
+    uint8_t buffer[1000];
+    for (size_t i = 0; i < sizeof(bufferSizes) / sizeof(bufferSizes[0]); i++) {
+        CBOR_BUFFER cborBuffer;
+        sinkLength = 0;
+        initCborSink(&cborBuffer, buffer, bufferSizes[i], collect, NULL);
+        if (ints) {
+            addInt64Array(&cborBuffer, ints, ARRAY_SIZE);
+        } else {
+            addDoubleArray(&cborBuffer, doubles, ARRAY_SIZE);
+        }
+        if (!flushCborBuffer(&cborBuffer) || sinkLength != expectedLength ||
+            memcmp(expected, sinkData, expectedLength)) {
+            printf("\n*** failed on %s array with a %zu byte sink buffer ***\n", what, bufferSizes[i]);
+        }
+    }
+}
+
+// Bulk encoding must be identical to encoding element by element.
+void arrayTurn(void) {
+    static double doubles[ARRAY_SIZE];
+    static float floats[ARRAY_SIZE];
+    static int64_t ints[ARRAY_SIZE];
+    static uint8_t expected[ARRAY_SIZE * 9 + 10];
+    static uint8_t actual[ARRAY_SIZE * 9 + 10];
+    uint64_t seed = 1;
+    for (int i = 0; i < ARRAY_SIZE; i++) {
+        // Mix of random bit patterns and values of limited precision.
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        uint64_t bitFormat = seed;
+        uint32_t floatBinary = (uint32_t)(seed >> 32);
+        if (i % 3 == 1) {
+            bitFormat &= 0xfff0fc0000000000ull;
+            floatBinary &= 0xffffe000;
+        }
+        memcpy(&doubles[i], &bitFormat, sizeof(double));
+        memcpy(&floats[i], &floatBinary, sizeof(float));
+        ints[i] = (int64_t)seed >> (i % 64);
+    }
+    doubles[7] = NAN;
+    doubles[8] = -INFINITY;
+    doubles[9] = -0.0;
+    floats[7] = NAN;
+    // The single value test vectors, across a block boundary.
+    for (int i = 0; i < vectorCount; i++) {
+        doubles[40 + i] = vectors[i];
+        floats[40 + i] = (float)vectors[i];
+    }
+
+    CBOR_BUFFER cborBuffer;
+    initCborBuffer(&cborBuffer, expected, sizeof(expected));
+    addArray(&cborBuffer, ARRAY_SIZE);
+    for (int i = 0; i < ARRAY_SIZE; i++) {
+        addInt(&cborBuffer, ints[i]);
+    }
+    size_t expectedLength = cborBuffer.pos;
+    initCborBuffer(&cborBuffer, actual, sizeof(actual));
+    addInt64Array(&cborBuffer, ints, ARRAY_SIZE);
+    if (!cborBuffer.length || cborBuffer.pos != expectedLength || memcmp(expected, actual, expectedLength)) {
+        printf("\n*** failed on int64 array ***\n");
+    }
+    sinkTurn("int64", NULL, ints, expected, expectedLength);
+
+    for (int pass = 0; pass < 2; pass++) {
+        initCborBuffer(&cborBuffer, expected, sizeof(expected));
+        addArray(&cborBuffer, ARRAY_SIZE);
+        for (int i = 0; i < ARRAY_SIZE; i++) {
+            addDouble(&cborBuffer, pass ? floats[i] : doubles[i]);
+        }
+        expectedLength = cborBuffer.pos;
+
+        initCborBuffer(&cborBuffer, actual, sizeof(actual));
+        if (pass) {
+            addFloatArray(&cborBuffer, floats, ARRAY_SIZE);
+        } else {
+            addDoubleArray(&cborBuffer, doubles, ARRAY_SIZE);
+        }
+        if (!cborBuffer.length || cborBuffer.pos != expectedLength || memcmp(expected, actual, expectedLength)) {
+            printf("\n*** failed on %s array ***\n", pass ? "float" : "double");
+        }
+        if (!pass) {
+            sinkTurn("double", doubles, NULL, expected, expectedLength);
+        }
+
+        // Not enough space must be reported as overflow.
+        initCborBuffer(&cborBuffer, actual, expectedLength - 1);
+        addDoubleArray(&cborBuffer, doubles, ARRAY_SIZE);
+        if (cborBuffer.length) {
+            printf("\n*** failed on array overflow ***\n");
+        }
+    }
+}
+
 int main(int argc, const char* argv[]) {
     (void)argc; // Avoid unused parameter error
 
@@ -90,5 +205,7 @@ int main(int argc, const char* argv[]) {
     oneTurn("5.0e-324",                 "fb0000000000000001");
     oneTurn("-1.7976931348623157e+308", "fbffefffffffffffff");
 
+    arrayTurn();
+
     printf("Done!\n");
 }
\ No newline at end of file
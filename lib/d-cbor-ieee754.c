@@ -23,6 +23,14 @@
 
 #include "d-cbor.h"
 
+#if defined(__AVX2__) && defined(__F16C__)
+#include <immintrin.h>
+#define ARRAY_CLASSIFIER_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define ARRAY_CLASSIFIER_SSE2
+#endif
+
 static const int FLOAT16_SIGNIFICAND_SIZE = 10;
 static const int FLOAT32_SIGNIFICAND_SIZE = 23;
 static const int FLOAT64_SIGNIFICAND_SIZE = 52;
@@ -51,11 +59,17 @@ static const uint64_t FLOAT64_NEG_ZERO     = 0x8000000000000000ul;
 
 static const uint64_t ONE                  = 0x0000000000000001ul;
 
+static const int MT_ARRAY   = 0x80;
 static const int MT_FLOAT16 = 0xf9;
 static const int MT_FLOAT32 = 0xfa;
 static const int MT_FLOAT64 = 0xfb;
 
-void addDouble(CBOR_BUFFER *cborBuffer, double d) {
+// Number of array elements classified and encoded at a time.
+#define ARRAY_BLOCK 64
+
+// Returns the shortest tag (MT_FLOAT16, MT_FLOAT32 or MT_FLOAT64) and the
+// corresponding bit pattern for "d".
+static int reduceDouble(double d, uint64_t* result) {
 
     // Initial assumption: the number is a plain vanilla 64-bit double.
  
@@ -189,5 +203,117 @@ void addDouble(CBOR_BUFFER *cborBuffer, double d) {
         significand;
 
 done:
+    *result = bitFormat;
+    return tag;
+}
+
+void addDouble(CBOR_BUFFER *cborBuffer, double d) {
+    uint64_t bitFormat;
+    int tag = reduceDouble(d, &bitFormat);
     encodeTagAndValue(cborBuffer, tag, 2 << (tag - MT_FLOAT16), bitFormat);
-}
\ No newline at end of file
+}
+
+// Finds the shortest representation of each element in a block and returns
+// the number of bytes needed for encoding the block.  Note: the SIMD paths
+// presume the default floating point environment (no flush-to-zero).
+static size_t classifyBlock(const double* values, int count, uint8_t* tags, uint64_t* bitFormats) {
+    size_t blockSize = 0;
+    int q = 0;
+#if defined(ARRAY_CLASSIFIER_AVX2)
+    for (; q + 4 <= count; q += 4) {
+        __m256d d = _mm256_loadu_pd(&values[q]);
+        __m128 f = _mm256_cvtpd_ps(d);
+        __m128i h = _mm_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT);
+        // Lanes that survive a round trip are exact.  NaN never does.
+        int fitsFloat32 = _mm256_movemask_pd(_mm256_cmp_pd(d, _mm256_cvtps_pd(f), _CMP_EQ_OQ));
+        int fitsFloat16 = _mm_movemask_ps(_mm_cmpeq_ps(f, _mm_cvtph_ps(h)));
+        int notNumber = _mm256_movemask_pd(_mm256_cmp_pd(d, d, _CMP_UNORD_Q));
+        float floats[4];
+        uint16_t halfs[8];
+        _mm_storeu_ps(floats, f);
+        _mm_storeu_si128((__m128i*)halfs, h);
+        for (int lane = 0; lane < 4; lane++) {
+            int bit = 1 << lane;
+            if (notNumber & bit) {
+                tags[q + lane] = (uint8_t)reduceDouble(values[q + lane], &bitFormats[q + lane]);
+            } else if (fitsFloat16 & fitsFloat32 & bit) {
+                tags[q + lane] = (uint8_t)MT_FLOAT16;
+                bitFormats[q + lane] = halfs[lane];
+            } else if (fitsFloat32 & bit) {
+                uint32_t floatBinary;
+                memcpy(&floatBinary, &floats[lane], sizeof(float));
+                tags[q + lane] = (uint8_t)MT_FLOAT32;
+                bitFormats[q + lane] = floatBinary;
+            } else {
+                tags[q + lane] = (uint8_t)MT_FLOAT64;
+                memcpy(&bitFormats[q + lane], &values[q + lane], sizeof(double));
+            }
+        }
+    }
+#elif defined(ARRAY_CLASSIFIER_SSE2)
+    for (; q + 2 <= count; q += 2) {
+        __m128d d = _mm_loadu_pd(&values[q]);
+        // Only elements that are exact as float32 need the complete reduction.
+        int fitsFloat32 = _mm_movemask_pd(_mm_cmpeq_pd(d, _mm_cvtps_pd(_mm_cvtpd_ps(d))));
+        int notNumber = _mm_movemask_pd(_mm_cmpunord_pd(d, d));
+        for (int lane = 0; lane < 2; lane++) {
+            if ((fitsFloat32 | notNumber) & (1 << lane)) {
+                tags[q + lane] = (uint8_t)reduceDouble(values[q + lane], &bitFormats[q + lane]);
+            } else {
+                tags[q + lane] = (uint8_t)MT_FLOAT64;
+                memcpy(&bitFormats[q + lane], &values[q + lane], sizeof(double));
+            }
+        }
+    }
+#endif
+    for (; q < count; q++) {
+        tags[q] = (uint8_t)reduceDouble(values[q], &bitFormats[q]);
+    }
+    for (q = 0; q < count; q++) {
+        blockSize += 1 + (2 << (tags[q] - MT_FLOAT16));
+    }
+    return blockSize;
+}
+
+static int encodeBlock(CBOR_BUFFER* cborBuffer, const double* values, int count) {
+    uint8_t tags[ARRAY_BLOCK];
+    uint64_t bitFormats[ARRAY_BLOCK];
+    size_t blockSize = classifyBlock(values, count, tags, bitFormats);
+    // A block that does not fit a sink buffer is reserved element by element.
+    int perElement = cborBuffer->sink && blockSize > cborBuffer->length;
+    if (!perElement && !reserveBytes(cborBuffer, blockSize)) {
+        return 0;
+    }
+    for (int q = 0; q < count; q++) {
+        int length = 2 << (tags[q] - MT_FLOAT16);
+        if (perElement && !reserveBytes(cborBuffer, 1 + (size_t)length)) {
+            return 0;
+        }
+        encodeTagAndValueUnchecked(cborBuffer, tags[q], length, bitFormats[q]);
+    }
+    return 1;
+}
+
+void addDoubleArray(CBOR_BUFFER* cborBuffer, const double* values, size_t count) {
+    encodeTagAndN(cborBuffer, MT_ARRAY, count);
+    for (size_t i = 0; i < count; i += ARRAY_BLOCK) {
+        int blockCount = count - i < ARRAY_BLOCK ? (int)(count - i) : ARRAY_BLOCK;
+        if (!encodeBlock(cborBuffer, &values[i], blockCount)) {
+            return;
+        }
+    }
+}
+
+void addFloatArray(CBOR_BUFFER* cborBuffer, const float* values, size_t count) {
+    double block[ARRAY_BLOCK];
+    encodeTagAndN(cborBuffer, MT_ARRAY, count);
+    for (size_t i = 0; i < count; i += ARRAY_BLOCK) {
+        int blockCount = count - i < ARRAY_BLOCK ? (int)(count - i) : ARRAY_BLOCK;
+        for (int q = 0; q < blockCount; q++) {
+            block[q] = values[i + q];
+        }
+        if (!encodeBlock(cborBuffer, block, blockCount)) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,325 @@
+/*
+ *  Copyright 2006-2022 WebPKI.org (https://webpki.org).
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+            ////////////////////////////////////////
+            // D-CBOR - Automatic map key sorting //
+            ////////////////////////////////////////
+
+#include <string.h>
+
+#include "d-cbor.h"
+
+static const int MT_BYTE_STRING   = 0x40;
+static const int MT_TEXT_STRING   = 0x60;
+static const int MT_ARRAY         = 0x80;
+static const int MT_MAP           = 0xa0;
+static const int MT_TAG_EXTENSION = 0xc0;
+static const int MT_SIMPLE        = 0xe0;
+
+// Returns the length of the (definite-length) CBOR item at "data",
+// or 0 if the item is malformed or does not fit in "length" bytes.
+static size_t skipItem(const uint8_t* data, size_t length) {
+    size_t pos = 0;
+    uint64_t remaining = 1;
+    while (remaining--) {
+        if (pos >= length) {
+            return 0;
+        }
+        int initialByte = data[pos++];
+        int majorType = initialByte & 0xe0;
+        int modifier = initialByte & 0x1f;
+        uint64_t n = modifier;
+        if (modifier > 27) {
+            return 0;  // Indefinite length is not D-CBOR.
+        }
+        if (modifier > 23) {
+            size_t argumentLength = (size_t)1 << (modifier - 24);
+            if (argumentLength > length - pos) {
+                return 0;
+            }
+            n = 0;
+            while (argumentLength--) {
+                n = (n << 8) | data[pos++];
+            }
+        }
+        if (majorType == MT_BYTE_STRING || majorType == MT_TEXT_STRING) {
+            if (n > length - pos) {
+                return 0;
+            }
+            pos += (size_t)n;
+        } else if (majorType == MT_ARRAY || majorType == MT_MAP || majorType == MT_TAG_EXTENSION) {
+            uint64_t items = majorType == MT_MAP ? n << 1 : majorType == MT_ARRAY ? n : 1;
+            if (items > length - pos) {
+                return 0;  // Every item needs at least one byte.
+            }
+            remaining += items;
+        } else if (majorType == MT_SIMPLE && modifier == 24 && n < 32) {
+            return 0;
+        }
+    }
+    return pos;
+}
+
+static int compareKeys(const uint8_t* data, const CBOR_MAP_ENTRY* a, const CBOR_MAP_ENTRY* b) {
+    size_t length = a->keyLength < b->keyLength ? a->keyLength : b->keyLength;
+    int result = memcmp(&data[a->start], &data[b->start], length);
+    if (result == 0 && a->keyLength != b->keyLength) {
+        result = a->keyLength < b->keyLength ? -1 : 1;
+    }
+    return result;
+}
+
+// Plain heapsort: O(n log n) without recursion or allocation.
+static void siftDown(const uint8_t* data, CBOR_MAP_ENTRY* entries, int root, int count) {
+    for (;;) {
+        int child = 2 * root + 1;
+        if (child >= count) {
+            return;
+        }
+        if (child + 1 < count && compareKeys(data, &entries[child], &entries[child + 1]) < 0) {
+            child++;
+        }
+        if (compareKeys(data, &entries[root], &entries[child]) >= 0) {
+            return;
+        }
+        CBOR_MAP_ENTRY temp = entries[root];
+        entries[root] = entries[child];
+        entries[child] = temp;
+        root = child;
+    }
+}
+
+static void sortEntries(const uint8_t* data, CBOR_MAP_ENTRY* entries, int count) {
+    for (int i = count / 2 - 1; i >= 0; i--) {
+        siftDown(data, entries, i, count);
+    }
+    for (int i = count - 1; i > 0; i--) {
+        CBOR_MAP_ENTRY temp = entries[0];
+        entries[0] = entries[i];
+        entries[i] = temp;
+        siftDown(data, entries, 0, i);
+    }
+}
+
+static void reverseBytes(uint8_t* data, size_t length) {
+    uint8_t* end = data + length;
+    while (data < --end) {
+        uint8_t temp = *data;
+        *data++ = *end;
+        *end = temp;
+    }
+}
+
+static void reverseEntries(CBOR_MAP_ENTRY* entries, int count) {
+    CBOR_MAP_ENTRY* end = entries + count;
+    while (entries < --end) {
+        CBOR_MAP_ENTRY temp = *entries;
+        *entries++ = *end;
+        *end = temp;
+    }
+}
+
+// Swaps the adjacent entries [first..middle) and [middle..last), both in
+// the buffer and in "entries", using three reversals.
+static void rotateEntries(uint8_t* data, CBOR_MAP_ENTRY* entries, int first, int middle, int last) {
+    size_t start = entries[first].start;
+    size_t split = entries[middle].start;
+    size_t end = entries[last - 1].start + entries[last - 1].length;
+    reverseBytes(&data[start], split - start);
+    reverseBytes(&data[split], end - split);
+    reverseBytes(&data[start], end - start);
+    reverseEntries(&entries[first], middle - first);
+    reverseEntries(&entries[middle], last - middle);
+    reverseEntries(&entries[first], last - first);
+    for (int i = first; i < last; i++) {
+        entries[i].start = start;
+        start += entries[i].length;
+    }
+}
+
+// First entry in [first..last) with a key that is not less than (or if
+// "orEqual" is set, greater than) the key of "sought".
+static int searchEntries(const uint8_t* data, const CBOR_MAP_ENTRY* entries, int first, int last,
+                         const CBOR_MAP_ENTRY* sought, int orEqual) {
+    while (first < last) {
+        int middle = first + (last - first) / 2;
+        int result = compareKeys(data, &entries[middle], sought);
+        if (result < 0 || (orEqual && result == 0)) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+// Merges the sorted entries [first..middle) and [middle..last) without a
+// buffer: the larger half is split in the middle, the other half where
+// that key belongs, and the two inner parts swap places by a rotation.
+// Every level moves each byte at most a few times.
+static void mergeEntries(uint8_t* data, CBOR_MAP_ENTRY* entries, int first, int middle, int last) {
+    while (first < middle && middle < last) {
+        if (last - first == 2) {
+            if (compareKeys(data, &entries[middle], &entries[first]) < 0) {
+                rotateEntries(data, entries, first, middle, last);
+            }
+            return;
+        }
+        int firstCut, secondCut;
+        if (middle - first > last - middle) {
+            firstCut = first + (middle - first) / 2;
+            CBOR_MAP_ENTRY sought = entries[firstCut];
+            secondCut = searchEntries(data, entries, middle, last, &sought, 0);
+        } else {
+            secondCut = middle + (last - middle) / 2;
+            CBOR_MAP_ENTRY sought = entries[secondCut];
+            firstCut = searchEntries(data, entries, first, middle, &sought, 1);
+        }
+        int newMiddle = firstCut + (secondCut - middle);
+        if (firstCut < middle && middle < secondCut) {
+            rotateEntries(data, entries, firstCut, middle, secondCut);
+        }
+        mergeEntries(data, entries, first, firstCut, newMiddle);
+        first = newMiddle;
+        middle = secondCut;
+    }
+}
+
+// Sorts the entries, which must be in buffer order, by moving them within
+// the map itself.  Used when there is not enough free space in the buffer
+// for a scratch copy of the map.  O(n log^2 n) byte moves, recursion depth
+// O(log n) and no allocation.
+static void sortEntriesInPlace(uint8_t* data, CBOR_MAP_ENTRY* entries, int count) {
+    for (int width = 1; width < count; width *= 2) {
+        for (int first = 0; first + width < count; first += 2 * width) {
+            int last = count - first > 2 * width ? first + 2 * width : count;
+            mergeEntries(data, entries, first, first + width, last);
+        }
+    }
+}
+
+static int hasDuplicateKeys(const uint8_t* data, const CBOR_MAP_ENTRY* entries, int count) {
+    for (int i = 1; i < count; i++) {
+        if (compareKeys(data, &entries[i - 1], &entries[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int sortedMapFailure(CBOR_BUFFER* cborBuffer) {
+    cborBuffer->length = 0;  // Indication to upper layers.
+    return 0;
+}
+
+void beginSortedMap(CBOR_BUFFER* cborBuffer, CBOR_SORTED_MAP* sortedMap,
+                    CBOR_MAP_ENTRY* entries, int keys) {
+    addMap(cborBuffer, keys);
+    sortedMap->entries = entries;
+    sortedMap->keys = keys;
+    sortedMap->count = 0;
+    sortedMap->flushed = cborBuffer->flushed;
+}
+
+void addSortedMapKey(CBOR_BUFFER* cborBuffer, CBOR_SORTED_MAP* sortedMap) {
+    if (sortedMap->count >= sortedMap->keys) {
+        sortedMapFailure(cborBuffer);
+    } else {
+        sortedMap->entries[sortedMap->count++].start = cborBuffer->pos;
+    }
+}
+
+int endSortedMap(CBOR_BUFFER* cborBuffer, CBOR_SORTED_MAP* sortedMap) {
+    int count = sortedMap->count;
+    CBOR_MAP_ENTRY* entries = sortedMap->entries;
+    if (cborBuffer->length == 0 || count != sortedMap->keys ||
+        cborBuffer->flushed != sortedMap->flushed) {
+        // Overflow, missing entries or part of the map already sent to a sink.
+        return sortedMapFailure(cborBuffer);
+    }
+    if (count == 0 || cborBuffer->data == NULL) {
+        return 1;  // Nothing to sort or dry-run mode.
+    }
+    uint8_t* data = cborBuffer->data;
+    size_t mapStart = entries[0].start;
+    for (int i = 0; i < count; i++) {
+        size_t end = i == count - 1 ? cborBuffer->pos : entries[i + 1].start;
+        entries[i].length = end - entries[i].start;
+        entries[i].keyLength = skipItem(&data[entries[i].start], entries[i].length);
+        if (entries[i].keyLength == 0 || entries[i].keyLength == entries[i].length) {
+            return sortedMapFailure(cborBuffer);  // Missing key or value.
+        }
+    }
+    size_t mapLength = cborBuffer->pos - mapStart;
+    if (cborBuffer->length - cborBuffer->pos >= mapLength) {
+        sortEntries(data, entries, count);
+        if (hasDuplicateKeys(data, entries, count)) {
+            return sortedMapFailure(cborBuffer);
+        }
+        // Use the free part of the buffer as scratch area.
+        uint8_t* scratch = &data[cborBuffer->pos];
+        size_t q = 0;
+        for (int i = 0; i < count; i++) {
+            memcpy(&scratch[q], &data[entries[i].start], entries[i].length);
+            entries[i].start = mapStart + q;
+            q += entries[i].length;
+        }
+        memcpy(&data[mapStart], scratch, mapLength);
+    } else {
+        sortEntriesInPlace(data, entries, count);
+        if (hasDuplicateKeys(data, entries, count)) {
+            return sortedMapFailure(cborBuffer);
+        }
+    }
+    return 1;
+}
+
+int isSortedMap(const CBOR_BUFFER* cborBuffer, size_t mapPos) {
+    const uint8_t* data = cborBuffer->data;
+    size_t length = cborBuffer->pos;
+    if (data == NULL || mapPos >= length || (data[mapPos] & 0xe0) != MT_MAP) {
+        return 0;
+    }
+    size_t mapLength = skipItem(&data[mapPos], length - mapPos);
+    if (mapLength == 0) {
+        return 0;
+    }
+    // Skip the map head.
+    size_t pos = mapPos + 1;
+    int modifier = data[mapPos] & 0x1f;
+    uint64_t keys = modifier;
+    if (modifier > 23) {
+        size_t argumentLength = (size_t)1 << (modifier - 24);
+        keys = 0;
+        while (argumentLength--) {
+            keys = (keys << 8) | data[pos++];
+        }
+    }
+    CBOR_MAP_ENTRY previous = { 0, 0, 0 };
+    while (keys--) {
+        CBOR_MAP_ENTRY current;
+        current.start = pos;
+        current.keyLength = skipItem(&data[pos], length - pos);
+        if (previous.keyLength && compareKeys(data, &previous, &current) >= 0) {
+            return 0;
+        }
+        pos += current.keyLength;
+        pos += skipItem(&data[pos], length - pos);
+        previous = current;
+    }
+    return 1;
+}
@@ -0,0 +1,189 @@
+/*
+ *  Copyright 2006-2022 WebPKI.org (https://webpki.org).
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+            ///////////////////////////////
+            // D-CBOR - UTF-8 validation //
+            ///////////////////////////////
+
+// Checks text strings according to RFC 3629: no overlong forms, no surrogates
+// and nothing above U+10FFFF.  With SSSE3 enabled at compile time, 16 bytes
+// are checked per step using the nibble lookup method by Keiser and Lemire
+// ("Validating UTF-8 In Less Than One Instruction Per Byte").  Otherwise a
+// portable scalar validator is used which skips ASCII 8 bytes at a time.
+
+#include <string.h>
+
+#include "d-cbor.h"
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define UTF8_VALIDATOR_SSSE3
+#endif
+
+#ifdef UTF8_VALIDATOR_SSSE3
+
+// Error classes of two consecutive bytes.  A pair is invalid if a class
+// is present in all three lookups.
+#define TOO_SHORT   0x01  // 11______ 0_______ or 11______ 11______
+#define TOO_LONG    0x02  // 0_______ 10______
+#define OVERLONG_3  0x04  // 11100000 100_____
+#define TOO_LARGE   0x08  // 11110100 1001____ and above
+#define SURROGATE   0x10  // 11101101 101_____
+#define OVERLONG_2  0x20  // 1100000_ 10______
+#define OVERLONG_4  0x40  // 11110000 1000____, also 11110101+ 1000____
+#define TWO_CONTS   0x80  // 10______ 10______
+
+#define CARRY (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+static __m128i highNibbles(__m128i bytes) {
+    return _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0f));
+}
+
+// Returns non-zero lanes for errors in "input", given the preceding 16 bytes.
+static __m128i checkBlock(__m128i input, __m128i previous) {
+    const __m128i byte1HighTable = _mm_setr_epi8(
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        (char)TWO_CONTS, (char)TWO_CONTS, (char)TWO_CONTS, (char)TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | OVERLONG_4);
+    const __m128i byte1LowTable = _mm_setr_epi8(
+        (char)(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4),
+        (char)(CARRY | OVERLONG_2),
+        (char)CARRY,
+        (char)CARRY,
+        (char)(CARRY | TOO_LARGE),
+        (char)(CARRY | TOO_LARGE | OVERLONG_4),
+        (char)(CARRY | TOO_LARGE | OVERLONG_4),
+        (char)(CARRY | TOO_LARGE | OVERLONG_4),
+        (char)(CARRY | TOO_LARGE | OVERLONG_4),
+        (char)(CARRY | TOO_LARGE | OVERLONG_4),
+        (char)(CARRY | TOO_LARGE | OVERLONG_4),
+        (char)(CARRY | TOO_LARGE | OVERLONG_4),
+        (char)(CARRY | TOO_LARGE | OVERLONG_4),
+        (char)(CARRY | TOO_LARGE | OVERLONG_4 | SURROGATE),
+        (char)(CARRY | TOO_LARGE | OVERLONG_4),
+        (char)(CARRY | TOO_LARGE | OVERLONG_4));
+    const __m128i byte2HighTable = _mm_setr_epi8(
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        (char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | OVERLONG_4),
+        (char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE),
+        (char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+        (char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+    __m128i special = _mm_and_si128(
+        _mm_and_si128(_mm_shuffle_epi8(byte1HighTable, highNibbles(prev1)),
+                      _mm_shuffle_epi8(byte1LowTable, _mm_and_si128(prev1, _mm_set1_epi8(0x0f)))),
+        _mm_shuffle_epi8(byte2HighTable, highNibbles(input)));
+
+    // Third and fourth bytes of multi-byte sequences must be continuations.
+    // These are the only places where TWO_CONTS is expected.
+    __m128i thirdByte = _mm_subs_epu8(_mm_alignr_epi8(input, previous, 14), _mm_set1_epi8((char)(0xe0 - 0x80)));
+    __m128i fourthByte = _mm_subs_epu8(_mm_alignr_epi8(input, previous, 13), _mm_set1_epi8((char)(0xf0 - 0x80)));
+    __m128i expected = _mm_and_si128(_mm_or_si128(thirdByte, fourthByte), _mm_set1_epi8((char)0x80));
+    return _mm_xor_si128(expected, special);
+}
+
+int isValidUtf8(const uint8_t* data, size_t length) {
+    // Non-zero for lead bytes in the last three positions that need more bytes.
+    const __m128i incompleteLimit = _mm_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xf0 - 1), (char)(0xe0 - 1), (char)(0xc0 - 1));
+    __m128i error = _mm_setzero_si128();
+    __m128i previous = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i input = _mm_loadu_si128((const __m128i*)&data[i]);
+        if (_mm_movemask_epi8(input) == 0) {
+            // ASCII only.  Just verify that the previous block did not end prematurely.
+            error = _mm_or_si128(error, incomplete);
+        } else {
+            error = _mm_or_si128(error, checkBlock(input, previous));
+            incomplete = _mm_subs_epu8(input, incompleteLimit);
+        }
+        previous = input;
+    }
+    if (i < length) {
+        // Zero padding makes truncated sequences at the end fail.
+        uint8_t tail[16] = { 0 };
+        memcpy(tail, &data[i], length - i);
+        error = _mm_or_si128(error, checkBlock(_mm_loadu_si128((const __m128i*)tail), previous));
+    } else {
+        error = _mm_or_si128(error, incomplete);
+    }
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xffff;
+}
+
+#else
+
+static const uint64_t ASCII_MASK = 0x8080808080808080ul;
+
+int isValidUtf8(const uint8_t* data, size_t length) {
+    size_t i = 0;
+    while (i < length) {
+        if (data[i] < 0x80) {
+            // Skip ASCII in 8-byte steps when possible.
+            uint64_t word;
+            while (i + 8 <= length && (memcpy(&word, &data[i], 8), (word & ASCII_MASK) == 0)) {
+                i += 8;
+            }
+            while (i < length && data[i] < 0x80) {
+                i++;
+            }
+            continue;
+        }
+        uint8_t lead = data[i];
+        uint8_t lower = 0x80;
+        uint8_t upper = 0xbf;
+        size_t trailing;
+        if (lead >= 0xc2 && lead <= 0xdf) {
+            trailing = 1;
+        } else if (lead >= 0xe0 && lead <= 0xef) {
+            trailing = 2;
+            if (lead == 0xe0) {
+                lower = 0xa0;  // Overlong
+            } else if (lead == 0xed) {
+                upper = 0x9f;  // Surrogates
+            }
+        } else if (lead >= 0xf0 && lead <= 0xf4) {
+            trailing = 3;
+            if (lead == 0xf0) {
+                lower = 0x90;  // Overlong
+            } else if (lead == 0xf4) {
+                upper = 0x8f;  // Above U+10FFFF
+            }
+        } else {
+            return 0;
+        }
+        if (length - i <= trailing || data[i + 1] < lower || data[i + 1] > upper) {
+            return 0;
+        }
+        for (size_t q = 2; q <= trailing; q++) {
+            if ((data[i + q] & 0xc0) != 0x80) {
+                return 0;
+            }
+        }
+        i += 1 + trailing;
+    }
+    return 1;
+}
+
+#endif
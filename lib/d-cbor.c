@@ -38,44 +38,190 @@ static const int MT_FALSE         = 0xf4;
 static const int MT_TRUE          = 0xf5;
 static const int MT_NULL          = 0xf6;
 
-static void putByte(CBOR_BUFFER *cborBuffer, uint8_t byte) {
-    if (cborBuffer->pos >= cborBuffer->length) {
-        // Buffer overflow! Ignore call to avoid crashing hard.
-        cborBuffer->length = 0;  // Indication to upper layers.
-    } else {
-        cborBuffer->data[cborBuffer->pos++] = byte;
+// Writes "length" bytes of "value" in big-endian order using a single store.
+static void putBigEndian(uint8_t* target, int length, uint64_t value) {
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    value = __builtin_bswap64(value << ((8 - length) << 3));
+    memcpy(target, &value, length);
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value <<= (8 - length) << 3;
+    memcpy(target, &value, length);
+#else
+    while (--length >= 0) {
+        target[length] = (uint8_t)value;
+        value >>= 8;
     }
+#endif
 }
 
-void addRawBytes(CBOR_BUFFER* cborBuffer, const uint8_t* bytePointer, int length) {
-    while (--length >= 0) {
-        putByte(cborBuffer, *bytePointer++);
+void initCborBuffer(CBOR_BUFFER* cborBuffer, uint8_t* data, size_t length) {
+    cborBuffer->length = length;
+    cborBuffer->pos = 0;
+    cborBuffer->data = data;
+    cborBuffer->sink = NULL;
+    cborBuffer->sinkContext = NULL;
+    cborBuffer->flushed = 0;
+    cborBuffer->validateUtf8 = 0;
+    cborBuffer->invalidUtf8 = 0;
+}
+
+void initCborSink(CBOR_BUFFER* cborBuffer, uint8_t* data, size_t length,
+                  CBOR_SINK sink, void* sinkContext) {
+    initCborBuffer(cborBuffer, data, length);
+    cborBuffer->sink = sink;
+    cborBuffer->sinkContext = sinkContext;
+}
+
+void initCborDryRun(CBOR_BUFFER* cborBuffer) {
+    initCborBuffer(cborBuffer, NULL, SIZE_MAX);
+}
+
+static void setOverflow(CBOR_BUFFER* cborBuffer) {
+    // Buffer overflow! Ignore call to avoid crashing hard.
+    cborBuffer->length = 0;  // Indication to upper layers.
+}
+
+int flushCborBuffer(CBOR_BUFFER* cborBuffer) {
+    if (cborBuffer->length == 0) {
+        return 0;  // Already in error state.
+    }
+    if (cborBuffer->sink && cborBuffer->pos) {
+        if (!cborBuffer->sink(cborBuffer->sinkContext, cborBuffer->data, cborBuffer->pos)) {
+            setOverflow(cborBuffer);
+            return 0;
+        }
+        cborBuffer->flushed += cborBuffer->pos;
+        cborBuffer->pos = 0;
+    }
+    return 1;
+}
+
+static size_t spaceLeft(CBOR_BUFFER* cborBuffer) {
+    return cborBuffer->length > cborBuffer->pos ? cborBuffer->length - cborBuffer->pos : 0;
+}
+
+int reserveBytes(CBOR_BUFFER* cborBuffer, size_t length) {
+    if (length <= spaceLeft(cborBuffer)) {
+        return 1;
+    }
+    // In sink mode the buffer is drained, but the request must still fit in the buffer.
+    if (cborBuffer->sink && length <= cborBuffer->length && flushCborBuffer(cborBuffer)) {
+        return 1;
+    }
+    setOverflow(cborBuffer);
+    return 0;
+}
+
+static void writeHead(uint8_t* target, int tag, int length, uint64_t value) {
+    *target = (uint8_t)tag;
+    if (length) {
+        putBigEndian(target + 1, length, value);
+    }
+}
+
+// Note: caller must have verified that there is room for the head.
+static void putHead(CBOR_BUFFER* cborBuffer, int tag, int length, uint64_t value) {
+    if (cborBuffer->data) {  // Dry-run mode only counts.
+        writeHead(&cborBuffer->data[cborBuffer->pos], tag, length, value);
+    }
+    cborBuffer->pos += 1 + length;
+}
+
+void addRawBytesUnchecked(CBOR_BUFFER* cborBuffer, const uint8_t* bytePointer, size_t length) {
+    if (cborBuffer->data) {
+        memcpy(&cborBuffer->data[cborBuffer->pos], bytePointer, length);
+    }
+    cborBuffer->pos += length;
+}
+
+// Streams data that does not fit in the buffer through the sink in buffer-sized chunks.
+static void streamRawBytes(CBOR_BUFFER* cborBuffer, const uint8_t* bytePointer, size_t length) {
+    while (length) {
+        size_t chunk = spaceLeft(cborBuffer);
+        if (chunk == 0) {
+            if (!flushCborBuffer(cborBuffer) || (chunk = spaceLeft(cborBuffer)) == 0) {
+                setOverflow(cborBuffer);
+                return;
+            }
+        }
+        if (chunk > length) {
+            chunk = length;
+        }
+        addRawBytesUnchecked(cborBuffer, bytePointer, chunk);
+        bytePointer += chunk;
+        length -= chunk;
+    }
+}
+
+void addRawBytes(CBOR_BUFFER* cborBuffer, const uint8_t* bytePointer, size_t length) {
+    if (length <= spaceLeft(cborBuffer)) {
+        addRawBytesUnchecked(cborBuffer, bytePointer, length);
+    } else if (cborBuffer->sink) {
+        streamRawBytes(cborBuffer, bytePointer, length);
+    } else {
+        setOverflow(cborBuffer);
     }
 }
 
 void encodeTagAndValue(CBOR_BUFFER *cborBuffer, int tag, int length, uint64_t value) {
-    putByte(cborBuffer, (uint8_t) tag);
-    uint8_t buffer[8];
-    int i = length;
-    while (--i >= 0) {
-        buffer[i] = (uint8_t)value;
-        value >>= 8;
+    if (reserveBytes(cborBuffer, 1 + length)) {
+        putHead(cborBuffer, tag, length, value);
     }
-    addRawBytes(cborBuffer, buffer, length);
 }
 
-void encodeTagAndN(CBOR_BUFFER *cborBuffer, int majorType, uint64_t n) {
-    int modifier = (int)n;
+void encodeTagAndValueUnchecked(CBOR_BUFFER *cborBuffer, int tag, int length, uint64_t value) {
+    putHead(cborBuffer, tag, length, value);
+}
+
+// Returns the number of bytes needed for holding "n" in a CBOR head (0, 1, 2, 4, 8).
+// The modifier (the lower 5 bits of the initial byte) is returned in "modifier".
+static int argumentLength(uint64_t n, int* modifier) {
+    *modifier = (int)n;
     int length = 0;
     if (n > 23) {
-        modifier = 27;
+        *modifier = 27;
         length = 32;
         while (((MASK_LOWER_32 << length) & n) == 0) {
-            modifier--;
+            (*modifier)--;
             length >>= 1;
         }
     }
-    encodeTagAndValue(cborBuffer, majorType | modifier, length >> 2, n);
+    return length >> 2;
+}
+
+// Emits a head and an optional payload after a single capacity check.
+static void encodeItem(CBOR_BUFFER *cborBuffer, int majorType, uint64_t n,
+                       const uint8_t* payload, size_t payloadLength) {
+    int modifier;
+    int length = argumentLength(n, &modifier);
+    if (1 + length + payloadLength <= spaceLeft(cborBuffer)) {
+        putHead(cborBuffer, majorType | modifier, length, n);
+        if (payloadLength) {
+            addRawBytesUnchecked(cborBuffer, payload, payloadLength);
+        }
+    } else if (cborBuffer->sink) {
+        // Slow path: the head is kept intact while the payload may be split.
+        if (reserveBytes(cborBuffer, 1 + length)) {
+            putHead(cborBuffer, majorType | modifier, length, n);
+            addRawBytes(cborBuffer, payload, payloadLength);
+        }
+    } else {
+        setOverflow(cborBuffer);
+    }
+}
+
+static void encodeItemUnchecked(CBOR_BUFFER *cborBuffer, int majorType, uint64_t n,
+                                const uint8_t* payload, size_t payloadLength) {
+    int modifier;
+    int length = argumentLength(n, &modifier);
+    putHead(cborBuffer, majorType | modifier, length, n);
+    if (payloadLength) {
+        addRawBytesUnchecked(cborBuffer, payload, payloadLength);
+    }
+}
+
+void encodeTagAndN(CBOR_BUFFER *cborBuffer, int majorType, uint64_t n) {
+    encodeItem(cborBuffer, majorType, n, NULL, 0);
 }
 
 void addInt(CBOR_BUFFER* cborBuffer, int64_t value) {
@@ -84,18 +230,30 @@ void addInt(CBOR_BUFFER* cborBuffer, int64_t value) {
         tag = MT_NEGATIVE;
         value = ~value;
     }
-    encodeTagAndN(cborBuffer, tag, (uint64_t)value);
+    encodeItem(cborBuffer, tag, (uint64_t)value, NULL, 0);
+}
+
+static int acceptTstr(CBOR_BUFFER* cborBuffer, const char* utf8String, size_t length) {
+    if (cborBuffer->validateUtf8 && !isValidUtf8((const uint8_t*)utf8String, length)) {
+        cborBuffer->invalidUtf8 = 1;
+        setOverflow(cborBuffer);
+        return 0;
+    }
+    return 1;
 }
 
 void addTstr(CBOR_BUFFER* cborBuffer, const char* utf8String) {
-    int length = (int)strlen(utf8String);
-    encodeTagAndN(cborBuffer, MT_TEXT_STRING, length);
-    addRawBytes(cborBuffer, (const uint8_t*)utf8String, length);
+    addTstrWithLength(cborBuffer, utf8String, strlen(utf8String));
 }
 
-void addBstr(CBOR_BUFFER* cborBuffer, const uint8_t* byteString, int length) {
-    encodeTagAndN(cborBuffer, MT_BYTE_STRING, length);
-    addRawBytes(cborBuffer, byteString, length);
+void addTstrWithLength(CBOR_BUFFER* cborBuffer, const char* utf8String, size_t length) {
+    if (acceptTstr(cborBuffer, utf8String, length)) {
+        encodeItem(cborBuffer, MT_TEXT_STRING, length, (const uint8_t*)utf8String, length);
+    }
+}
+
+void addBstr(CBOR_BUFFER* cborBuffer, const uint8_t* byteString, size_t length) {
+    encodeItem(cborBuffer, MT_BYTE_STRING, length, byteString, length);
 }
 
 void addArray(CBOR_BUFFER* cborBuffer, int elements) {
@@ -121,22 +279,151 @@ void addMappedTstr(CBOR_BUFFER* cborBuffer, int key, const char* utf8String) {
     addTstr(cborBuffer, utf8String);
 }
 
-void addMappedBstr(CBOR_BUFFER* cborBuffer, int key, const uint8_t* byteString, int length) {
+void addMappedBstr(CBOR_BUFFER* cborBuffer, int key, const uint8_t* byteString, size_t length) {
     addInt(cborBuffer, key);
     addBstr(cborBuffer, byteString, length);
 }
 
+void addIntUnchecked(CBOR_BUFFER* cborBuffer, int64_t value) {
+    int tag = MT_UNSIGNED;
+    if (value < 0) {
+        tag = MT_NEGATIVE;
+        value = ~value;
+    }
+    encodeItemUnchecked(cborBuffer, tag, (uint64_t)value, NULL, 0);
+}
+
+void addTstrUnchecked(CBOR_BUFFER* cborBuffer, const char* utf8String) {
+    size_t length = strlen(utf8String);
+    if (acceptTstr(cborBuffer, utf8String, length)) {
+        encodeItemUnchecked(cborBuffer, MT_TEXT_STRING, length, (const uint8_t*)utf8String, length);
+    }
+}
+
+void addBstrUnchecked(CBOR_BUFFER* cborBuffer, const uint8_t* byteString, size_t length) {
+    encodeItemUnchecked(cborBuffer, MT_BYTE_STRING, length, byteString, length);
+}
+
+void addArrayUnchecked(CBOR_BUFFER* cborBuffer, int elements) {
+    encodeItemUnchecked(cborBuffer, MT_ARRAY, elements, NULL, 0);
+}
+
+void addMapUnchecked(CBOR_BUFFER* cborBuffer, int keys) {
+    encodeItemUnchecked(cborBuffer, MT_MAP, keys, NULL, 0);
+}
+
+#define ARRAY_BLOCK 64
+
+void addInt64Array(CBOR_BUFFER* cborBuffer, const int64_t* values, size_t count) {
+    encodeTagAndN(cborBuffer, MT_ARRAY, count);
+    // Capacity is checked once per block of elements.
+    uint8_t lengths[ARRAY_BLOCK];
+    uint8_t tags[ARRAY_BLOCK];
+    for (size_t i = 0; i < count; i += ARRAY_BLOCK) {
+        int blockCount = count - i < ARRAY_BLOCK ? (int)(count - i) : ARRAY_BLOCK;
+        size_t blockSize = blockCount;
+        for (int q = 0; q < blockCount; q++) {
+            int64_t value = values[i + q];
+            int modifier;
+            int tag = value < 0 ? MT_NEGATIVE : MT_UNSIGNED;
+            lengths[q] = (uint8_t)argumentLength((uint64_t)(value < 0 ? ~value : value), &modifier);
+            tags[q] = (uint8_t)(tag | modifier);
+            blockSize += lengths[q];
+        }
+        // A block that does not fit a sink buffer is reserved element by element.
+        int perElement = cborBuffer->sink && blockSize > cborBuffer->length;
+        if (!perElement && !reserveBytes(cborBuffer, blockSize)) {
+            return;
+        }
+        for (int q = 0; q < blockCount; q++) {
+            int64_t value = values[i + q];
+            if (perElement && !reserveBytes(cborBuffer, 1 + (size_t)lengths[q])) {
+                return;
+            }
+            putHead(cborBuffer, tags[q], lengths[q], (uint64_t)(value < 0 ? ~value : value));
+        }
+    }
+}
+
 #ifdef INDEFINITE_LENGTH_EMULATION
-void insertArray(CBOR_BUFFER* cborBuffer, int savePos, int elements) {
-    int lastPos = cborBuffer->pos;
+void insertArray(CBOR_BUFFER* cborBuffer, size_t savePos, int elements) {
+    size_t lastPos = cborBuffer->pos;
     addArray(cborBuffer, elements);
-    if (cborBuffer->length) {  // Buffer overflow protection.
+    if (cborBuffer->length && cborBuffer->data) {  // Buffer overflow and dry-run protection.
         uint8_t buffer[5];  // 2^32 - 1 elements is not sufficient?
-        int q = cborBuffer->pos - lastPos;  // Length in bytes of the array object.
+        size_t q = cborBuffer->pos - lastPos;  // Length in bytes of the array object.
         // Put the array object in front of its associated array elements.
         memmove(buffer, &cborBuffer->data[lastPos], q);
         memmove(&cborBuffer->data[savePos + q], &cborBuffer->data[savePos], lastPos - savePos);
         memmove(&cborBuffer->data[savePos], buffer, q);
     }
 }
+
+void initFixupList(CBOR_BUFFER* cborBuffer, CBOR_FIXUP_LIST* fixupList,
+                   CBOR_FIXUP* fixups, int maxFixups) {
+    fixupList->fixups = fixups;
+    fixupList->maxFixups = maxFixups;
+    fixupList->count = 0;
+    fixupList->flushed = cborBuffer->flushed;
+}
+
+static int addPlaceholder(CBOR_BUFFER* cborBuffer, CBOR_FIXUP_LIST* fixupList, int majorType) {
+    if (fixupList->count >= fixupList->maxFixups) {
+        setOverflow(cborBuffer);
+        return -1;
+    }
+    CBOR_FIXUP* fixup = &fixupList->fixups[fixupList->count];
+    fixup->pos = cborBuffer->pos;
+    fixup->majorType = majorType;
+    fixup->elements = 0;
+    return fixupList->count++;
+}
+
+int addArrayPlaceholder(CBOR_BUFFER* cborBuffer, CBOR_FIXUP_LIST* fixupList) {
+    return addPlaceholder(cborBuffer, fixupList, MT_ARRAY);
+}
+
+int addMapPlaceholder(CBOR_BUFFER* cborBuffer, CBOR_FIXUP_LIST* fixupList) {
+    return addPlaceholder(cborBuffer, fixupList, MT_MAP);
+}
+
+void setPlaceholder(CBOR_FIXUP_LIST* fixupList, int placeholder, int elements) {
+    if (placeholder >= 0 && placeholder < fixupList->count) {  // Failed placeholders are ignored.
+        fixupList->fixups[placeholder].elements = elements;
+    }
+}
+
+int resolveFixups(CBOR_BUFFER* cborBuffer, CBOR_FIXUP_LIST* fixupList) {
+    CBOR_FIXUP* fixups = fixupList->fixups;
+    int count = fixupList->count;
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        int modifier;
+        total += 1 + argumentLength(fixups[i].elements, &modifier);
+    }
+    if (cborBuffer->length == 0 || cborBuffer->flushed != fixupList->flushed ||
+        total > spaceLeft(cborBuffer)) {
+        // Earlier overflow, part of the data already sent to a sink or not enough room for the heads.
+        setOverflow(cborBuffer);
+        return 0;
+    }
+    if (cborBuffer->data) {
+        // Working backwards, every byte is moved (at most) once to its final position.
+        size_t end = cborBuffer->pos;
+        size_t shift = total;
+        for (int i = count; --i >= 0; ) {
+            int modifier;
+            int length = argumentLength(fixups[i].elements, &modifier);
+            size_t start = fixups[i].pos;
+            memmove(&cborBuffer->data[start + shift], &cborBuffer->data[start], end - start);
+            shift -= 1 + length;
+            writeHead(&cborBuffer->data[start + shift], fixups[i].majorType | modifier,
+                      length, fixups[i].elements);
+            end = start;
+        }
+    }
+    cborBuffer->pos += total;
+    fixupList->count = 0;
+    return 1;
+}
 #endif
\ No newline at end of file
@@ -1,20 +1,54 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Optional sink for streaming output.  Called with the buffered data when
+// the buffer is full and by flushCborBuffer().  Must return non-zero on success.
+typedef int (*CBOR_SINK)(void* sinkContext, const uint8_t* data, size_t length);
+
 typedef struct {
-    int length;
-    int pos;
+    size_t length;
+    size_t pos;
     uint8_t *data;
+    CBOR_SINK sink;       // NULL => fixed buffer mode
+    void* sinkContext;
+    size_t flushed;       // Bytes already handed over to the sink
+    uint8_t validateUtf8; // Non-zero => text strings are checked for valid UTF-8
+    uint8_t invalidUtf8;  // Set if a text string was rejected.  "length" is also set to 0
 } CBOR_BUFFER;
 
+void initCborBuffer(CBOR_BUFFER* cborBuffer, uint8_t* data, size_t length);
+
+// Dry-run mode: nothing is written, but "pos" advances as usual which makes
+// it possible computing exact sizes and element counts in a first pass.
+void initCborDryRun(CBOR_BUFFER* cborBuffer);
+
+// Sink mode: encoding continues with constant memory after the buffer fills.
+// Note that fixups like insertArray() only work within the unflushed data.
+void initCborSink(CBOR_BUFFER* cborBuffer, uint8_t* data, size_t length,
+                  CBOR_SINK sink, void* sinkContext);
+
+// Hands any remaining data over to the sink.  Returns 0 on failure.
+int flushCborBuffer(CBOR_BUFFER* cborBuffer);
+
 void addInt(CBOR_BUFFER* cborBuffer, int64_t value);
 
 void addTstr(CBOR_BUFFER* cborBuffer, const char* utf8String);
 
-void addBstr(CBOR_BUFFER* cborBuffer, const uint8_t* byteString, int length);
+// For strings with known length.  "utf8String" does not need to be nul-terminated.
+void addTstrWithLength(CBOR_BUFFER* cborBuffer, const char* utf8String, size_t length);
+
+// Returns non-zero if "data" is valid UTF-8.  Note: the implementation is in "d-cbor-utf8.c".
+int isValidUtf8(const uint8_t* data, size_t length);
+
+void addBstr(CBOR_BUFFER* cborBuffer, const uint8_t* byteString, size_t length);
 
-void addRawBytes(CBOR_BUFFER* cborBuffer, const uint8_t* bytePointer, int length);
+void addRawBytes(CBOR_BUFFER* cborBuffer, const uint8_t* bytePointer, size_t length);
 
 void addBool(CBOR_BUFFER* cborBuffer, uint8_t value);
 
@@ -24,19 +58,118 @@ void addMap(CBOR_BUFFER* cborBuffer, int keys);
 
 void encodeTagAndValue(CBOR_BUFFER* cborBuffer, int tag, int length, uint64_t value);
 
+void encodeTagAndValueUnchecked(CBOR_BUFFER* cborBuffer, int tag, int length, uint64_t value);
+
+void encodeTagAndN(CBOR_BUFFER* cborBuffer, int majorType, uint64_t n);
+
 void printCborBuffer(CBOR_BUFFER* cborBuffer, char* string);
 
 void addMappedInt(CBOR_BUFFER* cborBuffer, int key, int value);
 
 void addMappedTstr(CBOR_BUFFER* cborBuffer, int key, const char* utf8String);
 
-void addMappedBstr(CBOR_BUFFER* cborBuffer, int key, const uint8_t* byteString, int length);
+void addMappedBstr(CBOR_BUFFER* cborBuffer, int key, const uint8_t* byteString, size_t length);
+
+// Worst-case size of a CBOR head (initial byte + 8 byte argument).
+#define CBOR_MAX_HEAD_SIZE 9
+
+// Verifies that "length" bytes are available, flushing the buffer in sink
+// mode.  Returns 0 and sets length to 0 (overflow indication) if not.
+// After a successful call, the *Unchecked functions below may be used for
+// emitting up to "length" bytes without further capacity checks.
+int reserveBytes(CBOR_BUFFER* cborBuffer, size_t length);
+
+void addIntUnchecked(CBOR_BUFFER* cborBuffer, int64_t value);
+
+void addTstrUnchecked(CBOR_BUFFER* cborBuffer, const char* utf8String);
+
+void addBstrUnchecked(CBOR_BUFFER* cborBuffer, const uint8_t* byteString, size_t length);
+
+void addRawBytesUnchecked(CBOR_BUFFER* cborBuffer, const uint8_t* bytePointer, size_t length);
+
+void addArrayUnchecked(CBOR_BUFFER* cborBuffer, int elements);
+
+void addMapUnchecked(CBOR_BUFFER* cborBuffer, int keys);
+
+// Automatic map key sorting.  Note: the implementation is in "d-cbor-sorted-map.c"
+typedef struct {
+    size_t start;         // Offset of the key
+    size_t keyLength;     // Set by endSortedMap()
+    size_t length;        // Key + value, set by endSortedMap()
+} CBOR_MAP_ENTRY;
+
+typedef struct {
+    CBOR_MAP_ENTRY* entries;
+    int keys;
+    int count;
+    size_t flushed;
+} CBOR_SORTED_MAP;
+
+// Writes the map head.  "entries" must hold "keys" elements.
+void beginSortedMap(CBOR_BUFFER* cborBuffer, CBOR_SORTED_MAP* sortedMap,
+                    CBOR_MAP_ENTRY* entries, int keys);
+
+// Must be called before adding each key.  Keys and values are added as usual.
+void addSortedMapKey(CBOR_BUFFER* cborBuffer, CBOR_SORTED_MAP* sortedMap);
+
+// Reorders the map entries in place into deterministic key order.
+// Duplicate keys and entry count mismatches return 0 and set length to 0.
+int endSortedMap(CBOR_BUFFER* cborBuffer, CBOR_SORTED_MAP* sortedMap);
+
+// Debug check for prearranged maps: returns 1 if the keys of the map
+// starting at "mapPos" are in strictly ascending order.
+int isSortedMap(const CBOR_BUFFER* cborBuffer, size_t mapPos);
+
+// Bulk array encoders.  They emit the array head followed by the elements,
+// byte-identical to calling addInt()/addDouble() per element.
+void addInt64Array(CBOR_BUFFER* cborBuffer, const int64_t* values, size_t count);
 
 #ifndef CBOR_NO_DOUBLE
 // Note: the implementation is in "ieee754.c"
 void addDouble(CBOR_BUFFER* cborBuffer, double value);
+
+// Uses AVX2/F16C or SSE2 for classifying elements if enabled at compile time.
+void addDoubleArray(CBOR_BUFFER* cborBuffer, const double* values, size_t count);
+
+void addFloatArray(CBOR_BUFFER* cborBuffer, const float* values, size_t count);
 #endif
 
 #ifdef INDEFINITE_LENGTH_EMULATION
-void insertArray(CBOR_BUFFER* cborBuffer, int savePos, int elements);
+void insertArray(CBOR_BUFFER* cborBuffer, size_t savePos, int elements);
+
+// Batched fixups: placeholders are registered in document order and all
+// heads are inserted by a single call to resolveFixups() which moves every
+// byte at most once.  Do not mix with insertArray() within the same data.
+typedef struct {
+    size_t pos;
+    int majorType;
+    int elements;
+} CBOR_FIXUP;
+
+typedef struct {
+    CBOR_FIXUP* fixups;
+    int maxFixups;
+    int count;
+    size_t flushed;
+} CBOR_FIXUP_LIST;
+
+void initFixupList(CBOR_BUFFER* cborBuffer, CBOR_FIXUP_LIST* fixupList,
+                   CBOR_FIXUP* fixups, int maxFixups);
+
+// Return a placeholder handle for setPlaceholder().  If the list is full,
+// -1 is returned and length is set to 0.
+int addArrayPlaceholder(CBOR_BUFFER* cborBuffer, CBOR_FIXUP_LIST* fixupList);
+
+int addMapPlaceholder(CBOR_BUFFER* cborBuffer, CBOR_FIXUP_LIST* fixupList);
+
+// Sets the number of array elements or map keys of a placeholder.
+// Handles that are not valid, like -1, are ignored.
+void setPlaceholder(CBOR_FIXUP_LIST* fixupList, int placeholder, int elements);
+
+// Inserts all pending heads.  Returns 0 and sets length to 0 on overflow.
+int resolveFixups(CBOR_BUFFER* cborBuffer, CBOR_FIXUP_LIST* fixupList);
+#endif
+
+#ifdef __cplusplus
+}
 #endif
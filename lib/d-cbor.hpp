@@ -0,0 +1,237 @@
+/*
+ *  Copyright 2006-2022 WebPKI.org (https://webpki.org).
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+            //////////////////////////////////////////////////
+            // D-CBOR - C++17 compile-time fragment encoder //
+            //////////////////////////////////////////////////
+
+// Encodes constant CBOR fragments at compile time using the same rules as
+// "d-cbor.c" and "d-cbor-ieee754.c".  The result is a static std::array
+// that can be handed to addRawBytes().  Example:
+//
+//   static constexpr auto KEY = DCBOR_FRAGMENT(dcbor::Encoder<>()
+//       .addMap(2)
+//         .addInt(1).addInt(1)
+//         .addInt(-1).addInt(6));
+//
+//   addRawBytes(&cborBuffer, KEY.data(), KEY.size());
+//
+// Note: requires __builtin_bit_cast (GCC 11+, Clang 9+, MSVC 16.8+).
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace dcbor {
+
+constexpr int MT_UNSIGNED    = 0x00;
+constexpr int MT_NEGATIVE    = 0x20;
+constexpr int MT_BYTE_STRING = 0x40;
+constexpr int MT_TEXT_STRING = 0x60;
+constexpr int MT_ARRAY       = 0x80;
+constexpr int MT_MAP         = 0xa0;
+constexpr int MT_FALSE       = 0xf4;
+constexpr int MT_TRUE        = 0xf5;
+constexpr int MT_FLOAT16     = 0xf9;
+constexpr int MT_FLOAT32     = 0xfa;
+constexpr int MT_FLOAT64     = 0xfb;
+
+template <std::size_t Capacity = 512>
+class Encoder {
+public:
+    constexpr Encoder() : data_{}, size_(0) {}
+
+    constexpr Encoder& addInt(int64_t value) {
+        int tag = MT_UNSIGNED;
+        if (value < 0) {
+            tag = MT_NEGATIVE;
+            value = ~value;
+        }
+        return encodeTagAndN(tag, static_cast<uint64_t>(value));
+    }
+
+    constexpr Encoder& addTstr(const char* utf8String) {
+        std::size_t length = 0;
+        while (utf8String[length]) {
+            length++;
+        }
+        encodeTagAndN(MT_TEXT_STRING, length);
+        for (std::size_t i = 0; i < length; i++) {
+            putByte(static_cast<uint8_t>(utf8String[i]));
+        }
+        return *this;
+    }
+
+    constexpr Encoder& addBstr(const uint8_t* byteString, std::size_t length) {
+        encodeTagAndN(MT_BYTE_STRING, length);
+        return addRawBytes(byteString, length);
+    }
+
+    template <std::size_t N>
+    constexpr Encoder& addBstr(const std::array<uint8_t, N>& byteString) {
+        return addBstr(byteString.data(), N);
+    }
+
+    constexpr Encoder& addRawBytes(const uint8_t* bytePointer, std::size_t length) {
+        for (std::size_t i = 0; i < length; i++) {
+            putByte(bytePointer[i]);
+        }
+        return *this;
+    }
+
+    // Embeds a previously built fragment.
+    template <std::size_t N>
+    constexpr Encoder& addRawBytes(const std::array<uint8_t, N>& fragment) {
+        return addRawBytes(fragment.data(), N);
+    }
+
+    constexpr Encoder& addBool(bool value) {
+        return encodeTagAndN(value ? MT_TRUE : MT_FALSE, 0);
+    }
+
+    constexpr Encoder& addArray(uint64_t elements) {
+        return encodeTagAndN(MT_ARRAY, elements);
+    }
+
+    constexpr Encoder& addMap(uint64_t keys) {
+        return encodeTagAndN(MT_MAP, keys);
+    }
+
+    constexpr Encoder& addDouble(double value);
+
+    constexpr std::size_t size() const {
+        return size_;
+    }
+
+    constexpr uint8_t operator[](std::size_t index) const {
+        return data_[index];
+    }
+
+private:
+    constexpr void putByte(uint8_t byte) {
+        // Throwing makes overflow a compile-time error.
+        size_ < Capacity ? (void)(data_[size_++] = byte) : throw "Encoder capacity exceeded";
+    }
+
+    constexpr Encoder& encodeTagAndValue(int tag, int length, uint64_t value) {
+        putByte(static_cast<uint8_t>(tag));
+        while (--length >= 0) {
+            putByte(static_cast<uint8_t>(value >> (length << 3)));
+        }
+        return *this;
+    }
+
+    constexpr Encoder& encodeTagAndN(int majorType, uint64_t n) {
+        int modifier = static_cast<int>(n);
+        int length = 0;
+        if (n > 23) {
+            modifier = 27;
+            length = 32;
+            while (((0x00000000ffffffffull << length) & n) == 0) {
+                modifier--;
+                length >>= 1;
+            }
+        }
+        return encodeTagAndValue(majorType | modifier, length >> 2, n);
+    }
+
+    std::array<uint8_t, Capacity> data_;
+    std::size_t size_;
+};
+
+// Constant-expression version of the integer-only path in "d-cbor-ieee754.c".
+template <std::size_t Capacity>
+constexpr Encoder<Capacity>& Encoder<Capacity>::addDouble(double d) {
+    constexpr uint64_t ONE = 1;
+    int tag = MT_FLOAT64;
+    uint64_t bitFormat = __builtin_bit_cast(uint64_t, d);
+    int64_t exponent = 0;
+    uint64_t significand = 0;
+
+    if ((bitFormat & ~0x8000000000000000ull) == 0) {
+        // Zeroes.
+        return encodeTagAndValue(MT_FLOAT16, 2, bitFormat ? 0x8000 : 0x0000);
+    }
+    if ((bitFormat & 0x7ff0000000000000ull) == 0x7ff0000000000000ull) {
+        // Infinity and NaN.  Only "quiet" NaN is supported.
+        return encodeTagAndValue(MT_FLOAT16, 2, bitFormat == 0x7ff0000000000000ull ?
+            0x7c00 : bitFormat == 0xfff0000000000000ull ? 0xfc00 : 0x7e00);
+    }
+
+    // Does it fit in a 32-bit float?
+    exponent = static_cast<int64_t>((bitFormat >> 52) & ((ONE << 11) - 1)) - (1023 - 127);
+    if (exponent < -23 || exponent > (127 << 1)) {
+        return encodeTagAndValue(tag, 8, bitFormat);
+    }
+    significand = bitFormat & ((ONE << 52) - 1);
+    if ((significand & ((ONE << (52 - 23)) - 1)) != 0) {
+        return encodeTagAndValue(tag, 8, bitFormat);
+    }
+    significand >>= (52 - 23);
+    if (exponent <= 0) {
+        significand += ONE << 23;
+        uint64_t significandCopy = significand;
+        significand >>= (1 - exponent);
+        if (significandCopy != (significand << (1 - exponent))) {
+            return encodeTagAndValue(tag, 8, bitFormat);
+        }
+        exponent = 0;
+    }
+    tag = MT_FLOAT32;
+    bitFormat = ((bitFormat >> (64 - 32)) & 0x80000000ull) +
+        (static_cast<uint64_t>(exponent) << 23) + significand;
+
+    // Does it fit in a 16-bit float as well?
+    exponent -= (127 - 15);
+    if (exponent < -10 || exponent > (15 << 1)) {
+        return encodeTagAndValue(tag, 4, bitFormat);
+    }
+    if ((significand & ((ONE << (23 - 10)) - 1)) != 0) {
+        return encodeTagAndValue(tag, 4, bitFormat);
+    }
+    significand >>= (23 - 10);
+    if (exponent <= 0) {
+        significand += ONE << 10;
+        uint64_t significandCopy = significand;
+        significand >>= (1 - exponent);
+        if (significandCopy != (significand << (1 - exponent))) {
+            return encodeTagAndValue(tag, 4, bitFormat);
+        }
+        exponent = 0;
+    }
+    bitFormat = ((bitFormat >> (32 - 16)) & 0x8000) +
+        (static_cast<uint64_t>(exponent) << 10) + significand;
+    return encodeTagAndValue(MT_FLOAT16, 2, bitFormat);
+}
+
+// Copies the used part of an encoder into an exactly sized array.
+// "Builder" must be a captureless constexpr lambda returning an Encoder.
+template <typename Builder>
+constexpr auto fragment(Builder builder) {
+    constexpr auto encoder = builder();
+    std::array<uint8_t, encoder.size()> result{};
+    for (std::size_t i = 0; i < encoder.size(); i++) {
+        result[i] = encoder[i];
+    }
+    return result;
+}
+
+}  // namespace dcbor
+
+#define DCBOR_FRAGMENT(...) dcbor::fragment([]() constexpr { return __VA_ARGS__; })
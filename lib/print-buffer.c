@@ -8,8 +8,8 @@
 
 void printCborBuffer(CBOR_BUFFER *cborBuffer, char* string) {
     if (cborBuffer->length) {
-        printf("%s [%d]:\n", string, cborBuffer->pos);
-        for (int i = 0; i < cborBuffer->pos; i++) {
+        printf("%s [%zu]:\n", string, cborBuffer->pos);
+        for (size_t i = 0; i < cborBuffer->pos; i++) {
             printf("%02x", (int)cborBuffer->data[i]);
         }
     } else {
@@ -0,0 +1,12 @@
+#!/bin/bash
+
+# Rudimentary Linux bash script for building and running the D-CBOR schema generator demo.
+#
+# Run from any directory: $ bash path-to-this-script
+#
+pushd $(dirname "${BASH_SOURCE[0]}")
+gcc -o schema-generator -Os schema-generator.c
+./schema-generator sensor.cddl sensor
+gcc -o demo -Os -DPLATFORM_SUPPORTS_FLOAT_CAST -I ../lib schema-demo.c sensor.c ../lib/*.c
+./demo
+popd
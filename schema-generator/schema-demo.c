@@ -0,0 +1,73 @@
+// schema-demo.c
+
+// Encodes the same data with generated and hand-written code.
+
+#include <d-cbor.h>
+
+#include <string.h>
+#include <stdio.h>
+
+#include "sensor.h"
+
+static const double samples[] = { 20.5, 21.0, 1.0e10, -0.0 };
+static const int64_t limits[] = { -40, 85 };
+static const uint8_t nonce[] = { 1, 2, 3, 4 };
+
+int main(int argc, const char* argv[]) {
+    (void)argc; // Avoid unused parameter error
+    (void)argv;
+
+    unsigned char generatedBuffer[SENSOR_READING_MAX_SIZE];
+    CBOR_BUFFER generated;
+    initCborBuffer(&generated, generatedBuffer, SENSOR_READING_MAX_SIZE);
+
+    SENSOR_READING reading;
+    reading.sensorId = 1234;
+    reading.nonce = nonce;
+    reading.nonceLength = sizeof(nonce);
+    reading.samples = samples;
+    reading.samplesCount = 4;
+    reading.limits = limits;
+    reading.limitsCount = 2;
+    reading.location = "Room 101";
+    reading.ok = 1;
+    encodeSensorReading(&generated, &reading);
+    printCborBuffer(&generated, "Generated encoder");
+
+    // The same thing using prearranged map key sorting.
+    unsigned char manualBuffer[SENSOR_READING_MAX_SIZE];
+    CBOR_BUFFER manual;
+    initCborBuffer(&manual, manualBuffer, SENSOR_READING_MAX_SIZE);
+    addMap(&manual, 6);
+      addInt(&manual, 1);
+      addInt(&manual, 1234);
+      addMappedBstr(&manual, 2, nonce, sizeof(nonce));
+      addInt(&manual, 3);
+      addArray(&manual, 4);
+        for (int i = 0; i < 4; i++) {
+            addDouble(&manual, samples[i]);
+        }
+      addInt(&manual, 4);
+      addArray(&manual, 2);
+        addInt(&manual, limits[0]);
+        addInt(&manual, limits[1]);
+      addInt(&manual, -1);
+      addTstr(&manual, "Room 101");
+      addTstr(&manual, "ok");
+      addBool(&manual, 1);
+
+    if (generated.pos != manual.pos || memcmp(generatedBuffer, manualBuffer, manual.pos)) {
+        printf("*** generated and hand-written encoders differ ***\n");
+        return 1;
+    }
+
+    // "limits" needs at least one element.
+    initCborBuffer(&generated, generatedBuffer, SENSOR_READING_MAX_SIZE);
+    reading.limitsCount = 0;
+    encodeSensorReading(&generated, &reading);
+    if (generated.length != 0) {
+        printf("*** too few array elements were accepted ***\n");
+        return 1;
+    }
+    printf("Done!\n");
+}
@@ -0,0 +1,573 @@
+// schema-generator.c
+
+// Generates straight-line D-CBOR encoders for fixed-layout maps.
+//
+// Usage: schema-generator schema.cddl output-base
+//
+// Writes "output-base.h" and "output-base.c".  The schema is a small CDDL
+// subset where each rule is a map with integer or text keys:
+//
+//   sensor-reading = {
+//     1: uint,                 ; id
+//     2: tstr .size 32,        ; location
+//     -1: [0*16 float],        ; samples
+//     "ok": bool
+//   }
+//
+// Supported types: int, uint, nint, tstr, text, bstr, bytes, bool, float,
+// float16, float32, float64 and arrays "[min*max type]" of these.  Strings
+// need a ".size N" upper bound and arrays a maximum element count so that
+// a worst-case buffer size can be computed.  The comment following a map
+// entry gives the name of the corresponding struct member.
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_NAME      64
+#define MAX_KEY_BYTES 80
+#define MAX_ENTRIES   100
+#define MAX_RULES     20
+
+typedef enum { T_INT, T_UINT, T_NINT, T_TSTR, T_BSTR, T_BOOL, T_FLOAT } FIELD_TYPE;
+
+typedef struct {
+    uint8_t key[MAX_KEY_BYTES];  // Encoded key
+    int keyLength;
+    char keyText[MAX_NAME];      // Key in diagnostic notation
+    char name[MAX_NAME];         // Struct member name
+    FIELD_TYPE type;
+    int isArray;
+    uint64_t minElements;
+    uint64_t maxElements;
+    uint64_t maxSize;            // Strings only
+} ENTRY;
+
+typedef struct {
+    char name[MAX_NAME];
+    ENTRY entries[MAX_ENTRIES];
+    int count;
+} RULE;
+
+static const char* input;
+static int line = 1;
+static const char* fileName;
+
+static void fail(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%s:%d: ", fileName, line);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    exit(1);
+}
+
+            //////////////////////////
+            //    Schema parsing    //
+            //////////////////////////
+
+// Skips white space and comments.  A comment on the same line is returned in "comment".
+static void skipSpace(char* comment) {
+    int sameLine = 1;
+    for (;;) {
+        if (*input == '\n') {
+            line++;
+            sameLine = 0;
+            input++;
+        } else if (isspace((unsigned char)*input)) {
+            input++;
+        } else if (*input == ';') {
+            const char* start = ++input;
+            while (*input && *input != '\n') {
+                input++;
+            }
+            if (sameLine && comment && !comment[0]) {
+                while (start < input && isspace((unsigned char)*start)) {
+                    start++;
+                }
+                int i = 0;
+                while (start < input && (isalnum((unsigned char)*start) || *start == '_') &&
+                       i < MAX_NAME - 1) {
+                    comment[i++] = *start++;
+                }
+                comment[i] = 0;
+            }
+        } else {
+            return;
+        }
+    }
+}
+
+static int accept(const char* token) {
+    skipSpace(NULL);
+    size_t length = strlen(token);
+    if (strncmp(input, token, length) == 0) {
+        input += length;
+        return 1;
+    }
+    return 0;
+}
+
+static void expect(const char* token) {
+    if (!accept(token)) {
+        fail("expected \"%s\"", token);
+    }
+}
+
+static void identifier(char* name) {
+    skipSpace(NULL);
+    int i = 0;
+    while (isalnum((unsigned char)*input) || *input == '-' || *input == '_') {
+        if (i == MAX_NAME - 1) {
+            fail("name too long");
+        }
+        name[i++] = *input++;
+    }
+    name[i] = 0;
+    if (!i) {
+        fail("expected name");
+    }
+}
+
+static int number(uint64_t* value) {
+    skipSpace(NULL);
+    if (!isdigit((unsigned char)*input)) {
+        return 0;
+    }
+    *value = 0;
+    while (isdigit((unsigned char)*input)) {
+        *value = *value * 10 + (uint64_t)(*input++ - '0');
+    }
+    return 1;
+}
+
+            //////////////////////////
+            // Generation-time CBOR //
+            //////////////////////////
+
+static int headSize(uint64_t n) {
+    return n < 24 ? 1 : n <= 0xff ? 2 : n <= 0xffff ? 3 : n <= 0xffffffffull ? 5 : 9;
+}
+
+static int encodeHead(uint8_t* target, int majorType, uint64_t n) {
+    int length = headSize(n) - 1;
+    target[0] = (uint8_t)(majorType | (length ? 23 + (length == 1 ? 1 : length == 2 ? 2 : length == 4 ? 3 : 4) : (int)n));
+    for (int i = 0; i < length; i++) {
+        target[length - i] = (uint8_t)(n >> (i * 8));
+    }
+    return length + 1;
+}
+
+static void parseKey(ENTRY* entry) {
+    skipSpace(NULL);
+    if (*input == '"') {
+        const char* start = ++input;
+        while (*input && *input != '"' && *input != '\n') {
+            input++;
+        }
+        if (*input != '"') {
+            fail("unterminated string");
+        }
+        size_t length = (size_t)(input++ - start);
+        if (length + 9 > MAX_KEY_BYTES || length + 3 > MAX_NAME) {
+            fail("key too long");
+        }
+        entry->keyLength = encodeHead(entry->key, 0x60, length);
+        memcpy(&entry->key[entry->keyLength], start, length);
+        entry->keyLength += (int)length;
+        snprintf(entry->keyText, MAX_NAME, "\"%.*s\"", (int)length, start);
+        int i = 0;
+        for (size_t q = 0; q < length; q++) {
+            entry->name[i++] = isalnum((unsigned char)start[q]) ? start[q] : '_';
+        }
+        entry->name[i] = 0;
+        if (!i || isdigit((unsigned char)entry->name[0])) {
+            fail("cannot derive a member name from key %s", entry->keyText);
+        }
+        return;
+    }
+    int negative = accept("-");
+    uint64_t value;
+    if (!number(&value) || (negative && value == 0)) {
+        fail("expected integer or text key");
+    }
+    entry->keyLength = encodeHead(entry->key, negative ? 0x20 : 0x00, negative ? value - 1 : value);
+    snprintf(entry->keyText, MAX_NAME, "%s%llu", negative ? "-" : "", (unsigned long long)value);
+    snprintf(entry->name, MAX_NAME, "key%s%llu", negative ? "Minus" : "", (unsigned long long)value);
+}
+
+static void parseType(ENTRY* entry) {
+    static const struct {
+        const char* name;
+        FIELD_TYPE type;
+    } TYPES[] = {
+        { "uint", T_UINT }, { "nint", T_NINT }, { "int", T_INT },
+        { "tstr", T_TSTR }, { "text", T_TSTR }, { "bstr", T_BSTR }, { "bytes", T_BSTR },
+        { "bool", T_BOOL }, { "float16", T_FLOAT }, { "float32", T_FLOAT },
+        { "float64", T_FLOAT }, { "float", T_FLOAT }
+    };
+    char name[MAX_NAME];
+    identifier(name);
+    for (size_t i = 0; i < sizeof(TYPES) / sizeof(TYPES[0]); i++) {
+        if (!strcmp(name, TYPES[i].name)) {
+            entry->type = TYPES[i].type;
+            if (entry->type == T_TSTR || entry->type == T_BSTR) {
+                if (!accept(".size") || !number(&entry->maxSize)) {
+                    fail("string type needs a \".size N\" upper bound");
+                }
+            }
+            return;
+        }
+    }
+    fail("unsupported type \"%s\"", name);
+}
+
+static void parseEntry(ENTRY* entry) {
+    parseKey(entry);
+    if (!accept(":") && !accept("=>")) {
+        fail("expected \":\"");
+    }
+    if (accept("[")) {
+        entry->isArray = 1;
+        number(&entry->minElements);
+        expect("*");
+        if (!number(&entry->maxElements)) {
+            fail("array needs a maximum element count");
+        }
+        if (entry->minElements > entry->maxElements) {
+            fail("invalid array bounds");
+        }
+        parseType(entry);
+        expect("]");
+    } else {
+        parseType(entry);
+    }
+}
+
+static int compareEntries(const void* a, const void* b) {
+    const ENTRY* e1 = (const ENTRY*)a;
+    const ENTRY* e2 = (const ENTRY*)b;
+    int length = e1->keyLength < e2->keyLength ? e1->keyLength : e2->keyLength;
+    int result = memcmp(e1->key, e2->key, length);
+    return result ? result : e1->keyLength - e2->keyLength;
+}
+
+static void parseRule(RULE* rule) {
+    identifier(rule->name);
+    expect("=");
+    expect("{");
+    rule->count = 0;
+    while (!accept("}")) {
+        if (rule->count == MAX_ENTRIES) {
+            fail("too many map entries");
+        }
+        ENTRY* entry = &rule->entries[rule->count++];
+        memset(entry, 0, sizeof(ENTRY));
+        parseEntry(entry);
+        char comment[MAX_NAME] = { 0 };
+        skipSpace(comment);
+        int separator = *input == ',';
+        if (separator) {
+            input++;
+            skipSpace(comment);
+        }
+        if (comment[0]) {
+            strcpy(entry->name, comment);
+        }
+        if (!separator && *input != '}') {
+            fail("expected \",\" or \"}\"");
+        }
+    }
+    // Deterministic key order.
+    qsort(rule->entries, rule->count, sizeof(ENTRY), compareEntries);
+    for (int i = 1; i < rule->count; i++) {
+        if (!compareEntries(&rule->entries[i - 1], &rule->entries[i])) {
+            fail("duplicate key %s in \"%s\"", rule->entries[i].keyText, rule->name);
+        }
+        for (int j = 0; j < i; j++) {
+            if (!strcmp(rule->entries[i].name, rule->entries[j].name)) {
+                fail("duplicate member name \"%s\" in \"%s\"", rule->entries[i].name, rule->name);
+            }
+        }
+    }
+}
+
+            //////////////////////////
+            //   Code generation    //
+            //////////////////////////
+
+static uint64_t elementSize(const ENTRY* entry) {
+    switch (entry->type) {
+        case T_BOOL:
+            return 1;
+        case T_TSTR:
+        case T_BSTR:
+            return headSize(entry->maxSize) + entry->maxSize;
+        default:
+            return 9;
+    }
+}
+
+static uint64_t worstCaseSize(const RULE* rule) {
+    uint64_t size = headSize(rule->count);
+    for (int i = 0; i < rule->count; i++) {
+        const ENTRY* entry = &rule->entries[i];
+        size += entry->keyLength;
+        if (entry->isArray) {
+            size += headSize(entry->maxElements) + entry->maxElements * elementSize(entry);
+        } else {
+            size += elementSize(entry);
+        }
+    }
+    return size;
+}
+
+// "sensor-reading" => "SENSOR_READING" or "SensorReading".
+static void convertName(char* target, const char* name, int upperCase) {
+    int capitalize = 1;
+    for (; *name; name++) {
+        if (*name == '-' || *name == '_') {
+            if (upperCase) {
+                *target++ = '_';
+            }
+            capitalize = 1;
+        } else {
+            *target++ = (char)(upperCase || capitalize ?
+                toupper((unsigned char)*name) : *name);
+            capitalize = 0;
+        }
+    }
+    *target = 0;
+}
+
+static const char* memberType(FIELD_TYPE type) {
+    switch (type) {
+        case T_TSTR:  return "const char*";
+        case T_BSTR:  return "const uint8_t*";
+        case T_BOOL:  return "uint8_t";
+        case T_FLOAT: return "double";
+        default:      return "int64_t";  // Like addInt()
+    }
+}
+
+static void generateHeader(FILE* out, const RULE* rules, int ruleCount) {
+    fprintf(out, "// Generated by schema-generator from %s.  Do not edit.\n\n", fileName);
+    fprintf(out, "#pragma once\n\n#include <d-cbor.h>\n");
+    for (int r = 0; r < ruleCount; r++) {
+        const RULE* rule = &rules[r];
+        char upper[MAX_NAME * 2], camel[MAX_NAME * 2];
+        convertName(upper, rule->name, 1);
+        convertName(camel, rule->name, 0);
+        fprintf(out, "\n#define %s_MAX_SIZE %llu\n\n", upper,
+                (unsigned long long)worstCaseSize(rule));
+        fprintf(out, "typedef struct {\n");
+        for (int i = 0; i < rule->count; i++) {
+            const ENTRY* entry = &rules[r].entries[i];
+            const char* type = memberType(entry->type);
+            if (entry->isArray) {
+                fprintf(out, "    const %s* %s;  // Key: %s\n", type, entry->name, entry->keyText);
+                fprintf(out, "    size_t %sCount;\n", entry->name);
+                if (entry->type == T_BSTR) {
+                    fprintf(out, "    const size_t* %sLengths;\n", entry->name);
+                }
+            } else {
+                fprintf(out, "    %s %s;  // Key: %s\n", type, entry->name, entry->keyText);
+                if (entry->type == T_BSTR) {
+                    fprintf(out, "    size_t %sLength;\n", entry->name);
+                }
+            }
+        }
+        fprintf(out, "} %s;\n\n", upper);
+        fprintf(out, "// Requires %s_MAX_SIZE bytes of free buffer space.\n", upper);
+        fprintf(out, "void encode%s(CBOR_BUFFER* cborBuffer, const %s* value);\n", camel, upper);
+    }
+}
+
+static void emitConstant(FILE* out, const uint8_t* bytes, int length, int* run) {
+    fprintf(out, "    static const uint8_t CONSTANT_%d[] = {", *run);
+    for (int i = 0; i < length; i++) {
+        fprintf(out, "%s0x%02x", i ? ", " : " ", bytes[i]);
+    }
+    fprintf(out, " };\n");
+    (*run)++;
+}
+
+static void emitValue(FILE* out, const ENTRY* entry, const char* value, const char* length) {
+    switch (entry->type) {
+        case T_TSTR:
+            fprintf(out, "addTstrUnchecked(cborBuffer, %s);\n", value);
+            break;
+        case T_BSTR:
+            fprintf(out, "addBstrUnchecked(cborBuffer, %s, %s);\n", value, length);
+            break;
+        case T_BOOL:
+            fprintf(out, "addRawBytesUnchecked(cborBuffer, %s ? &BOOLEANS[1] : &BOOLEANS[0], 1);\n", value);
+            break;
+        case T_FLOAT:
+            fprintf(out, "addDouble(cborBuffer, %s);  // Space is reserved\n", value);
+            break;
+        default:
+            fprintf(out, "addIntUnchecked(cborBuffer, (int64_t)%s);\n", value);
+            break;
+    }
+}
+
+static void generateSource(FILE* out, const RULE* rules, int ruleCount, const char* header) {
+    fprintf(out, "// Generated by schema-generator from %s.  Do not edit.\n\n", fileName);
+    fprintf(out, "#include <string.h>\n\n#include \"%s\"\n\n", header);
+    fprintf(out, "static const uint8_t BOOLEANS[] = { 0xf4, 0xf5 };\n");
+    for (int r = 0; r < ruleCount; r++) {
+        const RULE* rule = &rules[r];
+        char upper[MAX_NAME * 2], camel[MAX_NAME * 2];
+        convertName(upper, rule->name, 1);
+        convertName(camel, rule->name, 0);
+        fprintf(out, "\nvoid encode%s(CBOR_BUFFER* cborBuffer, const %s* value) {\n", camel, upper);
+
+        // Constant runs: map head + first key, and each following key.
+        int run = 0;
+        uint8_t constant[MAX_KEY_BYTES + 9];
+        int q = encodeHead(constant, 0xa0, rule->count);
+        for (int i = 0; i < rule->count; i++) {
+            memcpy(&constant[q], rule->entries[i].key, rule->entries[i].keyLength);
+            emitConstant(out, constant, q + rule->entries[i].keyLength, &run);
+            q = 0;
+        }
+        if (rule->count == 0) {
+            emitConstant(out, constant, q, &run);
+        }
+
+        // Bounds.
+        const char* separator = "\n    if (";
+        int checks = 0;
+        for (int i = 0; i < rule->count; i++) {
+            const ENTRY* entry = &rule->entries[i];
+            if (entry->isArray) {
+                if (entry->minElements) {
+                    fprintf(out, "%svalue->%sCount < %llu", separator, entry->name,
+                            (unsigned long long)entry->minElements);
+                    separator = " ||\n        ";
+                }
+                fprintf(out, "%svalue->%sCount > %llu", separator, entry->name,
+                        (unsigned long long)entry->maxElements);
+                separator = " ||\n        ";
+                checks++;
+            } else if (entry->type == T_TSTR) {
+                fprintf(out, "%sstrlen(value->%s) > %llu", separator, entry->name,
+                        (unsigned long long)entry->maxSize);
+                separator = " ||\n        ";
+                checks++;
+            } else if (entry->type == T_BSTR) {
+                fprintf(out, "%svalue->%sLength > %llu", separator, entry->name,
+                        (unsigned long long)entry->maxSize);
+                separator = " ||\n        ";
+                checks++;
+            } else if (entry->type == T_UINT || entry->type == T_NINT) {
+                fprintf(out, "%svalue->%s %s 0", separator, entry->name,
+                        entry->type == T_UINT ? "<" : ">=");
+                separator = " ||\n        ";
+                checks++;
+            }
+        }
+        if (checks) {
+            fprintf(out, ") {\n        // Schema violation.\n        cborBuffer->length = 0;\n"
+                         "        return;\n    }\n");
+        }
+        fprintf(out, "\n    if (!reserveBytes(cborBuffer, %s_MAX_SIZE)) {\n        return;\n    }\n", upper);
+
+        // Straight-line encoding.
+        for (int i = 0; i < rule->count; i++) {
+            const ENTRY* entry = &rule->entries[i];
+            fprintf(out, "    addRawBytesUnchecked(cborBuffer, CONSTANT_%d, sizeof(CONSTANT_%d));\n", i, i);
+            if (entry->isArray) {
+                char value[MAX_NAME * 2 + 20], length[MAX_NAME * 2 + 20];
+                fprintf(out, "    addArrayUnchecked(cborBuffer, (int)value->%sCount);\n", entry->name);
+                fprintf(out, "    for (size_t i = 0; i < value->%sCount; i++) {\n", entry->name);
+                if (entry->type == T_TSTR || entry->type == T_BSTR) {
+                    const char* bound = entry->type == T_TSTR ? "strlen(value->%s[i])" : "value->%sLengths[i]";
+                    fprintf(out, "        if (");
+                    fprintf(out, bound, entry->name);
+                    fprintf(out, " > %llu) {\n            cborBuffer->length = 0;\n            return;\n"
+                                 "        }\n", (unsigned long long)entry->maxSize);
+                }
+                snprintf(value, sizeof(value), "value->%s[i]", entry->name);
+                snprintf(length, sizeof(length), "value->%sLengths[i]", entry->name);
+                fprintf(out, "        ");
+                emitValue(out, entry, value, length);
+                fprintf(out, "    }\n");
+            } else {
+                char value[MAX_NAME * 2 + 20], length[MAX_NAME * 2 + 20];
+                snprintf(value, sizeof(value), "value->%s", entry->name);
+                snprintf(length, sizeof(length), "value->%sLength", entry->name);
+                fprintf(out, "    ");
+                emitValue(out, entry, value, length);
+            }
+        }
+        if (rule->count == 0) {
+            fprintf(out, "    addRawBytesUnchecked(cborBuffer, CONSTANT_0, sizeof(CONSTANT_0));\n");
+        }
+        fprintf(out, "}\n");
+    }
+}
+
+static char* readFile(const char* name) {
+    FILE* file = fopen(name, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = malloc((size_t)size + 1);
+    if (data && fread(data, 1, (size_t)size, file) == (size_t)size) {
+        data[size] = 0;
+    } else {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+int main(int argc, const char* argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s schema.cddl output-base\n", argv[0]);
+        return 1;
+    }
+    fileName = argv[1];
+    char* data = readFile(fileName);
+    if (!data) {
+        fprintf(stderr, "Cannot read %s\n", fileName);
+        return 1;
+    }
+    static RULE rules[MAX_RULES];
+    int ruleCount = 0;
+    input = data;
+    for (skipSpace(NULL); *input; skipSpace(NULL)) {
+        if (ruleCount == MAX_RULES) {
+            fail("too many rules");
+        }
+        parseRule(&rules[ruleCount++]);
+    }
+
+    char headerName[1024], sourceName[1024];
+    snprintf(headerName, sizeof(headerName), "%s.h", argv[2]);
+    snprintf(sourceName, sizeof(sourceName), "%s.c", argv[2]);
+    const char* headerBase = strrchr(headerName, '/');
+    headerBase = headerBase ? headerBase + 1 : headerName;
+    FILE* header = fopen(headerName, "w");
+    FILE* source = fopen(sourceName, "w");
+    if (!header || !source) {
+        fprintf(stderr, "Cannot write %s\n", argv[2]);
+        return 1;
+    }
+    generateHeader(header, rules, ruleCount);
+    generateSource(source, rules, ruleCount, headerBase);
+    fclose(header);
+    fclose(source);
+    free(data);
+    return 0;
+}
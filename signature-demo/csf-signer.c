@@ -41,7 +41,7 @@ void signBuffer(CBOR_BUFFER* cborBuffer, int key) {
     // Set the application specific map key holding the signature.
     addInt(cborBuffer, key);
     // Remember to update map size after the signature has been added.
-    int signatureMap = cborBuffer->pos;
+    size_t signatureMap = cborBuffer->pos;
     // Intially there are only 2 elements in the core signature map.
     addMap(cborBuffer, 2);
       // COSE algorithm EdDSA but in CSF and FIDO treated as Ed25519.
@@ -19,9 +19,7 @@ int main(int argc, const char* argv[]) {
     // Buffer setup, here using the stack for storage.
     unsigned char outputBuffer[BUFFER_SIZE];
     CBOR_BUFFER cborBuffer;
-    cborBuffer.data = outputBuffer;
-    cborBuffer.length = BUFFER_SIZE;
-    cborBuffer.pos = 0;
+    initCborBuffer(&cborBuffer, outputBuffer, BUFFER_SIZE);
 
     addMap(&cborBuffer, 3);
       // Application data.
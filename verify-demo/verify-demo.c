@@ -54,6 +54,10 @@ int main(int argc, const char* argv[]) {
     QCBORDecodeContext DecodeCtx;
     QCBORDecode_Init(&DecodeCtx, UsefulOutBuf_OutUBuf(&UOB), QCBOR_DECODE_MODE_NORMAL);
 
+    // Index map labels so that lookups don't rescan the maps.
+    UsefulBuf_MAKE_STACK_UB(mapIndex, 8 * QCBOR_MAP_INDEX_BYTES_PER_LABEL + 7);
+    QCBORDecode_SetMapIndex(&DecodeCtx, mapIndex);
+
     // For debug and demo purposes only...
     printUsefulBufC(&DecodeCtx.InBuf.UB, "Signed CBOR data");
 